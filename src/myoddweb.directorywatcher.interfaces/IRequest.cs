@@ -19,5 +19,17 @@ namespace myoddweb.directorywatcher.interfaces
     /// The various refresh rates
     /// </summary>
     IRates Rates { get; }
+
+    /// <summary>
+    /// If we only want the net effect of the events of each path in a window.
+    /// For example a file that is added then removed is not reported at all.
+    /// </summary>
+    bool CoalesceEvents { get; }
+
+    /// <summary>
+    /// How long, in ms, a touched path must not change before it is reported, 0 to report the changes straight away.
+    /// A path that keeps changing is still reported from time to time.
+    /// </summary>
+    long SettleMilliseconds { get; }
   }
 }
\ No newline at end of file
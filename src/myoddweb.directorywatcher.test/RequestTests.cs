@@ -36,6 +36,38 @@ namespace myoddweb.directorywatcher.test
       Assert.AreEqual(recursive, request.Recursive);
     }
 
+    [TestCase(true)]
+    [TestCase(false)]
+    public void CoalesceEventsIsSaved(bool coalesceEvents)
+    {
+      var request = new Request("c:\\", false, new Rates(50, 0), coalesceEvents);
+      Assert.AreEqual(coalesceEvents, request.CoalesceEvents);
+    }
+
+    [Test]
+    public void EventsAreNotCoalescedByDefault()
+    {
+      var request = new Request("c:\\", false);
+      Assert.IsFalse(request.CoalesceEvents);
+    }
+
+    [TestCase(0)]
+    [TestCase(500)]
+    public void SettleMillisecondsIsSaved(long settleMilliseconds)
+    {
+      var request = new Request("c:\\", false, new Rates(50, 0), false, settleMilliseconds);
+      Assert.AreEqual(settleMilliseconds, request.SettleMilliseconds);
+    }
+
+    [Test]
+    public void CannotCreateWithNegativeSettleMilliseconds()
+    {
+      Assert.Throws<ArgumentOutOfRangeException>(() =>
+      {
+        var _ = new Request("c:\\", false, new Rates(50, 0), false, -1);
+      });
+    }
+
     [Test]
     public void CannotCreateWithNullPath()
     {
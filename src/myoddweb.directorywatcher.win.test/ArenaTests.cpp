@@ -0,0 +1,84 @@
+#include "pch.h"
+
+#include <cstdint>
+#include "../myoddweb.directorywatcher.win/utils/Arena.h"
+#include "../myoddweb.directorywatcher.win/utils/BufferPool.h"
+
+using myoddweb::directorywatcher::Arena;
+using myoddweb::directorywatcher::BufferPool;
+
+struct ArenaTestItem
+{
+  long long Value;
+  bool Flag;
+};
+
+TEST(Arena, NewArenaHasNoMemory) {
+  const Arena arena;
+  EXPECT_EQ(0, arena.BytesUsed());
+  EXPECT_EQ(0, arena.BytesReserved());
+}
+
+TEST(Arena, CopyStringIsNullTerminated) {
+  Arena arena;
+  const auto copy = arena.Copy(L"c:\\foo\\bar.txt");
+  ASSERT_STREQ(L"c:\\foo\\bar.txt", copy);
+
+  const auto empty = arena.Copy(L"");
+  ASSERT_STREQ(L"", empty);
+}
+
+TEST(Arena, CreatedObjectsAreAligned) {
+  Arena arena;
+  for (auto i = 0; i < 100; ++i)
+  {
+    // a string of odd length to make sure that the next object is not aligned by chance.
+    (void)arena.Copy(L"abc");
+    const auto item = arena.Create<ArenaTestItem>(ArenaTestItem{ i, true });
+    EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(item) % alignof(ArenaTestItem));
+    EXPECT_EQ(i, item->Value);
+  }
+}
+
+TEST(Arena, LargeAllocationsGetTheirOwnBlock) {
+  Arena arena(64);
+  const std::wstring large(1000, L'a');
+  const auto copy = arena.Copy(large);
+  ASSERT_EQ(large, copy);
+
+  // we can still use the normal blocks.
+  ASSERT_STREQ(L"foo", arena.Copy(L"foo"));
+}
+
+TEST(Arena, ResetGivesTheBlocksBackToThePool) {
+  Arena arena(1024);
+  for (auto i = 0; i < 10; ++i)
+  {
+    (void)arena.Copy(L"some/long/path/to/a/file.txt");
+  }
+  const auto reserved = arena.BytesReserved();
+  EXPECT_NE(0, arena.BytesUsed());
+
+  // an idle arena holds no memory.
+  arena.Reset();
+  EXPECT_EQ(0, arena.BytesUsed());
+  EXPECT_EQ(0, arena.BytesReserved());
+
+  // using it again takes the blocks from the pool rather than the heap.
+  const auto hits = BufferPool::Shared().NumberOfHits();
+  for (auto i = 0; i < 10; ++i)
+  {
+    (void)arena.Copy(L"some/long/path/to/a/file.txt");
+  }
+  EXPECT_EQ(reserved, arena.BytesReserved());
+  EXPECT_LT(hits, BufferPool::Shared().NumberOfHits());
+}
+
+TEST(Arena, ResetReleasesLargeBlocks) {
+  Arena arena(64);
+  (void)arena.Copy(std::wstring(1000, L'a'));
+  EXPECT_LT(1000 * sizeof(wchar_t), arena.BytesReserved());
+
+  arena.Reset();
+  EXPECT_EQ(0, arena.BytesReserved());
+}
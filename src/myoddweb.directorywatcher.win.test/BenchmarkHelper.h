@@ -0,0 +1,53 @@
+#pragma once
+#include <chrono>
+#include <ctime>
+#include <functional>
+#include <iostream>
+#include <string>
+#if defined(_WIN32)
+  #include <Windows.h>
+#endif
+
+/**
+ * \brief time a function and output the result in the test log.
+ *        Benchmarks are disabled by default, run them with:
+ *          --gtest_also_run_disabled_tests --gtest_filter=*Benchmark*
+ * \param name the name of what we are timing.
+ * \param numberOfItems the number of items processed by the function, (used for the rate).
+ * \param function the function we are timing.
+ * \return the number of milliseconds it took.
+ */
+inline double Benchmark(const std::string& name, const long long numberOfItems, const std::function<void()>& function)
+{
+  const auto start = std::chrono::high_resolution_clock::now();
+  function();
+  const auto end = std::chrono::high_resolution_clock::now();
+
+  const auto elapsed = std::chrono::duration<double, std::milli>(end - start).count();
+  const auto rate = elapsed > 0 ? (numberOfItems / elapsed) * 1000 : 0;
+  std::cout << "[ BENCHMARK] " << name << ": " << numberOfItems << " items in " << elapsed << "ms (" << static_cast<long long>(rate) << "/s)" << std::endl;
+  return elapsed;
+}
+
+/**
+ * \brief the cpu time used by all the threads of the process so far.
+ * \return the number of milliseconds of cpu.
+ */
+inline double ProcessCpuMilliseconds()
+{
+#if defined(_WIN32)
+  FILETIME creation, exit, kernel, user;
+  if (!::GetProcessTimes(::GetCurrentProcess(), &creation, &exit, &kernel, &user))
+  {
+    return 0;
+  }
+  const auto toMilliseconds = [](const FILETIME& time)
+  {
+    // in 100ns units.
+    return static_cast<double>((static_cast<unsigned long long>(time.dwHighDateTime) << 32) | time.dwLowDateTime) / 10000;
+  };
+  return toMilliseconds(kernel) + toMilliseconds(user);
+#else
+  return static_cast<double>(std::clock()) * 1000 / CLOCKS_PER_SEC;
+#endif
+}
@@ -0,0 +1,111 @@
+#include "pch.h"
+
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "../myoddweb.directorywatcher.win/utils/BufferPool.h"
+
+using myoddweb::directorywatcher::BufferPool;
+using myoddweb::directorywatcher::MYODDWEB_BUFFERPOOL_MAX_FREE_BUFFERS;
+
+TEST(BufferPool, NewPoolHasNoFreeBuffers) {
+  const BufferPool pool;
+  EXPECT_EQ(0, pool.NumberOfFreeBuffers());
+  EXPECT_EQ(0, pool.NumberOfHits());
+  EXPECT_EQ(0, pool.NumberOfMisses());
+}
+
+TEST(BufferPool, BuffersAreAligned) {
+  BufferPool pool;
+  for (auto size : { 1, 100, 1024, 1025, 65536, 100000 })
+  {
+    const auto buffer = pool.Acquire(size);
+    EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(buffer) % BufferPool::Alignment);
+    memset(buffer, 0, size);
+    pool.Release(buffer);
+  }
+}
+
+TEST(BufferPool, ReleasedBufferIsReused) {
+  BufferPool pool;
+  const auto first = pool.Acquire(2000);
+  pool.Release(first);
+
+  // a different size in the same class gets the same buffer back.
+  const auto second = pool.Acquire(1500);
+  EXPECT_EQ(first, second);
+  pool.Release(second);
+
+  EXPECT_EQ(1, pool.NumberOfHits());
+  EXPECT_EQ(1, pool.NumberOfMisses());
+}
+
+TEST(BufferPool, DifferentSizesAreNotMixed) {
+  BufferPool pool;
+  pool.Release(pool.Acquire(512));
+
+  // the small buffer cannot be used for a large request.
+  const auto buffer = pool.Acquire(65536);
+  memset(buffer, 0, 65536);
+  pool.Release(buffer);
+
+  EXPECT_EQ(0, pool.NumberOfHits());
+  EXPECT_EQ(2, pool.NumberOfMisses());
+  EXPECT_EQ(2, pool.NumberOfFreeBuffers());
+}
+
+TEST(BufferPool, LargeBuffersAreNotKept) {
+  BufferPool pool;
+  pool.Release(pool.Acquire(65537));
+  pool.Release(pool.Acquire(65537));
+
+  EXPECT_EQ(0, pool.NumberOfHits());
+  EXPECT_EQ(2, pool.NumberOfMisses());
+  EXPECT_EQ(0, pool.NumberOfFreeBuffers());
+}
+
+TEST(BufferPool, NumberOfFreeBuffersIsLimited) {
+  BufferPool pool;
+  std::vector<unsigned char*> buffers;
+  for (auto i = 0; i < MYODDWEB_BUFFERPOOL_MAX_FREE_BUFFERS + 10; ++i)
+  {
+    buffers.emplace_back(pool.Acquire(4096));
+  }
+  for (const auto buffer : buffers)
+  {
+    pool.Release(buffer);
+  }
+  EXPECT_EQ(MYODDWEB_BUFFERPOOL_MAX_FREE_BUFFERS, pool.NumberOfFreeBuffers());
+}
+
+TEST(BufferPool, ReleasingNullDoesNothing) {
+  BufferPool pool;
+  pool.Release(nullptr);
+  EXPECT_EQ(0, pool.NumberOfFreeBuffers());
+}
+
+TEST(BufferPool, MoreThanOneThreadCanUseThePool) {
+  BufferPool pool;
+  std::vector<std::thread> threads;
+  for (auto t = 0; t < 4; ++t)
+  {
+    threads.emplace_back([&pool]
+    {
+      for (auto i = 0; i < 1000; ++i)
+      {
+        const auto buffer = pool.Acquire(8192);
+        memset(buffer, i & 0xff, 8192);
+        pool.Release(buffer);
+      }
+    });
+  }
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+
+  // at most one buffer per thread was ever needed.
+  EXPECT_EQ(4000, pool.NumberOfHits() + pool.NumberOfMisses());
+  EXPECT_GE(4, pool.NumberOfMisses());
+}
@@ -0,0 +1,73 @@
+#include "pch.h"
+
+#include "../myoddweb.directorywatcher.win/monitors/Base.h"
+#include "../myoddweb.directorywatcher.win/utils/BufferSizePolicy.h"
+
+using myoddweb::directorywatcher::BufferSizePolicy;
+using myoddweb::directorywatcher::MYODDWEB_READ_BUFFER_IDLE_MILLISECONDS;
+
+TEST(BufferSizePolicy, InitialSizeIsWithinTheBounds) {
+  const BufferSizePolicy tooSmall(4096, 65536, 1024);
+  EXPECT_EQ(4096, tooSmall.Size());
+
+  const BufferSizePolicy tooLarge(4096, 65536, 1024 * 1024);
+  EXPECT_EQ(65536, tooLarge.Size());
+
+  const BufferSizePolicy inside(4096, 65536, 16384);
+  EXPECT_EQ(16384, inside.Size());
+  EXPECT_EQ(0, inside.NumberOfOverflows());
+}
+
+TEST(BufferSizePolicy, OverflowDoublesTheSizeUpToTheMaximum) {
+  BufferSizePolicy policy(4096, 65536, 16384);
+  policy.OnOverflow(0);
+  EXPECT_EQ(32768, policy.Size());
+  policy.OnOverflow(0);
+  EXPECT_EQ(65536, policy.Size());
+  policy.OnOverflow(0);
+  EXPECT_EQ(65536, policy.Size());
+  EXPECT_EQ(3, policy.NumberOfOverflows());
+}
+
+TEST(BufferSizePolicy, NearlyFullReadGrowsTheSize) {
+  BufferSizePolicy policy(4096, 65536, 16384);
+  policy.OnRead(16384 / 2, 0);
+  EXPECT_EQ(16384, policy.Size());
+
+  policy.OnRead(16384 * 3 / 4, 0);
+  EXPECT_EQ(32768, policy.Size());
+  EXPECT_EQ(0, policy.NumberOfOverflows());
+}
+
+TEST(BufferSizePolicy, LightReadsOnlyShrinkAfterBeingIdle) {
+  BufferSizePolicy policy(4096, 65536, 16384);
+  policy.OnRead(100, 0);
+  policy.OnRead(100, MYODDWEB_READ_BUFFER_IDLE_MILLISECONDS - 1);
+  EXPECT_EQ(16384, policy.Size());
+
+  policy.OnRead(100, MYODDWEB_READ_BUFFER_IDLE_MILLISECONDS);
+  EXPECT_EQ(8192, policy.Size());
+
+  // the next shrink needs another idle period.
+  policy.OnRead(100, MYODDWEB_READ_BUFFER_IDLE_MILLISECONDS + 1);
+  EXPECT_EQ(8192, policy.Size());
+}
+
+TEST(BufferSizePolicy, BusyReadResetsTheIdleTime) {
+  BufferSizePolicy policy(4096, 65536, 16384);
+  policy.OnRead(100, 0);
+  policy.OnRead(16384 / 2, MYODDWEB_READ_BUFFER_IDLE_MILLISECONDS - 1);
+  policy.OnRead(100, MYODDWEB_READ_BUFFER_IDLE_MILLISECONDS);
+  EXPECT_EQ(16384, policy.Size());
+}
+
+TEST(BufferSizePolicy, SizeNeverGoesBelowTheMinimum) {
+  BufferSizePolicy policy(4096, 65536, 8192);
+  auto now = 0ll;
+  for (auto i = 0; i < 5; ++i)
+  {
+    policy.OnRead(0, now);
+    now += MYODDWEB_READ_BUFFER_IDLE_MILLISECONDS;
+  }
+  EXPECT_EQ(4096, policy.Size());
+}
@@ -0,0 +1,158 @@
+#include "pch.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../myoddweb.directorywatcher.win/utils/Arena.h"
+#include "../myoddweb.directorywatcher.win/utils/Collector.h"
+#include "../myoddweb.directorywatcher.win/utils/Event.h"
+#include "../myoddweb.directorywatcher.win/utils/EventAction.h"
+#include "../myoddweb.directorywatcher.win/utils/EventError.h"
+#include "BenchmarkHelper.h"
+
+using myoddweb::directorywatcher::Arena;
+using myoddweb::directorywatcher::Collector;
+using myoddweb::directorywatcher::Event;
+using myoddweb::directorywatcher::EventError;
+using myoddweb::directorywatcher::EventAction;
+
+// long enough for the events to never be cleaned up while we add them.
+constexpr auto BenchmarkMaxCleanupAgeMilliseconds = 3600000;
+
+class CollectorBenchmark :public ::testing::TestWithParam<int> {};
+INSTANTIATE_TEST_SUITE_P(
+  CollectorBenchmarks,
+  CollectorBenchmark,
+  ::testing::Values(1000, 10000, 100000, 1000000)
+);
+
+TEST_P(CollectorBenchmark, DISABLED_GetEventsWithDuplicates) {
+  const auto numberOfEvents = static_cast<size_t>(GetParam());
+
+  Collector c(BenchmarkMaxCleanupAgeMilliseconds);
+
+  // half of the events are duplicates.
+  for (size_t i = 0; i < numberOfEvents; ++i)
+  {
+    c.Add(EventAction::Touched, L"c:\\", std::to_wstring(i % (numberOfEvents / 2)) + L".txt", true, EventError::None);
+  }
+
+  Arena memory;
+  std::vector<Event*> events;
+  Benchmark("Collector::GetEvents", numberOfEvents, [&]
+  {
+    c.GetEvents(events, memory);
+  });
+  EXPECT_EQ(numberOfEvents / 2, events.size());
+}
+
+TEST_P(CollectorBenchmark, DISABLED_GetEventsWithoutDuplicates) {
+  const auto numberOfEvents = static_cast<size_t>(GetParam());
+
+  Collector c(BenchmarkMaxCleanupAgeMilliseconds);
+  for (size_t i = 0; i < numberOfEvents; ++i)
+  {
+    c.Add(EventAction::Added, L"c:\\", std::to_wstring(i) + L".txt", true, EventError::None);
+  }
+
+  Arena memory;
+  std::vector<Event*> events;
+  Benchmark("Collector::GetEvents", numberOfEvents, [&]
+  {
+    c.GetEvents(events, memory);
+  });
+  EXPECT_EQ(numberOfEvents, events.size());
+}
+
+TEST_P(CollectorBenchmark, DISABLED_AddAndGetEvents) {
+  const auto numberOfEvents = static_cast<size_t>(GetParam());
+
+  // build the names first so we only measure the collector.
+  std::vector<std::wstring> names;
+  names.reserve(numberOfEvents);
+  for (size_t i = 0; i < numberOfEvents; ++i)
+  {
+    names.emplace_back(std::to_wstring(i) + L".txt");
+  }
+
+  Collector c(BenchmarkMaxCleanupAgeMilliseconds);
+  Arena memory;
+  std::vector<Event*> events;
+
+  // the first round allocates the arenas, the second one re-uses them.
+  for (auto round = 0; round < 2; ++round)
+  {
+    events.clear();
+    memory.Reset();
+    Benchmark("Collector::Add+GetEvents", numberOfEvents, [&]
+    {
+      for (const auto& name : names)
+      {
+        c.Add(EventAction::Added, L"c:\\", name, true, EventError::None);
+      }
+      c.GetEvents(events, memory);
+    });
+    EXPECT_EQ(numberOfEvents, events.size());
+  }
+}
+
+class CollectorContentionBenchmark :public ::testing::TestWithParam<int> {};
+INSTANTIATE_TEST_SUITE_P(
+  CollectorBenchmarks,
+  CollectorContentionBenchmark,
+  ::testing::Values(1, 2, 4, 8, 16, 32, 64)
+);
+
+TEST_P(CollectorContentionBenchmark, DISABLED_AddFromManyThreads) {
+  const auto numberOfThreads = GetParam();
+  constexpr auto numberOfEvents = 1000000;
+  const auto numberOfEventsPerThread = numberOfEvents / numberOfThreads;
+
+  // build the names first so we only measure the collector.
+  std::vector<std::wstring> names;
+  names.reserve(numberOfEventsPerThread);
+  for (auto i = 0; i < numberOfEventsPerThread; ++i)
+  {
+    names.emplace_back(std::to_wstring(i) + L".txt");
+  }
+
+  Collector c(BenchmarkMaxCleanupAgeMilliseconds);
+  Arena memory;
+  std::vector<Event*> events;
+  std::atomic<bool> stop = false;
+
+  // the publisher keeps reading while the producers are adding.
+  std::thread consumer([&]
+  {
+    while (!stop)
+    {
+      c.GetEvents(events, memory);
+      events.clear();
+      memory.Reset();
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  });
+
+  Benchmark("Collector::Add x " + std::to_string(numberOfThreads) + " threads", numberOfEventsPerThread * numberOfThreads, [&]
+  {
+    std::vector<std::thread> producers;
+    for (auto t = 0; t < numberOfThreads; ++t)
+    {
+      producers.emplace_back([&]
+      {
+        for (const auto& name : names)
+        {
+          c.Add(EventAction::Touched, L"c:\\", name, true, EventError::None);
+        }
+      });
+    }
+    for (auto& producer : producers)
+    {
+      producer.join();
+    }
+  });
+
+  stop = true;
+  consumer.join();
+}
@@ -1,10 +1,17 @@
 #include "pch.h"
 
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../myoddweb.directorywatcher.win/utils/Arena.h"
 #include "../myoddweb.directorywatcher.win/utils/Collector.h"
 #include "../myoddweb.directorywatcher.win/utils/Event.h"
 #include "../myoddweb.directorywatcher.win/utils/EventAction.h"
 #include "../myoddweb.directorywatcher.win/utils/EventError.h"
 
+using myoddweb::directorywatcher::Arena;
 using myoddweb::directorywatcher::Collector;
 using myoddweb::directorywatcher::Event;
 using myoddweb::directorywatcher::EventError;
@@ -12,17 +19,31 @@ using myoddweb::directorywatcher::EventAction;
 
 constexpr auto MaxCleanupAgeMilliseconds = 100;
 
+/**
+ * \brief the name of a file of the root the way the collector gives it on this platform,
+ *        the tests are written with the windows separator.
+ */
+static std::wstring Native(std::wstring path)
+{
+#if !defined(_WIN32)
+  std::replace(path.begin(), path.end(), L'\\', L'/');
+#endif
+  return path;
+}
+
 TEST(Collector, EmptyCollectorReturnsNothing) {
 
   // create new one.
   Collector c(MaxCleanupAgeMilliseconds);
 
   // empty
+  Arena memory;
   std::vector<Event*> events;
-  c.GetEvents(events);
+  c.GetEvents(events, memory);
   EXPECT_EQ( 0, events.size() );
 }
 
+#if defined(_WIN32)
 TEST(Collector, PathIsValidWithTwoBackSlash) {
 
   // create new one.
@@ -30,12 +51,12 @@ TEST(Collector, PathIsValidWithTwoBackSlash) {
   c.Add( EventAction::Added, L"c:\\", L"\\foo\\bar.txt", true, EventError::None);
 
   // get it.
+  Arena memory;
   std::vector<Event*> events;
-  c.GetEvents(events);
+  c.GetEvents(events, memory);
   EXPECT_EQ(1, events.size() );
 
   EXPECT_TRUE(wcscmp(L"c:\\foo\\bar.txt", events[0]->Name) == 0);
-  delete events[0];
 }
 
 TEST(Collector, PathIsValidWithOneBackSlashOnPath) {
@@ -45,12 +66,12 @@ TEST(Collector, PathIsValidWithOneBackSlashOnPath) {
   c.Add(EventAction::Added, L"c:\\", L"foo\\bar.txt", true, EventError::None);
 
   // get it.
+  Arena memory;
   std::vector<Event*> events;
-  c.GetEvents(events);
+  c.GetEvents(events, memory);
   EXPECT_EQ(1, events.size() );
 
   EXPECT_TRUE(wcscmp(L"c:\\foo\\bar.txt", events[0]->Name) == 0);
-  delete events[0];
 }
 
 TEST(Collector, PathIsValidWithOneBackSlashOnFileName) {
@@ -60,10 +81,297 @@ TEST(Collector, PathIsValidWithOneBackSlashOnFileName) {
   c.Add(EventAction::Added, L"c:", L"\\foo\\bar.txt", true, EventError::None );
 
   // get it.
+  Arena memory;
   std::vector<Event*> events;
-  c.GetEvents(events);
+  c.GetEvents(events, memory);
   EXPECT_EQ(1, events.size() );
 
   EXPECT_TRUE(wcscmp(L"c:\\foo\\bar.txt", events[0]->Name)==0);
-  delete events[0];
-}
\ No newline at end of file
+}
+#else
+TEST(Collector, PathIsValidWithTwoSlash) {
+
+  // create new one.
+  Collector c(MaxCleanupAgeMilliseconds);
+  c.Add(EventAction::Added, L"/", L"/foo/bar.txt", true, EventError::None);
+
+  // get it.
+  Arena memory;
+  std::vector<Event*> events;
+  c.GetEvents(events, memory);
+  EXPECT_EQ(1, events.size());
+
+  EXPECT_TRUE(wcscmp(L"/foo/bar.txt", events[0]->Name) == 0);
+}
+
+TEST(Collector, PathIsValidWithOneSlashOnFileName) {
+
+  // create new one.
+  Collector c(MaxCleanupAgeMilliseconds);
+  c.Add(EventAction::Added, L"/foo", L"/bar.txt", true, EventError::None);
+
+  // get it.
+  Arena memory;
+  std::vector<Event*> events;
+  c.GetEvents(events, memory);
+  EXPECT_EQ(1, events.size());
+
+  EXPECT_TRUE(wcscmp(L"/foo/bar.txt", events[0]->Name) == 0);
+}
+#endif
+
+TEST(Collector, OlderDuplicatesAreRemoved) {
+
+  // create new one.
+  Collector c(MaxCleanupAgeMilliseconds);
+  c.Add(EventAction::Touched, L"c:\\", L"foo.txt", true, EventError::None);
+  c.Add(EventAction::Touched, L"c:\\", L"bar.txt", true, EventError::None);
+  c.Add(EventAction::Touched, L"c:\\", L"foo.txt", true, EventError::None);
+
+  // get it.
+  Arena memory;
+  std::vector<Event*> events;
+  c.GetEvents(events, memory);
+  ASSERT_EQ(2, events.size());
+
+  // the newest 'foo' is kept, so it is after 'bar'
+  EXPECT_TRUE(wcscmp(Native(L"c:\\bar.txt").c_str(), events[0]->Name) == 0);
+  EXPECT_TRUE(wcscmp(Native(L"c:\\foo.txt").c_str(), events[1]->Name) == 0);
+}
+
+TEST(Collector, DifferentActionsAreNotDuplicates) {
+
+  // create new one.
+  Collector c(MaxCleanupAgeMilliseconds);
+  c.Add(EventAction::Added, L"c:\\", L"foo.txt", true, EventError::None);
+  c.Add(EventAction::Touched, L"c:\\", L"foo.txt", true, EventError::None);
+  c.Add(EventAction::Removed, L"c:\\", L"foo.txt", true, EventError::None);
+
+  // get it.
+  Arena memory;
+  std::vector<Event*> events;
+  c.GetEvents(events, memory);
+  ASSERT_EQ(3, events.size());
+
+  EXPECT_EQ(static_cast<int>(EventAction::Added), events[0]->Action);
+  EXPECT_EQ(static_cast<int>(EventAction::Touched), events[1]->Action);
+  EXPECT_EQ(static_cast<int>(EventAction::Removed), events[2]->Action);
+}
+
+TEST(Collector, FilesAndFoldersAreNotDuplicates) {
+
+  // create new one.
+  Collector c(MaxCleanupAgeMilliseconds);
+  c.Add(EventAction::Added, L"c:\\", L"foo", true, EventError::None);
+  c.Add(EventAction::Added, L"c:\\", L"foo", false, EventError::None);
+
+  // get it.
+  Arena memory;
+  std::vector<Event*> events;
+  c.GetEvents(events, memory);
+  ASSERT_EQ(2, events.size());
+
+  EXPECT_TRUE(events[0]->IsFile);
+  EXPECT_FALSE(events[1]->IsFile);
+}
+
+TEST(Collector, RenameKeepsBothNames) {
+
+  // create new one.
+  Collector c(MaxCleanupAgeMilliseconds);
+  c.AddRename(L"c:\\", L"bar.txt", L"foo.txt", true, EventError::None);
+
+  // get it.
+  Arena memory;
+  std::vector<Event*> events;
+  c.GetEvents(events, memory);
+  ASSERT_EQ(1, events.size());
+
+  EXPECT_EQ(static_cast<int>(EventAction::Renamed), events[0]->Action);
+  EXPECT_TRUE(wcscmp(Native(L"c:\\bar.txt").c_str(), events[0]->Name) == 0);
+  EXPECT_TRUE(wcscmp(Native(L"c:\\foo.txt").c_str(), events[0]->OldName) == 0);
+}
+
+TEST(Collector, HasEventsUntilTheyAreCollected) {
+
+  // create new one.
+  Collector c(MaxCleanupAgeMilliseconds);
+  EXPECT_FALSE(c.HasEvents());
+
+  c.Add(EventAction::Added, L"c:\\", L"foo.txt", true, EventError::None);
+  EXPECT_TRUE(c.HasEvents());
+
+  Arena memory;
+  std::vector<Event*> events;
+  c.GetEvents(events, memory);
+  EXPECT_EQ(1, events.size());
+  EXPECT_FALSE(c.HasEvents());
+}
+
+TEST(Collector, EventsAreOnlyReturnedOnce) {
+
+  // create new one.
+  Collector c(MaxCleanupAgeMilliseconds);
+  Arena memory;
+  std::vector<Event*> events;
+
+  for (auto i = 0; i < 3; ++i)
+  {
+    c.Add(EventAction::Added, L"c:\\", L"foo.txt", true, EventError::None);
+    c.GetEvents(events, memory);
+    ASSERT_EQ(1, events.size());
+    EXPECT_TRUE(wcscmp(Native(L"c:\\foo.txt").c_str(), events[0]->Name) == 0);
+
+    // nothing new was added.
+    c.GetEvents(events, memory);
+    EXPECT_EQ(1, events.size());
+
+    events.clear();
+    memory.Reset();
+  }
+}
+
+TEST(Collector, EventsFromManyThreadsAreAllCollected) {
+
+  // create new one.
+  Collector c(MaxCleanupAgeMilliseconds);
+  constexpr auto numberOfThreads = 8;
+  constexpr auto numberOfEventsPerThread = 1000;
+
+  std::vector<std::thread> threads;
+  for (auto t = 0; t < numberOfThreads; ++t)
+  {
+    threads.emplace_back([&c, t]
+    {
+      for (auto i = 0; i < numberOfEventsPerThread; ++i)
+      {
+        c.Add(EventAction::Added, L"c:\\", std::to_wstring(t) + L"_" + std::to_wstring(i), true, EventError::None);
+      }
+    });
+  }
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+
+  // get them all, there are no duplicates.
+  Arena memory;
+  std::vector<Event*> events;
+  c.GetEvents(events, memory);
+  ASSERT_EQ(numberOfThreads * numberOfEventsPerThread, events.size());
+
+  // they are all in time order.
+  EXPECT_TRUE(std::is_sorted(events.begin(), events.end(), Collector::SortByTimeMillisecondsUtc));
+}
+
+TEST(Collector, EventsAreNotCoalescedByDefault) {
+
+  Collector c(MaxCleanupAgeMilliseconds);
+  c.Add(EventAction::Added, L"c:\\", L"foo.tmp", true, EventError::None);
+  c.Add(EventAction::Removed, L"c:\\", L"foo.tmp", true, EventError::None);
+
+  Arena memory;
+  std::vector<Event*> events;
+  c.GetEvents(events, memory);
+  EXPECT_EQ(2, events.size());
+  EXPECT_EQ(2, c.NumberOfCollectedEvents());
+  EXPECT_EQ(0, c.NumberOfCoalescedEvents());
+}
+
+TEST(Collector, CoalescedEventsOnlyKeepTheNetEffect) {
+
+  Collector c(MaxCleanupAgeMilliseconds, true);
+  c.Add(EventAction::Added, L"c:\\", L"foo.tmp", true, EventError::None);
+  c.Add(EventAction::Touched, L"c:\\", L"foo.tmp", true, EventError::None);
+  c.Add(EventAction::Removed, L"c:\\", L"foo.tmp", true, EventError::None);
+  c.Add(EventAction::Added, L"c:\\", L"bar.tmp", true, EventError::None);
+  c.AddRename(L"c:\\", L"bar.txt", L"bar.tmp", true, EventError::None);
+
+  Arena memory;
+  std::vector<Event*> events;
+  c.GetEvents(events, memory);
+  ASSERT_EQ(1, events.size());
+  EXPECT_EQ(static_cast<int>(EventAction::Added), events[0]->Action);
+  EXPECT_TRUE(wcscmp(Native(L"c:\\bar.txt").c_str(), events[0]->Name) == 0);
+  EXPECT_EQ(5, c.NumberOfCollectedEvents());
+  EXPECT_EQ(4, c.NumberOfCoalescedEvents());
+}
+
+TEST(Collector, OlderDuplicatesAreCounted) {
+
+  Collector c(MaxCleanupAgeMilliseconds);
+  c.Add(EventAction::Touched, L"c:\\", L"foo.log", true, EventError::None);
+  c.Add(EventAction::Touched, L"c:\\", L"foo.log", true, EventError::None);
+  c.Add(EventAction::Touched, L"c:\\", L"foo.log", true, EventError::None);
+  c.Add(EventAction::Added, L"c:\\", L"bar.txt", true, EventError::None);
+
+  Arena memory;
+  std::vector<Event*> events;
+  c.GetEvents(events, memory);
+  EXPECT_EQ(2, events.size());
+  EXPECT_EQ(4, c.NumberOfCollectedEvents());
+  EXPECT_EQ(2, c.NumberOfDeduplicatedEvents());
+}
+
+TEST(Collector, TouchedFilesAreHeldUntilTheySettle) {
+
+  Collector c(MaxCleanupAgeMilliseconds, false, 50);
+  c.Add(EventAction::Touched, L"c:\\", L"foo.log", true, EventError::None);
+  c.Add(EventAction::Touched, L"c:\\", L"foo.log", true, EventError::None);
+  c.Add(EventAction::Added, L"c:\\", L"bar.txt", true, EventError::None);
+
+  // only the added file is returned, the touched one is still changing.
+  Arena memory;
+  std::vector<Event*> events;
+  c.GetEvents(events, memory);
+  ASSERT_EQ(1, events.size());
+  EXPECT_EQ(static_cast<int>(EventAction::Added), events[0]->Action);
+  EXPECT_EQ(1, c.NumberOfSettlingPaths());
+  EXPECT_TRUE(c.HasEvents());
+
+  // once it settled it is returned once.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  events.clear();
+  c.GetEvents(events, memory);
+  ASSERT_EQ(1, events.size());
+  EXPECT_EQ(static_cast<int>(EventAction::Touched), events[0]->Action);
+  EXPECT_TRUE(wcscmp(Native(L"c:\\foo.log").c_str(), events[0]->Name) == 0);
+  EXPECT_EQ(0, c.NumberOfSettlingPaths());
+  EXPECT_FALSE(c.HasEvents());
+}
+
+TEST(Collector, FilesStillSettlingDoNotStopUsFromAddingEvents) {
+
+  // a log file that is written to all the time never settles.
+  Collector c(MaxCleanupAgeMilliseconds, false, 60000);
+  Arena memory;
+  std::vector<Event*> events;
+  for (auto i = 0; i < 10; ++i)
+  {
+    c.Add(EventAction::Touched, L"c:\\", L"foo.log", true, EventError::None);
+    c.GetEvents(events, memory);
+    EXPECT_TRUE(events.empty());
+    EXPECT_EQ(1, c.NumberOfSettlingPaths());
+  }
+
+  // other events are still collected.
+  c.Add(EventAction::Added, L"c:\\", L"bar.txt", true, EventError::None);
+  c.GetEvents(events, memory);
+  ASSERT_EQ(1, events.size());
+  EXPECT_EQ(static_cast<int>(EventAction::Added), events[0]->Action);
+}
+
+TEST(Collector, OtherEventsReleaseTheTouchedFileFirst) {
+
+  Collector c(MaxCleanupAgeMilliseconds, false, 60000);
+  c.Add(EventAction::Touched, L"c:\\", L"foo.txt", true, EventError::None);
+  c.Add(EventAction::Removed, L"c:\\", L"foo.txt", true, EventError::None);
+
+  Arena memory;
+  std::vector<Event*> events;
+  c.GetEvents(events, memory);
+  ASSERT_EQ(2, events.size());
+  EXPECT_EQ(static_cast<int>(EventAction::Touched), events[0]->Action);
+  EXPECT_EQ(static_cast<int>(EventAction::Removed), events[1]->Action);
+  EXPECT_EQ(0, c.NumberOfSettlingPaths());
+}
@@ -0,0 +1,96 @@
+#include "pch.h"
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../myoddweb.directorywatcher.win/utils/BufferPool.h"
+#include "../myoddweb.directorywatcher.win/utils/ConcurrentArena.h"
+
+using myoddweb::directorywatcher::BufferPool;
+using myoddweb::directorywatcher::ConcurrentArena;
+
+TEST(ConcurrentArena, NewArenaHasNoMemory) {
+  const ConcurrentArena arena;
+  EXPECT_EQ(0, arena.BytesReserved());
+}
+
+TEST(ConcurrentArena, CopyStringIsNullTerminated) {
+  ConcurrentArena arena;
+  ASSERT_STREQ(L"c:\\foo\\bar.txt", arena.Copy(L"c:\\foo\\bar.txt"));
+  ASSERT_STREQ(L"", arena.Copy(L""));
+}
+
+TEST(ConcurrentArena, MemoryIsAligned) {
+  ConcurrentArena arena(128);
+  for (auto i = 0; i < 100; ++i)
+  {
+    const auto string = arena.Copy(L"abc");
+    EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(string) % ConcurrentArena::Alignment);
+  }
+}
+
+TEST(ConcurrentArena, LargeAllocationsGetTheirOwnBlock) {
+  ConcurrentArena arena(64);
+  const std::wstring large(1000, L'a');
+  ASSERT_EQ(large, arena.Copy(large));
+  ASSERT_STREQ(L"foo", arena.Copy(L"foo"));
+
+  // nothing is kept once the arena is reset.
+  arena.Reset();
+  EXPECT_EQ(0, arena.BytesReserved());
+}
+
+TEST(ConcurrentArena, ResetGivesTheBlocksBackToThePool) {
+  ConcurrentArena arena(1024);
+  for (auto i = 0; i < 10; ++i)
+  {
+    (void)arena.Copy(L"some/long/path/to/a/file.txt");
+  }
+  const auto reserved = arena.BytesReserved();
+
+  // an idle arena holds no memory.
+  arena.Reset();
+  EXPECT_EQ(0, arena.BytesReserved());
+
+  // using it again takes the blocks from the pool rather than the heap.
+  const auto hits = BufferPool::Shared().NumberOfHits();
+  for (auto i = 0; i < 10; ++i)
+  {
+    (void)arena.Copy(L"some/long/path/to/a/file.txt");
+  }
+  EXPECT_EQ(reserved, arena.BytesReserved());
+  EXPECT_LT(hits, BufferPool::Shared().NumberOfHits());
+}
+
+TEST(ConcurrentArena, ManyThreadsCanAllocateAtTheSameTime) {
+  ConcurrentArena arena(256);
+  constexpr auto numberOfThreads = 8;
+  constexpr auto numberOfStrings = 1000;
+
+  std::vector<std::vector<const wchar_t*>> strings(numberOfThreads);
+  std::vector<std::thread> threads;
+  for (auto t = 0; t < numberOfThreads; ++t)
+  {
+    threads.emplace_back([&arena, &strings, t]
+    {
+      for (auto i = 0; i < numberOfStrings; ++i)
+      {
+        strings[t].emplace_back(arena.Copy(std::to_wstring(t) + L"_" + std::to_wstring(i)));
+      }
+    });
+  }
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+
+  // no thread wrote over the memory of another.
+  for (auto t = 0; t < numberOfThreads; ++t)
+  {
+    for (auto i = 0; i < numberOfStrings; ++i)
+    {
+      ASSERT_EQ(std::to_wstring(t) + L"_" + std::to_wstring(i), strings[t][i]);
+    }
+  }
+}
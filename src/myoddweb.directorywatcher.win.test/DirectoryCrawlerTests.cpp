@@ -0,0 +1,189 @@
+#include "pch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../myoddweb.directorywatcher.win/utils/DirectoryCrawler.h"
+#include "../myoddweb.directorywatcher.win/utils/Io.h"
+
+using myoddweb::directorywatcher::DirectoryCrawler;
+using myoddweb::directorywatcher::Io;
+
+/**
+ * \brief a folder tree in the temp folder, removed when we are done with it.
+ */
+class TempTree
+{
+public:
+  explicit TempTree(const std::wstring& name) :
+    Root(std::filesystem::temp_directory_path() / name)
+  {
+    std::filesystem::remove_all(Root);
+    std::filesystem::create_directories(Root);
+  }
+
+  ~TempTree()
+  {
+    std::error_code ec;
+    std::filesystem::remove_all(Root, ec);
+  }
+
+  /**
+   * \brief create a folder, and all its parents, relative to the root.
+   */
+  std::wstring AddFolder(const std::wstring& path) const
+  {
+    const auto folder = Root / path;
+    std::filesystem::create_directories(folder);
+    return folder.wstring();
+  }
+
+  const std::filesystem::path Root;
+};
+
+/**
+ * \brief crawl the whole tree and collect all the folders we listed.
+ */
+static std::vector<std::wstring> CrawlAll(const std::wstring& root, const unsigned int numberOfThreads)
+{
+  std::mutex lock;
+  std::vector<std::wstring> folders;
+  DirectoryCrawler crawler(numberOfThreads);
+  crawler.Crawl(root,
+    [](const std::wstring&) { return true; },
+    [&](const std::wstring& folder, const std::vector<std::wstring>&)
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      folders.emplace_back(Io::NormalizeFolder(folder));
+      return true;
+    });
+  EXPECT_EQ(static_cast<long long>(folders.size()), crawler.NumberOfFolders());
+  std::sort(folders.begin(), folders.end());
+  return folders;
+}
+
+TEST(DirectoryCrawler, EmptyFolderIsListed) {
+  const TempTree tree(L"myoddweb.crawler.empty");
+  const auto folders = CrawlAll(tree.Root.wstring(), 2);
+  ASSERT_EQ(1u, folders.size());
+  EXPECT_EQ(Io::NormalizeFolder(tree.Root.wstring()), folders[0]);
+}
+
+TEST(DirectoryCrawler, AllTheSubFoldersAreListed) {
+  const TempTree tree(L"myoddweb.crawler.all");
+  std::vector<std::wstring> expected = { Io::NormalizeFolder(tree.Root.wstring()) };
+  for (auto i = 0; i < 5; ++i)
+  {
+    for (auto j = 0; j < 5; ++j)
+    {
+      const auto parent = tree.AddFolder(std::to_wstring(i));
+      expected.emplace_back(Io::NormalizeFolder(tree.AddFolder(std::to_wstring(i) + L"/" + std::to_wstring(j))));
+      if (j == 0)
+      {
+        expected.emplace_back(Io::NormalizeFolder(parent));
+      }
+    }
+  }
+  std::sort(expected.begin(), expected.end());
+
+  EXPECT_EQ(expected, CrawlAll(tree.Root.wstring(), 4));
+}
+
+TEST(DirectoryCrawler, FilesAreNotListed) {
+  const TempTree tree(L"myoddweb.crawler.files");
+  tree.AddFolder(L"sub");
+  { std::ofstream file(tree.Root / L"file.txt"); file << "hello"; }
+
+  std::vector<std::wstring> subFolders;
+  DirectoryCrawler crawler(1);
+  crawler.Crawl(tree.Root.wstring(),
+    [](const std::wstring&) { return true; },
+    [&](const std::wstring& folder, const std::vector<std::wstring>& found)
+    {
+      if (Io::AreSameFolders(folder, tree.Root.wstring()))
+      {
+        subFolders = found;
+      }
+      return false;
+    });
+  ASSERT_EQ(1u, subFolders.size());
+  EXPECT_TRUE(Io::AreSameFolders((tree.Root / L"sub").wstring(), subFolders[0]));
+}
+
+TEST(DirectoryCrawler, FoldersWeDoNotEnterAreNotListed) {
+  const TempTree tree(L"myoddweb.crawler.enter");
+  tree.AddFolder(L"a/b/c");
+  tree.AddFolder(L"d/e");
+
+  std::mutex lock;
+  std::vector<std::wstring> entered;
+  DirectoryCrawler crawler(2);
+  crawler.Crawl(tree.Root.wstring(),
+    [&](const std::wstring& folder)
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      entered.emplace_back(folder);
+      return !Io::AreSameFolders(folder, (tree.Root / L"a").wstring());
+    },
+    [](const std::wstring&, const std::vector<std::wstring>&) { return true; });
+
+  // the root, 'a', 'd' and 'd/e', we never looked inside 'a'.
+  EXPECT_EQ(4u, entered.size());
+  EXPECT_EQ(3, crawler.NumberOfFolders());
+}
+
+TEST(DirectoryCrawler, MissingFolderIsListedAsEmpty) {
+  const TempTree tree(L"myoddweb.crawler.missing");
+  const auto missing = (tree.Root / L"missing").wstring();
+
+  auto numberOfSubFolders = static_cast<size_t>(-1);
+  DirectoryCrawler crawler(1);
+  crawler.Crawl(missing,
+    [](const std::wstring&) { return true; },
+    [&](const std::wstring&, const std::vector<std::wstring>& subFolders)
+    {
+      numberOfSubFolders = subFolders.size();
+      return true;
+    });
+  EXPECT_EQ(0u, numberOfSubFolders);
+}
+
+TEST(DirectoryCrawler, ExceptionsDoNotStopTheCrawl) {
+  const TempTree tree(L"myoddweb.crawler.exception");
+  tree.AddFolder(L"a");
+  tree.AddFolder(L"b");
+
+  std::atomic<int> count(0);
+  DirectoryCrawler crawler(2);
+  crawler.Crawl(tree.Root.wstring(),
+    [](const std::wstring&) { return true; },
+    [&](const std::wstring& folder, const std::vector<std::wstring>&) -> bool
+    {
+      ++count;
+      if (Io::AreSameFolders(folder, (tree.Root / L"a").wstring()))
+      {
+        throw std::runtime_error("Bad folder");
+      }
+      return true;
+    });
+  EXPECT_EQ(3, count);
+}
+
+TEST(DirectoryCrawler, CrawlerCanBeUsedMoreThanOnce) {
+  const TempTree tree(L"myoddweb.crawler.twice");
+  tree.AddFolder(L"a/b");
+
+  DirectoryCrawler crawler(2);
+  for (auto i = 0; i < 2; ++i)
+  {
+    crawler.Crawl(tree.Root.wstring(),
+      [](const std::wstring&) { return true; },
+      [](const std::wstring&, const std::vector<std::wstring>&) { return true; });
+  }
+  EXPECT_EQ(6, crawler.NumberOfFolders());
+}
@@ -0,0 +1,105 @@
+#include "pch.h"
+
+#include <string>
+#include "../myoddweb.directorywatcher.win/utils/EntryCache.h"
+
+using myoddweb::directorywatcher::EntryCache;
+
+TEST(EntryCache, UnknownEntryIsAMiss) {
+  EntryCache cache;
+  auto isFile = true;
+  EXPECT_FALSE(cache.TryGet(L"foo.txt", isFile));
+  EXPECT_EQ(0, cache.NumberOfHits());
+  EXPECT_EQ(1, cache.NumberOfMisses());
+}
+
+TEST(EntryCache, KnownEntryIsAHit) {
+  EntryCache cache;
+  cache.Set(L"foo.txt", true);
+  cache.Set(L"bar", false);
+
+  auto isFile = false;
+  EXPECT_TRUE(cache.TryGet(L"foo.txt", isFile));
+  EXPECT_TRUE(isFile);
+  EXPECT_TRUE(cache.TryGet(L"bar", isFile));
+  EXPECT_FALSE(isFile);
+  EXPECT_EQ(2, cache.NumberOfHits());
+  EXPECT_EQ(0, cache.NumberOfMisses());
+}
+
+TEST(EntryCache, SetUpdatesTheEntry) {
+  EntryCache cache;
+  cache.Set(L"foo", true);
+  cache.Set(L"foo", false);
+
+  auto isFile = true;
+  EXPECT_TRUE(cache.TryGet(L"foo", isFile));
+  EXPECT_FALSE(isFile);
+  EXPECT_EQ(1, cache.Size());
+}
+
+TEST(EntryCache, OldestEntryIsRemovedWhenFull) {
+  EntryCache cache(2);
+  cache.Set(L"a", true);
+  cache.Set(L"b", true);
+
+  // using 'a' makes 'b' the oldest one.
+  auto isFile = false;
+  EXPECT_TRUE(cache.TryGet(L"a", isFile));
+  cache.Set(L"c", true);
+
+  EXPECT_EQ(2, cache.Size());
+  EXPECT_TRUE(cache.TryGet(L"a", isFile));
+  EXPECT_FALSE(cache.TryGet(L"b", isFile));
+  EXPECT_TRUE(cache.TryGet(L"c", isFile));
+}
+
+TEST(EntryCache, RemovingAFileOnlyRemovesThatFile) {
+  EntryCache cache;
+  cache.Set(L"foo", true);
+  cache.Set(L"foo\\bar.txt", true);
+  cache.Remove(L"foo");
+
+  auto isFile = false;
+  EXPECT_FALSE(cache.TryGet(L"foo", isFile));
+  EXPECT_TRUE(cache.TryGet(L"foo\\bar.txt", isFile));
+}
+
+TEST(EntryCache, RemovingADirectoryRemovesItsContent) {
+  EntryCache cache;
+  cache.Set(L"foo", false);
+  cache.Set(L"foo\\bar.txt", true);
+  cache.Set(L"foo\\sub\\baz.txt", true);
+  cache.Set(L"foobar.txt", true);
+  cache.Remove(L"foo");
+
+  auto isFile = false;
+  EXPECT_FALSE(cache.TryGet(L"foo", isFile));
+  EXPECT_FALSE(cache.TryGet(L"foo\\bar.txt", isFile));
+  EXPECT_FALSE(cache.TryGet(L"foo\\sub\\baz.txt", isFile));
+  EXPECT_TRUE(cache.TryGet(L"foobar.txt", isFile));
+  EXPECT_EQ(1, cache.Size());
+}
+
+TEST(EntryCache, EmptyCacheKeepsNothing) {
+  EntryCache cache(0);
+  cache.Set(L"foo", true);
+
+  auto isFile = false;
+  EXPECT_FALSE(cache.TryGet(L"foo", isFile));
+  EXPECT_EQ(0, cache.Size());
+}
+
+TEST(EntryCache, LookupsDoNotNeedTheSameString) {
+  EntryCache cache;
+  {
+    const std::wstring name = L"some\\folder\\file.txt";
+    cache.Set(name, true);
+  }
+
+  // the cache keeps its own copy of the path.
+  const std::wstring other = L"some\\folder\\file.txt";
+  auto isFile = false;
+  EXPECT_TRUE(cache.TryGet(std::wstring_view(other), isFile));
+  EXPECT_TRUE(isFile);
+}
@@ -0,0 +1,80 @@
+#include "pch.h"
+
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "../myoddweb.directorywatcher.win/monitors/Base.h"
+#include "../myoddweb.directorywatcher.win/utils/BufferPool.h"
+#include "BenchmarkHelper.h"
+#include "FakeEventSource.h"
+
+using myoddweb::directorywatcher::BufferPool;
+using myoddweb::directorywatcher::MYODDWEB_READ_BUFFER_INITIAL_SIZE;
+using myoddweb::directorywatcher::MYODDWEB_READ_BUFFER_MIN_SIZE;
+
+class EventSourceBenchmark :public ::testing::TestWithParam<int> {};
+INSTANTIATE_TEST_SUITE_P(
+  EventSourceBenchmarks,
+  EventSourceBenchmark,
+  ::testing::Values(1000, 20000)
+);
+
+/**
+ * \brief everything a monitor keeps for one root.
+ */
+struct BenchmarkRoot
+{
+  BenchmarkRoot() :
+    Policy(MYODDWEB_READ_BUFFER_MIN_SIZE, 65536, MYODDWEB_READ_BUFFER_INITIAL_SIZE),
+    Source(Policy)
+  {
+  }
+
+  BufferSizePolicy Policy;
+  FakeEventSource Source;
+};
+
+TEST_P(EventSourceBenchmark, DISABLED_MemoryPerIdleRoot) {
+  const auto numberOfRoots = GetParam();
+  std::vector<std::unique_ptr<BenchmarkRoot>> roots;
+  roots.reserve(numberOfRoots);
+  Benchmark("StartRoots", numberOfRoots, [&]
+  {
+    for (auto i = 0; i < numberOfRoots; ++i)
+    {
+      roots.emplace_back(new BenchmarkRoot());
+      roots.back()->Source.Start();
+    }
+  });
+
+  // only one root in a hundred has any changes.
+  const unsigned char data[256] = {};
+  long long numberOfReads = 0;
+  Benchmark("ReadActiveRoots", numberOfRoots / 100 * 10, [&]
+  {
+    for (auto read = 0; read < 10; ++read)
+    {
+      for (auto i = 0; i < numberOfRoots; i += 100)
+      {
+        roots[i]->Source.Receive(data, sizeof(data));
+        for (const auto& notification : roots[i]->Source.Get())
+        {
+          BufferPool::Shared().Release(notification.Buffer);
+          ++numberOfReads;
+        }
+      }
+    }
+  });
+  EXPECT_EQ(numberOfRoots / 100 * 10, numberOfReads);
+
+  unsigned long long borrowedBytes = 0;
+  for (const auto& root : roots)
+  {
+    borrowedBytes += root->Source.NumberOfBorrowedBytes();
+  }
+  EXPECT_EQ(0u, borrowedBytes);
+
+  // the roots used to own a 64KB buffer each, whether they had changes or not.
+  const auto bytesPerRoot = sizeof(BenchmarkRoot) + borrowedBytes / numberOfRoots;
+  std::cout << "[ BENCHMARK] MemoryPerIdleRoot: " << bytesPerRoot << " bytes per root, " << (bytesPerRoot * numberOfRoots) / 1024 << "KB for " << numberOfRoots << " roots (was " << (65536ull * numberOfRoots) / 1024 << "KB)" << std::endl;
+}
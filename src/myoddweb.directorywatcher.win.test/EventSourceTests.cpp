@@ -0,0 +1,98 @@
+#include "pch.h"
+
+#include <vector>
+#include "../myoddweb.directorywatcher.win/utils/BufferPool.h"
+#include "FakeEventSource.h"
+
+using myoddweb::directorywatcher::BufferPool;
+
+TEST(EventSource, NothingIsBorrowedBeforeARead) {
+  BufferSizePolicy policy(4096, 65536, 16384);
+  FakeEventSource source(policy);
+  EXPECT_TRUE(source.Start());
+  EXPECT_EQ(0u, source.NumberOfBorrowedBytes());
+  EXPECT_TRUE(source.Get().empty());
+}
+
+TEST(EventSource, ReadBufferHasThePolicySize) {
+  BufferSizePolicy policy(4096, 65536, 16384);
+  FakeEventSource source(policy);
+  EXPECT_NE(nullptr, source.BeginRead());
+  EXPECT_EQ(16384u, source.ReadLength());
+  EXPECT_EQ(16384u, source.NumberOfBorrowedBytes());
+
+  // the policy wants a larger buffer for the next read.
+  policy.OnOverflow(0);
+  source.BeginRead();
+  EXPECT_EQ(32768u, source.ReadLength());
+  EXPECT_EQ(32768u, source.NumberOfBorrowedBytes());
+}
+
+TEST(EventSource, CompletedReadIsHandedOverWithoutACopy) {
+  BufferSizePolicy policy(4096, 65536, 16384);
+  FakeEventSource source(policy);
+  const auto buffer = source.BeginRead();
+  EXPECT_TRUE(source.CompleteRead(100));
+
+  const auto notifications = source.Get();
+  ASSERT_EQ(1u, notifications.size());
+  EXPECT_EQ(buffer, notifications[0].Buffer);
+  EXPECT_EQ(100u, notifications[0].Length);
+  EXPECT_EQ(0u, source.NumberOfBorrowedBytes());
+  BufferPool::Shared().Release(notifications[0].Buffer);
+}
+
+TEST(EventSource, PendingDataIsBorrowedUntilItIsTaken) {
+  BufferSizePolicy policy(4096, 65536, 16384);
+  FakeEventSource source(policy);
+  const unsigned char data[] = { 1, 2, 3, 4 };
+  source.Start();
+  EXPECT_TRUE(source.Receive(data, sizeof(data)));
+  EXPECT_TRUE(source.Receive(data, sizeof(data)));
+  EXPECT_EQ(2u * 16384u, source.NumberOfBorrowedBytes());
+
+  for (const auto& notification : source.Get())
+  {
+    EXPECT_EQ(0, std::memcmp(data, notification.Buffer, sizeof(data)));
+    BufferPool::Shared().Release(notification.Buffer);
+  }
+  EXPECT_EQ(0u, source.NumberOfBorrowedBytes());
+}
+
+TEST(EventSource, CancelledReadGivesTheBufferBack) {
+  BufferSizePolicy policy(4096, 65536, 16384);
+  FakeEventSource source(policy);
+  source.BeginRead();
+  source.CancelRead();
+  EXPECT_EQ(0u, source.NumberOfBorrowedBytes());
+  EXPECT_TRUE(source.Get().empty());
+}
+
+TEST(EventSource, ReadLargerThanTheBufferIsAnOverflow) {
+  BufferSizePolicy policy(4096, 65536, 4096);
+  FakeEventSource source(policy);
+  source.Start();
+  std::vector<unsigned char> data(8192, 1);
+  EXPECT_FALSE(source.Receive(data.data(), static_cast<unsigned long>(data.size())));
+  EXPECT_EQ(1, policy.NumberOfOverflows());
+  EXPECT_EQ(0u, source.NumberOfBorrowedBytes());
+
+  // the next read is large enough.
+  EXPECT_TRUE(source.Receive(data.data(), static_cast<unsigned long>(data.size())));
+  for (const auto& notification : source.Get())
+  {
+    BufferPool::Shared().Release(notification.Buffer);
+  }
+}
+
+TEST(EventSource, StopGivesEverythingBack) {
+  BufferSizePolicy policy(4096, 65536, 16384);
+  FakeEventSource source(policy);
+  const unsigned char data[] = { 1, 2, 3, 4 };
+  source.Start();
+  source.Receive(data, sizeof(data));
+  source.BeginRead();
+  source.Stop();
+  EXPECT_EQ(0u, source.NumberOfBorrowedBytes());
+  EXPECT_TRUE(source.Get().empty());
+}
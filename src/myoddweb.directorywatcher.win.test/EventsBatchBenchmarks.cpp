@@ -0,0 +1,106 @@
+#include "pch.h"
+
+#include <string>
+#include <vector>
+#include "../myoddweb.directorywatcher.win/monitors/Callbacks.h"
+#include "../myoddweb.directorywatcher.win/utils/Arena.h"
+#include "../myoddweb.directorywatcher.win/utils/Event.h"
+#include "../myoddweb.directorywatcher.win/utils/EventAction.h"
+#include "../myoddweb.directorywatcher.win/utils/EventError.h"
+#include "../myoddweb.directorywatcher.win/utils/EventsBatch.h"
+#include "BenchmarkHelper.h"
+
+using myoddweb::directorywatcher::Arena;
+using myoddweb::directorywatcher::Event;
+using myoddweb::directorywatcher::EventCallback;
+using myoddweb::directorywatcher::EventError;
+using myoddweb::directorywatcher::EventAction;
+using myoddweb::directorywatcher::EventRecord;
+using myoddweb::directorywatcher::EventsBatch;
+using myoddweb::directorywatcher::EventsBatchCallback;
+
+// the callbacks copy the strings, the same way the managed code has to marshal them.
+static size_t benchmarkReceivedCharacters = 0;
+
+void __stdcall BenchmarkEventCallback(long long, bool, const wchar_t* name, const wchar_t* oldName, int, int, long long)
+{
+  const std::wstring n(name);
+  const std::wstring o(oldName == nullptr ? L"" : oldName);
+  benchmarkReceivedCharacters += n.size() + o.size();
+}
+
+void __stdcall BenchmarkEventsBatchCallback(long long, const EventRecord* events, const int numberOfEvents, const wchar_t* names, int)
+{
+  for (auto i = 0; i < numberOfEvents; ++i)
+  {
+    const auto& event = events[i];
+    const std::wstring n(names + event.NameOffset, event.NameLength);
+    const std::wstring o(event.OldNameOffset == -1 ? L"" : names + event.OldNameOffset, event.OldNameLength);
+    benchmarkReceivedCharacters += n.size() + o.size();
+  }
+}
+
+class EventsBatchBenchmark :public ::testing::TestWithParam<int> {};
+INSTANTIATE_TEST_SUITE_P(
+  EventsBatchBenchmarks,
+  EventsBatchBenchmark,
+  ::testing::Values(100, 1000, 10000, 100000)
+);
+
+/**
+ * \brief create a publish window worth of events.
+ * \param memory where the events live.
+ * \param numberOfEvents the number of events we want.
+ * \return the events.
+ */
+static std::vector<Event*> CreateBenchmarkEvents(Arena& memory, const int numberOfEvents)
+{
+  std::vector<Event*> events;
+  events.reserve(numberOfEvents);
+  for (auto i = 0; i < numberOfEvents; ++i)
+  {
+    const auto name = L"c:\\some\\folder\\" + std::to_wstring(i) + L".txt";
+    events.push_back(memory.Create<Event>(memory.Copy(name), nullptr, static_cast<int>(EventAction::Added), static_cast<int>(EventError::None), i, true));
+  }
+  return events;
+}
+
+TEST_P(EventsBatchBenchmark, DISABLED_PublishOneEventPerCall) {
+  const auto numberOfEvents = GetParam();
+  Arena memory;
+  const auto events = CreateBenchmarkEvents(memory, numberOfEvents);
+
+  // volatile so the calls are not inlined.
+  volatile EventCallback callback = BenchmarkEventCallback;
+  benchmarkReceivedCharacters = 0;
+  Benchmark("EventCallback", numberOfEvents, [&]
+  {
+    for (const auto& event : events)
+    {
+      callback(0, event->IsFile, event->Name, event->OldName, event->Action, event->Error, event->TimeMillisecondsUtc);
+    }
+  });
+  EXPECT_LT(0u, benchmarkReceivedCharacters);
+}
+
+TEST_P(EventsBatchBenchmark, DISABLED_PublishAllEventsInOneCall) {
+  const auto numberOfEvents = GetParam();
+  Arena memory;
+  const auto events = CreateBenchmarkEvents(memory, numberOfEvents);
+
+  // volatile so the call is not inlined.
+  volatile EventsBatchCallback callback = BenchmarkEventsBatchCallback;
+  benchmarkReceivedCharacters = 0;
+  EventsBatch batch;
+
+  // the first round allocates the batch, the second one re-uses it.
+  for (auto round = 0; round < 2; ++round)
+  {
+    Benchmark("EventsBatchCallback", numberOfEvents, [&]
+    {
+      batch.Build(events);
+      callback(0, batch.Records(), batch.NumberOfRecords(), batch.Names(), batch.NamesLength());
+    });
+  }
+  EXPECT_LT(0u, benchmarkReceivedCharacters);
+}
@@ -0,0 +1,149 @@
+#include "pch.h"
+
+#include <string>
+#include <vector>
+#include "../myoddweb.directorywatcher.win/utils/Arena.h"
+#include "../myoddweb.directorywatcher.win/utils/Event.h"
+#include "../myoddweb.directorywatcher.win/utils/EventAction.h"
+#include "../myoddweb.directorywatcher.win/utils/EventError.h"
+#include "../myoddweb.directorywatcher.win/utils/EventsBatch.h"
+
+using myoddweb::directorywatcher::Arena;
+using myoddweb::directorywatcher::Event;
+using myoddweb::directorywatcher::EventError;
+using myoddweb::directorywatcher::EventAction;
+using myoddweb::directorywatcher::EventsBatch;
+
+TEST(EventsBatch, EmptyBatchHasNoRecords) {
+  EventsBatch batch;
+  batch.Build({});
+  EXPECT_EQ(0, batch.NumberOfRecords());
+  EXPECT_EQ(0, batch.NamesLength());
+}
+
+TEST(EventsBatch, RecordsAreInTheSameOrderAsTheEvents) {
+  Arena memory;
+  std::vector<Event*> events;
+  events.push_back(memory.Create<Event>(memory.Copy(L"c:\\a.txt"), nullptr, static_cast<int>(EventAction::Added), static_cast<int>(EventError::None), 10, true));
+  events.push_back(memory.Create<Event>(memory.Copy(L"c:\\b"), nullptr, static_cast<int>(EventAction::Removed), static_cast<int>(EventError::Access), 20, false));
+
+  EventsBatch batch;
+  batch.Build(events);
+  ASSERT_EQ(2, batch.NumberOfRecords());
+
+  const auto* records = batch.Records();
+  EXPECT_EQ(10, records[0].DateTimeUtc);
+  EXPECT_EQ(static_cast<int>(EventAction::Added), records[0].Action);
+  EXPECT_EQ(static_cast<int>(EventError::None), records[0].Error);
+  EXPECT_EQ(1, records[0].IsFile);
+
+  EXPECT_EQ(20, records[1].DateTimeUtc);
+  EXPECT_EQ(static_cast<int>(EventAction::Removed), records[1].Action);
+  EXPECT_EQ(static_cast<int>(EventError::Access), records[1].Error);
+  EXPECT_EQ(0, records[1].IsFile);
+}
+
+TEST(EventsBatch, NamesAreInTheSharedBlock) {
+  Arena memory;
+  std::vector<Event*> events;
+  events.push_back(memory.Create<Event>(memory.Copy(L"c:\\new.txt"), memory.Copy(L"c:\\old.txt"), static_cast<int>(EventAction::Renamed), static_cast<int>(EventError::None), 0, true));
+  events.push_back(memory.Create<Event>(memory.Copy(L"c:\\other.txt"), nullptr, static_cast<int>(EventAction::Added), static_cast<int>(EventError::None), 0, true));
+
+  EventsBatch batch;
+  batch.Build(events);
+  ASSERT_EQ(2, batch.NumberOfRecords());
+
+  const auto* records = batch.Records();
+  const auto* names = batch.Names();
+  EXPECT_EQ(std::wstring(L"c:\\new.txt"), std::wstring(names + records[0].NameOffset, records[0].NameLength));
+  EXPECT_EQ(std::wstring(L"c:\\old.txt"), std::wstring(names + records[0].OldNameOffset, records[0].OldNameLength));
+  EXPECT_EQ(std::wstring(L"c:\\other.txt"), std::wstring(names + records[1].NameOffset, records[1].NameLength));
+
+  // every name is null terminated.
+  EXPECT_EQ(L'\0', names[records[0].NameOffset + records[0].NameLength]);
+  EXPECT_EQ(L'\0', names[records[0].OldNameOffset + records[0].OldNameLength]);
+  EXPECT_EQ(L'\0', names[records[1].NameOffset + records[1].NameLength]);
+
+  // 3 names and their terminators.
+  EXPECT_EQ(11 + 11 + 13, batch.NamesLength());
+}
+
+TEST(EventsBatch, MissingOldNameHasNoOffset) {
+  Arena memory;
+  std::vector<Event*> events;
+  events.push_back(memory.Create<Event>(memory.Copy(L"c:\\a.txt"), nullptr, static_cast<int>(EventAction::Added), static_cast<int>(EventError::None), 0, true));
+  events.push_back(memory.Create<Event>(memory.Copy(L"c:\\b.txt"), memory.Copy(L""), static_cast<int>(EventAction::Added), static_cast<int>(EventError::None), 0, true));
+
+  EventsBatch batch;
+  batch.Build(events);
+  ASSERT_EQ(2, batch.NumberOfRecords());
+  EXPECT_EQ(-1, batch.Records()[0].OldNameOffset);
+  EXPECT_EQ(0, batch.Records()[0].OldNameLength);
+  EXPECT_EQ(-1, batch.Records()[1].OldNameOffset);
+  EXPECT_EQ(0, batch.Records()[1].OldNameLength);
+}
+
+TEST(EventsBatch, BuildReplacesThePreviousBatch) {
+  Arena memory;
+  std::vector<Event*> events;
+  events.push_back(memory.Create<Event>(memory.Copy(L"c:\\a.txt"), nullptr, static_cast<int>(EventAction::Added), static_cast<int>(EventError::None), 0, true));
+  events.push_back(memory.Create<Event>(memory.Copy(L"c:\\b.txt"), nullptr, static_cast<int>(EventAction::Added), static_cast<int>(EventError::None), 0, true));
+
+  EventsBatch batch;
+  batch.Build(events);
+  EXPECT_EQ(2, batch.NumberOfRecords());
+
+  events.pop_back();
+  batch.Build(events);
+  ASSERT_EQ(1, batch.NumberOfRecords());
+  EXPECT_EQ(0, batch.Records()[0].NameOffset);
+  EXPECT_EQ(9, batch.NamesLength());
+}
+
+TEST(EventsBatch, CopyToStopsWhenTheEventsAreFull) {
+  Arena memory;
+  std::vector<Event*> events;
+  events.push_back(memory.Create<Event>(memory.Copy(L"c:\\a.txt"), nullptr, static_cast<int>(EventAction::Added), static_cast<int>(EventError::None), 0, true));
+  events.push_back(memory.Create<Event>(memory.Copy(L"c:\\b.txt"), nullptr, static_cast<int>(EventAction::Added), static_cast<int>(EventError::None), 0, true));
+  events.push_back(memory.Create<Event>(memory.Copy(L"c:\\c.txt"), nullptr, static_cast<int>(EventAction::Added), static_cast<int>(EventError::None), 0, true));
+
+  EventsBatch batch;
+  batch.Build(events);
+
+  myoddweb::directorywatcher::EventRecord records[2];
+  wchar_t names[100];
+  ASSERT_EQ(2, batch.CopyTo(0, records, 2, names, 100));
+  EXPECT_EQ(std::wstring(L"c:\\b.txt"), std::wstring(names + records[1].NameOffset, records[1].NameLength));
+
+  // the offsets are relative to the names we were given.
+  ASSERT_EQ(1, batch.CopyTo(2, records, 2, names, 100));
+  EXPECT_EQ(0, records[0].NameOffset);
+  EXPECT_EQ(std::wstring(L"c:\\c.txt"), std::wstring(names + records[0].NameOffset, records[0].NameLength));
+
+  // nothing left.
+  EXPECT_EQ(0, batch.CopyTo(3, records, 2, names, 100));
+}
+
+TEST(EventsBatch, CopyToStopsWhenTheNamesAreFull) {
+  Arena memory;
+  std::vector<Event*> events;
+  events.push_back(memory.Create<Event>(memory.Copy(L"c:\\new.txt"), memory.Copy(L"c:\\old.txt"), static_cast<int>(EventAction::Renamed), static_cast<int>(EventError::None), 0, true));
+  events.push_back(memory.Create<Event>(memory.Copy(L"c:\\b.txt"), nullptr, static_cast<int>(EventAction::Added), static_cast<int>(EventError::None), 0, true));
+
+  EventsBatch batch;
+  batch.Build(events);
+
+  myoddweb::directorywatcher::EventRecord records[10];
+  wchar_t names[25];
+
+  // both names of the first event fit, (22 characters), but not the second event.
+  ASSERT_EQ(1, batch.CopyTo(0, records, 10, names, 25));
+  EXPECT_EQ(std::wstring(L"c:\\old.txt"), std::wstring(names + records[0].OldNameOffset, records[0].OldNameLength));
+
+  ASSERT_EQ(1, batch.CopyTo(1, records, 10, names, 25));
+  EXPECT_EQ(0, records[0].NameOffset);
+  EXPECT_EQ(-1, records[0].OldNameOffset);
+
+  // the first event can never fit.
+  EXPECT_EQ(0, batch.CopyTo(0, records, 10, names, 10));
+}
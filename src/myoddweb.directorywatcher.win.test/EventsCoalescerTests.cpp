@@ -0,0 +1,209 @@
+#include "pch.h"
+
+#include <string>
+#include <vector>
+#include "../myoddweb.directorywatcher.win/utils/Arena.h"
+#include "../myoddweb.directorywatcher.win/utils/EventAction.h"
+#include "../myoddweb.directorywatcher.win/utils/EventError.h"
+#include "../myoddweb.directorywatcher.win/utils/EventInformation.h"
+#include "../myoddweb.directorywatcher.win/utils/EventsCoalescer.h"
+
+using myoddweb::directorywatcher::Arena;
+using myoddweb::directorywatcher::EventAction;
+using myoddweb::directorywatcher::EventError;
+using myoddweb::directorywatcher::EventInformation;
+using myoddweb::directorywatcher::EventsCoalescer;
+
+/**
+ * \brief the events of a test, each event is one ms after the previous one.
+ */
+class CoalescerEvents
+{
+public:
+  void Add(const EventAction action, const wchar_t* name, const bool isFile = true)
+  {
+    Events.push_back(Memory.Create<EventInformation>(++_time, action, EventError::None, Memory.Copy(name), L"", isFile));
+  }
+
+  void Rename(const wchar_t* oldName, const wchar_t* name)
+  {
+    Events.push_back(Memory.Create<EventInformation>(++_time, EventAction::Renamed, EventError::None, Memory.Copy(name), Memory.Copy(oldName), true));
+  }
+
+  void Coalesce()
+  {
+    EventsCoalescer coalescer;
+    coalescer.Coalesce(Events, Memory);
+  }
+
+  /**
+   * \brief check that an event has the given action and names.
+   */
+  void Expect(const size_t index, const EventAction action, const std::wstring& name, const std::wstring& oldName = L"") const
+  {
+    ASSERT_LT(index, Events.size());
+    EXPECT_EQ(action, Events[index]->Action);
+    EXPECT_EQ(name, Events[index]->Name);
+    EXPECT_EQ(oldName, Events[index]->OldName);
+  }
+
+  Arena Memory;
+  std::vector<const EventInformation*> Events;
+
+private:
+  long long _time = 0;
+};
+
+TEST(EventsCoalescer, EmptyEventsStayEmpty) {
+  CoalescerEvents events;
+  events.Coalesce();
+  EXPECT_EQ(0, events.Events.size());
+}
+
+TEST(EventsCoalescer, AddedThenRemovedCancel) {
+  CoalescerEvents events;
+  events.Add(EventAction::Added, L"a.tmp");
+  for (auto i = 0; i < 50; ++i)
+  {
+    events.Add(EventAction::Touched, L"a.tmp");
+  }
+  events.Add(EventAction::Removed, L"a.tmp");
+  events.Add(EventAction::Added, L"b.txt");
+  events.Coalesce();
+
+  ASSERT_EQ(1, events.Events.size());
+  events.Expect(0, EventAction::Added, L"b.txt");
+}
+
+TEST(EventsCoalescer, AddedThenTouchedIsAdded) {
+  CoalescerEvents events;
+  events.Add(EventAction::Added, L"a.txt");
+  events.Add(EventAction::Touched, L"a.txt");
+  events.Add(EventAction::Touched, L"a.txt");
+  events.Coalesce();
+
+  ASSERT_EQ(1, events.Events.size());
+  events.Expect(0, EventAction::Added, L"a.txt");
+  EXPECT_EQ(1, events.Events[0]->TimeMillisecondsUtc);
+}
+
+TEST(EventsCoalescer, TouchedThenRemovedIsRemoved) {
+  CoalescerEvents events;
+  events.Add(EventAction::Touched, L"a.txt");
+  events.Add(EventAction::Touched, L"a.txt");
+  events.Add(EventAction::Removed, L"a.txt");
+  events.Coalesce();
+
+  ASSERT_EQ(1, events.Events.size());
+  events.Expect(0, EventAction::Removed, L"a.txt");
+}
+
+TEST(EventsCoalescer, RemovedThenAddedAreBothKept) {
+  CoalescerEvents events;
+  events.Add(EventAction::Removed, L"a.txt");
+  events.Add(EventAction::Added, L"a.txt");
+  events.Add(EventAction::Touched, L"a.txt");
+  events.Coalesce();
+
+  ASSERT_EQ(2, events.Events.size());
+  events.Expect(0, EventAction::Removed, L"a.txt");
+  events.Expect(1, EventAction::Added, L"a.txt");
+}
+
+TEST(EventsCoalescer, RemovedAddedRemovedIsRemoved) {
+  CoalescerEvents events;
+  events.Add(EventAction::Removed, L"a.txt");
+  events.Add(EventAction::Added, L"a.txt");
+  events.Add(EventAction::Removed, L"a.txt");
+  events.Coalesce();
+
+  ASSERT_EQ(1, events.Events.size());
+  events.Expect(0, EventAction::Removed, L"a.txt");
+}
+
+TEST(EventsCoalescer, RenameChainsAreJoined) {
+  CoalescerEvents events;
+  events.Rename(L"a.txt", L"b.txt");
+  events.Rename(L"b.txt", L"c.txt");
+  events.Rename(L"c.txt", L"d.txt");
+  events.Coalesce();
+
+  ASSERT_EQ(1, events.Events.size());
+  events.Expect(0, EventAction::Renamed, L"d.txt", L"a.txt");
+  EXPECT_EQ(3, events.Events[0]->TimeMillisecondsUtc);
+}
+
+TEST(EventsCoalescer, RenamedBackCancels) {
+  CoalescerEvents events;
+  events.Rename(L"a.txt", L"b.txt");
+  events.Rename(L"b.txt", L"a.txt");
+  events.Coalesce();
+
+  EXPECT_EQ(0, events.Events.size());
+}
+
+TEST(EventsCoalescer, AddedThenRenamedIsAddedWithTheNewName) {
+  CoalescerEvents events;
+  events.Add(EventAction::Added, L"a.tmp");
+  events.Rename(L"a.tmp", L"a.txt");
+  events.Coalesce();
+
+  ASSERT_EQ(1, events.Events.size());
+  events.Expect(0, EventAction::Added, L"a.txt");
+}
+
+TEST(EventsCoalescer, RenamedThenRemovedRemovesTheOldName) {
+  CoalescerEvents events;
+  events.Rename(L"a.txt", L"b.txt");
+  events.Add(EventAction::Touched, L"b.txt");
+  events.Add(EventAction::Removed, L"b.txt");
+  events.Coalesce();
+
+  ASSERT_EQ(1, events.Events.size());
+  events.Expect(0, EventAction::Removed, L"a.txt");
+}
+
+TEST(EventsCoalescer, TouchedAfterARenameIsKept) {
+  CoalescerEvents events;
+  events.Rename(L"a.txt", L"b.txt");
+  events.Add(EventAction::Touched, L"b.txt");
+  events.Coalesce();
+
+  ASSERT_EQ(2, events.Events.size());
+  events.Expect(0, EventAction::Renamed, L"b.txt", L"a.txt");
+  events.Expect(1, EventAction::Touched, L"b.txt");
+}
+
+TEST(EventsCoalescer, FilesAndFoldersAreNotCombined) {
+  CoalescerEvents events;
+  events.Add(EventAction::Added, L"foo", true);
+  events.Add(EventAction::Removed, L"foo", false);
+  events.Coalesce();
+
+  EXPECT_EQ(2, events.Events.size());
+}
+
+TEST(EventsCoalescer, ErrorsAreNeverCombined) {
+  CoalescerEvents events;
+  events.Add(EventAction::Added, L"a.txt");
+  events.Events.push_back(events.Memory.Create<EventInformation>(2, EventAction::Removed, EventError::Overflow, events.Memory.Copy(L"a.txt"), L"", true));
+  events.Coalesce();
+
+  ASSERT_EQ(2, events.Events.size());
+  EXPECT_EQ(EventError::Overflow, events.Events[1]->Error);
+}
+
+TEST(EventsCoalescer, OtherPathsKeepTheirOrder) {
+  CoalescerEvents events;
+  events.Add(EventAction::Touched, L"a.txt");
+  events.Add(EventAction::Added, L"b.tmp");
+  events.Add(EventAction::Touched, L"c.txt");
+  events.Add(EventAction::Removed, L"b.tmp");
+  events.Add(EventAction::Added, L"d.txt");
+  events.Coalesce();
+
+  ASSERT_EQ(3, events.Events.size());
+  events.Expect(0, EventAction::Touched, L"a.txt");
+  events.Expect(1, EventAction::Touched, L"c.txt");
+  events.Expect(2, EventAction::Added, L"d.txt");
+}
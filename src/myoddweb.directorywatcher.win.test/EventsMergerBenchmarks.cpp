@@ -0,0 +1,75 @@
+#include "pch.h"
+
+#include <algorithm>
+#include <vector>
+#include "../myoddweb.directorywatcher.win/utils/Collector.h"
+#include "../myoddweb.directorywatcher.win/utils/Event.h"
+#include "../myoddweb.directorywatcher.win/utils/EventsMerger.h"
+#include "BenchmarkHelper.h"
+
+using myoddweb::directorywatcher::Collector;
+using myoddweb::directorywatcher::Event;
+using myoddweb::directorywatcher::EventsMerger;
+
+// the total number of events, shared by all the children.
+constexpr auto BenchmarkNumberOfEvents = 200000;
+
+class EventsMergerBenchmark :public ::testing::TestWithParam<int> {};
+INSTANTIATE_TEST_SUITE_P(
+  EventsMergerBenchmarks,
+  EventsMergerBenchmark,
+  ::testing::Values(10, 100, 1000, 20000)
+);
+
+/**
+ * \brief create the events of all the children, one run per child, each run in time order.
+ * \param numberOfChildren the number of children.
+ * \param storage the memory of the events.
+ * \param runs the index of the first event of each child.
+ * \return the events, one run after the other.
+ */
+static std::vector<Event*> CreateBenchmarkRuns(const int numberOfChildren, std::vector<Event>& storage, std::vector<size_t>& runs)
+{
+  storage = std::vector<Event>(BenchmarkNumberOfEvents);
+  runs.clear();
+
+  std::vector<Event*> events;
+  events.reserve(BenchmarkNumberOfEvents);
+  const auto eventsPerChild = BenchmarkNumberOfEvents / numberOfChildren;
+  for (auto child = 0; child < numberOfChildren; ++child)
+  {
+    runs.push_back(events.size());
+    for (auto i = 0; i < eventsPerChild; ++i)
+    {
+      // the children's events are spread over the same period of time
+      // with a lot of them in the same ms.
+      auto& event = storage[events.size()];
+      event.TimeMillisecondsUtc = (static_cast<long long>(i) * numberOfChildren + child) / 16;
+      events.push_back(&event);
+    }
+  }
+  return events;
+}
+
+TEST_P(EventsMergerBenchmark, DISABLED_SortEverything) {
+  std::vector<Event> storage;
+  std::vector<size_t> runs;
+  auto events = CreateBenchmarkRuns(GetParam(), storage, runs);
+  Benchmark("SortEverything", static_cast<long long>(events.size()), [&]
+  {
+    std::sort(events.begin(), events.end(), Collector::SortByTimeMillisecondsUtc);
+  });
+  EXPECT_TRUE(std::is_sorted(events.begin(), events.end(), Collector::SortByTimeMillisecondsUtc));
+}
+
+TEST_P(EventsMergerBenchmark, DISABLED_MergeRuns) {
+  std::vector<Event> storage;
+  std::vector<size_t> runs;
+  auto events = CreateBenchmarkRuns(GetParam(), storage, runs);
+  EventsMerger merger;
+  Benchmark("MergeRuns", static_cast<long long>(events.size()), [&]
+  {
+    merger.Merge(events, runs);
+  });
+  EXPECT_TRUE(std::is_sorted(events.begin(), events.end(), Collector::SortByTimeMillisecondsUtc));
+}
@@ -0,0 +1,178 @@
+#include "pch.h"
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+#include "../myoddweb.directorywatcher.win/utils/Collector.h"
+#include "../myoddweb.directorywatcher.win/utils/Event.h"
+#include "../myoddweb.directorywatcher.win/utils/EventsMerger.h"
+
+using myoddweb::directorywatcher::Collector;
+using myoddweb::directorywatcher::Event;
+using myoddweb::directorywatcher::EventsMerger;
+
+/**
+ * \brief the events of a test, they own the memory.
+ */
+class MergerEvents
+{
+public:
+  /**
+   * \brief start a new run of events.
+   */
+  void StartRun()
+  {
+    Runs.push_back(Events.size());
+  }
+
+  /**
+   * \brief add an event to the current run.
+   * \param time the time of the event.
+   * \param action used to tell the events apart.
+   */
+  void Add(const long long time, const int action)
+  {
+    _events.emplace_back(new Event(nullptr, nullptr, action, 0, time, true));
+    Events.push_back(_events.back().get());
+  }
+
+  std::vector<Event*> Events;
+  std::vector<size_t> Runs;
+
+private:
+  std::vector<std::unique_ptr<Event>> _events;
+};
+
+TEST(EventsMerger, RunsAreMergedByTime) {
+  MergerEvents e;
+  e.StartRun();
+  e.Add(1, 1);
+  e.Add(4, 4);
+  e.Add(7, 7);
+  e.StartRun();
+  e.Add(2, 2);
+  e.Add(5, 5);
+  e.StartRun();
+  e.Add(3, 3);
+  e.Add(6, 6);
+  e.Add(8, 8);
+
+  EventsMerger merger;
+  merger.Merge(e.Events, e.Runs);
+  ASSERT_EQ(8u, e.Events.size());
+  for (auto i = 0; i < 8; ++i)
+  {
+    EXPECT_EQ(i + 1, e.Events[i]->Action);
+  }
+}
+
+TEST(EventsMerger, SameTimeKeepsTheOrderOfTheRuns) {
+  MergerEvents e;
+  e.StartRun();
+  e.Add(1, 10);
+  e.Add(1, 11);
+  e.StartRun();
+  e.Add(0, 20);
+  e.Add(1, 21);
+  e.Add(1, 22);
+
+  EventsMerger merger;
+  merger.Merge(e.Events, e.Runs);
+  const std::vector<int> expected = { 20, 10, 11, 21, 22 };
+  for (size_t i = 0; i < expected.size(); ++i)
+  {
+    EXPECT_EQ(expected[i], e.Events[i]->Action);
+  }
+}
+
+TEST(EventsMerger, EmptyRunsAreIgnored) {
+  MergerEvents e;
+  e.StartRun();
+  e.StartRun();
+  e.Add(2, 2);
+  e.StartRun();
+  e.StartRun();
+  e.Add(1, 1);
+  e.StartRun();
+
+  EventsMerger merger;
+  merger.Merge(e.Events, e.Runs);
+  ASSERT_EQ(2u, e.Events.size());
+  EXPECT_EQ(1, e.Events[0]->Action);
+  EXPECT_EQ(2, e.Events[1]->Action);
+}
+
+TEST(EventsMerger, UnorderedRunIsSortedFirst) {
+  MergerEvents e;
+  e.StartRun();
+  e.Add(3, 3);
+  e.Add(1, 1);
+  e.StartRun();
+  e.Add(2, 2);
+
+  EventsMerger merger;
+  merger.Merge(e.Events, e.Runs);
+  for (auto i = 0; i < 3; ++i)
+  {
+    EXPECT_EQ(i + 1, e.Events[i]->Action);
+  }
+}
+
+TEST(EventsMerger, EventsBeforeTheFirstRunAreNotMoved) {
+  MergerEvents e;
+  e.Add(9, 9);
+  e.StartRun();
+  e.Add(2, 2);
+  e.StartRun();
+  e.Add(1, 1);
+
+  EventsMerger merger;
+  merger.Merge(e.Events, e.Runs);
+  EXPECT_EQ(9, e.Events[0]->Action);
+  EXPECT_EQ(1, e.Events[1]->Action);
+  EXPECT_EQ(2, e.Events[2]->Action);
+}
+
+TEST(EventsMerger, MergerCanBeReused) {
+  EventsMerger merger;
+  for (auto i = 0; i < 3; ++i)
+  {
+    MergerEvents e;
+    e.StartRun();
+    e.Add(2, 2);
+    e.StartRun();
+    e.Add(1, 1);
+    merger.Merge(e.Events, e.Runs);
+    EXPECT_EQ(1, e.Events[0]->Action);
+    EXPECT_EQ(2, e.Events[1]->Action);
+  }
+}
+
+TEST(EventsMerger, SameAsAStableSort) {
+  std::mt19937 random(42);
+  for (auto test = 0; test < 20; ++test)
+  {
+    MergerEvents e;
+    const auto numberOfRuns = 1 + static_cast<int>(random() % 50);
+    for (auto run = 0; run < numberOfRuns; ++run)
+    {
+      e.StartRun();
+      auto time = static_cast<long long>(random() % 10);
+      const auto numberOfEvents = static_cast<int>(random() % 20);
+      for (auto i = 0; i < numberOfEvents; ++i)
+      {
+        // a lot of events in the same ms.
+        time += static_cast<long long>(random() % 3);
+        e.Add(time, static_cast<int>(e.Events.size()));
+      }
+    }
+
+    auto expected = e.Events;
+    std::stable_sort(expected.begin(), expected.end(), Collector::SortByTimeMillisecondsUtc);
+
+    EventsMerger merger;
+    merger.Merge(e.Events, e.Runs);
+    EXPECT_EQ(expected, e.Events);
+  }
+}
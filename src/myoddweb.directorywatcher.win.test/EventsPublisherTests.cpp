@@ -0,0 +1,129 @@
+#include "pch.h"
+
+#include <atomic>
+#include <vector>
+#include "../myoddweb.directorywatcher.win/monitors/Base.h"
+#include "../myoddweb.directorywatcher.win/monitors/Monitor.h"
+#include "../myoddweb.directorywatcher.win/utils/EventAction.h"
+#include "../myoddweb.directorywatcher.win/utils/Threads/WorkerPool.h"
+#include "../myoddweb.directorywatcher.win/utils/Wait.h"
+#include "MonitorsManagerTestHelper.h"
+#include "RequestTestHelper.h"
+
+using myoddweb::directorywatcher::Arena;
+using myoddweb::directorywatcher::Event;
+using myoddweb::directorywatcher::EventRecord;
+using myoddweb::directorywatcher::Monitor;
+using myoddweb::directorywatcher::MonitorStatistics;
+using myoddweb::directorywatcher::Wait;
+using myoddweb::directorywatcher::threads::WorkerPool;
+
+/**
+ * \brief a monitor that does not watch anything, the events are added by the test.
+ */
+class PublisherTestMonitor final : public Monitor
+{
+public:
+  PublisherTestMonitor(myoddweb::directorywatcher::threads::WorkerPool& pool, const Request& request) :
+    Monitor(42, pool, request)
+  {
+  }
+
+protected:
+  void OnGetEvents(std::vector<Event*>&, Arena&) override
+  {
+  }
+
+  const long long& ParentId() const override
+  {
+    return _id;
+  }
+};
+
+static std::atomic<bool> publisherTestRelease(true);
+static std::atomic<int> publisherTestCallbacks(0);
+static std::atomic<int> publisherTestEvents(0);
+
+void __stdcall PublisherTestSlowCallback(long long, const EventRecord*, const int numberOfEvents, const wchar_t*, int)
+{
+  ++publisherTestCallbacks;
+  while (!publisherTestRelease)
+  {
+    std::this_thread::yield();
+  }
+  publisherTestEvents += numberOfEvents;
+}
+
+TEST(EventsPublisher, SlowCallbackDoesNotStopTheCollection) {
+  publisherTestRelease = false;
+  publisherTestCallbacks = 0;
+  publisherTestEvents = 0;
+
+  WorkerPool pool(10);
+  const auto request = RequestHelper(L"c:\\", false, nullptr, nullptr, nullptr, 10, 0, PublisherTestSlowCallback);
+  PublisherTestMonitor monitor(pool, request);
+  pool.Add(monitor);
+  ASSERT_TRUE(Wait::SpinUntil([&] { return monitor.Started(); }, TEST_TIMEOUT_WAIT));
+
+  // the first window is stuck in the callback.
+  monitor.AddEvent(EventAction::Added, L"a.txt", true);
+  monitor.Wake();
+  ASSERT_TRUE(Wait::SpinUntil([] { return publisherTestCallbacks == 1; }, TEST_TIMEOUT_WAIT));
+
+  // but the monitor is still updated, so the next window is collected and queued.
+  monitor.AddEvent(EventAction::Added, L"b.txt", true);
+  monitor.Wake();
+  EXPECT_TRUE(Wait::SpinUntil([&]
+  {
+    MonitorStatistics statistics{};
+    monitor.GetStatistics(statistics);
+    return !monitor.HasEvents() && statistics.QueueDepth == 1;
+  }, TEST_TIMEOUT_WAIT));
+
+  // once the host catches up everything is delivered.
+  publisherTestRelease = true;
+  EXPECT_TRUE(Wait::SpinUntil([] { return publisherTestEvents == 2; }, TEST_TIMEOUT_WAIT));
+
+  MonitorStatistics statistics{};
+  monitor.GetStatistics(statistics);
+  EXPECT_EQ(static_cast<int>(sizeof(MonitorStatistics)), statistics.Size);
+  EXPECT_EQ(2, statistics.NumberOfEvents);
+  EXPECT_EQ(0, statistics.NumberOfDroppedEvents);
+  EXPECT_EQ(0, statistics.QueueDepth);
+  EXPECT_EQ(1, statistics.MaxQueueDepth);
+  EXPECT_EQ(2, statistics.NumberOfCallbacks);
+
+  pool.StopAndWait(monitor, TEST_TIMEOUT_WAIT);
+}
+
+TEST(EventsPublisher, OldestWindowIsDroppedWhenTheQueueIsFull) {
+  publisherTestRelease = false;
+  publisherTestCallbacks = 0;
+  publisherTestEvents = 0;
+
+  WorkerPool pool(10);
+  const auto request = RequestHelper(L"c:\\", false, nullptr, nullptr, nullptr, 10, 0, PublisherTestSlowCallback);
+  PublisherTestMonitor monitor(pool, request);
+  pool.Add(monitor);
+  ASSERT_TRUE(Wait::SpinUntil([&] { return monitor.Started(); }, TEST_TIMEOUT_WAIT));
+
+  monitor.AddEvent(EventAction::Added, L"first.txt", true);
+  monitor.Wake();
+  ASSERT_TRUE(Wait::SpinUntil([] { return publisherTestCallbacks == 1; }, TEST_TIMEOUT_WAIT));
+
+  // fill the queue, one window at a time, and then one more.
+  for (auto i = 0; i <= myoddweb::directorywatcher::MYODDWEB_PUBLISHER_MAX_PENDING_WINDOWS; ++i)
+  {
+    monitor.AddEvent(EventAction::Added, std::to_wstring(i) + L".txt", true);
+    monitor.Wake();
+    ASSERT_TRUE(Wait::SpinUntil([&] { return !monitor.HasEvents(); }, TEST_TIMEOUT_WAIT));
+  }
+
+  MonitorStatistics statistics{};
+  monitor.GetStatistics(statistics);
+  EXPECT_LE(1, statistics.NumberOfDroppedEvents);
+  EXPECT_EQ(myoddweb::directorywatcher::MYODDWEB_PUBLISHER_MAX_PENDING_WINDOWS, statistics.MaxQueueDepth);
+
+  publisherTestRelease = true;
+  pool.StopAndWait(monitor, TEST_TIMEOUT_WAIT);
+}
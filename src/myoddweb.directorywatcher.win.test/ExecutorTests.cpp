@@ -0,0 +1,85 @@
+#include "pch.h"
+
+#include <atomic>
+#include <thread>
+#include "../myoddweb.directorywatcher.win/utils/Threads/Executor.h"
+#include "../myoddweb.directorywatcher.win/utils/Wait.h"
+#include "MonitorsManagerTestHelper.h"
+
+using myoddweb::directorywatcher::threads::Executor;
+using myoddweb::directorywatcher::Wait;
+
+TEST(Executor, NumberOfThreads) {
+  const Executor executor(3);
+  EXPECT_EQ(3, executor.NumberOfThreads());
+}
+
+TEST(Executor, ZeroThreadsUsesAtLeastOneThread) {
+  const Executor executor(0);
+  EXPECT_LE(1, executor.NumberOfThreads());
+}
+
+TEST(Executor, AllTasksAreRun) {
+  std::atomic<int> count(0);
+  {
+    Executor executor(4);
+    for (auto i = 0; i < 1000; ++i)
+    {
+      EXPECT_TRUE(executor.Post([&count] { ++count; }));
+    }
+
+    EXPECT_TRUE(Wait::SpinUntil([&count] { return count == 1000; }, TEST_TIMEOUT_WAIT));
+  }
+  EXPECT_EQ(1000, count);
+}
+
+TEST(Executor, StopRunsTheQueuedTasks) {
+  std::atomic<int> count(0);
+  Executor executor(2);
+  for (auto i = 0; i < 100; ++i)
+  {
+    executor.Post([&count] { ++count; });
+  }
+  executor.Stop();
+  EXPECT_EQ(100, count);
+}
+
+TEST(Executor, CannotPostOnceStopped) {
+  auto called = false;
+  Executor executor(2);
+  executor.Stop();
+  EXPECT_FALSE(executor.Post([&called] { called = true; }));
+  EXPECT_FALSE(called);
+}
+
+TEST(Executor, ExceptionsDoNotStopTheThreads) {
+  std::atomic<int> count(0);
+  Executor executor(1);
+  executor.Post([] { throw std::runtime_error("Bad task"); });
+  executor.Post([&count] { ++count; });
+  executor.Stop();
+  EXPECT_EQ(1, count);
+}
+
+TEST(Executor, IdleThreadsStealTheWork) {
+  std::atomic<bool> release(false);
+  std::atomic<int> count(0);
+  Executor executor(2);
+
+  // the tasks posted by the busy task are queued on its own thread
+  // so the only way they can complete is if the other thread steals them.
+  executor.Post([&executor, &release, &count]
+  {
+    for (auto i = 0; i < 10; ++i)
+    {
+      executor.Post([&count] { ++count; });
+    }
+    while (!release)
+    {
+      std::this_thread::yield();
+    }
+  });
+
+  EXPECT_TRUE(Wait::SpinUntil([&count] { return count == 10; }, TEST_TIMEOUT_WAIT));
+  release = true;
+}
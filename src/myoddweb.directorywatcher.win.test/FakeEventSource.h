@@ -0,0 +1,63 @@
+#pragma once
+#include <cstring>
+#include "../myoddweb.directorywatcher.win/monitors/EventSource.h"
+
+using myoddweb::directorywatcher::BufferSizePolicy;
+using myoddweb::directorywatcher::EventSource;
+
+/**
+ * \brief an event source that reads from memory rather than from the file system.
+ *        Like inotify it only reads when it is told that some data is available.
+ */
+class FakeEventSource final : public EventSource
+{
+public:
+  explicit FakeEventSource(BufferSizePolicy& bufferSize) :
+    EventSource(bufferSize)
+  {
+  }
+
+  using EventSource::BeginRead;
+  using EventSource::ReadLength;
+  using EventSource::CompleteRead;
+  using EventSource::CancelRead;
+
+  bool Start() override
+  {
+    _started = true;
+    return true;
+  }
+
+  void Stop() override
+  {
+    _started = false;
+    ReleaseBuffers();
+  }
+
+  /**
+   * \brief some data is available, read it the way a real source would.
+   * \param data the data we are reading.
+   * \param length the number of bytes.
+   * \return if the data could be read, false if it was more than the buffer could hold.
+   */
+  bool Receive(const unsigned char* data, const unsigned long length)
+  {
+    if (!_started)
+    {
+      return false;
+    }
+
+    const auto buffer = BeginRead();
+    if (length > ReadLength())
+    {
+      CancelRead();
+      OverflowRead();
+      return false;
+    }
+    std::memcpy(buffer, data, length);
+    return CompleteRead(length);
+  }
+
+private:
+  bool _started = false;
+};
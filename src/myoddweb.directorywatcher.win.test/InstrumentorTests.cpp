@@ -0,0 +1,111 @@
+#include "pch.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../myoddweb.directorywatcher.win/utils/Instrumentor.h"
+
+using myoddweb::directorywatcher::Instrumentor;
+using myoddweb::directorywatcher::InstrumentationTimer;
+
+/**
+ * \brief where the test traces are written.
+ */
+static std::filesystem::path TracePath()
+{
+  return std::filesystem::temp_directory_path() / "myoddweb.directorywatcher.profile.json";
+}
+
+/**
+ * \brief read the whole trace.
+ */
+static std::string ReadTrace()
+{
+  std::ifstream file(TracePath());
+  std::stringstream content;
+  content << file.rdbuf();
+  return content.str();
+}
+
+/**
+ * \brief count the number of times a scope was written to the trace.
+ */
+static int CountScopes(const std::string& trace, const std::string& name)
+{
+  auto count = 0;
+  const auto needle = "\"name\":\"" + name + "\"";
+  for (auto position = trace.find(needle); position != std::string::npos; position = trace.find(needle, position + 1))
+  {
+    ++count;
+  }
+  return count;
+}
+
+static void RunScopes(const char* name, const int numberOfScopes)
+{
+  for (auto i = 0; i < numberOfScopes; ++i)
+  {
+    InstrumentationTimer timer(name);
+  }
+}
+
+TEST(Instrumentor, NothingIsRecordedWithoutASession) {
+  EXPECT_FALSE(Instrumentor::Get().IsEnabled());
+  EXPECT_EQ(nullptr, Instrumentor::Get().BeginScope());
+}
+
+TEST(Instrumentor, SessionWritesTheScopesOfAllTheThreads) {
+  ASSERT_TRUE(Instrumentor::Get().BeginSession(TracePath().string()));
+  EXPECT_TRUE(Instrumentor::Get().IsEnabled());
+
+  std::vector<std::thread> threads;
+  for (auto i = 0; i < 4; ++i)
+  {
+    threads.emplace_back([] { RunScopes("AllTheThreads", 100); });
+  }
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+  Instrumentor::Get().EndSession();
+  EXPECT_FALSE(Instrumentor::Get().IsEnabled());
+
+  const auto trace = ReadTrace();
+  EXPECT_EQ(0, trace.find("{\"otherData\": {},\"traceEvents\":["));
+  EXPECT_EQ(trace.size() - 2, trace.rfind("]}"));
+  EXPECT_EQ(400, CountScopes(trace, "AllTheThreads"));
+  std::filesystem::remove(TracePath());
+}
+
+TEST(Instrumentor, OnlyOneScopeInEverySampleIsRecorded) {
+  ASSERT_TRUE(Instrumentor::Get().BeginSession(TracePath().string(), 10));
+  std::thread thread([] { RunScopes("Sampled", 100); });
+  thread.join();
+  Instrumentor::Get().EndSession();
+
+  EXPECT_EQ(10, CountScopes(ReadTrace(), "Sampled"));
+  std::filesystem::remove(TracePath());
+}
+
+TEST(Instrumentor, ScopesOutsideTheSessionAreNotRecorded) {
+  RunScopes("BeforeTheSession", 10);
+  ASSERT_TRUE(Instrumentor::Get().BeginSession(TracePath().string()));
+  RunScopes("DuringTheSession", 10);
+  Instrumentor::Get().EndSession();
+  RunScopes("AfterTheSession", 10);
+
+  const auto trace = ReadTrace();
+  EXPECT_EQ(0, CountScopes(trace, "BeforeTheSession"));
+  EXPECT_EQ(10, CountScopes(trace, "DuringTheSession"));
+  EXPECT_EQ(0, CountScopes(trace, "AfterTheSession"));
+  std::filesystem::remove(TracePath());
+}
+
+TEST(Instrumentor, SessionCannotStartIfTheFileCannotBeCreated) {
+  const auto path = std::filesystem::temp_directory_path() / "myoddweb.directorywatcher.missing" / "profile.json";
+  EXPECT_FALSE(Instrumentor::Get().BeginSession(path.string()));
+  EXPECT_FALSE(Instrumentor::Get().IsEnabled());
+}
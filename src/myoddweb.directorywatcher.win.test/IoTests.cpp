@@ -11,6 +11,7 @@ TEST(Io, CombineEmptyStrings) {
   ASSERT_STREQ(expected, actual.c_str());
 }
 
+#if defined(_WIN32)
 TEST(Io, CombineEmptyRhsWithNoBackSlash) {
   const auto lhs = L"c:\\foo";
   const auto rhs = L"";
@@ -171,6 +172,116 @@ TEST(Io, CombineWithMultipleWindowsAndNonWindowsEndingBackSlash) {
   ASSERT_STREQ(expected, actual.c_str());
 }
 
+#else
+TEST(Io, CombineEmptyRhsWithNoSlash) {
+  const auto lhs = L"/foo";
+  const auto rhs = L"";
+  const auto expected = L"/foo/";
+  const auto actual = ::Io::Combine(lhs, rhs);
+  ASSERT_STREQ(expected, actual.c_str());
+}
+
+TEST(Io, CombineEmptyRhsWithSlash) {
+  const auto lhs = L"/foo/";
+  const auto rhs = L"";
+  const auto expected = L"/foo/";
+  const auto actual = ::Io::Combine(lhs, rhs);
+  ASSERT_STREQ(expected, actual.c_str());
+}
+
+TEST(Io, CombineEmptyLhsWithNoSlash) {
+  const auto lhs = L"";
+  const auto rhs = L"bar";
+  const auto expected = L"/bar";
+  const auto actual = ::Io::Combine(lhs, rhs);
+  ASSERT_STREQ(expected, actual.c_str());
+}
+
+TEST(Io, CombineEmptyLhsWithSlash) {
+  const auto lhs = L"";
+  const auto rhs = L"/bar";
+  const auto expected = L"/bar";
+  const auto actual = ::Io::Combine(lhs, rhs);
+  ASSERT_STREQ(expected, actual.c_str());
+}
+
+TEST(Io, CombineWithRoot) {
+  const auto lhs = L"/";
+  const auto rhs = L"foo/bar.txt";
+  const auto expected = L"/foo/bar.txt";
+  const auto actual = ::Io::Combine(lhs, rhs);
+  ASSERT_STREQ(expected, actual.c_str());
+}
+
+TEST(Io, CombineWithNoSlash) {
+  const auto lhs = L"/foo";
+  const auto rhs = L"bar.txt";
+  const auto expected = L"/foo/bar.txt";
+  const auto actual = ::Io::Combine(lhs, rhs);
+  ASSERT_STREQ(expected, actual.c_str());
+}
+
+TEST(Io, CombineWithEndingSlash) {
+  const auto lhs = L"/foo/";
+  const auto rhs = L"bar.txt";
+  const auto expected = L"/foo/bar.txt";
+  const auto actual = ::Io::Combine(lhs, rhs);
+  ASSERT_STREQ(expected, actual.c_str());
+}
+
+TEST(Io, CombineWithStartingSlash) {
+  const auto lhs = L"/foo";
+  const auto rhs = L"/bar.txt";
+  const auto expected = L"/foo/bar.txt";
+  const auto actual = ::Io::Combine(lhs, rhs);
+  ASSERT_STREQ(expected, actual.c_str());
+}
+
+TEST(Io, CombineWithEndingAndStartingSlash) {
+  const auto lhs = L"/foo/";
+  const auto rhs = L"/bar/baz.txt";
+  const auto expected = L"/foo/bar/baz.txt";
+  const auto actual = ::Io::Combine(lhs, rhs);
+  ASSERT_STREQ(expected, actual.c_str());
+}
+
+TEST(Io, CombineWithMultipleEndingAndStartingSlash) {
+  const auto lhs = L"/foo///";
+  const auto rhs = L"///bar.txt";
+  const auto expected = L"/foo/bar.txt";
+  const auto actual = ::Io::Combine(lhs, rhs);
+  ASSERT_STREQ(expected, actual.c_str());
+}
+
+TEST(Io, CombineWithWindowsEndingAndStartingBackSlash) {
+  const auto lhs = L"/foo\\";
+  const auto rhs = L"\\bar.txt";
+  const auto expected = L"/foo/bar.txt";
+  const auto actual = ::Io::Combine(lhs, rhs);
+  ASSERT_STREQ(expected, actual.c_str());
+}
+
+#endif
+
+TEST(Io, CombineInBufferGivesSameResultAsCombine) {
+  const auto lhs = L"c:\\foo\\//";
+  const auto rhs = L"/\\bar.txt";
+  const auto expected = ::Io::Combine(lhs, rhs);
+  const auto length = ::Io::CombineLength(lhs, rhs);
+  ASSERT_EQ(expected.length(), length);
+
+  std::wstring actual(length + 1, L'x');
+  ASSERT_EQ(length, ::Io::Combine(actual.data(), lhs, rhs));
+  ASSERT_STREQ(expected.c_str(), actual.c_str());
+}
+
+TEST(Io, CombineInBufferEmptyStrings) {
+  wchar_t actual[] = L"x";
+  ASSERT_EQ(0, ::Io::CombineLength(L"", L"\\"));
+  ASSERT_EQ(0, ::Io::Combine(actual, L"", L"\\"));
+  ASSERT_STREQ(L"", actual);
+}
+
 TEST(Io, RootFoldersAreSame) {
   const auto lhs = L"c:\\";
   const auto rhs = L"c:\\";
@@ -278,3 +389,27 @@ TEST(Io, FoldersWithLhsHasMultipleForwardSlash) {
   const auto rhs = L"c:\\foo";
   ASSERT_TRUE(::Io::AreSameFolders(lhs, rhs));
 }
+
+TEST(Io, FoldersAreSameCaseCompareLhsUpper) {
+  const auto lhs = L"C:\\FOO";
+  const auto rhs = L"c:\\foo";
+  ASSERT_TRUE(::Io::AreSameFolders(lhs, rhs));
+}
+
+TEST(Io, NormalizeFolderTidiesTheSeparators) {
+#if defined(_WIN32)
+  ASSERT_EQ(L"c:\\foo\\bar", ::Io::NormalizeFolder(L"C:/Foo//Bar\\\\"));
+#else
+  ASSERT_EQ(L"c:/foo/bar", ::Io::NormalizeFolder(L"C:/Foo//Bar\\\\"));
+#endif
+}
+
+TEST(Io, NormalizeFolderOfRoot) {
+  ASSERT_EQ(L"c:", ::Io::NormalizeFolder(L"c:\\"));
+  ASSERT_EQ(L"", ::Io::NormalizeFolder(L""));
+}
+
+TEST(Io, NormalizedSameFoldersAreEqual) {
+  ASSERT_EQ(::Io::NormalizeFolder(L"c:/foo/"), ::Io::NormalizeFolder(L"C:\\FOO"));
+  ASSERT_NE(::Io::NormalizeFolder(L"c:\\foo"), ::Io::NormalizeFolder(L"c:\\foobar"));
+}
@@ -0,0 +1,192 @@
+#include "pch.h"
+#if defined(__linux__)
+#include <cstdio>
+#include <cstdlib>
+#include <cwchar>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../myoddweb.directorywatcher.win/monitors/LinuxMonitor.h"
+#include "../myoddweb.directorywatcher.win/utils/Arena.h"
+#include "../myoddweb.directorywatcher.win/utils/Event.h"
+#include "../myoddweb.directorywatcher.win/utils/EventAction.h"
+#include "../myoddweb.directorywatcher.win/utils/Io.h"
+#include "../myoddweb.directorywatcher.win/utils/Threads/WorkerPool.h"
+#include "../myoddweb.directorywatcher.win/utils/Wait.h"
+#include "RequestTestHelper.h"
+
+using myoddweb::directorywatcher::Arena;
+using myoddweb::directorywatcher::Event;
+using myoddweb::directorywatcher::EventAction;
+using myoddweb::directorywatcher::Io;
+using myoddweb::directorywatcher::LinuxMonitor;
+using myoddweb::directorywatcher::Wait;
+using myoddweb::directorywatcher::threads::WorkerPool;
+
+constexpr auto LinuxMonitorTimeoutWait = 5000;
+
+/**
+ * \brief a temp folder with a monitor watching it, the folder is removed when we are done.
+ */
+class LinuxMonitorTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    char folder[] = "/tmp/myoddweb.directorywatcher.XXXXXX";
+    ASSERT_NE(nullptr, mkdtemp(folder));
+    _folder = folder;
+    ASSERT_EQ(0, mkdir(Path("sub").c_str(), 0700));
+
+    _pool = new WorkerPool(10);
+    // there are no callbacks so the events are kept for the host to get them.
+    _request = new RequestHelper(Io::FromUtf8(_folder).c_str(), true, nullptr, nullptr, nullptr, LinuxMonitorTimeoutWait, 0);
+    _monitor = new LinuxMonitor(1, *_pool, *_request);
+    _pool->Add(*_monitor);
+    ASSERT_TRUE(Wait::SpinUntil([&] { return _monitor->Started(); }, LinuxMonitorTimeoutWait));
+
+    // the monitor is started before all the watches are added, so we wait for the sub folder to be watched.
+    ASSERT_TRUE(Wait::SpinUntil([&]
+    {
+      Touch(Path("sub/ready.txt"));
+      return WaitForEvent(EventAction::Touched, Name("sub/ready.txt"), nullptr, 10);
+    }, LinuxMonitorTimeoutWait));
+  }
+
+  void TearDown() override
+  {
+    if (_pool != nullptr)
+    {
+      _pool->StopAndWait(*_monitor, LinuxMonitorTimeoutWait);
+    }
+    delete _monitor;
+    delete _request;
+    delete _pool;
+    _monitor = nullptr;
+    _request = nullptr;
+    _pool = nullptr;
+
+    const auto command = "rm -rf '" + _folder + "'";
+    EXPECT_EQ(0, std::system(command.c_str()));
+  }
+
+  /**
+   * \brief the full path of something in our folder.
+   */
+  [[nodiscard]]
+  std::string Path(const std::string& name) const
+  {
+    return _folder + "/" + name;
+  }
+
+  /**
+   * \brief the full path of something in our folder, the way the monitor names it.
+   */
+  [[nodiscard]]
+  std::wstring Name(const std::string& name) const
+  {
+    return Io::FromUtf8(Path(name));
+  }
+
+  static void Touch(const std::string& path)
+  {
+    const auto file = std::fopen(path.c_str(), "w");
+    ASSERT_NE(nullptr, file);
+    std::fputs("myoddweb", file);
+    std::fclose(file);
+  }
+
+  /**
+   * \brief wait for the monitor to give us an event.
+   * \param action the action we are waiting for.
+   * \param name the name of the event.
+   * \param oldName the old name, (for renames), or nullptr.
+   * \param timeout how long we are prepared to wait.
+   * \return if the event was found before we timed out.
+   */
+  bool WaitForEvent(const EventAction action, const std::wstring& name, const std::wstring* oldName = nullptr, const long long timeout = LinuxMonitorTimeoutWait)
+  {
+    return Wait::SpinUntil([&]
+    {
+      Arena memory;
+      std::vector<Event*> events;
+      _monitor->GetEvents(events, memory);
+      for (const auto* event : events)
+      {
+        if (event->Action != static_cast<int>(action) || name != event->Name)
+        {
+          continue;
+        }
+        if (oldName != nullptr && (event->OldName == nullptr || *oldName != event->OldName))
+        {
+          continue;
+        }
+        return true;
+      }
+      return false;
+    }, timeout);
+  }
+
+  std::string _folder;
+  WorkerPool* _pool = nullptr;
+  RequestHelper* _request = nullptr;
+  LinuxMonitor* _monitor = nullptr;
+};
+
+TEST_F(LinuxMonitorTest, CreatedFileIsAdded) {
+  Touch(Path("a.txt"));
+  EXPECT_TRUE(WaitForEvent(EventAction::Added, Name("a.txt")));
+}
+
+TEST_F(LinuxMonitorTest, CreatedFileInASubFolderIsAdded) {
+  Touch(Path("sub/a.txt"));
+  EXPECT_TRUE(WaitForEvent(EventAction::Added, Name("sub/a.txt")));
+}
+
+TEST_F(LinuxMonitorTest, RenamedFileKeepsBothNames) {
+  Touch(Path("a.txt"));
+  ASSERT_TRUE(WaitForEvent(EventAction::Added, Name("a.txt")));
+
+  ASSERT_EQ(0, std::rename(Path("a.txt").c_str(), Path("b.txt").c_str()));
+  const auto oldName = Name("a.txt");
+  EXPECT_TRUE(WaitForEvent(EventAction::Renamed, Name("b.txt"), &oldName));
+}
+
+TEST_F(LinuxMonitorTest, DeletedFileIsRemoved) {
+  Touch(Path("a.txt"));
+  ASSERT_TRUE(WaitForEvent(EventAction::Added, Name("a.txt")));
+
+  ASSERT_EQ(0, unlink(Path("a.txt").c_str()));
+  EXPECT_TRUE(WaitForEvent(EventAction::Removed, Name("a.txt")));
+}
+
+TEST_F(LinuxMonitorTest, FileMovedToASubFolderIsRenamed) {
+  Touch(Path("a.txt"));
+  ASSERT_TRUE(WaitForEvent(EventAction::Added, Name("a.txt")));
+
+  ASSERT_EQ(0, std::rename(Path("a.txt").c_str(), Path("sub/a.txt").c_str()));
+  const auto oldName = Name("a.txt");
+  EXPECT_TRUE(WaitForEvent(EventAction::Renamed, Name("sub/a.txt"), &oldName));
+}
+
+TEST_F(LinuxMonitorTest, FileMovedOutOfTheFolderIsRemoved) {
+  Touch(Path("a.txt"));
+  ASSERT_TRUE(WaitForEvent(EventAction::Added, Name("a.txt")));
+
+  // the other half of the move is never seen, so it is a delete.
+  const auto outside = _folder + ".moved";
+  ASSERT_EQ(0, std::rename(Path("a.txt").c_str(), outside.c_str()));
+  EXPECT_TRUE(WaitForEvent(EventAction::Removed, Name("a.txt")));
+  unlink(outside.c_str());
+}
+
+TEST_F(LinuxMonitorTest, CreatedFolderIsWatched) {
+  ASSERT_EQ(0, mkdir(Path("new").c_str(), 0700));
+  ASSERT_TRUE(WaitForEvent(EventAction::Added, Name("new")));
+
+  // inotify is not recursive, the new folder must have been added to the watches.
+  Touch(Path("new/a.txt"));
+  EXPECT_TRUE(WaitForEvent(EventAction::Added, Name("new/a.txt")));
+}
+#endif
@@ -0,0 +1,157 @@
+#include "pch.h"
+
+#include <cstdarg>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../myoddweb.directorywatcher.win/utils/LogRing.h"
+
+using myoddweb::directorywatcher::LogLevel;
+using myoddweb::directorywatcher::LogRing;
+using myoddweb::directorywatcher::MYODDWEB_LOGGER_MAX_MESSAGE;
+
+/**
+ * \brief format and push a record the same way the logger does.
+ */
+static bool Push(LogRing& ring, const long long id, const LogLevel level, const wchar_t* format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  const auto pushed = ring.TryPush(id, level, format, args);
+  va_end(args);
+  return pushed;
+}
+
+/**
+ * \brief push a record and tell if it was the next one to be taken.
+ */
+static bool PushIsNext(LogRing& ring, const wchar_t* format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  auto isNext = false;
+  EXPECT_TRUE(ring.TryPush(0, LogLevel::Information, format, args, isNext));
+  va_end(args);
+  return isNext;
+}
+
+TEST(LogRing, CapacityIsRoundedUpToAPowerOfTwo) {
+  EXPECT_EQ(2, LogRing(0).Capacity());
+  EXPECT_EQ(8, LogRing(5).Capacity());
+  EXPECT_EQ(1024, LogRing(1024).Capacity());
+}
+
+TEST(LogRing, EmptyRingHasNothingToPop) {
+  LogRing ring(4);
+  LogRing::Record record;
+  EXPECT_FALSE(ring.CanPop());
+  EXPECT_FALSE(ring.TryPop(record));
+  EXPECT_EQ(0, ring.Pushed());
+}
+
+TEST(LogRing, RecordsArePoppedInOrderAndFormatted) {
+  LogRing ring(4);
+  EXPECT_TRUE(Push(ring, 12, LogLevel::Warning, L"first %d", 1));
+  EXPECT_TRUE(Push(ring, 0, LogLevel::Error, L"second %ls", L"two"));
+  EXPECT_EQ(2, ring.Pushed());
+
+  LogRing::Record record;
+  ASSERT_TRUE(ring.TryPop(record));
+  EXPECT_EQ(12, record.id);
+  EXPECT_EQ(LogLevel::Warning, record.level);
+  EXPECT_EQ(std::wstring(L"first 1"), record.message);
+
+  ASSERT_TRUE(ring.TryPop(record));
+  EXPECT_EQ(0, record.id);
+  EXPECT_EQ(LogLevel::Error, record.level);
+  EXPECT_EQ(std::wstring(L"second two"), record.message);
+
+  EXPECT_FALSE(ring.TryPop(record));
+}
+
+TEST(LogRing, FullRingRefusesRecordsUntilOneIsPopped) {
+  LogRing ring(4);
+  for (auto i = 0; i < 4; ++i)
+  {
+    EXPECT_TRUE(Push(ring, i, LogLevel::Information, L"%d", i));
+  }
+  EXPECT_FALSE(Push(ring, 4, LogLevel::Information, L"%d", 4));
+  EXPECT_EQ(4, ring.Pushed());
+
+  LogRing::Record record;
+  ASSERT_TRUE(ring.TryPop(record));
+  EXPECT_EQ(0, record.id);
+
+  // the slot we freed can be used again.
+  EXPECT_TRUE(Push(ring, 5, LogLevel::Information, L"%d", 5));
+  for (const auto expected : { 1, 2, 3, 5 })
+  {
+    ASSERT_TRUE(ring.TryPop(record));
+    EXPECT_EQ(expected, record.id);
+  }
+}
+
+TEST(LogRing, LongMessagesAreTruncated) {
+  LogRing ring(2);
+  const std::wstring longMessage(MYODDWEB_LOGGER_MAX_MESSAGE * 2, L'x');
+  EXPECT_TRUE(Push(ring, 1, LogLevel::Information, L"%ls", longMessage.c_str()));
+
+  LogRing::Record record;
+  ASSERT_TRUE(ring.TryPop(record));
+  EXPECT_LT(std::wstring(record.message).size(), static_cast<size_t>(MYODDWEB_LOGGER_MAX_MESSAGE));
+}
+
+TEST(LogRing, NullFormatGivesAnEmptyMessage) {
+  LogRing ring(2);
+  EXPECT_TRUE(Push(ring, 1, LogLevel::Information, nullptr));
+
+  LogRing::Record record;
+  ASSERT_TRUE(ring.TryPop(record));
+  EXPECT_EQ(std::wstring(L""), record.message);
+}
+
+TEST(LogRing, ManyThreadsCanPushAtOnce) {
+  const auto numberOfThreads = 4;
+  const auto numberOfRecords = 2000;
+  LogRing ring(numberOfThreads * numberOfRecords);
+
+  std::vector<std::thread> threads;
+  for (auto t = 0; t < numberOfThreads; ++t)
+  {
+    threads.emplace_back([&ring, t]
+    {
+      for (auto i = 0; i < numberOfRecords; ++i)
+      {
+        Push(ring, static_cast<long long>(t) * numberOfRecords + i, LogLevel::Information, L"%d", i);
+      }
+    });
+  }
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+
+  // every record is there once.
+  std::set<long long> ids;
+  LogRing::Record record;
+  while (ring.TryPop(record))
+  {
+    ids.insert(record.id);
+  }
+  EXPECT_EQ(static_cast<size_t>(numberOfThreads * numberOfRecords), ids.size());
+}
+
+TEST(LogRing, OnlyTheRecordAfterTheLastOneTakenIsNext) {
+  LogRing ring(4);
+
+  // the reader has nothing so it might be waiting for the first record, but not for the ones after it.
+  EXPECT_TRUE(PushIsNext(ring, L"first"));
+  EXPECT_FALSE(PushIsNext(ring, L"second"));
+
+  // once everything was taken the next record is the one the reader waits for.
+  LogRing::Record record;
+  ASSERT_TRUE(ring.TryPop(record));
+  ASSERT_TRUE(ring.TryPop(record));
+  EXPECT_TRUE(PushIsNext(ring, L"third"));
+}
@@ -0,0 +1,209 @@
+#include "pch.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../myoddweb.directorywatcher.win/utils/Logger.h"
+#include "MonitorsManagerTestHelper.h"
+
+using myoddweb::directorywatcher::Logger;
+using myoddweb::directorywatcher::LogLevel;
+using myoddweb::directorywatcher::MYODDWEB_LOGGER_RING_SIZE;
+
+/**
+ * \brief a message received by one of our loggers.
+ */
+struct LoggedMessage
+{
+  long long logger;
+  long long id;
+  int level;
+  std::wstring message;
+};
+
+static std::mutex _loggedLock;
+static std::vector<LoggedMessage> _logged;
+static std::atomic<bool> _loggersBlocked = false;
+
+static void Received(const long long logger, const long long id, const int level, const wchar_t* message)
+{
+  while (_loggersBlocked)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  std::lock_guard<std::mutex> lock(_loggedLock);
+  _logged.push_back({ logger, id, level, message });
+}
+
+static void __stdcall FirstLogger(const long long id, const int level, const wchar_t* message)
+{
+  Received(1001, id, level, message);
+}
+
+static void __stdcall SecondLogger(const long long id, const int level, const wchar_t* message)
+{
+  Received(1002, id, level, message);
+}
+
+/**
+ * \brief take all the messages received so far.
+ */
+static std::vector<LoggedMessage> TakeLogged()
+{
+  std::lock_guard<std::mutex> lock(_loggedLock);
+  auto logged = _logged;
+  _logged.clear();
+  return logged;
+}
+
+TEST(Logger, LoggingWithoutLoggersDoesNothing) {
+  TakeLogged();
+  Logger::Log(LogLevel::Error, L"Nobody is listening %d", 1);
+  EXPECT_TRUE(Logger::Flush(TEST_TIMEOUT_WAIT));
+  EXPECT_TRUE(TakeLogged().empty());
+}
+
+TEST(Logger, MessagesAreDeliveredToTheirLogger) {
+  TakeLogged();
+  Logger::Add(1001, FirstLogger);
+  Logger::Add(1002, SecondLogger);
+
+  Logger::Log(1001, LogLevel::Warning, L"Hello %ls %d", L"world", 42);
+  EXPECT_TRUE(Logger::Flush(TEST_TIMEOUT_WAIT));
+
+  const auto logged = TakeLogged();
+  ASSERT_EQ(1, logged.size());
+  EXPECT_EQ(1001, logged[0].logger);
+  EXPECT_EQ(1001, logged[0].id);
+  EXPECT_EQ(static_cast<int>(LogLevel::Warning), logged[0].level);
+  EXPECT_EQ(std::wstring(L"Hello world 42"), logged[0].message);
+
+  Logger::Remove(1001);
+  Logger::Remove(1002);
+}
+
+TEST(Logger, GlobalMessagesAreDeliveredToAllTheLoggers) {
+  TakeLogged();
+  Logger::Add(1001, FirstLogger);
+  Logger::Add(1002, SecondLogger);
+
+  Logger::Log(LogLevel::Error, L"Everyone");
+  EXPECT_TRUE(Logger::Flush(TEST_TIMEOUT_WAIT));
+
+  const auto logged = TakeLogged();
+  ASSERT_EQ(2, logged.size());
+  EXPECT_EQ(0, logged[0].id);
+  EXPECT_EQ(0, logged[1].id);
+  EXPECT_NE(logged[0].logger, logged[1].logger);
+
+  Logger::Remove(1001);
+  Logger::Remove(1002);
+}
+
+TEST(Logger, MessagesBelowTheLevelAreIgnored) {
+  TakeLogged();
+  Logger::Add(1001, FirstLogger);
+  Logger::SetLevel(LogLevel::Warning);
+
+  EXPECT_FALSE(Logger::IsEnabled(LogLevel::Debug));
+  EXPECT_FALSE(Logger::IsEnabled(LogLevel::Information));
+  EXPECT_TRUE(Logger::IsEnabled(LogLevel::Warning));
+  EXPECT_TRUE(Logger::IsEnabled(LogLevel::Panic));
+
+  Logger::Log(1001, LogLevel::Information, L"Ignored");
+  Logger::Log(1001, LogLevel::Debug, L"Ignored");
+  Logger::Log(1001, LogLevel::Error, L"Logged");
+  EXPECT_TRUE(Logger::Flush(TEST_TIMEOUT_WAIT));
+
+  const auto logged = TakeLogged();
+  ASSERT_EQ(1, logged.size());
+  EXPECT_EQ(std::wstring(L"Logged"), logged[0].message);
+
+  Logger::SetLevel(LogLevel::Debug);
+  EXPECT_TRUE(Logger::IsEnabled(LogLevel::Debug));
+  Logger::Remove(1001);
+}
+
+TEST(Logger, RemovingALoggerDeliversWhatWasLoggedForIt) {
+  TakeLogged();
+  Logger::Add(1001, FirstLogger);
+  for (auto i = 0; i < 10; ++i)
+  {
+    Logger::Log(1001, LogLevel::Information, L"Message %d", i);
+  }
+  Logger::Remove(1001);
+
+  const auto logged = TakeLogged();
+  ASSERT_EQ(10, logged.size());
+  EXPECT_EQ(std::wstring(L"Message 0"), logged[0].message);
+  EXPECT_EQ(std::wstring(L"Message 9"), logged[9].message);
+}
+
+TEST(Logger, MessagesFromManyThreadsAreAllDelivered) {
+  TakeLogged();
+  Logger::Add(1001, FirstLogger);
+
+  // the thread is only woken up for some of the messages, none of them must be left behind.
+  const auto numberOfThreads = 8;
+  const auto numberOfMessages = 100;
+  std::vector<std::thread> threads;
+  for (auto t = 0; t < numberOfThreads; ++t)
+  {
+    threads.emplace_back([]
+    {
+      for (auto i = 0; i < numberOfMessages; ++i)
+      {
+        Logger::Log(1001, LogLevel::Information, L"Message %d", i);
+        if (i % 10 == 0)
+        {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+  EXPECT_TRUE(Logger::Flush(TEST_TIMEOUT_WAIT));
+  EXPECT_EQ(numberOfThreads * numberOfMessages, static_cast<int>(TakeLogged().size()));
+
+  Logger::Remove(1001);
+}
+
+TEST(Logger, SlowLoggersDropMessagesRatherThanBlocking) {
+  TakeLogged();
+  Logger::Add(1001, FirstLogger);
+  const auto droppedBefore = Logger::Dropped();
+
+  // the logger cannot receive anything so the ring fills up.
+  _loggersBlocked = true;
+  const auto numberOfMessages = MYODDWEB_LOGGER_RING_SIZE * 2;
+  for (auto i = 0; i < numberOfMessages; ++i)
+  {
+    Logger::Log(1001, LogLevel::Information, L"Message %d", i);
+  }
+  const auto dropped = Logger::Dropped() - droppedBefore;
+  EXPECT_GE(dropped, numberOfMessages - MYODDWEB_LOGGER_RING_SIZE - 1);
+
+  _loggersBlocked = false;
+  EXPECT_TRUE(Logger::Flush(TEST_TIMEOUT_WAIT * 10));
+
+  // what was not dropped was delivered, and we were told about what was.
+  const auto logged = TakeLogged();
+  auto warnings = 0;
+  for (const auto& message : logged)
+  {
+    if (message.id == 0 && message.message.find(L"dropped") != std::wstring::npos)
+    {
+      ++warnings;
+    }
+  }
+  EXPECT_GE(warnings, 1);
+  EXPECT_EQ(numberOfMessages - dropped, static_cast<long long>(logged.size()) - warnings);
+
+  Logger::Remove(1001);
+}
@@ -0,0 +1,114 @@
+#include "pch.h"
+
+#include <thread>
+#include <vector>
+#include "../myoddweb.directorywatcher.win/utils/Metrics.h"
+
+using myoddweb::directorywatcher::Metrics;
+using myoddweb::directorywatcher::MonitorStatistics;
+using myoddweb::directorywatcher::MonitorHistogram;
+
+TEST(Metrics, CountersStartAtZero) {
+  const Metrics metrics;
+  EXPECT_EQ(0, metrics.Get(Metrics::Counter::ReceivedEvents));
+  EXPECT_EQ(0, metrics.Get(Metrics::Counter::BytesRead));
+
+  MonitorStatistics statistics = {};
+  metrics.AddTo(statistics);
+  EXPECT_EQ(0, statistics.NumberOfReceivedEvents);
+  EXPECT_EQ(0, statistics.EventAgeMilliseconds.Count);
+}
+
+TEST(Metrics, UnusedMetricsHoldNoCounters) {
+  // the copies of the counters are only created once a thread adds to them.
+  EXPECT_GE(myoddweb::directorywatcher::MYODDWEB_METRICS_SHARDS * sizeof(void*), sizeof(Metrics));
+}
+
+TEST(Metrics, CountersAddUpAcrossAllTheThreads) {
+  Metrics metrics;
+  const auto numberOfThreads = 16;
+  const auto numberOfAdds = 10000;
+
+  std::vector<std::thread> threads;
+  for (auto t = 0; t < numberOfThreads; ++t)
+  {
+    threads.emplace_back([&metrics]
+    {
+      for (auto i = 0; i < numberOfAdds; ++i)
+      {
+        metrics.Add(Metrics::Counter::ReceivedEvents);
+        metrics.Add(Metrics::Counter::BytesRead, 10);
+      }
+    });
+  }
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+
+  EXPECT_EQ(numberOfThreads * numberOfAdds, metrics.Get(Metrics::Counter::ReceivedEvents));
+  EXPECT_EQ(numberOfThreads * numberOfAdds * 10ll, metrics.Get(Metrics::Counter::BytesRead));
+  EXPECT_EQ(0, metrics.Get(Metrics::Counter::CollectedEvents));
+}
+
+TEST(Metrics, DurationsAreBucketedByPowersOfTwo) {
+  EXPECT_EQ(0, Metrics::Bucket(0));
+  EXPECT_EQ(1, Metrics::Bucket(1));
+  EXPECT_EQ(2, Metrics::Bucket(2));
+  EXPECT_EQ(2, Metrics::Bucket(3));
+  EXPECT_EQ(3, Metrics::Bucket(4));
+  EXPECT_EQ(10, Metrics::Bucket(1000));
+  EXPECT_EQ(myoddweb::directorywatcher::MYODDWEB_METRICS_HISTOGRAM_BUCKETS - 1, Metrics::Bucket(0x7fffffffffffffffLL));
+}
+
+TEST(Metrics, HistogramsAreAddedToTheStatistics) {
+  Metrics metrics;
+  metrics.Record(Metrics::Timing::Callback, 1);
+  metrics.Record(Metrics::Timing::Callback, 3);
+  metrics.Record(Metrics::Timing::Callback, -5);
+  metrics.Record(Metrics::Timing::Publish, 2);
+
+  MonitorStatistics statistics = {};
+  metrics.AddTo(statistics);
+  EXPECT_EQ(3, statistics.CallbackMilliseconds.Count);
+  EXPECT_DOUBLE_EQ(4, statistics.CallbackMilliseconds.TotalMilliseconds);
+  EXPECT_DOUBLE_EQ(3, statistics.CallbackMilliseconds.MaxMilliseconds);
+  EXPECT_EQ(1, statistics.CallbackMilliseconds.Buckets[0]);
+  EXPECT_EQ(1, statistics.CallbackMilliseconds.Buckets[Metrics::Bucket(1000)]);
+  EXPECT_EQ(1, statistics.CallbackMilliseconds.Buckets[Metrics::Bucket(3000)]);
+  EXPECT_EQ(1, statistics.PublishMilliseconds.Count);
+  EXPECT_EQ(0, statistics.EventAgeMilliseconds.Count);
+
+  // the values of another monitor are added to ours.
+  metrics.AddTo(statistics);
+  EXPECT_EQ(6, statistics.CallbackMilliseconds.Count);
+  EXPECT_DOUBLE_EQ(3, statistics.CallbackMilliseconds.MaxMilliseconds);
+}
+
+TEST(Metrics, PercentilesAreTheUpperBoundOfTheirBucket) {
+  Metrics metrics;
+  for (auto i = 0; i < 90; ++i)
+  {
+    metrics.Record(Metrics::Timing::EventAge, 0.1);
+  }
+  for (auto i = 0; i < 10; ++i)
+  {
+    metrics.Record(Metrics::Timing::EventAge, 50);
+  }
+
+  MonitorStatistics statistics = {};
+  metrics.AddTo(statistics);
+  Metrics::CalculatePercentiles(statistics.EventAgeMilliseconds);
+
+  // 100us is in the bucket under 128us, the max caps the last one.
+  EXPECT_DOUBLE_EQ(0.128, statistics.EventAgeMilliseconds.P50Milliseconds);
+  EXPECT_DOUBLE_EQ(0.128, statistics.EventAgeMilliseconds.P90Milliseconds);
+  EXPECT_DOUBLE_EQ(50, statistics.EventAgeMilliseconds.P99Milliseconds);
+}
+
+TEST(Metrics, PercentilesOfAnEmptyHistogramAreZero) {
+  MonitorHistogram histogram = {};
+  Metrics::CalculatePercentiles(histogram);
+  EXPECT_EQ(0, histogram.P50Milliseconds);
+  EXPECT_EQ(0, histogram.P99Milliseconds);
+}
@@ -58,11 +58,11 @@ inline auto eventFunction = []
 (
   const long long id,
   const bool isFile,
-  const wchar_t* name,
-  const wchar_t* oldName,
+  const wchar_t* /*name*/,
+  const wchar_t* /*oldName*/,
   const int action,
-  const int error,
-  const long long dateTimeUtc
+  const int /*error*/,
+  const long long /*dateTimeUtc*/
 ) -> void
 {
   Get(id)->EventAction(static_cast<::EventAction>(action), isFile);
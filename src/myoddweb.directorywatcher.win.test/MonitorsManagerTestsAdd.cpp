@@ -1,6 +1,7 @@
 #pragma once
 #include "pch.h"
 
+#include <vector>
 #include "../myoddweb.directorywatcher.win/utils/MonitorsManager.h"
 #include "../myoddweb.directorywatcher.win/utils/EventAction.h"
 #include "../myoddweb.directorywatcher.win/utils/Wait.h"
@@ -13,6 +14,7 @@ using myoddweb::directorywatcher::EventAction;
 using myoddweb::directorywatcher::MonitorsManager;
 using myoddweb::directorywatcher::Request;
 using myoddweb::directorywatcher::EventCallback;
+using myoddweb::directorywatcher::MonitorStatistics;
 
 typedef std::tuple<int, bool> IdentifierParams;
 class ValidateNumberOfItemAdded :public ::testing::TestWithParam<IdentifierParams> {};
@@ -77,6 +79,91 @@ TEST(MonitorsManagerAdd, StoppingWhatWasNeverStarted) {
   EXPECT_NO_THROW(::MonitorsManager::Stop(id));
 }
 
+TEST(MonitorsManagerAdd, StopManyStopsAllTheMonitors) {
+
+  // create the helper.
+  auto helper = new MonitorsManagerTestHelper();
+
+  std::vector<long long> ids;
+  for (auto i = 0; i < 10; ++i)
+  {
+    const auto r = RequestHelper(
+      helper->Folder(),
+      false,
+      nullptr,
+      nullptr,
+      nullptr,
+      50,
+      0);
+    ids.push_back(::MonitorsManager::Start(::Request(r)));
+  }
+
+  Wait::SpinUntil([] { return ::MonitorsManager::Ready(); }, TEST_TIMEOUT_WAIT);
+
+  // they are all stopped at once.
+  EXPECT_EQ(10, ::MonitorsManager::StopMany(ids.data(), static_cast<int>(ids.size())));
+
+  // and they are all gone.
+  for (const auto id : ids)
+  {
+    EXPECT_FALSE(::MonitorsManager::Stop(id));
+  }
+  delete helper;
+}
+
+TEST(MonitorsManagerAdd, StopManyIgnoresWhatWasNeverStarted) {
+
+  const auto r = RequestHelper(
+    L"c:\\",
+    false,
+    nullptr,
+    nullptr,
+    nullptr,
+    50,
+    0);
+
+  const auto request = ::Request(r);
+  const auto id = ::MonitorsManager::Start(request);
+
+  // the wrong one is ignored and the correct one is only stopped once.
+  const long long ids[] = { id + 1, id, id };
+  long long stoppedIds[] = { 0, 0, 0 };
+  EXPECT_EQ(1, ::MonitorsManager::StopMany(ids, 3, stoppedIds));
+
+  // we are only told about the one that was stopped.
+  EXPECT_EQ(id, stoppedIds[0]);
+  EXPECT_EQ(0, stoppedIds[1]);
+
+  // nothing to stop.
+  EXPECT_EQ(0, ::MonitorsManager::StopMany(ids, 3));
+  EXPECT_EQ(-1, ::MonitorsManager::StopMany(nullptr, 3));
+}
+
+TEST(MonitorsManagerAdd, StatisticsOfAnotherLayoutAreRefused) {
+
+  const auto r = RequestHelper(
+    L"c:\\",
+    false,
+    nullptr,
+    nullptr,
+    nullptr,
+    50,
+    0);
+
+  const auto request = ::Request(r);
+  const auto id = ::MonitorsManager::Start(request);
+
+  // the host did not tell us its size.
+  MonitorStatistics statistics = {};
+  EXPECT_FALSE(::MonitorsManager::GetStatistics(id, statistics));
+
+  statistics.Size = static_cast<int>(sizeof(MonitorStatistics));
+  EXPECT_TRUE(::MonitorsManager::GetStatistics(id, statistics));
+  EXPECT_EQ(static_cast<int>(sizeof(MonitorStatistics)), statistics.Size);
+
+  EXPECT_TRUE(::MonitorsManager::Stop(id));
+}
+
 TEST(MonitorsManagerAdd, StartStopThenAddFileToFolder) {
     // create the helper.
     auto helper = new MonitorsManagerTestHelper();
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "../myoddweb.directorywatcher.win/monitors/win/NotificationParser.h"
+
+using myoddweb::directorywatcher::win::NotifyInformation;
+
+/**
+ * \brief build a notification buffer the same way ReadDirectoryChangesW( ... ) does.
+ */
+class NotificationBuffer final
+{
+public:
+  /**
+   * \brief add a record at the end of the buffer.
+   * \param action the action of the record.
+   * \param fileName the name of the file.
+   * \return if the record was added, false if the buffer is full.
+   */
+  bool Add(const unsigned long action, const std::wstring& fileName)
+  {
+    const auto nameLength = fileName.size() * sizeof(wchar_t);
+    const auto recordLength = Align(offsetof(NotifyInformation, FileName) + nameLength);
+    if (_length + recordLength > _maxLength)
+    {
+      return false;
+    }
+
+    // point the previous record to this one.
+    if (_length > 0)
+    {
+      Record(_last)->NextEntryOffset = static_cast<unsigned long>(_length - _last);
+    }
+    _last = _length;
+    _length += recordLength;
+    _storage.resize(_length / sizeof(unsigned long long));
+
+    const auto record = Record(_last);
+    record->NextEntryOffset = 0;
+    record->Action = action;
+    record->FileNameLength = static_cast<unsigned long>(nameLength);
+    std::memcpy(record->FileName, fileName.data(), nameLength);
+    return true;
+  }
+
+  [[nodiscard]]
+  const unsigned char* Data() const { return reinterpret_cast<const unsigned char*>(_storage.data()); }
+
+  [[nodiscard]]
+  unsigned char* Data() { return reinterpret_cast<unsigned char*>(_storage.data()); }
+
+  [[nodiscard]]
+  size_t Length() const { return _length; }
+
+  explicit NotificationBuffer(const size_t maxLength = 65536) :
+    _maxLength(maxLength),
+    _length(0),
+    _last(0)
+  {
+    _storage.reserve(maxLength / sizeof(unsigned long long));
+  }
+
+private:
+  static size_t Align(const size_t length)
+  {
+    return (length + sizeof(unsigned long long) - 1) & ~(sizeof(unsigned long long) - 1);
+  }
+
+  NotifyInformation* Record(const size_t offset)
+  {
+    return reinterpret_cast<NotifyInformation*>(Data() + offset);
+  }
+
+  const size_t _maxLength;
+  size_t _length;
+  size_t _last;
+  std::vector<unsigned long long> _storage;
+};
@@ -0,0 +1,97 @@
+#include "pch.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../myoddweb.directorywatcher.win/monitors/win/NotificationParser.h"
+#include "../myoddweb.directorywatcher.win/utils/Io.h"
+#include "BenchmarkHelper.h"
+#include "NotificationHelper.h"
+
+using myoddweb::directorywatcher::Io;
+using myoddweb::directorywatcher::win::NotificationParser;
+using myoddweb::directorywatcher::win::NotificationRecord;
+
+class NotificationParserBenchmark :public ::testing::TestWithParam<int> {};
+INSTANTIATE_TEST_SUITE_P(
+  NotificationParserBenchmarks,
+  NotificationParserBenchmark,
+  ::testing::Values(10, 100, 1000)
+);
+
+/**
+ * \brief fill 64KB buffers with records, the same way a busy folder would.
+ * \param numberOfBuffers the number of buffers we want.
+ * \param numberOfRecords the total number of records created.
+ * \return the buffers.
+ */
+static std::vector<NotificationBuffer> CreateBenchmarkBuffers(const int numberOfBuffers, long long& numberOfRecords)
+{
+  numberOfRecords = 0;
+  std::vector<NotificationBuffer> buffers(numberOfBuffers);
+  for (auto& buffer : buffers)
+  {
+    while (buffer.Add(1 + numberOfRecords % 5, L"some\\folder\\" + std::to_wstring(numberOfRecords) + L".txt"))
+    {
+      ++numberOfRecords;
+    }
+  }
+  return buffers;
+}
+
+static const std::wstring benchmarkPath = L"c:\\watched\\folder";
+static size_t benchmarkReceivedCharacters = 0;
+
+TEST_P(NotificationParserBenchmark, DISABLED_CopyEachName) {
+  long long numberOfRecords;
+  const auto buffers = CreateBenchmarkBuffers(GetParam(), numberOfRecords);
+
+  // the way we used to read the buffers, each name is copied to a string
+  // and then copied again once combined with the path.
+  benchmarkReceivedCharacters = 0;
+  Benchmark("CopyEachName", numberOfRecords, [&]
+  {
+    for (const auto& buffer : buffers)
+    {
+      std::wstring oldFilename;
+      auto pRecord = reinterpret_cast<const NotifyInformation*>(buffer.Data());
+      for (;;)
+      {
+        const auto wFilename = std::wstring(pRecord->FileName, pRecord->FileNameLength / sizeof(wchar_t));
+        oldFilename = wFilename;
+        benchmarkReceivedCharacters += Io::Combine(benchmarkPath, oldFilename).size();
+        if (0 == pRecord->NextEntryOffset)
+        {
+          break;
+        }
+        pRecord = reinterpret_cast<const NotifyInformation*>(&reinterpret_cast<const unsigned char*>(pRecord)[pRecord->NextEntryOffset]);
+      }
+    }
+  });
+  EXPECT_LT(0u, benchmarkReceivedCharacters);
+}
+
+TEST_P(NotificationParserBenchmark, DISABLED_ParseWithViews) {
+  long long numberOfRecords;
+  const auto buffers = CreateBenchmarkBuffers(GetParam(), numberOfRecords);
+
+  // the names are views in the buffer and the path is combined in memory we already have.
+  benchmarkReceivedCharacters = 0;
+  std::wstring combined;
+  Benchmark("ParseWithViews", numberOfRecords, [&]
+  {
+    for (const auto& buffer : buffers)
+    {
+      NotificationParser parser(buffer.Data(), buffer.Length());
+      NotificationRecord record = {};
+      std::wstring_view oldFilename;
+      while (parser.Next(record))
+      {
+        oldFilename = record.FileName;
+        combined.resize(Io::CombineLength(benchmarkPath, oldFilename));
+        benchmarkReceivedCharacters += Io::Combine(combined.data(), benchmarkPath, oldFilename);
+      }
+    }
+  });
+  EXPECT_LT(0u, benchmarkReceivedCharacters);
+}
@@ -0,0 +1,123 @@
+#include "pch.h"
+
+#include <random>
+#include <string>
+#include <vector>
+#include "../myoddweb.directorywatcher.win/monitors/win/NotificationParser.h"
+#include "NotificationHelper.h"
+
+using myoddweb::directorywatcher::win::NotificationParser;
+using myoddweb::directorywatcher::win::NotificationRecord;
+
+TEST(NotificationParser, EmptyBufferHasNoRecords) {
+  NotificationParser parser(nullptr, 100);
+  NotificationRecord record = {};
+  EXPECT_FALSE(parser.Next(record));
+  EXPECT_FALSE(parser.IsMalformed());
+}
+
+TEST(NotificationParser, AllRecordsAreRead) {
+  NotificationBuffer buffer;
+  ASSERT_TRUE(buffer.Add(1, L"a.txt"));
+  ASSERT_TRUE(buffer.Add(4, L"old\\name.txt"));
+  ASSERT_TRUE(buffer.Add(5, L"new\\name.txt"));
+
+  NotificationParser parser(buffer.Data(), buffer.Length());
+  NotificationRecord record = {};
+  ASSERT_TRUE(parser.Next(record));
+  EXPECT_EQ(1, record.Action);
+  EXPECT_EQ(L"a.txt", record.FileName);
+
+  ASSERT_TRUE(parser.Next(record));
+  EXPECT_EQ(4, record.Action);
+  EXPECT_EQ(L"old\\name.txt", record.FileName);
+
+  ASSERT_TRUE(parser.Next(record));
+  EXPECT_EQ(5, record.Action);
+  EXPECT_EQ(L"new\\name.txt", record.FileName);
+
+  EXPECT_FALSE(parser.Next(record));
+  EXPECT_FALSE(parser.IsMalformed());
+}
+
+TEST(NotificationParser, NamesAreNotCopied) {
+  NotificationBuffer buffer;
+  ASSERT_TRUE(buffer.Add(1, L"a.txt"));
+
+  NotificationParser parser(buffer.Data(), buffer.Length());
+  NotificationRecord record = {};
+  ASSERT_TRUE(parser.Next(record));
+  EXPECT_EQ(reinterpret_cast<const NotifyInformation*>(buffer.Data())->FileName, record.FileName.data());
+}
+
+TEST(NotificationParser, NameLongerThanTheBufferIsMalformed) {
+  NotificationBuffer buffer;
+  ASSERT_TRUE(buffer.Add(1, L"a.txt"));
+  reinterpret_cast<NotifyInformation*>(buffer.Data())->FileNameLength = 1000;
+
+  NotificationParser parser(buffer.Data(), buffer.Length());
+  NotificationRecord record = {};
+  EXPECT_FALSE(parser.Next(record));
+  EXPECT_TRUE(parser.IsMalformed());
+}
+
+TEST(NotificationParser, NextOffsetOutsideTheBufferIsMalformed) {
+  NotificationBuffer buffer;
+  ASSERT_TRUE(buffer.Add(1, L"a.txt"));
+  ASSERT_TRUE(buffer.Add(1, L"b.txt"));
+  reinterpret_cast<NotifyInformation*>(buffer.Data())->NextEntryOffset = 4096;
+
+  // the first record is still good, but we cannot go past it.
+  NotificationParser parser(buffer.Data(), buffer.Length());
+  NotificationRecord record = {};
+  ASSERT_TRUE(parser.Next(record));
+  EXPECT_EQ(L"a.txt", record.FileName);
+  EXPECT_FALSE(parser.Next(record));
+  EXPECT_TRUE(parser.IsMalformed());
+}
+
+TEST(NotificationParser, TruncatedBufferIsMalformed) {
+  NotificationBuffer buffer;
+  ASSERT_TRUE(buffer.Add(1, L"a.txt"));
+  ASSERT_TRUE(buffer.Add(1, L"some\\longer\\name.txt"));
+
+  NotificationParser parser(buffer.Data(), buffer.Length() - 8);
+  NotificationRecord record = {};
+  ASSERT_TRUE(parser.Next(record));
+  EXPECT_FALSE(parser.Next(record));
+  EXPECT_TRUE(parser.IsMalformed());
+}
+
+TEST(NotificationParser, RandomBuffersNeverReadOutsideTheBuffer) {
+  // fill the buffer with random values, the parser must always stop
+  // and every name it gives us must be inside the buffer.
+  std::mt19937 random(42);
+  std::uniform_int_distribution<unsigned int> small(0, 64);
+  std::vector<unsigned long long> storage(64);
+  const auto data = reinterpret_cast<unsigned char*>(storage.data());
+  const auto length = storage.size() * sizeof(unsigned long long);
+  for (auto i = 0; i < 10000; ++i)
+  {
+    for (auto& value : storage)
+    {
+      value = (static_cast<unsigned long long>(random()) << 32) | random();
+    }
+
+    // small values are more likely to be close to a valid buffer.
+    const auto header = reinterpret_cast<NotifyInformation*>(data);
+    header->NextEntryOffset = small(random) * 4;
+    header->FileNameLength = small(random) * 2;
+
+    NotificationParser parser(data, length);
+    NotificationRecord record = {};
+    auto count = 0u;
+    while (parser.Next(record))
+    {
+      const auto begin = reinterpret_cast<const unsigned char*>(record.FileName.data());
+      const auto end = reinterpret_cast<const unsigned char*>(record.FileName.data() + record.FileName.size());
+      ASSERT_LE(data, begin);
+      ASSERT_LE(end, data + length);
+      ASSERT_GT(length, count++);
+    }
+  }
+}
@@ -0,0 +1,74 @@
+#include "pch.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "../myoddweb.directorywatcher.win/utils/Threads/Notifier.h"
+#include "MonitorsManagerTestHelper.h"
+
+using myoddweb::directorywatcher::threads::Notifier;
+
+TEST(Notifier, ConditionAlreadyTrueDoesNotWait) {
+  Notifier notifier;
+  EXPECT_TRUE(notifier.WaitUntil([] { return true; }, 0));
+  EXPECT_TRUE(notifier.WaitUntil([] { return true; }, -1));
+}
+
+TEST(Notifier, TimesOutWhenTheConditionIsNeverTrue) {
+  Notifier notifier;
+  EXPECT_FALSE(notifier.WaitUntil([] { return false; }, 10));
+}
+
+TEST(Notifier, NotifyingWithoutAChangeDoesNotWakeUs) {
+  Notifier notifier;
+  std::atomic<bool> done = false;
+  std::thread thread([&notifier]
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    notifier.NotifyAll();
+  });
+
+  EXPECT_FALSE(notifier.WaitUntil([&done] { return done.load(); }, 50));
+  thread.join();
+}
+
+TEST(Notifier, ChangeFromAnotherThreadWakesUsUp) {
+  Notifier notifier;
+  std::atomic<bool> done = false;
+  std::thread thread([&notifier, &done]
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    done = true;
+    notifier.NotifyAll();
+  });
+
+  EXPECT_TRUE(notifier.WaitUntil([&done] { return done.load(); }, TEST_TIMEOUT_WAIT));
+  thread.join();
+}
+
+TEST(Notifier, AllTheWaitingThreadsAreWokenUp) {
+  Notifier notifier;
+  std::atomic<bool> done = false;
+  std::atomic<int> woken = 0;
+  std::vector<std::thread> threads;
+  for (auto i = 0; i < 8; ++i)
+  {
+    threads.emplace_back([&]
+    {
+      if (notifier.WaitUntil([&done] { return done.load(); }, TEST_TIMEOUT_WAIT * 10))
+      {
+        ++woken;
+      }
+    });
+  }
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  done = true;
+  notifier.NotifyAll();
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+  EXPECT_EQ(8, woken);
+}
@@ -70,3 +70,75 @@ TEST(Request, RecursiveIsSaved) {
     EXPECT_FALSE(request.Recursive());
   }
 }
+
+void __stdcall RequestTestEventsBatchCallback(long long, const myoddweb::directorywatcher::EventRecord*, int, const wchar_t*, int)
+{
+}
+
+TEST(Request, EventsBatchCallbackIsUsedForEvents) {
+  // use the test request to create the Request
+  // we make a copy of our helper onto the 'real' request to make sure copy is not broken
+  const auto r = RequestHelper(
+    L"c:\\",
+    false,
+    nullptr,
+    nullptr,
+    nullptr,
+    50,
+    0,
+    RequestTestEventsBatchCallback);
+  const auto request = ::Request(r);
+  EXPECT_TRUE(request.IsUsingEvents());
+  EXPECT_EQ(nullptr, request.CallbackEvents());
+  EXPECT_EQ(&RequestTestEventsBatchCallback, request.CallbackEventsBatch());
+}
+
+TEST(Request, EventsArePulledWhenThereAreNoEventsCallbacks) {
+  {
+    const auto request = RequestHelper(L"c:\\", false, nullptr, nullptr, nullptr, 50, 0);
+    EXPECT_TRUE(request.IsPullingEvents());
+    EXPECT_FALSE(request.IsUsingEvents());
+  }
+  {
+    // without a rate we do not keep the events.
+    const auto request = RequestHelper(L"c:\\", false, nullptr, nullptr, nullptr, 0, 0);
+    EXPECT_FALSE(request.IsPullingEvents());
+  }
+  {
+    // they are published so they cannot be pulled.
+    const auto request = RequestHelper(L"c:\\", false, nullptr, nullptr, nullptr, 50, 0, RequestTestEventsBatchCallback);
+    EXPECT_FALSE(request.IsPullingEvents());
+  }
+}
+
+TEST(Request, EventsAreNotCoalescedByDefault) {
+  const auto request = RequestHelper(L"c:\\", false, nullptr, nullptr, nullptr, 50, 0);
+  EXPECT_FALSE(request.CoalesceEvents());
+}
+
+TEST(Request, CoalesceEventsIsSaved) {
+  const auto r = RequestHelper(L"c:\\", true, nullptr, nullptr, nullptr, 50, 0, nullptr, true);
+  const auto request = ::Request(r);
+  EXPECT_TRUE(request.CoalesceEvents());
+}
+
+TEST(Request, ChildRequestKeepsTheParentOptions) {
+  const auto parent = RequestHelper(L"c:\\", true, nullptr, nullptr, nullptr, 50, 20, nullptr, true);
+  const auto child = ::Request(L"c:\\foo", false, parent);
+  EXPECT_TRUE(wcscmp(L"c:\\foo", child.Path()) == 0);
+  EXPECT_FALSE(child.Recursive());
+  EXPECT_EQ(50, child.EventsCallbackRateMilliseconds());
+  EXPECT_EQ(20, child.StatsCallbackRateMilliseconds());
+  EXPECT_TRUE(child.CoalesceEvents());
+}
+
+TEST(Request, TouchedEventsDoNotSettleByDefault) {
+  const auto request = RequestHelper(L"c:\\", false, nullptr, nullptr, nullptr, 50, 0);
+  EXPECT_EQ(0, request.SettleMilliseconds());
+}
+
+TEST(Request, SettleMillisecondsIsSavedAndGivenToTheChildren) {
+  const auto parent = RequestHelper(L"c:\\", true, nullptr, nullptr, nullptr, 50, 0, nullptr, false, 500);
+  EXPECT_EQ(500, ::Request(parent).SettleMilliseconds());
+  EXPECT_EQ(500, ::Request(L"c:\\foo", false, parent).SettleMilliseconds());
+}
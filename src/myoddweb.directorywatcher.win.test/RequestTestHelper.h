@@ -5,6 +5,7 @@ using myoddweb::directorywatcher::Request;
 using myoddweb::directorywatcher::EventCallback;
 using myoddweb::directorywatcher::StatisticsCallback;
 using myoddweb::directorywatcher::LoggerCallback;
+using myoddweb::directorywatcher::EventsBatchCallback;
 
 class RequestHelper : public ::Request
 {
@@ -16,7 +17,10 @@ public:
     const EventCallback& eventsCallback, 
     const StatisticsCallback& statisticsCallback, 
     long long eventsCallbackRateMs, 
-    long long statisticsCallbackRateMs
+    long long statisticsCallbackRateMs,
+    const EventsBatchCallback& eventsBatchCallback = nullptr,
+    bool coalesceEvents = false,
+    long long settleMilliseconds = 0
   ) : Request(
     path,
     recursive,
@@ -24,7 +28,10 @@ public:
     eventsCallback,
     statisticsCallback,
     eventsCallbackRateMs,
-    statisticsCallbackRateMs
+    statisticsCallbackRateMs,
+    eventsBatchCallback,
+    coalesceEvents,
+    settleMilliseconds
   )
   {
     
@@ -0,0 +1,127 @@
+#include "pch.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "../myoddweb.directorywatcher.win/utils/SettleQueue.h"
+
+using myoddweb::directorywatcher::SettleQueue;
+
+constexpr auto SettleMilliseconds = 100;
+constexpr auto MaxHoldMilliseconds = 1000;
+
+TEST(SettleQueue, EmptyQueueHasNothingSettled) {
+  SettleQueue queue(SettleMilliseconds, MaxHoldMilliseconds);
+  std::vector<SettleQueue::Settled> settled;
+  queue.TakeSettled(100000, settled);
+  EXPECT_EQ(0, settled.size());
+  EXPECT_EQ(0, queue.Size());
+}
+
+TEST(SettleQueue, PathSettlesOnceItStopsChanging) {
+  SettleQueue queue(SettleMilliseconds, MaxHoldMilliseconds);
+  queue.Change(L"a.txt", true, 10);
+
+  std::vector<SettleQueue::Settled> settled;
+  queue.TakeSettled(109, settled);
+  EXPECT_EQ(0, settled.size());
+
+  queue.TakeSettled(110, settled);
+  ASSERT_EQ(1, settled.size());
+  EXPECT_EQ(L"a.txt", settled[0].Name);
+  EXPECT_TRUE(settled[0].IsFile);
+  EXPECT_EQ(10, settled[0].TimeMillisecondsUtc);
+  EXPECT_EQ(0, queue.Size());
+}
+
+TEST(SettleQueue, EachChangePushesTheSettleTimeBack) {
+  SettleQueue queue(SettleMilliseconds, MaxHoldMilliseconds);
+  queue.Change(L"a.txt", true, 10);
+  queue.Change(L"a.txt", true, 50);
+  queue.Change(L"a.txt", true, 90);
+  EXPECT_EQ(1, queue.Size());
+
+  std::vector<SettleQueue::Settled> settled;
+  queue.TakeSettled(150, settled);
+  EXPECT_EQ(0, settled.size());
+
+  queue.TakeSettled(190, settled);
+  ASSERT_EQ(1, settled.size());
+  EXPECT_EQ(90, settled[0].TimeMillisecondsUtc);
+}
+
+TEST(SettleQueue, PathThatNeverSettlesIsNotHeldForever) {
+  SettleQueue queue(SettleMilliseconds, MaxHoldMilliseconds);
+  std::vector<SettleQueue::Settled> settled;
+  for (auto time = 0; time < 2000; time += 10)
+  {
+    queue.Change(L"a.log", true, time);
+    queue.TakeSettled(time, settled);
+  }
+
+  // it was released after the max hold time, and then held again.
+  ASSERT_EQ(1, settled.size());
+  EXPECT_EQ(MaxHoldMilliseconds, settled[0].TimeMillisecondsUtc);
+  EXPECT_EQ(1, queue.Size());
+}
+
+TEST(SettleQueue, OnlyThePathsThatSettledAreTaken) {
+  SettleQueue queue(SettleMilliseconds, MaxHoldMilliseconds);
+  queue.Change(L"a.txt", true, 10);
+  queue.Change(L"b.txt", true, 20);
+  queue.Change(L"a.txt", true, 30);
+  queue.Change(L"c.txt", true, 40);
+
+  std::vector<SettleQueue::Settled> settled;
+  queue.TakeSettled(135, settled);
+  ASSERT_EQ(2, settled.size());
+  EXPECT_EQ(L"b.txt", settled[0].Name);
+  EXPECT_EQ(L"a.txt", settled[1].Name);
+  EXPECT_EQ(1, queue.Size());
+}
+
+TEST(SettleQueue, ReleasedPathIsNotTakenAgain) {
+  SettleQueue queue(SettleMilliseconds, MaxHoldMilliseconds);
+  queue.Change(L"a.txt", true, 10);
+  queue.Change(L"a.txt", true, 20);
+
+  long long time = 0;
+  EXPECT_FALSE(queue.Release(L"b.txt", true, time));
+  EXPECT_TRUE(queue.Release(L"a.txt", true, time));
+  EXPECT_EQ(20, time);
+  EXPECT_FALSE(queue.Release(L"a.txt", true, time));
+
+  std::vector<SettleQueue::Settled> settled;
+  queue.TakeSettled(100000, settled);
+  EXPECT_EQ(0, settled.size());
+}
+
+TEST(SettleQueue, FilesAndFoldersAreDifferentPaths) {
+  SettleQueue queue(SettleMilliseconds, MaxHoldMilliseconds);
+  queue.Change(L"foo", true, 10);
+  queue.Change(L"foo", false, 10);
+  EXPECT_EQ(2, queue.Size());
+
+  long long time = 0;
+  EXPECT_TRUE(queue.Release(L"foo", false, time));
+  EXPECT_EQ(1, queue.Size());
+}
+
+TEST(SettleQueue, ManyPathsAllSettle) {
+  SettleQueue queue(SettleMilliseconds, MaxHoldMilliseconds);
+  constexpr auto numberOfPaths = 10000;
+  for (auto i = 0; i < numberOfPaths; ++i)
+  {
+    queue.Change(std::to_wstring(i), true, i / 100);
+  }
+  EXPECT_EQ(numberOfPaths, queue.Size());
+
+  std::vector<SettleQueue::Settled> settled;
+  queue.TakeSettled(100000, settled);
+  ASSERT_EQ(numberOfPaths, settled.size());
+  EXPECT_TRUE(std::is_sorted(settled.begin(), settled.end(), [](const auto& lhs, const auto& rhs)
+  {
+    return lhs.TimeMillisecondsUtc < rhs.TimeMillisecondsUtc;
+  }));
+  EXPECT_EQ(0, queue.Size());
+}
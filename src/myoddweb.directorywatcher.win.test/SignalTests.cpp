@@ -0,0 +1,41 @@
+#include "pch.h"
+
+#include <chrono>
+#include <thread>
+#include "../myoddweb.directorywatcher.win/utils/Threads/Signal.h"
+#include "MonitorsManagerTestHelper.h"
+
+using myoddweb::directorywatcher::threads::Signal;
+
+TEST(Signal, TimesOutWhenNotSet) {
+  Signal signal;
+  EXPECT_FALSE(signal.WaitFor(10));
+}
+
+TEST(Signal, SetBeforeWaitingDoesNotWait) {
+  Signal signal;
+  signal.Set();
+  EXPECT_TRUE(signal.WaitFor(TEST_TIMEOUT_WAIT));
+}
+
+TEST(Signal, IsResetOnceWoken) {
+  Signal signal;
+  signal.Set();
+  signal.Set();
+  EXPECT_TRUE(signal.WaitFor(0));
+
+  // setting it more than once only wakes us once.
+  EXPECT_FALSE(signal.WaitFor(10));
+}
+
+TEST(Signal, SetFromAnotherThread) {
+  Signal signal;
+  std::thread thread([&signal]
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    signal.Set();
+  });
+
+  EXPECT_TRUE(signal.WaitFor(TEST_TIMEOUT_WAIT));
+  thread.join();
+}
@@ -0,0 +1,198 @@
+#include "pch.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include "../myoddweb.directorywatcher.win/utils/Threads/TimerWheel.h"
+
+using myoddweb::directorywatcher::threads::TimerWheel;
+
+constexpr auto Origin = 1000LL;
+
+/**
+ * \brief advance the wheel one ms at a time until the timer expires.
+ * \return the time it expired at, or -1 if it never did.
+ */
+static long long AdvanceUntilExpired(TimerWheel& wheel, const long long from, const long long to)
+{
+  std::vector<TimerWheel::Timer*> expired;
+  for (auto now = from; now <= to; ++now)
+  {
+    wheel.Advance(now, expired);
+    if (!expired.empty())
+    {
+      return now;
+    }
+  }
+  return -1;
+}
+
+TEST(TimerWheel, EmptyWheelHasNothingToDo) {
+  TimerWheel wheel(1, Origin);
+  EXPECT_EQ(0, wheel.Size());
+  EXPECT_EQ(myoddweb::directorywatcher::MYODDWEB_TIMERWHEEL_NEVER, wheel.NextAdvanceMilliseconds());
+
+  std::vector<TimerWheel::Timer*> expired;
+  wheel.Advance(Origin + 100000, expired);
+  EXPECT_EQ(0, expired.size());
+}
+
+TEST(TimerWheel, TimerExpiresOnItsDeadline) {
+  TimerWheel wheel(1, Origin);
+  auto owner = 42;
+  TimerWheel::Timer timer(&owner);
+  wheel.Schedule(timer, Origin + 10);
+  EXPECT_TRUE(timer.Scheduled());
+  EXPECT_EQ(1, wheel.Size());
+
+  std::vector<TimerWheel::Timer*> expired;
+  wheel.Advance(Origin + 9, expired);
+  EXPECT_EQ(0, expired.size());
+
+  wheel.Advance(Origin + 10, expired);
+  ASSERT_EQ(1, expired.size());
+  EXPECT_EQ(&owner, expired[0]->Owner());
+  EXPECT_FALSE(timer.Scheduled());
+  EXPECT_EQ(0, wheel.Size());
+}
+
+TEST(TimerWheel, DeadlinesAreHonouredWithinOneTick) {
+  constexpr auto tick = 10LL;
+  for (auto deadline : { 1LL, 9LL, 10LL, 11LL, 639LL, 640LL, 641LL, 5000LL, 40961LL })
+  {
+    TimerWheel wheel(tick, Origin);
+    TimerWheel::Timer timer(nullptr);
+    wheel.Schedule(timer, Origin + deadline);
+
+    const auto at = AdvanceUntilExpired(wheel, Origin, Origin + deadline + tick);
+    ASSERT_NE(-1, at) << deadline;
+    EXPECT_GE(at, Origin + deadline) << deadline;
+    EXPECT_LT(at, Origin + deadline + tick) << deadline;
+  }
+}
+
+TEST(TimerWheel, TimersAreMovedDownTheLevels) {
+  TimerWheel wheel(1, Origin);
+  TimerWheel::Timer near(nullptr);
+  TimerWheel::Timer middle(nullptr);
+  TimerWheel::Timer far(nullptr);
+  wheel.Schedule(near, Origin + 50);
+  wheel.Schedule(middle, Origin + 3000);
+  wheel.Schedule(far, Origin + 300000);
+
+  // jump straight past the first two, they both expire and the last is still there.
+  std::vector<TimerWheel::Timer*> expired;
+  wheel.Advance(Origin + 4000, expired);
+  ASSERT_EQ(2, expired.size());
+  EXPECT_NE(expired.end(), std::find(expired.begin(), expired.end(), &near));
+  EXPECT_NE(expired.end(), std::find(expired.begin(), expired.end(), &middle));
+  EXPECT_TRUE(far.Scheduled());
+
+  expired.clear();
+  wheel.Advance(Origin + 299999, expired);
+  EXPECT_EQ(0, expired.size());
+  wheel.Advance(Origin + 300000, expired);
+  ASSERT_EQ(1, expired.size());
+  EXPECT_EQ(&far, expired[0]);
+}
+
+TEST(TimerWheel, CancelledTimerNeverExpires) {
+  TimerWheel wheel(1, Origin);
+  TimerWheel::Timer timer(nullptr);
+  wheel.Schedule(timer, Origin + 10);
+  wheel.Cancel(timer);
+  EXPECT_FALSE(timer.Scheduled());
+  EXPECT_EQ(0, wheel.Size());
+
+  // cancelling it again does nothing.
+  wheel.Cancel(timer);
+
+  std::vector<TimerWheel::Timer*> expired;
+  wheel.Advance(Origin + 1000, expired);
+  EXPECT_EQ(0, expired.size());
+}
+
+TEST(TimerWheel, SchedulingAgainMovesTheTimer) {
+  TimerWheel wheel(1, Origin);
+  TimerWheel::Timer timer(nullptr);
+  wheel.Schedule(timer, Origin + 10);
+  wheel.Schedule(timer, Origin + 500);
+  EXPECT_EQ(1, wheel.Size());
+
+  std::vector<TimerWheel::Timer*> expired;
+  wheel.Advance(Origin + 100, expired);
+  EXPECT_EQ(0, expired.size());
+  wheel.Advance(Origin + 500, expired);
+  EXPECT_EQ(1, expired.size());
+}
+
+TEST(TimerWheel, DeadlinesInThePastExpireOnTheNextAdvance) {
+  TimerWheel wheel(1, Origin);
+  std::vector<TimerWheel::Timer*> expired;
+  wheel.Advance(Origin + 100, expired);
+
+  TimerWheel::Timer timer(nullptr);
+  wheel.Schedule(timer, Origin + 20);
+  EXPECT_LE(wheel.NextAdvanceMilliseconds(), Origin + 100);
+
+  wheel.Advance(Origin + 100, expired);
+  EXPECT_EQ(1, expired.size());
+}
+
+TEST(TimerWheel, NextAdvanceIsNeverAfterTheFirstDeadline) {
+  TimerWheel wheel(1, Origin);
+  TimerWheel::Timer first(nullptr);
+  TimerWheel::Timer second(nullptr);
+  wheel.Schedule(second, Origin + 5000);
+  EXPECT_LE(wheel.NextAdvanceMilliseconds(), Origin + 5000);
+
+  wheel.Schedule(first, Origin + 30);
+  EXPECT_EQ(Origin + 30, wheel.NextAdvanceMilliseconds());
+
+  // following the next advance times gets us to each deadline, without going around every tick.
+  std::vector<TimerWheel::Timer*> expired;
+  auto advances = 0;
+  while (wheel.Size() > 0)
+  {
+    const auto next = wheel.NextAdvanceMilliseconds();
+    wheel.Advance(next, expired);
+    for (const auto timer : expired)
+    {
+      EXPECT_EQ(timer == &first ? Origin + 30 : Origin + 5000, next);
+    }
+    expired.clear();
+    ++advances;
+  }
+  EXPECT_LT(advances, 20);
+}
+
+TEST(TimerWheel, ManyTimersAllExpireInOrder) {
+  TimerWheel wheel(1, Origin);
+  constexpr auto numberOfTimers = 10000;
+  std::vector<std::unique_ptr<long long>> deadlines;
+  std::vector<std::unique_ptr<TimerWheel::Timer>> timers;
+  for (auto i = 0; i < numberOfTimers; ++i)
+  {
+    deadlines.emplace_back(new long long(Origin + (i * 7919LL) % 100000));
+    timers.emplace_back(new TimerWheel::Timer(deadlines.back().get()));
+    wheel.Schedule(*timers.back(), *deadlines.back());
+  }
+  EXPECT_EQ(numberOfTimers, wheel.Size());
+
+  auto count = 0;
+  std::vector<TimerWheel::Timer*> expired;
+  for (auto now = Origin; now < Origin + 100000 + 13; now += 13)
+  {
+    wheel.Advance(now, expired);
+    for (const auto timer : expired)
+    {
+      const auto deadline = *static_cast<long long*>(timer->Owner());
+      EXPECT_LE(deadline, now);
+      EXPECT_GT(deadline, now - 13);
+      ++count;
+    }
+    expired.clear();
+  }
+  EXPECT_EQ(numberOfTimers, count);
+  EXPECT_EQ(0, wheel.Size());
+}
@@ -28,7 +28,7 @@ public:
   {
     ++_endCalled;
   }
-  bool OnWorkerUpdate(float fElapsedTimeMilliseconds) override
+  bool OnWorkerUpdate(float /*fElapsedTimeMilliseconds*/) override
   {
     // we must have started
     EXPECT_TRUE(Started());
@@ -0,0 +1,115 @@
+#include "pch.h"
+
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "../myoddweb.directorywatcher.win/monitors/Base.h"
+#include "../myoddweb.directorywatcher.win/utils/Threads/WorkerPool.h"
+#include "BenchmarkHelper.h"
+#include "MonitorsManagerTestHelper.h"
+
+using myoddweb::directorywatcher::MYODDWEB_WORKERPOOL_THROTTLE;
+using myoddweb::directorywatcher::threads::WaitResult;
+using myoddweb::directorywatcher::threads::Worker;
+using myoddweb::directorywatcher::threads::WorkerPool;
+
+/**
+ * \brief a worker that, like an idle monitor, does nothing until it is told to stop.
+ */
+class IdleWorker final : public Worker
+{
+protected:
+  bool OnWorkerStart() override
+  {
+    return true;
+  }
+
+  bool OnWorkerUpdate(float) override
+  {
+    return !MustStop();
+  }
+
+  float OnWorkerNextUpdateMilliseconds() const override
+  {
+    return MustStop() ? 0.f : 60000.f;
+  }
+
+  void OnWorkerStop() override
+  {
+  }
+};
+
+class WorkerPoolBenchmark :public ::testing::TestWithParam<int> {};
+INSTANTIATE_TEST_SUITE_P(
+  WorkerPoolBenchmarks,
+  WorkerPoolBenchmark,
+  ::testing::Values(100, 1000)
+);
+
+/**
+ * \brief add idle workers to the pool and wait for all of them to start.
+ * \return if they all started.
+ */
+static bool StartIdleWorkers(WorkerPool& pool, const int numberOfWorkers, std::vector<std::unique_ptr<IdleWorker>>& workers, std::vector<Worker*>& pointers)
+{
+  for (auto i = 0; i < numberOfWorkers; ++i)
+  {
+    workers.emplace_back(new IdleWorker());
+    pointers.push_back(workers.back().get());
+  }
+
+  pool.Add(pointers);
+  return Worker::WaitUntil([&]
+  {
+    for (const auto& worker : workers)
+    {
+      if (!worker->Started())
+      {
+        return false;
+      }
+    }
+    return true;
+  }, TEST_TIMEOUT_WAIT * 10);
+}
+
+TEST_P(WorkerPoolBenchmark, DISABLED_StopManyWorkers) {
+  const auto numberOfWorkers = GetParam();
+  std::vector<std::unique_ptr<IdleWorker>> workers;
+  std::vector<Worker*> pointers;
+  WorkerPool pool(MYODDWEB_WORKERPOOL_THROTTLE);
+  ASSERT_TRUE(StartIdleWorkers(pool, numberOfWorkers, workers, pointers));
+
+  // they are all told to stop at once and we wait once for all of them.
+  const auto cpuStart = ProcessCpuMilliseconds();
+  const auto elapsed = Benchmark("StopManyWorkers", numberOfWorkers, [&]
+  {
+    EXPECT_EQ(WaitResult::complete, pool.StopAndWait(pointers, TEST_TIMEOUT_WAIT * 10));
+  });
+  const auto cpu = ProcessCpuMilliseconds() - cpuStart;
+  std::cout << "[ BENCHMARK] StopManyWorkers: " << cpu << "ms of cpu for " << elapsed << "ms of wall time" << std::endl;
+
+  for (const auto& worker : workers)
+  {
+    EXPECT_TRUE(worker->Completed());
+  }
+}
+
+TEST_P(WorkerPoolBenchmark, DISABLED_StopWorkersOneAtATime) {
+  const auto numberOfWorkers = GetParam();
+  std::vector<std::unique_ptr<IdleWorker>> workers;
+  std::vector<Worker*> pointers;
+  WorkerPool pool(MYODDWEB_WORKERPOOL_THROTTLE);
+  ASSERT_TRUE(StartIdleWorkers(pool, numberOfWorkers, workers, pointers));
+
+  // what stopping the workers costs when each one waits for the previous one.
+  const auto cpuStart = ProcessCpuMilliseconds();
+  const auto elapsed = Benchmark("StopWorkersOneAtATime", numberOfWorkers, [&]
+  {
+    for (const auto worker : pointers)
+    {
+      EXPECT_EQ(WaitResult::complete, pool.StopAndWait(*worker, TEST_TIMEOUT_WAIT * 10));
+    }
+  });
+  const auto cpu = ProcessCpuMilliseconds() - cpuStart;
+  std::cout << "[ BENCHMARK] StopWorkersOneAtATime: " << cpu << "ms of cpu for " << elapsed << "ms of wall time" << std::endl;
+}
@@ -1,4 +1,9 @@
 #include "pch.h"
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
 #include "../myoddweb.directorywatcher.win/utils/Threads/WorkerPool.h"
 #include "../myoddweb.directorywatcher.win/utils/Threads/Worker.h"
 #include "../myoddweb.directorywatcher.win/utils/Wait.h"
@@ -80,7 +85,8 @@ TEST(WorkPool, NumberOfTimesUpdatesIsCalled) {
 
 TEST(WorkPool, WaitingForAWorkerThatIsNotOurs)
 {
-  auto worker1 = TestWorker(5);
+  // the worker runs until it is stopped, otherwise the pool could complete before we check it.
+  auto worker1 = TestWorker((std::numeric_limits<int>::max)());
   auto worker2 = TestWorker(1);
 
   auto pool = ::WorkerPool(10);
@@ -167,7 +173,8 @@ TEST(WorkPool, StopAndWait) {
 
 TEST(WorkPool, CheckHasStarted)
 {
-  auto worker1 = TestWorker(5);
+  // the worker runs until it is stopped, otherwise the pool could complete before we check it.
+  auto worker1 = TestWorker((std::numeric_limits<int>::max)());
   auto worker2 = TestWorker(1);
 
   auto pool = ::WorkerPool(10);
@@ -193,3 +200,186 @@ TEST(WorkPool, CheckHasStarted)
 
   EXPECT_FALSE(pool.Started());
 }
+
+class SlowTestWorker final : public ::Worker
+{
+public:
+  std::atomic<bool> _release = false;
+  std::atomic<int> _updateCalled = 0;
+
+  void OnWorkerStop() override { _release = true; }
+  bool OnWorkerStart() override { return true; }
+  void OnWorkerEnd() override {}
+  bool OnWorkerUpdate(float /*fElapsedTimeMilliseconds*/) override
+  {
+    ++_updateCalled;
+
+    // block the update until we are told to stop.
+    while (!_release)
+    {
+      std::this_thread::yield();
+    }
+    return false;
+  }
+};
+
+TEST(WorkPool, SlowWorkerDoesNotHoldBackOtherWorkers)
+{
+  auto slowWorker = SlowTestWorker();
+  auto worker = TestWorker(5);
+
+  auto pool = ::WorkerPool(10, 2);
+  pool.Add(slowWorker);
+  pool.Add(worker);
+
+  // the other worker completes while the slow one is still in its first update.
+  EXPECT_EQ(myoddweb::directorywatcher::threads::WaitResult::complete, pool.WaitFor(worker, TEST_TIMEOUT_WAIT));
+  EXPECT_EQ(worker._maxUpdate, worker._updateCalled);
+  EXPECT_EQ(1, slowWorker._updateCalled);
+
+  // release the slow worker.
+  EXPECT_EQ(myoddweb::directorywatcher::threads::WaitResult::complete, pool.StopAndWait(TEST_TIMEOUT_WAIT));
+}
+
+class IdleTestWorker final : public ::Worker
+{
+public:
+  std::atomic<int> _updateCalled = 0;
+
+  void OnWorkerStop() override {}
+  bool OnWorkerStart() override { return true; }
+  void OnWorkerEnd() override {}
+  bool OnWorkerUpdate(float /*fElapsedTimeMilliseconds*/) override
+  {
+    ++_updateCalled;
+    return true;
+  }
+
+  // we never need an update unless we are woken up.
+  float OnWorkerNextUpdateMilliseconds() const override { return 60000; }
+};
+
+TEST(WorkPool, IdleWorkerIsOnlyUpdatedWhenWoken)
+{
+  auto worker = IdleTestWorker();
+
+  auto pool = ::WorkerPool(10, 2);
+  pool.Add(worker);
+  if (!Wait::SpinUntil([&]
+    {
+      return worker.Started();
+    }, TEST_TIMEOUT))
+  {
+    GTEST_FATAL_FAILURE_("Unable to start worker");
+  }
+
+  // the worker has nothing to do, so it is never updated.
+  Wait::Delay(100);
+  EXPECT_EQ(0, worker._updateCalled);
+
+  // wake it once.
+  pool.Wake(worker);
+  EXPECT_TRUE(Wait::SpinUntil([&]
+    {
+      return worker._updateCalled == 1;
+    }, TEST_TIMEOUT_WAIT));
+
+  // and it goes back to sleep.
+  Wait::Delay(100);
+  EXPECT_EQ(1, worker._updateCalled);
+
+  EXPECT_EQ(myoddweb::directorywatcher::threads::WaitResult::complete, pool.StopAndWait(TEST_TIMEOUT_WAIT));
+}
+
+TEST(WorkPool, StopAndWaitManyWorkersAtOnce)
+{
+  std::vector<std::unique_ptr<IdleTestWorker>> workers;
+  std::vector<::Worker*> pointers;
+  for (auto i = 0; i < 50; ++i)
+  {
+    workers.emplace_back(new IdleTestWorker());
+    pointers.push_back(workers.back().get());
+  }
+
+  auto pool = ::WorkerPool(10, 2);
+  pool.Add(pointers);
+  if (!Wait::SpinUntil([&]
+    {
+      for (const auto& worker : workers)
+      {
+        if (!worker->Started())
+        {
+          return false;
+        }
+      }
+      return true;
+    }, TEST_TIMEOUT_WAIT))
+  {
+    GTEST_FATAL_FAILURE_("Unable to start workers");
+  }
+
+  // they are all told to stop and we wait once for all of them.
+  EXPECT_EQ(myoddweb::directorywatcher::threads::WaitResult::complete, pool.StopAndWait(pointers, TEST_TIMEOUT_WAIT));
+  for (const auto& worker : workers)
+  {
+    EXPECT_TRUE(worker->Completed());
+  }
+
+  // stopping them again does nothing.
+  EXPECT_EQ(myoddweb::directorywatcher::threads::WaitResult::complete, pool.StopAndWait(pointers, TEST_TIMEOUT_WAIT));
+}
+
+TEST(WorkPool, StoppingSomeWorkersKeepsTheOthersRunning)
+{
+  std::vector<std::unique_ptr<IdleTestWorker>> workers;
+  std::vector<::Worker*> stopped;
+  std::vector<::Worker*> running;
+  for (auto i = 0; i < 50; ++i)
+  {
+    workers.emplace_back(new IdleTestWorker());
+    (i % 2 == 0 ? stopped : running).push_back(workers.back().get());
+  }
+
+  auto pool = ::WorkerPool(10, 2);
+  pool.Add(stopped);
+  pool.Add(running);
+  if (!Wait::SpinUntil([&]
+    {
+      for (const auto& worker : workers)
+      {
+        if (!worker->Started())
+        {
+          return false;
+        }
+      }
+      return true;
+    }, TEST_TIMEOUT_WAIT))
+  {
+    GTEST_FATAL_FAILURE_("Unable to start workers");
+  }
+
+  // every other worker is removed from the running workers.
+  EXPECT_EQ(myoddweb::directorywatcher::threads::WaitResult::complete, pool.StopAndWait(stopped, TEST_TIMEOUT_WAIT));
+
+  // the others are still running and are still updated when they are woken up.
+  std::vector<int> updates;
+  for (const auto worker : running)
+  {
+    EXPECT_FALSE(worker->Completed());
+    updates.push_back(static_cast<IdleTestWorker*>(worker)->_updateCalled);
+    pool.Wake(*worker);
+  }
+  EXPECT_TRUE(Wait::SpinUntil([&]
+    {
+      for (size_t i = 0; i < running.size(); ++i)
+      {
+        if (static_cast<IdleTestWorker*>(running[i])->_updateCalled <= updates[i])
+        {
+          return false;
+        }
+      }
+      return true;
+    }, TEST_TIMEOUT_WAIT));
+
+  EXPECT_EQ(myoddweb::directorywatcher::threads::WaitResult::complete, pool.StopAndWait(running, TEST_TIMEOUT_WAIT));
+}
@@ -32,6 +32,30 @@ namespace myoddweb:: directorywatcher
    */
   const auto MYODDWEB_WORKERPOOL_THROTTLE = 10L;
 
+  /**
+   * \brief the number of threads the worker pool uses to update the workers.
+   *        0 means one thread per core.
+   */
+  constexpr auto MYODDWEB_WORKERPOOL_THREADS = 0u;
+
+  /**
+   * \brief the longest the worker pool will sleep when none of the workers need an update.
+   *        Workers normally wake the pool up when they have something to do, this is a safety net.
+   */
+  constexpr auto MYODDWEB_WORKERPOOL_MAX_WAIT = 500L;
+
+  /**
+   * \brief the number of threads delivering the events and statistics to the host.
+   *        The callbacks are called on those threads so a slow callback never delays the worker pool.
+   */
+  constexpr auto MYODDWEB_PUBLISHER_THREADS = 2u;
+
+  /**
+   * \brief the number of windows of events a monitor can have waiting to be delivered.
+   *        If the callback cannot keep up the oldest window is dropped and an overflow error is raised.
+   */
+  constexpr auto MYODDWEB_PUBLISHER_MAX_PENDING_WINDOWS = 16;
+
   /**
    * \brief The min number of Milliseconds we want to wait for an IO signal.
    *        If this number is too low then we will use more CPU.
@@ -95,4 +119,117 @@ namespace myoddweb:: directorywatcher
    *        but it should not be that important
    */
   constexpr auto MYODDWEB_MAX_EVENT_AGE_BUFFER = 1000;
+
+  /**
+   * \brief the size of each block of memory used by the arenas that hold the events.
+   *        each event uses roughly 100 bytes, plus the length of the path(s).
+   */
+  constexpr auto MYODDWEB_ARENA_BLOCK_SIZE = 65536;
+
+  /**
+   * \brief the number of shards the collector spreads the producers across.
+   *        each thread adding events gets its own shard, up to that number.
+   */
+  constexpr auto MYODDWEB_COLLECTOR_SHARDS = 16;
+
+  /**
+   * \brief the smallest and largest buffers the buffer pool recycles, as a power of 2.
+   *        1024 bytes up to 65536 bytes, (the size of the buffer each directory reads into and of the arena blocks).
+   *        Anything larger is allocated and freed every time.
+   */
+  constexpr auto MYODDWEB_BUFFERPOOL_MIN_SIZE_SHIFT = 10;
+  constexpr auto MYODDWEB_BUFFERPOOL_MAX_SIZE_SHIFT = 16;
+
+  /**
+   * \brief the maximum number of free buffers the pool keeps for each size.
+   *        Any buffer above that is given back so a burst of changes does not hold on to the memory.
+   */
+  constexpr auto MYODDWEB_BUFFERPOOL_MAX_FREE_BUFFERS = 64;
+
+  /**
+   * \brief the maximum number of files/directories each monitor remembers
+   *        so it does not need to ask the file system if an entry is a file or not.
+   *        Once full, the entry used the longest time ago is removed.
+   */
+  constexpr auto MYODDWEB_ENTRYCACHE_MAX_ENTRIES = 4096;
+
+  /**
+   * \brief the smallest and starting size of the buffer each directory reads the changes into.
+   *        the buffer grows when it overflows or is nearly full, up to the size given by the monitor,
+   *        and shrinks back when it is mostly empty for a while, so idle folders do not hold on to memory.
+   */
+  constexpr auto MYODDWEB_READ_BUFFER_MIN_SIZE = 4096ul;
+  constexpr auto MYODDWEB_READ_BUFFER_INITIAL_SIZE = 16384ul;
+
+  /**
+   * \brief how long the read buffer must be mostly empty before we make it smaller.
+   */
+  constexpr auto MYODDWEB_READ_BUFFER_IDLE_MILLISECONDS = 60000;
+
+  /**
+   * \brief the number of threads looking for the sub-folders when a recursive monitor starts.
+   *        Listing a folder mostly waits for the disk, (or the network), so this does not depend on the number of cores.
+   */
+  constexpr auto MYODDWEB_CRAWLER_THREADS = 8u;
+
+  /**
+   * \brief the size of the buffer the entries of a folder are read into, in bytes.
+   */
+  constexpr auto MYODDWEB_CRAWLER_BUFFER_SIZE = 65536;
+
+  /**
+   * \brief a touched path that keeps changing is still published once it was held that many times the settle time.
+   *        so a file that is always being written to, (a log file), is not held forever.
+   */
+  constexpr auto MYODDWEB_SETTLE_MAX_HOLD_FACTOR = 10;
+
+  /**
+   * \brief the number of ms in a tick of the timing wheel, a timer is never late by more than that.
+   */
+  constexpr auto MYODDWEB_TIMERWHEEL_TICK = 1LL;
+
+  /**
+   * \brief the number of slots of each level of the timing wheel, as a number of bits.
+   */
+  constexpr auto MYODDWEB_TIMERWHEEL_SLOT_BITS = 6;
+  constexpr auto MYODDWEB_TIMERWHEEL_SLOTS = 1 << MYODDWEB_TIMERWHEEL_SLOT_BITS;
+
+  /**
+   * \brief the number of levels of the timing wheel, with 1ms ticks 4 levels of 64 slots cover about 4.6 hours.
+   *        timers further than that are simply kept in the last level until they are close enough.
+   */
+  constexpr auto MYODDWEB_TIMERWHEEL_LEVELS = 4;
+
+  /**
+   * \brief the time of a timer that never expires.
+   */
+  constexpr auto MYODDWEB_TIMERWHEEL_NEVER = 0x7fffffffffffffffLL;
+
+  /**
+   * \brief the number of log records waiting to be delivered to the loggers, once full the records are dropped and counted.
+   */
+  constexpr auto MYODDWEB_LOGGER_RING_SIZE = 1024;
+
+  /**
+   * \brief the maximum number of characters in a log message, including the terminating null, longer messages are truncated.
+   */
+  constexpr auto MYODDWEB_LOGGER_MAX_MESSAGE = 512;
+
+  /**
+   * \brief how long we wait, in ms, for the messages of a logger to be delivered before it is removed.
+   */
+  constexpr auto MYODDWEB_LOGGER_FLUSH_TIMEOUT = 1000;
+
+  /**
+   * \brief the number of copies of the counters of each monitor, each thread adds to one of them
+   *        so the threads reading the changes of the same monitor do not fight over the same cache line.
+   *        A copy is only created once a thread adds to it.
+   */
+  constexpr auto MYODDWEB_METRICS_SHARDS = 8;
+
+  /**
+   * \brief the number of buckets of the duration histograms, bucket n counts the durations under 2^n microseconds,
+   *        the last bucket counts everything else, (about 9 minutes and more).
+   */
+  constexpr auto MYODDWEB_METRICS_HISTOGRAM_BUCKETS = 31;
 }
@@ -2,6 +2,12 @@
 // Florent Guelfucci licenses this file to you under the MIT license.
 // See the LICENSE file in the project root for more information.
 #pragma once
+#include "Base.h"
+
+#if !defined(_WIN32)
+  // the calling convention only matters on windows.
+  #define __stdcall
+#endif
 
 namespace myoddweb:: directorywatcher
 {
@@ -48,4 +54,217 @@ namespace myoddweb:: directorywatcher
     int error,
     long long dateTimeUtc
     );
+
+  /**
+   * \brief a single event in a batch of events.
+   *        The names are not part of the record, they are in the names block given with the batch
+   *        the offsets and lengths are in characters, (not bytes), and do not include the null terminator.
+   */
+  struct EventRecord
+  {
+    /**
+     * \brief unix timestamp of the event
+     */
+    long long DateTimeUtc;
+
+    /**
+     * \brief the action that happened
+     */
+    int Action;
+
+    /**
+     * \brief the error type, (if any)
+     */
+    int Error;
+
+    /**
+     * \brief 1 if the event is for a file, 0 if it is for a directory.
+     */
+    int IsFile;
+
+    /**
+     * \brief where the name starts in the names block.
+     */
+    int NameOffset;
+
+    /**
+     * \brief the number of characters in the name.
+     */
+    int NameLength;
+
+    /**
+     * \brief where the old name starts in the names block, -1 if there is no old name.
+     */
+    int OldNameOffset;
+
+    /**
+     * \brief the number of characters in the old name.
+     */
+    int OldNameLength;
+  };
+
+  /**
+   * \brief the callback function when a batch of events is published.
+   *        The records and the names are only valid for the duration of the call.
+   * \param id the monitor id
+   * \param events the events, from the oldest to the newest.
+   * \param numberOfEvents the number of events.
+   * \param names all the names, each one is null terminated.
+   * \param namesLength the number of characters in the names block.
+   */
+  typedef void(__stdcall *EventsBatchCallback)(
+    long long id,
+    const EventRecord* events,
+    int numberOfEvents,
+    const wchar_t* names,
+    int namesLength
+    );
+
+  /**
+   * \brief the spread of a duration, bucket n counts the durations under 2^n microseconds, (see MYODDWEB_METRICS_HISTOGRAM_BUCKETS).
+   */
+  struct MonitorHistogram
+  {
+    /**
+     * \brief the number of durations recorded.
+     */
+    long long Count;
+
+    /**
+     * \brief the total and the longest of all the durations.
+     */
+    double TotalMilliseconds;
+    double MaxMilliseconds;
+
+    /**
+     * \brief the estimated median, 90th and 99th percentiles, (the upper bound of the bucket they fall in).
+     */
+    double P50Milliseconds;
+    double P90Milliseconds;
+    double P99Milliseconds;
+
+    /**
+     * \brief the number of durations in each bucket.
+     */
+    long long Buckets[MYODDWEB_METRICS_HISTOGRAM_BUCKETS];
+  };
+
+  /**
+   * \brief how well the host keeps up with the events of a monitor, all the values are since the monitor started.
+   */
+  struct MonitorStatistics
+  {
+    /**
+     * \brief the size of the structure, the host sets it to sizeof(MonitorStatistics) before asking for the statistics.
+     *        new values are only ever added at the end, a host built with another layout is refused rather than given the wrong values.
+     */
+    int Size;
+
+    /**
+     * \brief the number of events delivered to the host.
+     */
+    long long NumberOfEvents;
+
+    /**
+     * \brief the number of events dropped because the callback could not keep up.
+     */
+    long long NumberOfDroppedEvents;
+
+    /**
+     * \brief the number of windows of events waiting to be delivered.
+     */
+    int QueueDepth;
+
+    /**
+     * \brief the largest number of windows that were waiting to be delivered.
+     */
+    int MaxQueueDepth;
+
+    /**
+     * \brief the number of times the events callback was called, (once per window in batch mode).
+     */
+    long long NumberOfCallbacks;
+
+    /**
+     * \brief the total time spent in the events callback.
+     */
+    double TotalCallbackMilliseconds;
+
+    /**
+     * \brief the longest time spent delivering a single window of events.
+     */
+    double MaxCallbackMilliseconds;
+
+    /**
+     * \brief the number of times we knew if an entry was a file or a directory without asking the file system.
+     */
+    long long NumberOfEntryCacheHits;
+
+    /**
+     * \brief the number of times we had to ask the file system if an entry was a file or a directory.
+     */
+    long long NumberOfEntryCacheMisses;
+
+    /**
+     * \brief the total size, in bytes, of the buffers the changes are read into.
+     */
+    long long ReadBufferSize;
+
+    /**
+     * \brief the number of times a read buffer was too small and some changes were lost.
+     */
+    long long NumberOfReadOverflows;
+
+    /**
+     * \brief the time it took to look for all the sub-folders and start watching them, (or so far if still starting).
+     *        zero for monitors that do not need to look for the sub-folders.
+     */
+    long long StartupMilliseconds;
+
+    /**
+     * \brief the number of events collected, before they were coalesced or their duplicates removed.
+     */
+    long long NumberOfCollectedEvents;
+
+    /**
+     * \brief the number of events that were removed because they did not change the net effect, (see Request::CoalesceEvents()).
+     *        compared to the number of collected events this is how much the coalescing saved.
+     */
+    long long NumberOfCoalescedEvents;
+
+    /**
+     * \brief the number of touched paths currently held until they settle, (see Request::SettleMilliseconds()).
+     */
+    long long NumberOfSettlingPaths;
+
+    /**
+     * \brief the number of events given to the collector, before anything was removed.
+     */
+    long long NumberOfReceivedEvents;
+
+    /**
+     * \brief the number of events removed because a newer event of the same path and action was collected.
+     */
+    long long NumberOfDeduplicatedEvents;
+
+    /**
+     * \brief the number of bytes of changes read from the file system.
+     */
+    long long NumberOfBytesRead;
+
+    /**
+     * \brief the time it took to take the events from the monitor and queue them for delivery.
+     */
+    MonitorHistogram PublishMilliseconds;
+
+    /**
+     * \brief the time spent in the events callback, once per window of events.
+     */
+    MonitorHistogram CallbackMilliseconds;
+
+    /**
+     * \brief how old each event was when it was given to the host.
+     */
+    MonitorHistogram EventAgeMilliseconds;
+  };
 }
\ No newline at end of file
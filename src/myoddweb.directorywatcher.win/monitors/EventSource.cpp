@@ -0,0 +1,135 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#include "EventSource.h"
+#include "../utils/BufferPool.h"
+#include "../utils/Lock.h"
+
+namespace myoddweb:: directorywatcher
+{
+  /**
+   * \brief create the source, nothing is borrowed until the first read.
+   * \param bufferSize the policy that decides the size of our reads.
+   */
+  EventSource::EventSource(BufferSizePolicy& bufferSize) :
+    _bufferSize(bufferSize),
+    _readBuffer(nullptr),
+    _readLength(0),
+    _pendingBytes(0)
+  {
+  }
+
+  EventSource::~EventSource()
+  {
+    ReleaseBuffers();
+  }
+
+  /**
+   * \brief get all the buffers received so far, the caller owns them
+   *        and must give them back to the shared buffer pool.
+   */
+  std::vector<EventSource::Notification> EventSource::Get()
+  {
+    std::vector<Notification> pending;
+    MYODDWEB_LOCK(_lock);
+    pending.swap(_pending);
+    _pendingBytes = 0;
+    return pending;
+  }
+
+  /**
+   * \brief the number of bytes borrowed from the shared pool,
+   *        for the read in flight as well as the data waiting to be processed.
+   */
+  unsigned long long EventSource::NumberOfBorrowedBytes() const
+  {
+    MYODDWEB_LOCK(_lock);
+    return _pendingBytes + (_readBuffer == nullptr ? 0 : _readLength);
+  }
+
+  /**
+   * \brief borrow the buffer for the next read, its size comes from the policy.
+   *        if we still have the buffer of a read that did not complete it is reused.
+   * \return the buffer to read into, (see ReadLength()).
+   */
+  unsigned char* EventSource::BeginRead()
+  {
+    const auto size = _bufferSize.Size();
+    MYODDWEB_LOCK(_lock);
+    if (_readBuffer != nullptr && size == _readLength)
+    {
+      return _readBuffer;
+    }
+
+    // the size changed since the last read.
+    BufferPool::Shared().Release(_readBuffer);
+    _readBuffer = BufferPool::Shared().Acquire(size);
+    _readLength = size;
+    return _readBuffer;
+  }
+
+  /**
+   * \brief the size of the buffer returned by BeginRead()
+   */
+  unsigned long EventSource::ReadLength() const
+  {
+    MYODDWEB_LOCK(_lock);
+    return _readLength;
+  }
+
+  /**
+   * \brief the read completed, the buffer is moved to the data waiting to be processed
+   *        and the next read will need to borrow another one.
+   * \param numberOfBytes the number of bytes read.
+   * \return false if the number of bytes is more than the buffer could hold.
+   */
+  bool EventSource::CompleteRead(const unsigned long numberOfBytes)
+  {
+    {
+      MYODDWEB_LOCK(_lock);
+      if (_readBuffer == nullptr || numberOfBytes > _readLength)
+      {
+        return false;
+      }
+
+      // we do not copy the data, the pending buffer is the one we read into.
+      _pending.push_back({ _readBuffer, numberOfBytes });
+      _pendingBytes += _readLength;
+      _readBuffer = nullptr;
+    }
+
+    // let the policy know how much of the buffer we used, the next read might be a different size.
+    _bufferSize.OnRead(numberOfBytes);
+    return true;
+  }
+
+  /**
+   * \brief the read did not give us anything, give the buffer back.
+   */
+  void EventSource::CancelRead()
+  {
+    MYODDWEB_LOCK(_lock);
+    BufferPool::Shared().Release(_readBuffer);
+    _readBuffer = nullptr;
+  }
+
+  /**
+   * \brief the read buffer was too small and the changes were lost.
+   */
+  void EventSource::OverflowRead() const
+  {
+    _bufferSize.OnOverflow();
+  }
+
+  /**
+   * \brief give back the read buffer as well as the data that was not processed.
+   */
+  void EventSource::ReleaseBuffers()
+  {
+    CancelRead();
+    for (const auto& notification : Get())
+    {
+      BufferPool::Shared().Release(notification.Buffer);
+    }
+  }
+}
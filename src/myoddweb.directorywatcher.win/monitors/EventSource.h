@@ -0,0 +1,123 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#pragma once
+#include <vector>
+#include "Base.h"
+#include "../utils/BufferSizePolicy.h"
+
+namespace myoddweb:: directorywatcher
+{
+  /**
+   * \brief where a monitor gets the raw changes of one root from.
+   *        The source does not own a read buffer, it borrows one from the shared buffer pool
+   *        only while a read is in flight and hands it over once the read completes,
+   *        so a root without a read in flight only costs the size of the source itself.
+   */
+  class EventSource
+  {
+  public:
+    /**
+     * \brief a buffer received by a read and the number of bytes in it.
+     */
+    struct Notification
+    {
+      unsigned char* Buffer;
+      unsigned long Length;
+    };
+
+    explicit EventSource(BufferSizePolicy& bufferSize);
+    virtual ~EventSource();
+
+    EventSource() = delete;
+    EventSource(const EventSource&) = delete;
+    EventSource(EventSource&&) = delete;
+    EventSource& operator=(const EventSource&) = delete;
+    EventSource& operator=(EventSource&&) = delete;
+
+    /**
+     * \brief start watching the root.
+     * \return if we managed to start the monitoring or not.
+     */
+    virtual bool Start() = 0;
+
+    /**
+     * \brief stop watching the root, the buffers are given back to the pool.
+     */
+    virtual void Stop() = 0;
+
+    /**
+     * \brief get all the buffers received so far, the caller owns them
+     *        and must give them back to the shared buffer pool.
+     */
+    std::vector<Notification> Get();
+
+    /**
+     * \brief the number of bytes borrowed from the shared pool,
+     *        for the read in flight as well as the data waiting to be processed.
+     */
+    [[nodiscard]]
+    unsigned long long NumberOfBorrowedBytes() const;
+
+  protected:
+    /**
+     * \brief borrow the buffer for the next read, its size comes from the policy.
+     *        if we still have the buffer of a read that did not complete it is reused.
+     * \return the buffer to read into, (see ReadLength()).
+     */
+    unsigned char* BeginRead();
+
+    /**
+     * \brief the size of the buffer returned by BeginRead()
+     */
+    [[nodiscard]]
+    unsigned long ReadLength() const;
+
+    /**
+     * \brief the read completed, the buffer is moved to the data waiting to be processed
+     *        and the next read will need to borrow another one.
+     * \param numberOfBytes the number of bytes read.
+     * \return false if the number of bytes is more than the buffer could hold.
+     */
+    bool CompleteRead(unsigned long numberOfBytes);
+
+    /**
+     * \brief the read did not give us anything, give the buffer back.
+     */
+    void CancelRead();
+
+    /**
+     * \brief the read buffer was too small and the changes were lost.
+     */
+    void OverflowRead() const;
+
+    /**
+     * \brief give back the read buffer as well as the data that was not processed.
+     */
+    void ReleaseBuffers();
+
+  private:
+    /**
+     * \brief decides how large the read buffer should be, it is owned by the monitor.
+     */
+    BufferSizePolicy& _bufferSize;
+
+    /**
+     * \brief the buffer borrowed for the read in flight, if any.
+     */
+    unsigned char* _readBuffer;
+    unsigned long _readLength;
+
+    mutable MYODDWEB_MUTEX _lock;
+
+    /**
+     * \brief the reads that completed but were not processed yet.
+     */
+    std::vector<Notification> _pending;
+
+    /**
+     * \brief the size of the buffers waiting to be processed.
+     */
+    unsigned long long _pendingBytes;
+  };
+}
@@ -2,9 +2,15 @@
 // Florent Guelfucci licenses this file to you under the MIT license.
 // See the LICENSE file in the project root for more information.
 #include "EventsPublisher.h"
+#include <algorithm>
+#include <chrono>
+#include <limits>
 #include <vector>
+#include "../utils/Collector.h"
 #include "../utils/Event.h"
+#include "../utils/EventError.h"
 #include "../utils/Instrumentor.h"
+#include "../utils/Lock.h"
 #include "../utils/Logger.h"
 #include "../utils/LogLevel.h"
 #include "Monitor.h"
@@ -16,38 +22,84 @@ namespace myoddweb::directorywatcher
     _monitor(monitor),
     _id(id),
     _request(request),
-    _elapsedEventsTimeMilliseconds(0),
-    _elapsedStatisticsTimeMilliseconds(0)
+    _nextEventsMilliseconds(0),
+    _nextStatisticsMilliseconds(0),
+    _lastStatisticsMilliseconds(0),
+    _hasPendingStatistics(false),
+    _pendingStatisticsElapsedTimeMilliseconds(0),
+    _delivering(false),
+    _overflowRaised(false)
   {
+    // the first events and statistics are due one rate from now.
+    const auto now = threads::WorkerPool::NowMilliseconds();
+    _nextEventsMilliseconds = now + _request.EventsCallbackRateMilliseconds();
+    _nextStatisticsMilliseconds = now + _request.StatsCallbackRateMilliseconds();
+    _lastStatisticsMilliseconds = now;
+  }
+
+  EventsPublisher::~EventsPublisher()
+  {
+    // the task delivering our events must be done before we go.
+    {
+      std::unique_lock<MYODDWEB_MUTEX> lock(_lock);
+      _delivered.wait(lock, [this] { return !_delivering; });
+    }
 
+    for (auto window : _pendingWindows)
+    {
+      delete window;
+    }
+    _pendingWindows.clear();
+    for (auto window : _spareWindows)
+    {
+      delete window;
+    }
+    _spareWindows.clear();
   }
 
   /**
-   * \brief check if the time has now elapsed.
-   * \param fElapsedTimeMilliseconds the number of ms since the last time we checked.
+   * \brief move a deadline to the next one after the current time.
+   * \param deadlineMilliseconds the deadline that was reached.
+   * \param rateMilliseconds how often the deadline comes.
+   * \param nowMilliseconds the current time.
+   * \return the next deadline.
+   */
+  long long EventsPublisher::NextDeadline(const long long deadlineMilliseconds, const long long rateMilliseconds, const long long nowMilliseconds)
+  {
+    // we keep the same rhythm, unless we fell a whole rate behind
+    // in which case we do not try to catch up with all the ones we missed.
+    const auto next = deadlineMilliseconds + rateMilliseconds;
+    return next > nowMilliseconds ? next : nowMilliseconds + rateMilliseconds;
+  }
+
+  /**
+   * \brief check if the events are now due, if they are the next ones are scheduled.
+   * \param nowMilliseconds the current time.
    * \return if the time has elapsed and we can continue.
    */
-  bool EventsPublisher::HasEventsElapsed(const float fElapsedTimeMilliseconds)
+  bool EventsPublisher::HasEventsElapsed(const long long nowMilliseconds)
   {
     if( !_request.IsUsingEvents())
     {
       return false;
     }
 
-    _elapsedEventsTimeMilliseconds += fElapsedTimeMilliseconds;
-    if (_elapsedEventsTimeMilliseconds < static_cast<float>(_request.EventsCallbackRateMilliseconds()))
+    if (nowMilliseconds < _nextEventsMilliseconds)
     {
       return false;
     }
 
     //  restart the timer.
-    while (_elapsedEventsTimeMilliseconds > static_cast<float>(_request.EventsCallbackRateMilliseconds())) {
-      _elapsedEventsTimeMilliseconds -= static_cast<float>(_request.EventsCallbackRateMilliseconds());
-    }
+    _nextEventsMilliseconds = NextDeadline(_nextEventsMilliseconds, _request.EventsCallbackRateMilliseconds(), nowMilliseconds);
     return true;
   }
 
-  float EventsPublisher::HasStatisticsElapsed(const float fElapsedTimeMilliseconds)
+  /**
+   * \brief check if the statistics are now due, if they are the next ones are scheduled.
+   * \param nowMilliseconds the current time.
+   * \return 0 if the number has not elapsed otherwise the number of ms since we last published them.
+   */
+  float EventsPublisher::HasStatisticsElapsed(const long long nowMilliseconds)
   {
     // are we using stats?
     if( !_request.IsUsingStatistics())
@@ -55,38 +107,66 @@ namespace myoddweb::directorywatcher
       return 0;
     }
 
-    _elapsedStatisticsTimeMilliseconds += fElapsedTimeMilliseconds;
-    if (_elapsedStatisticsTimeMilliseconds < static_cast<float>(_request.StatsCallbackRateMilliseconds()))
+    if (nowMilliseconds < _nextStatisticsMilliseconds)
     {
       return 0;
     }
 
-    const auto actualElapsedTimeMilliseconds = _elapsedStatisticsTimeMilliseconds;
+    const auto actualElapsedTimeMilliseconds = static_cast<float>((std::max)(nowMilliseconds - _lastStatisticsMilliseconds, 1LL));
+    _lastStatisticsMilliseconds = nowMilliseconds;
 
     //  restart the timer.
-    while (_elapsedStatisticsTimeMilliseconds > static_cast<float>(_request.StatsCallbackRateMilliseconds())) {
-      _elapsedStatisticsTimeMilliseconds -= static_cast<float>(_request.StatsCallbackRateMilliseconds());
-    }
+    _nextStatisticsMilliseconds = NextDeadline(_nextStatisticsMilliseconds, _request.StatsCallbackRateMilliseconds(), nowMilliseconds);
     return actualElapsedTimeMilliseconds;
   }
 
-  void EventsPublisher::Update(const float fElapsedTimeMilliseconds)
+  /**
+   * \brief called at various intervals, we publish whatever is due.
+   */
+  void EventsPublisher::Update()
   {
+    const auto now = threads::WorkerPool::NowMilliseconds();
+
     // first check the events
-    UpdateEvents(fElapsedTimeMilliseconds);
+    UpdateEvents(now);
 
     // then the stats
-    UpdateStatistics(fElapsedTimeMilliseconds);
+    UpdateStatistics(now);
+  }
+
+  /**
+   * \brief how long until we next have something to publish.
+   *        If we have no events and no statistics to publish we never need to be updated.
+   * \return the number of ms until the next events or statistics are due.
+   */
+  float EventsPublisher::MillisecondsUntilNextUpdate() const
+  {
+    const auto now = threads::WorkerPool::NowMilliseconds();
+    auto milliseconds = (std::numeric_limits<float>::max)();
+
+    // there is no need to wake up for events if we have none.
+    if (_request.IsUsingEvents() && _monitor.HasEvents())
+    {
+      milliseconds = static_cast<float>(_nextEventsMilliseconds - now);
+    }
+
+    // but the statistics are published even when nothing happened.
+    if (_request.IsUsingStatistics())
+    {
+      const auto statistics = static_cast<float>(_nextStatisticsMilliseconds - now);
+      milliseconds = (std::min)(milliseconds, statistics);
+    }
+    return milliseconds;
   }
 
   /**
    * \brief called at various intervals.
-   * \param fElapsedTimeMilliseconds the number of ms since the last update
+   * \param nowMilliseconds the current time.
    */
-  void EventsPublisher::UpdateEvents(float fElapsedTimeMilliseconds)
+  void EventsPublisher::UpdateEvents(const long long nowMilliseconds)
   {
     // check if we are ready.
-    if (!HasEventsElapsed(fElapsedTimeMilliseconds))
+    if (!HasEventsElapsed(nowMilliseconds))
     {
       return;
     }
@@ -95,14 +175,24 @@ namespace myoddweb::directorywatcher
     PublishEvents();
   }
 
+  /**
+   * \brief get how well the host is keeping up with our events.
+   * \param statistics the statistics we are filling.
+   */
+  void EventsPublisher::GetStatistics(MonitorStatistics& statistics) const
+  {
+    MYODDWEB_LOCK(_lock);
+    statistics = _statistics;
+  }
+
   /**
    * \brief called at various intervals.
-   * \param fElapsedTimeMilliseconds the number of ms since the last update
+   * \param nowMilliseconds the current time.
    */
-  void EventsPublisher::UpdateStatistics(float fElapsedTimeMilliseconds)
+  void EventsPublisher::UpdateStatistics(const long long nowMilliseconds)
   {
     // check if we are ready.
-    const auto actualElapsedTimeMilliseconds = HasStatisticsElapsed(fElapsedTimeMilliseconds);
+    const auto actualElapsedTimeMilliseconds = HasStatisticsElapsed(nowMilliseconds);
     if (actualElapsedTimeMilliseconds == 0 )
     {
       return;
@@ -113,7 +203,7 @@ namespace myoddweb::directorywatcher
     EnsureStatisticsAreUpToDateIfNotCollectingEvents();
 
     // then we can publish the stats
-    PublishStatistics(actualElapsedTimeMilliseconds);
+    QueueStatistics(actualElapsedTimeMilliseconds);
   }
 
   /**
@@ -130,31 +220,229 @@ namespace myoddweb::directorywatcher
       return;
     }
 
+    // the events belong to the host, we only count the ones it took.
+    if (_request.IsPullingEvents())
+    {
+      const auto numberOfEvents = _monitor.TakeNumberOfPulledEvents();
+      MYODDWEB_LOCK(_lock);
+      _currentStatistics.numberOfEvents += numberOfEvents;
+      return;
+    }
+
     // other wise get all the events.
     // and make sure that we update our stats accordingly.
     auto events = std::vector<Event*>();
-    if (0 != _monitor.GetEvents(events))
+    const auto numberOfEvents = _monitor.GetEvents(events, _memory);
+
+    // we are done with the events
+    // so we can release them all in one go.
+    _memory.Reset();
+
+    MYODDWEB_LOCK(_lock);
+    _currentStatistics.numberOfEvents += numberOfEvents;
+  }
+
+  /**
+   * \brief queue the statistics to be delivered.
+   * \param actualElapsedTimeMilliseconds the number of ms since the last time we published
+   */
+  void EventsPublisher::QueueStatistics(const float actualElapsedTimeMilliseconds)
+  {
+    {
+      MYODDWEB_LOCK(_lock);
+
+      // if the previous statistics were not delivered yet, we add to them.
+      _pendingStatisticsElapsedTimeMilliseconds += actualElapsedTimeMilliseconds;
+      _hasPendingStatistics = true;
+      if (!StartDeliveryInLock())
+      {
+        return;
+      }
+    }
+    Deliver();
+  }
+
+  /**
+   * \brief publish all the events
+   */
+  void EventsPublisher::PublishEvents()
+  {
+    MYODDWEB_PROFILE_FUNCTION();
+
+    // get the events.
+    const auto start = std::chrono::steady_clock::now();
+    auto events = std::vector<Event*>();
+    if (0 != _monitor.GetEvents(events, _memory))
+    {
+      QueueEvents(events);
+      _monitor.MonitorMetrics().Record(Metrics::Timing::Publish, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    // the window has its own copy of the events
+    // so we can release them all in one go.
+    _memory.Reset();
+  }
+
+  /**
+   * \brief queue a window of events to be delivered, if we have too many windows waiting the oldest is dropped.
+   * \param events the events we are queuing.
+   */
+  void EventsPublisher::QueueEvents(const std::vector<Event*>& events)
+  {
+    MYODDWEB_PROFILE_FUNCTION();
+
+    // re-use a window that was already delivered if we can.
+    EventsBatch* window = nullptr;
     {
-      // then call the callback
-      for (auto it = events.begin(); it != events.end(); ++it)
+      MYODDWEB_LOCK(_lock);
+      if (!_spareWindows.empty())
       {
-        const auto& event = (*it);
+        window = _spareWindows.back();
+        _spareWindows.pop_back();
+      }
+    }
+    if (window == nullptr)
+    {
+      window = new EventsBatch();
+    }
 
-        // update the stats
-        UpdateStatistics(*event);
+    // build it outside of the lock so we do not slow the delivery down.
+    window->Build(events);
 
-        // we are done with the event
-        // so we can get rid of it.
-        delete event;
+    auto overflow = false;
+    auto deliverNow = false;
+    {
+      MYODDWEB_LOCK(_lock);
+      if (static_cast<int>(_pendingWindows.size()) >= MYODDWEB_PUBLISHER_MAX_PENDING_WINDOWS)
+      {
+        // the host cannot keep up, we drop the oldest window so the newest events are not lost.
+        const auto oldest = _pendingWindows.front();
+        _pendingWindows.pop_front();
+        _statistics.NumberOfDroppedEvents += oldest->NumberOfRecords();
+        _spareWindows.push_back(oldest);
+        overflow = !_overflowRaised;
+        _overflowRaised = true;
       }
+      _pendingWindows.push_back(window);
+      _statistics.QueueDepth = static_cast<int>(_pendingWindows.size());
+      _statistics.MaxQueueDepth = (std::max)(_statistics.MaxQueueDepth, _statistics.QueueDepth);
+      deliverNow = StartDeliveryInLock();
+    }
+
+    if (overflow)
+    {
+      // let the host know, it will be in the next window.
+      Logger::Log(_id, LogLevel::Warning, L"The events callback cannot keep up, the oldest events were dropped.");
+      _monitor.AddEventError(EventError::Overflow);
+    }
+
+    // we could not post the delivery, so we have to do it ourselves.
+    if (deliverNow)
+    {
+      Deliver();
+    }
+  }
+
+  /**
+   * \brief make sure that a task is delivering what we queued, must be called while holding the lock.
+   * \return if the caller must deliver the events itself.
+   */
+  bool EventsPublisher::StartDeliveryInLock()
+  {
+    // the task that is running will deliver everything queued before it ends.
+    if (_delivering)
+    {
+      return false;
+    }
+    _delivering = true;
+
+    // if the publishers are not running we have no choice but to do it ourselves.
+    return !_monitor.WorkerPool().Publish([this] { Deliver(); });
+  }
+
+  /**
+   * \brief deliver everything that is queued, this is called on one of the publisher threads.
+   */
+  void EventsPublisher::Deliver()
+  {
+    MYODDWEB_PROFILE_FUNCTION();
+    for (;;)
+    {
+      EventsBatch* window = nullptr;
+      auto statisticsElapsedTimeMilliseconds = 0.f;
+      auto statisticsNumberOfEvents = 0ll;
+      {
+        MYODDWEB_LOCK(_lock);
+        if (!_pendingWindows.empty())
+        {
+          window = _pendingWindows.front();
+          _pendingWindows.pop_front();
+          _statistics.QueueDepth = static_cast<int>(_pendingWindows.size());
+        }
+        else if (_hasPendingStatistics)
+        {
+          statisticsElapsedTimeMilliseconds = _pendingStatisticsElapsedTimeMilliseconds;
+          statisticsNumberOfEvents = _currentStatistics.numberOfEvents;
+          _pendingStatisticsElapsedTimeMilliseconds = 0;
+          _hasPendingStatistics = false;
+
+          // we are done with the stats
+          _currentStatistics = { 0 };
+        }
+        else
+        {
+          // nothing left, the next thing queued will start a new task.
+          _overflowRaised = false;
+          _delivering = false;
+          _delivered.notify_all();
+          return;
+        }
+      }
+
+      if (window == nullptr)
+      {
+        PublishStatistics(statisticsElapsedTimeMilliseconds, statisticsNumberOfEvents);
+        continue;
+      }
+
+      // how long each event waited before the host was given it.
+      auto& metrics = _monitor.MonitorMetrics();
+      const auto nowUtc = Collector::GetMillisecondsNowUtc();
+      const auto records = window->Records();
+      for (auto i = 0; i < window->NumberOfRecords(); ++i)
+      {
+        metrics.Record(Metrics::Timing::EventAge, static_cast<double>(nowUtc - records[i].DateTimeUtc));
+      }
+
+      const auto start = std::chrono::steady_clock::now();
+      if (nullptr != _request.CallbackEventsBatch())
+      {
+        PublishEventsBatch(*window);
+      }
+      else
+      {
+        PublishEvents(*window);
+      }
+      const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      metrics.Record(Metrics::Timing::Callback, elapsed);
+
+      MYODDWEB_LOCK(_lock);
+      _currentStatistics.numberOfEvents += window->NumberOfRecords();
+      _statistics.NumberOfEvents += window->NumberOfRecords();
+      _statistics.NumberOfCallbacks += nullptr != _request.CallbackEventsBatch() ? 1 : window->NumberOfRecords();
+      _statistics.TotalCallbackMilliseconds += elapsed;
+      _statistics.MaxCallbackMilliseconds = (std::max)(_statistics.MaxCallbackMilliseconds, elapsed);
+      window->Clear();
+      _spareWindows.push_back(window);
     }
   }
 
   /**
    * \brief get the events.
    * \param actualElapsedTimeMilliseconds the number of ms since the last time we published
+   * \param numberOfEvents the number of events since the last time we published.
    */
-  void EventsPublisher::PublishStatistics(const float actualElapsedTimeMilliseconds)
+  void EventsPublisher::PublishStatistics(const float actualElapsedTimeMilliseconds, const long long numberOfEvents)
   {
     MYODDWEB_PROFILE_FUNCTION();
     try
@@ -162,11 +450,8 @@ namespace myoddweb::directorywatcher
       _request.CallbackStatistics()(
         _id,
         actualElapsedTimeMilliseconds,
-        _currentStatistics.numberOfEvents
+        numberOfEvents
         );
-
-      // we are done with the stats
-      _currentStatistics = { 0 };
     }
     catch (const std::exception& e)
     {
@@ -177,48 +462,31 @@ namespace myoddweb::directorywatcher
   }
 
   /**
-   * \brief update the stats with the given event
-   * \paranm event the event we will update the stats with
+   * \brief deliver a window of events one at a time.
+   * \param window the window of events we are publishing.
    */
-  void EventsPublisher::UpdateStatistics(const Event& event)
-  {
-    ++_currentStatistics.numberOfEvents;
-  }
-
-
-  /**
-   * \brief publish all the events
-   */
-  void EventsPublisher::PublishEvents()
+  void EventsPublisher::PublishEvents(const EventsBatch& window) const
   {
     MYODDWEB_PROFILE_FUNCTION();
 
-    // get the events.
-    auto events = std::vector<Event*>();
-    if (0 == _monitor.GetEvents(events))
-    {
-      return;
-    }
-
     // then call the callback
-    for (auto it = events.begin(); it != events.end(); ++it)
+    const auto names = window.Names();
+    const auto records = window.Records();
+    for (auto i = 0; i < window.NumberOfRecords(); ++i)
     {
-      const auto& event = (*it);
+      const auto& record = records[i];
       try
       {
         // publish it
         _request.CallbackEvents()(
           _id,
-          event->IsFile,
-          event->Name,
-          event->OldName,
-          event->Action,
-          event->Error,
-          event->TimeMillisecondsUtc
+          record.IsFile != 0,
+          names + record.NameOffset,
+          record.OldNameOffset == -1 ? L"" : names + record.OldNameOffset,
+          record.Action,
+          record.Error,
+          record.DateTimeUtc
           );
-
-        // update the stats
-        UpdateStatistics(*event);
       }
       catch (const std::exception& e)
       {
@@ -226,10 +494,31 @@ namespace myoddweb::directorywatcher
         // log the error
         Logger::Log(LogLevel::Error, L"Caught exception '%hs' in PublishEvents, check the callback!", e.what());
       }
+    }
+  }
 
-      // we are done with the event
-      // so we can get rid of it.
-      delete event;
+  /**
+   * \brief publish all the events of a window in one call.
+   * \param window the window of events we are publishing.
+   */
+  void EventsPublisher::PublishEventsBatch(const EventsBatch& window) const
+  {
+    MYODDWEB_PROFILE_FUNCTION();
+    try
+    {
+      _request.CallbackEventsBatch()(
+        _id,
+        window.Records(),
+        window.NumberOfRecords(),
+        window.Names(),
+        window.NamesLength()
+        );
+    }
+    catch (const std::exception& e)
+    {
+      // the callback did something wrong!
+      // log the error
+      Logger::Log(LogLevel::Error, L"Caught exception '%hs' in PublishEventsBatch, check the callback!", e.what());
     }
   }
 }
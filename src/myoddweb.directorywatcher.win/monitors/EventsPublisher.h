@@ -2,6 +2,11 @@
 // Florent Guelfucci licenses this file to you under the MIT license.
 // See the LICENSE file in the project root for more information.
 #pragma once
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include "../utils/Arena.h"
+#include "../utils/EventsBatch.h"
 #include "../utils/Request.h"
 
 namespace myoddweb::directorywatcher
@@ -13,8 +18,17 @@ namespace myoddweb::directorywatcher
     Monitor& _monitor;
     const long long _id;
     const Request& _request;
-    float _elapsedEventsTimeMilliseconds;
-    float _elapsedStatisticsTimeMilliseconds;
+
+    /**
+     * \brief when the next events and statistics are due, (see threads::WorkerPool::NowMilliseconds( ... ) ).
+     */
+    long long _nextEventsMilliseconds;
+    long long _nextStatisticsMilliseconds;
+
+    /**
+     * \brief when we last published the statistics.
+     */
+    long long _lastStatisticsMilliseconds;
 
     struct CurrentStatistics
     {
@@ -26,58 +40,172 @@ namespace myoddweb::directorywatcher
      */
     CurrentStatistics _currentStatistics{};
 
+    /**
+     * \brief the memory that holds the events we are publishing
+     *        it is reset once all the events have been delivered.
+     */
+    Arena _memory;
+
+    /**
+     * \brief the lock for everything shared with the thread delivering to the host.
+     */
+    mutable MYODDWEB_MUTEX _lock;
+
+    /**
+     * \brief signaled when the thread delivering to the host has nothing left to do.
+     */
+    std::condition_variable _delivered;
+
+    /**
+     * \brief the windows of events waiting to be delivered, oldest first.
+     */
+    std::deque<EventsBatch*> _pendingWindows;
+
+    /**
+     * \brief the windows that were delivered, they are re-used so we do not allocate all the time.
+     */
+    std::vector<EventsBatch*> _spareWindows;
+
+    /**
+     * \brief set when statistics are waiting to be delivered.
+     */
+    bool _hasPendingStatistics;
+
+    /**
+     * \brief the elapsed time of the statistics waiting to be delivered.
+     */
+    float _pendingStatisticsElapsedTimeMilliseconds;
+
+    /**
+     * \brief set while a task is delivering to the host.
+     */
+    bool _delivering;
+
+    /**
+     * \brief set once we raised an overflow error, so we only raise it once until the host catches up.
+     *        Otherwise the error itself would fill the queue again.
+     */
+    bool _overflowRaised;
+
+    /**
+     * \brief how well the host is keeping up with our events.
+     */
+    MonitorStatistics _statistics{};
+
   public:
     explicit EventsPublisher(Monitor& monitor, long long id, const Request& request );
 
     /**
-     * \brief called at various intervals.
-     * \param fElapsedTimeMilliseconds the number of ms since the last update
+     * \brief wait for everything queued to be delivered.
      */
-    void Update(float fElapsedTimeMilliseconds);
+    ~EventsPublisher();
+
+    EventsPublisher(const EventsPublisher&) = delete;
+    EventsPublisher(EventsPublisher&&) = delete;
+    const EventsPublisher& operator=(const EventsPublisher&) = delete;
+    EventsPublisher& operator=(EventsPublisher&&) = delete;
+
+    /**
+     * \brief called at various intervals, we publish whatever is due.
+     */
+    void Update();
+
+    /**
+     * \brief how long until we next have something to publish.
+     *        If we have no events and no statistics to publish we never need to be updated.
+     * \return the number of ms until the next events or statistics are due.
+     */
+    [[nodiscard]]
+    float MillisecondsUntilNextUpdate() const;
+
+    /**
+     * \brief get how well the host is keeping up with our events.
+     * \param statistics the statistics we are filling.
+     */
+    void GetStatistics(MonitorStatistics& statistics) const;
 
   private:
     /**
      * \brief called at various intervals.
-     * \param fElapsedTimeMilliseconds the number of ms since the last update
+     * \param nowMilliseconds the current time.
      */
-    void UpdateEvents(float fElapsedTimeMilliseconds);
+    void UpdateEvents(long long nowMilliseconds);
 
     /**
      * \brief called at various intervals.
-     * \param fElapsedTimeMilliseconds the number of ms since the last update
+     * \param nowMilliseconds the current time.
      */
-    void UpdateStatistics(float fElapsedTimeMilliseconds);
+    void UpdateStatistics(long long nowMilliseconds);
 
     /**
      * \brief get the events.
      * \param actualElapsedTimeMilliseconds the number of ms since the last time we published
+     * \param numberOfEvents the number of events since the last time we published.
      */
-    void PublishStatistics(float actualElapsedTimeMilliseconds);
+    void PublishStatistics(float actualElapsedTimeMilliseconds, long long numberOfEvents);
 
     /**
-     * \brief get the events.
+     * \brief get the events and queue them to be delivered.
      */
     void PublishEvents();
 
     /**
-     * \brief update the stats with the given event
-     * \paranm event the event we will update the stats with
+     * \brief queue a window of events to be delivered, if we have too many windows waiting the oldest is dropped.
+     * \param events the events we are queuing.
      */
-    void UpdateStatistics(const Event& event);
+    void QueueEvents(const std::vector<Event*>& events);
 
     /**
-     * \brief check if the events time has now elapsed.
-     * \param fElapsedTimeMilliseconds the number of ms since the last time we checked.
+     * \brief queue the statistics to be delivered.
+     * \param actualElapsedTimeMilliseconds the number of ms since the last time we published
+     */
+    void QueueStatistics(float actualElapsedTimeMilliseconds);
+
+    /**
+     * \brief make sure that a task is delivering what we queued, must be called while holding the lock.
+     * \return if the caller must deliver the events itself.
+     */
+    bool StartDeliveryInLock();
+
+    /**
+     * \brief deliver everything that is queued, this is called on one of the publisher threads.
+     */
+    void Deliver();
+
+    /**
+     * \brief deliver a window of events one at a time.
+     * \param window the window of events we are publishing.
+     */
+    void PublishEvents(const EventsBatch& window) const;
+
+    /**
+     * \brief publish all the events of a window in one call.
+     * \param window the window of events we are publishing.
+     */
+    void PublishEventsBatch(const EventsBatch& window) const;
+
+    /**
+     * \brief check if the events are now due, if they are the next ones are scheduled.
+     * \param nowMilliseconds the current time.
      * \return if the time has elapsed and we can continue.
      */
-    bool HasEventsElapsed(float fElapsedTimeMilliseconds);
+    bool HasEventsElapsed(long long nowMilliseconds);
+
+    /**
+     * \brief check if the statistics are now due, if they are the next ones are scheduled.
+     * \param nowMilliseconds the current time.
+     * \return 0 if the number has not elapsed otherwise the number of ms since we last published them.
+     */
+    float HasStatisticsElapsed(long long nowMilliseconds);
 
     /**
-     * \brief check if the statusticstime has now elapsed.
-     * \param fElapsedTimeMilliseconds the number of ms since the last time we checked.
-     * \return 0 if the number has not elapsed otherwise the number of ms elapsed
+     * \brief move a deadline to the next one after the current time.
+     * \param deadlineMilliseconds the deadline that was reached.
+     * \param rateMilliseconds how often the deadline comes.
+     * \param nowMilliseconds the current time.
+     * \return the next deadline.
      */
-    float HasStatisticsElapsed(float fElapsedTimeMilliseconds);
+    static long long NextDeadline(long long deadlineMilliseconds, long long rateMilliseconds, long long nowMilliseconds);
 
     /**
      * \brief make sure that all the stats values are up to date
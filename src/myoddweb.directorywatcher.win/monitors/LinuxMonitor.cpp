@@ -0,0 +1,169 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#if defined(__linux__)
+#include "LinuxMonitor.h"
+#include <algorithm>
+
+#include "../utils/Instrumentor.h"
+#include "Base.h"
+
+namespace myoddweb:: directorywatcher
+{
+  /**
+   * \brief The size of the buffer we use for each read( ... )
+   *        the larger the buffer the more events we get per system call
+   *        each event is sizeof(inotify_event) + the length of the name.
+   * \see http://man7.org/linux/man-pages/man7/inotify.7.html
+   */
+  #define MAX_INOTIFY_BUFFER_SIZE (unsigned long)262144
+
+  /**
+   * \brief Create the Monitor that uses inotify
+   * \param id the unique id of this monitor
+   * \param workerPool the worker pool
+   * \param request details of the request.
+   */
+  LinuxMonitor::LinuxMonitor(const long long id, threads::WorkerPool& workerPool, const Request& request) :
+    LinuxMonitor(id, workerPool, request, MAX_INOTIFY_BUFFER_SIZE)
+  {
+  }
+
+  /**
+   * \brief Create the Monitor that uses inotify
+   * \param id the unique id of this monitor
+   * \param workerPool the worker pool
+   * \param request details of the request.
+   * \param bufferLength the largest size of the buffer, it starts smaller and grows when it is nearly full.
+   */
+  LinuxMonitor::LinuxMonitor(const long long id, threads::WorkerPool& workerPool, const Request& request, const unsigned long bufferLength) :
+    Monitor(id, workerPool, request),
+    _data(nullptr),
+    _bufferSize(MYODDWEB_READ_BUFFER_MIN_SIZE, bufferLength, MYODDWEB_READ_BUFFER_INITIAL_SIZE)
+  {
+  }
+
+  LinuxMonitor::~LinuxMonitor() = default;
+
+  /**
+   * \brief get the id of the parent, the owner of all the monitors.
+   *        we are always our own parent as inotify can watch all the sub folders in one go.
+   * \return the parent id.
+   */
+  const long long& LinuxMonitor::ParentId() const
+  {
+    return Id();
+  }
+
+  /**
+   * \brief add the size of our read buffer and how often it overflowed.
+   * \param statistics the statistics we are adding to.
+   */
+  void LinuxMonitor::AddMonitorStatistics(MonitorStatistics& statistics) const
+  {
+    Monitor::AddMonitorStatistics(statistics);
+    statistics.ReadBufferSize += _bufferSize.Size();
+    statistics.NumberOfReadOverflows += _bufferSize.NumberOfOverflows();
+  }
+
+  /**
+   * \brief process the collected events add/remove them.
+   * \param events the collected events.
+   * \param memory the arena that holds the events.
+   */
+  void LinuxMonitor::OnGetEvents(std::vector<Event*>& /*events*/, Arena& /*memory*/)
+  {
+    //  nothing to do
+  }
+
+  /**
+   * \brief the non blocking stop function, it can be called while an update is still running
+   *        so we only wake the monitor, the inotify file descriptor is closed in OnWorkerEnd( ... )
+   */
+  void LinuxMonitor::OnWorkerStop()
+  {
+    // make sure that we get our last update.
+    Monitor::OnWorkerStop();
+  }
+
+  /**
+   * \brief called when the worker is ready to start
+   *        return false if you do not wish to start the worker.
+   */
+  bool LinuxMonitor::OnWorkerStart()
+  {
+    MYODDWEB_PROFILE_FUNCTION();
+    try
+    {
+      _data = new inotify::Data(*this, _bufferSize);
+      if (!_data->Start())
+      {
+        delete _data;
+        _data = nullptr;
+        return false;
+      }
+
+      // all done
+      return Monitor::OnWorkerStart();
+    }
+    catch (...)
+    {
+      SaveCurrentException();
+      return false;
+    }
+  }
+
+  /**
+   * \brief Give the worker a chance to do something in the loop
+   *        Workers can do _all_ the work at once and simply return false
+   *        or if they have a tight look they can return true until they need to come out.
+   * \param fElapsedTimeMilliseconds the amount of time since the last time we made this call.
+   * \return true if we want to continue or false if we want to end the thread
+   */
+  bool LinuxMonitor::OnWorkerUpdate(const float fElapsedTimeMilliseconds)
+  {
+    MYODDWEB_PROFILE_FUNCTION();
+    try
+    {
+      if (!MustStop())
+      {
+        _data->Update();
+        _data->CheckStillValid();
+      }
+    }
+    catch (...)
+    {
+      SaveCurrentException();
+    }
+    return Monitor::OnWorkerUpdate(fElapsedTimeMilliseconds);
+  }
+
+  /**
+   * \brief how long we are happy to wait before our next update if nothing wakes us up.
+   * \return the number of ms before we next need an update.
+   */
+  float LinuxMonitor::OnWorkerNextUpdateMilliseconds() const
+  {
+    // if we lost the root we need to be updated when it is time to re-open it.
+    const auto milliseconds = Monitor::OnWorkerNextUpdateMilliseconds();
+    if (_data != nullptr)
+    {
+      return (std::min)(milliseconds, _data->MillisecondsUntilReopen());
+    }
+    return milliseconds;
+  }
+
+  /**
+   * \brief called when the worker has completed
+   */
+  void LinuxMonitor::OnWorkerEnd()
+  {
+    MYODDWEB_PROFILE_FUNCTION();
+    Monitor::OnWorkerEnd();
+
+    // there are no more updates, so nothing is still reading the watches.
+    delete _data;
+    _data = nullptr;
+  }
+}
+#endif
@@ -0,0 +1,87 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#pragma once
+#if defined(__linux__)
+#include "Monitor.h"
+#include "inotify/Data.h"
+
+namespace myoddweb
+{
+  namespace directorywatcher
+  {
+    /**
+     * \brief monitor that uses inotify, inotify is not recursive
+     *        so the same monitor is used for both recursive and non recursive requests.
+     */
+    class LinuxMonitor final : public Monitor
+    {
+    protected:
+      LinuxMonitor(long long id, threads::WorkerPool& workerPool, const Request& request, unsigned long bufferLength);
+
+    public:
+      LinuxMonitor(long long id, threads::WorkerPool& workerPool, const Request& request);
+
+      virtual ~LinuxMonitor();
+
+      LinuxMonitor() = delete;
+      LinuxMonitor(const LinuxMonitor&) = delete;
+      LinuxMonitor(LinuxMonitor&&) = delete;
+      const LinuxMonitor& operator=(const LinuxMonitor&) = delete;
+      LinuxMonitor&& operator=(LinuxMonitor&&) = delete;
+
+      void OnGetEvents(std::vector<Event*>& events, Arena& memory) override;
+
+      [[nodiscard]]
+      const long long& ParentId() const override;
+
+      /**
+       * \brief add the size of our read buffer and how often it overflowed.
+       * \param statistics the statistics we are adding to.
+       */
+      void AddMonitorStatistics(MonitorStatistics& statistics) const override;
+
+    protected:
+      /**
+       * \brief the non blocking stop function
+       */
+      void OnWorkerStop() override;
+
+      /**
+       * \brief called when the worker is ready to start
+       *        return false if you do not wish to start the worker.
+       */
+      bool OnWorkerStart() override;
+
+      /**
+       * \brief Give the worker a chance to do something in the loop
+       *        Workers can do _all_ the work at once and simply return false
+       *        or if they have a tight look they can return true until they need to come out.
+       * \param fElapsedTimeMilliseconds the amount of time since the last time we made this call.
+       * \return true if we want to continue or false if we want to end the thread
+       */
+      bool OnWorkerUpdate(float fElapsedTimeMilliseconds) override;
+
+      /**
+       * \brief how long we are happy to wait before our next update if nothing wakes us up.
+       * \return the number of ms before we next need an update.
+       */
+      [[nodiscard]]
+      float OnWorkerNextUpdateMilliseconds() const override;
+
+      /**
+       * \brief called when the worker has completed
+       */
+      void OnWorkerEnd() override;
+
+    private:
+      inotify::Data* _data;
+
+      /**
+       * \brief the size of the buffer we read the events into.
+       */
+      BufferSizePolicy _bufferSize;
+    };
+  }
+}
+#endif
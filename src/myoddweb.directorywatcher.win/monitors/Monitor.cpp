@@ -1,16 +1,17 @@
 ﻿// Licensed to Florent Guelfucci under one or more agreements.
 // Florent Guelfucci licenses this file to you under the MIT license.
 // See the LICENSE file in the project root for more information.
-#include <Windows.h>
 #include "Monitor.h"
+#include <algorithm>
 #include "../utils/Io.h"
+#include "../utils/Lock.h"
 #include "../utils/Instrumentor.h"
 #include "../utils/Logger.h"
 #include "../utils/LogLevel.h"
 
 namespace myoddweb:: directorywatcher
 {
-  Monitor::Monitor( const __int64 id, threads::WorkerPool& workerPool, const Request& request) :
+  Monitor::Monitor( const long long id, threads::WorkerPool& workerPool, const Request& request) :
     Worker(),
     _id(id),
     _workerPool( workerPool ),
@@ -18,8 +19,11 @@ namespace myoddweb:: directorywatcher
                       // we will keep data for as long as we need it, either the event time if not zero, (as it updates the stats)
                       // otherwise we will set the time to the stats time
                       // if both of them are zero then nothing will be collected
-    _eventCollector(request.EventsCallbackRateMilliseconds() == 0 ? request.StatsCallbackRateMilliseconds() : request.EventsCallbackRateMilliseconds()),
-    _publisher(nullptr)
+    _eventCollector(request.EventsCallbackRateMilliseconds() == 0 ? request.StatsCallbackRateMilliseconds() : request.EventsCallbackRateMilliseconds(), request.CoalesceEvents(), request.SettleMilliseconds(), &_metrics),
+    _publisher(nullptr),
+    _pulledIndex(0),
+    _pullGeneration(0),
+    _numberOfPulledEvents(0)
   {
   }
 
@@ -30,6 +34,7 @@ namespace myoddweb:: directorywatcher
       // log the error
       Logger::Log(LogLevel::Error, L"Trying to dispose of a monitor that was never completed!" );
     }
+    MYODDWEB_LOCK(_publisherLock);
     delete _publisher;
     _publisher = nullptr;
   }
@@ -42,6 +47,14 @@ namespace myoddweb:: directorywatcher
     return _eventCollector;
   }
 
+  /**
+   * \brief the counters and the duration histograms of this monitor.
+   */
+  Metrics& Monitor::MonitorMetrics()
+  {
+    return _metrics;
+  }
+
   /**
    * \brief the id of this monitor
    */
@@ -72,7 +85,7 @@ namespace myoddweb:: directorywatcher
    * \param fileName the name of the file/directory
    * \param isFile if it is a file or not
    */
-  void Monitor::AddEvent(const EventAction action, const std::wstring& fileName, const bool isFile)
+  void Monitor::AddEvent(const EventAction action, const std::wstring_view fileName, const bool isFile)
   {
     MYODDWEB_PROFILE_FUNCTION();
     _eventCollector.Add(action, Path(), fileName, isFile, EventError::None);
@@ -84,7 +97,7 @@ namespace myoddweb:: directorywatcher
    * \param oldFilename the previous name
    * \param isFile if this is a file or not.
    */
-  void Monitor::AddRenameEvent(const std::wstring& newFileName, const std::wstring& oldFilename, const bool isFile)
+  void Monitor::AddRenameEvent(const std::wstring_view newFileName, const std::wstring_view oldFilename, const bool isFile)
   {
     MYODDWEB_PROFILE_FUNCTION();
     _eventCollector.AddRename(Path(), newFileName, oldFilename, isFile, EventError::None );
@@ -100,12 +113,31 @@ namespace myoddweb:: directorywatcher
     _eventCollector.Add(EventAction::Unknown, Path(), L"", false, error );
   }
 
+  /**
+   * \brief check if we have collected events that have not been published yet.
+   * \return if we have events waiting.
+   */
+  bool Monitor::HasEvents() const
+  {
+    return _eventCollector.HasEvents();
+  }
+
+  /**
+   * \brief tell the worker pool that we have something to do and need an update.
+   *        This is thread safe and can be called from any thread, (or completion routine).
+   */
+  void Monitor::Wake()
+  {
+    _workerPool.Wake(*this);
+  }
+
   /**
    * \brief fill the vector with all the values currently on record.
    * \param events the events we will be filling
+   * \param memory the arena that will hold the events, they are valid until it is reset.
    * \return the number of events we found.
    */
-  long long Monitor::GetEvents(std::vector<Event*>& events)
+  long long Monitor::GetEvents(std::vector<Event*>& events, Arena& memory)
   {
     MYODDWEB_PROFILE_FUNCTION();
 
@@ -115,15 +147,129 @@ namespace myoddweb:: directorywatcher
     }
 
     // get the events we collected.
-    _eventCollector.GetEvents(events);
+    _eventCollector.GetEvents(events, memory);
 
     // allow the base class to add/remove events.
-    OnGetEvents(events);
+    OnGetEvents(events, memory);
 
     // then return how-ever many we found.  
     return static_cast<long long>(events.size());
   }
 
+  /**
+   * \brief copy the pending events to the buffers given by the host, (see Request::IsPullingEvents( ... ) ).
+   *        The events are taken from the collector one window at a time, once the whole window has been
+   *        pulled the next call takes a new window.
+   * \param events where we are copying the events to.
+   * \param eventsCapacity the number of events we can copy.
+   * \param names where we are copying the names to, the offsets in the events are relative to it.
+   * \param namesCapacity the number of characters we can copy.
+   * \param cursor 0 to get the next events, or a value returned by a previous call to continue, (or re-read), the current window.
+   *        It is set to 0 once the current window has been pulled completely.
+   * \return the number of events copied or -1 if the request is not pulling events, the cursor is not valid
+   *         or the next event does not fit in the names buffer.
+   */
+  int Monitor::PullEvents(EventRecord* events, const int eventsCapacity, wchar_t* names, const int namesCapacity, long long& cursor)
+  {
+    MYODDWEB_PROFILE_FUNCTION();
+
+    // if the publisher takes the events, the host cannot have them.
+    if (!_request.IsPullingEvents())
+    {
+      return -1;
+    }
+
+    MYODDWEB_LOCK(_pullLock);
+    auto index = _pulledIndex;
+    if (cursor != 0)
+    {
+      // the cursor must be one we gave for the current window.
+      const auto generation = static_cast<unsigned int>(static_cast<unsigned long long>(cursor) >> 32);
+      const auto position = static_cast<int>(cursor & 0xFFFFFFFF);
+      if (generation != _pullGeneration || position > _pulledEvents.NumberOfRecords())
+      {
+        return -1;
+      }
+      index = position;
+    }
+    else if (index >= _pulledEvents.NumberOfRecords())
+    {
+      // the whole window was pulled, take whatever was collected since.
+      auto collected = std::vector<Event*>();
+      GetEvents(collected, _pulledMemory);
+      _pulledEvents.Build(collected);
+      _numberOfPulledEvents += static_cast<long long>(collected.size());
+      _metrics.Add(Metrics::Counter::PulledEvents, static_cast<long long>(collected.size()));
+
+      // the window has its own copy of the names.
+      _pulledMemory.Reset();
+
+      // 0 is never a valid generation so a cursor is never 0.
+      if (++_pullGeneration == 0)
+      {
+        ++_pullGeneration;
+      }
+      index = 0;
+    }
+
+    const auto count = _pulledEvents.CopyTo(index, events, eventsCapacity, names, namesCapacity);
+    if (count == 0 && index < _pulledEvents.NumberOfRecords())
+    {
+      // the next event does not fit.
+      return -1;
+    }
+
+    _pulledIndex = index + count;
+    cursor = _pulledIndex < _pulledEvents.NumberOfRecords() ? static_cast<long long>((static_cast<unsigned long long>(_pullGeneration) << 32) | static_cast<unsigned int>(_pulledIndex)) : 0;
+    return count;
+  }
+
+  /**
+   * \brief get the number of events taken by the host since the last time we asked, and reset it.
+   * \return the number of events pulled.
+   */
+  long long Monitor::TakeNumberOfPulledEvents()
+  {
+    return _numberOfPulledEvents.exchange(0);
+  }
+
+  /**
+   * \brief get how well the host is keeping up with our events.
+   * \param statistics the statistics we are filling, all zeros if we are not publishing, (other than the size).
+   */
+  void Monitor::GetStatistics(MonitorStatistics& statistics) const
+  {
+    {
+      MYODDWEB_LOCK(_publisherLock);
+      if (_publisher == nullptr)
+      {
+        statistics = {};
+      }
+      else
+      {
+        _publisher->GetStatistics(statistics);
+      }
+    }
+    AddMonitorStatistics(statistics);
+
+    // the histograms of all the monitors were added, we can now work out the percentiles.
+    Metrics::CalculatePercentiles(statistics.PublishMilliseconds);
+    Metrics::CalculatePercentiles(statistics.CallbackMilliseconds);
+    Metrics::CalculatePercentiles(statistics.EventAgeMilliseconds);
+    statistics.Size = static_cast<int>(sizeof(MonitorStatistics));
+  }
+
+  /**
+   * \brief add the statistics kept by the monitor itself, rather than by the publisher.
+   *        by default we add our counters and histograms and the number of paths settling.
+   * \param statistics the statistics we are adding to.
+   */
+  void Monitor::AddMonitorStatistics(MonitorStatistics& statistics) const
+  {
+    _metrics.AddTo(statistics);
+    statistics.NumberOfSettlingPaths += _eventCollector.NumberOfSettlingPaths();
+  }
+
   /**
    * \brief Start the monitoring, if needed.
    * \return success or not.
@@ -161,21 +307,39 @@ namespace myoddweb:: directorywatcher
    * \param fElapsedTimeMilliseconds the amount of time since the last time we made this call.
    * \return true if we want to continue or false if we want to end the thread
    */
-  bool Monitor::OnWorkerUpdate( const float fElapsedTimeMilliseconds)
+  bool Monitor::OnWorkerUpdate( const float /*fElapsedTimeMilliseconds*/)
   {
+    // the publisher and the collector keep their own deadlines.
     if( _publisher != nullptr )
     {
-      _publisher->Update(fElapsedTimeMilliseconds);
+      _publisher->Update();
     }
+    _eventCollector.CleanupEvents();
     return !MustStop();
   }
 
+  /**
+   * \brief how long we are happy to wait before our next update if nothing wakes us up.
+   * \return the number of ms before we next need to publish something.
+   */
+  float Monitor::OnWorkerNextUpdateMilliseconds() const
+  {
+    // we need to be updated right away to stop.
+    if (MustStop() || _publisher == nullptr)
+    {
+      return 0;
+    }
+    // the old events are cleaned up even if nobody takes them.
+    return (std::min)(_publisher->MillisecondsUntilNextUpdate(), _eventCollector.MillisecondsUntilCleanup());
+  }
+
   /**
    * \brief stop the worker
    */
   void Monitor::OnWorkerStop()
   {
-    // nothing to do here
+    // make sure that we get our last update.
+    Wake();
   }
 
   /**
@@ -186,7 +350,8 @@ namespace myoddweb:: directorywatcher
     MYODDWEB_PROFILE_FUNCTION();
     try
     {
-      // clean the publisher
+      // clean the publisher, this waits for the host to get the last of the events.
+      MYODDWEB_LOCK(_publisherLock);
       delete _publisher;
       _publisher = nullptr;
     }
@@ -206,6 +371,7 @@ namespace myoddweb:: directorywatcher
     MYODDWEB_PROFILE_FUNCTION();
 
     // whatever we are doing, we need to kill the current timer.
+    MYODDWEB_LOCK(_publisherLock);
     delete _publisher;
     _publisher = nullptr;
 
@@ -2,10 +2,15 @@
 // Florent Guelfucci licenses this file to you under the MIT license.
 // See the LICENSE file in the project root for more information.
 #pragma once
+#include <atomic>
 #include <string>
+#include <string_view>
+#include "../utils/Arena.h"
 #include "../utils/EventAction.h"
 #include "../utils/EventError.h"
 #include "../utils/Collector.h"
+#include "../utils/EventsBatch.h"
+#include "../utils/Metrics.h"
 #include "../utils/Request.h"
 #include "../utils/Threads/WorkerPool.h"
 #include "EventsPublisher.h"
@@ -17,7 +22,7 @@ namespace myoddweb
     class Monitor : public threads::Worker
     {
     public:
-      Monitor( __int64 id, threads::WorkerPool& workerPool, const Request& request);
+      Monitor( long long id, threads::WorkerPool& workerPool, const Request& request);
       virtual ~Monitor();
 
       Monitor& operator=(Monitor&& other) = delete;
@@ -50,6 +55,12 @@ namespace myoddweb
       [[nodiscard]]
       const Collector& EventsCollector() const;
 
+      /**
+       * \brief the counters and the duration histograms of this monitor.
+       */
+      [[nodiscard]]
+      Metrics& MonitorMetrics();
+
       /**
        * \brief check if a given path is the same as the given one.
        * \param maybe the path we are checking against.
@@ -61,9 +72,43 @@ namespace myoddweb
       /**
        * \brief fill the vector with all the values currently on record.
        * \param events the events we will be filling
+       * \param memory the arena that will hold the events, they are valid until it is reset.
        * \return the number of events we found.
        */
-      long long GetEvents(std::vector<Event*>& events);
+      long long GetEvents(std::vector<Event*>& events, Arena& memory);
+
+      /**
+       * \brief copy the pending events to the buffers given by the host, (see Request::IsPullingEvents( ... ) ).
+       *        The events are taken from the collector one window at a time, once the whole window has been
+       *        pulled the next call takes a new window.
+       * \param events where we are copying the events to.
+       * \param eventsCapacity the number of events we can copy.
+       * \param names where we are copying the names to, the offsets in the events are relative to it.
+       * \param namesCapacity the number of characters we can copy.
+       * \param cursor 0 to get the next events, or a value returned by a previous call to continue, (or re-read), the current window.
+       *        It is set to 0 once the current window has been pulled completely.
+       * \return the number of events copied or -1 if the request is not pulling events, the cursor is not valid
+       *         or the next event does not fit in the names buffer.
+       */
+      int PullEvents(EventRecord* events, int eventsCapacity, wchar_t* names, int namesCapacity, long long& cursor);
+
+      /**
+       * \brief get the number of events taken by the host since the last time we asked, and reset it.
+       * \return the number of events pulled.
+       */
+      long long TakeNumberOfPulledEvents();
+
+      /**
+       * \brief get how well the host is keeping up with our events.
+       * \param statistics the statistics we are filling, all zeros if we are not publishing, (other than the size).
+       */
+      void GetStatistics(MonitorStatistics& statistics) const;
+
+      /**
+       * \brief add the statistics kept by the monitor itself, rather than by the publisher.
+       * \param statistics the statistics we are adding to.
+       */
+      virtual void AddMonitorStatistics(MonitorStatistics& statistics) const;
 
       /**
        * \brief Add an event to our current log.
@@ -71,7 +116,7 @@ namespace myoddweb
        * \param fileName the name of the file/directory
        * \param isFile if it is a file or not
        */
-      void AddEvent(EventAction action, const std::wstring& fileName, bool isFile );
+      void AddEvent(EventAction action, std::wstring_view fileName, bool isFile );
 
       /**
        * \brief Add an event to our current log.
@@ -79,7 +124,7 @@ namespace myoddweb
        * \param oldFilename the previous name
        * \param isFile if this is a file or not.
        */
-      void AddRenameEvent(const std::wstring& newFileName, const std::wstring& oldFilename, bool isFile);
+      void AddRenameEvent(std::wstring_view newFileName, std::wstring_view oldFilename, bool isFile);
 
       /**
        * \brief add an event error to the queue
@@ -87,6 +132,19 @@ namespace myoddweb
        */
       void AddEventError(EventError error);
 
+      /**
+       * \brief check if we have collected events that have not been published yet.
+       * \return if we have events waiting.
+       */
+      [[nodiscard]]
+      virtual bool HasEvents() const;
+
+      /**
+       * \brief tell the worker pool that we have something to do and need an update.
+       *        This is thread safe and can be called from any thread, (or completion routine).
+       */
+      void Wake();
+
       /**
        * \brief get the worker pool
        */
@@ -118,6 +176,13 @@ namespace myoddweb
        */
       bool OnWorkerUpdate(float fElapsedTimeMilliseconds) override;
 
+      /**
+       * \brief how long we are happy to wait before our next update if nothing wakes us up.
+       * \return the number of ms before we next need to publish something.
+       */
+      [[nodiscard]]
+      float OnWorkerNextUpdateMilliseconds() const override;
+
       /**
        * \brief called when the worker has completed
        */
@@ -140,6 +205,11 @@ namespace myoddweb
        */
       const Request _request;
 
+      /**
+       * \brief the counters and the duration histograms, before the collector as it counts its events in it.
+       */
+      Metrics _metrics;
+
       /**
        * \brief the current list of collected events.
        */
@@ -149,6 +219,41 @@ namespace myoddweb
        * \brief how often we want to check for new events.
        */
       EventsPublisher* _publisher;
+
+      /**
+       * \brief the lock used when the publisher is created or deleted.
+       */
+      mutable MYODDWEB_MUTEX _publisherLock;
+
+      /**
+       * \brief the lock for the events being pulled by the host.
+       */
+      MYODDWEB_MUTEX _pullLock;
+
+      /**
+       * \brief the window of events that is being pulled.
+       */
+      EventsBatch _pulledEvents;
+
+      /**
+       * \brief the memory used when taking a window of events from the collector.
+       */
+      Arena _pulledMemory;
+
+      /**
+       * \brief the index of the next event of the window to pull.
+       */
+      int _pulledIndex;
+
+      /**
+       * \brief a number that changes for each window so old cursors cannot be used.
+       */
+      unsigned int _pullGeneration;
+
+      /**
+       * \brief the number of events pulled since the statistics were last published.
+       */
+      std::atomic<long long> _numberOfPulledEvents;
       #pragma endregion 
 
       /**
@@ -156,7 +261,7 @@ namespace myoddweb
        */
       void StartEventsPublisher();
 
-      virtual void OnGetEvents(std::vector<Event*>& events) = 0;
+      virtual void OnGetEvents(std::vector<Event*>& events, Arena& memory) = 0;
 
       /***
        * \brief the parent id if we have one, otherwise the current id.
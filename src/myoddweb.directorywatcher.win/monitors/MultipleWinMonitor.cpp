@@ -3,10 +3,12 @@
 // See the LICENSE file in the project root for more information.
 #include "Base.h"
 #include "MultipleWinMonitor.h"
+#include "../utils/DirectoryCrawler.h"
 #include "../utils/Io.h"
 #include "../utils/Lock.h"
 
 #include <algorithm>
+#include <chrono>
 
 #ifdef _DEBUG
 #include <cassert>
@@ -20,7 +22,9 @@
 namespace myoddweb::directorywatcher
 {
   MultipleWinMonitor::MultipleWinMonitor(const long long id, threads::WorkerPool& workerPool, const Request& request) :
-    Monitor( id, workerPool, request)
+    Monitor( id, workerPool, request),
+    _creationTime(std::chrono::steady_clock::now()),
+    _startupMilliseconds(-1)
   {
     // use a standar monitor for non recursive items.
     if (!request.Recursive())
@@ -29,7 +33,7 @@ namespace myoddweb::directorywatcher
     }
 
     // try and create the list of monitors.
-    CreateMonitors( _request );
+    CreateMonitors();
   }
 
   MultipleWinMonitor::~MultipleWinMonitor()
@@ -49,9 +53,9 @@ namespace myoddweb::directorywatcher
   /**
    * \brief fill the vector with all the values currently on record.
    * \param events the events we will be filling
-   * \return the number of events we found.
+   * \param memory the arena that will hold the events.
    */
-  void MultipleWinMonitor::OnGetEvents(std::vector<Event*>& events)
+  void MultipleWinMonitor::OnGetEvents(std::vector<Event*>& events, Arena& memory)
   {
     // now that we have the lock ... check if we have stopped.
     if (!Is(State::started))
@@ -62,18 +66,71 @@ namespace myoddweb::directorywatcher
     // guard for multiple (re)entry.
     MYODDWEB_LOCK(_lock);
 
-    // get the children events
-    const auto childrentEvents = GetAndProcessChildEventsInLock();
+    // our own events are the first run.
+    _runs.assign(1, 0);
 
-    // then look for the parent events.
-    const auto parentEvents = GetAndProcessParentEventsInLock();
+    // add the children events, and then the parent events.
+    GetAndProcessChildEventsInLock(events, _runs, memory);
+    GetAndProcessParentEventsInLock(events, _runs, memory);
 
-    //  add the parents and the children
-    events.insert(events.end(), childrentEvents.begin(), childrentEvents.end());
-    events.insert(events.end(), parentEvents.begin(), parentEvents.end());
+    // each monitor gave us its events in time order, so we only need to merge them.
+    _merger.Merge(events, _runs);
+  }
+
+  /**
+   * \brief check if we, or any of our monitors, have events that have not been published yet.
+   * \return if we have events waiting.
+   */
+  bool MultipleWinMonitor::HasEvents() const
+  {
+    if (Monitor::HasEvents())
+    {
+      return true;
+    }
+
+    // this is called by the worker pool while it holds its own locks
+    // so we cannot wait, if the lock is busy we assume that we have events.
+    std::unique_lock<MYODDWEB_MUTEX> lock(_lock, std::try_to_lock);
+    if (!lock.owns_lock())
+    {
+      return true;
+    }
+
+    for (const auto monitor : _nonRecursiveParents)
+    {
+      if (monitor->HasEvents())
+      {
+        return true;
+      }
+    }
+    for (const auto monitor : _recursiveChildren)
+    {
+      if (monitor->HasEvents())
+      {
+        return true;
+      }
+    }
+    return false;
+  }
 
-    // then sort everything by inserted time
-    std::sort(events.begin(), events.end(), Collector::SortByTimeMillisecondsUtc);
+  /**
+   * \brief add the statistics of all our monitors.
+   * \param statistics the statistics we are adding to.
+   */
+  void MultipleWinMonitor::AddMonitorStatistics(MonitorStatistics& statistics) const
+  {
+    Monitor::AddMonitorStatistics(statistics);
+    statistics.StartupMilliseconds = StartupMilliseconds();
+
+    MYODDWEB_LOCK(_lock);
+    for (const auto monitor : _nonRecursiveParents)
+    {
+      monitor->AddMonitorStatistics(statistics);
+    }
+    for (const auto monitor : _recursiveChildren)
+    {
+      monitor->AddMonitorStatistics(statistics);
+    }
   }
 
 #pragma region Woker functions
@@ -104,6 +161,9 @@ namespace myoddweb::directorywatcher
       // and the children
       Start(_recursiveChildren);
 
+      // we are as ready as we can be.
+      _startupMilliseconds = StartupMilliseconds();
+
       return Monitor::OnWorkerStart();
     }
     catch (const std::exception& e)
@@ -139,20 +199,22 @@ namespace myoddweb::directorywatcher
   /**
    * \brief look for a possible child with a matching path.
    * \param path the path we are looking for.
-   * \return if we find it, the iterator of the child monitor.
+   * \return the child monitor or null if we do not have one.
    */
-  std::vector<Monitor*>::const_iterator MultipleWinMonitor::FindChildInLock(const std::wstring& path) const
+  Monitor* MultipleWinMonitor::FindChildInLock(const std::wstring& path) const
   {
-    for (auto child = _recursiveChildren.begin();
-      child != _recursiveChildren.end();
-      ++child)
-    {
-      if ((*child)->IsPath(path))
-      {
-        return child;
-      }
-    }
-    return _recursiveChildren.end();
+    const auto child = _childrenByPath.find(Io::NormalizeFolder(path));
+    return child == _childrenByPath.end() ? nullptr : child->second;
+  }
+
+  /**
+   * \brief add a recursive child and index it by path.
+   * \param child the child we are adding, we own it.
+   */
+  void MultipleWinMonitor::AddChildInLock(Monitor* child)
+  {
+    _recursiveChildren.emplace_back(child);
+    _childrenByPath[Io::NormalizeFolder(child->Path())] = child;
   }
 
   /**
@@ -160,23 +222,26 @@ namespace myoddweb::directorywatcher
    */
   void MultipleWinMonitor::RemoveCompletedFoldersInLock()
   {
-    for (auto it = _recursiveChildren.begin(); it != _recursiveChildren.end(); ++it)
+    // remove them all in a single pass.
+    const auto end = std::remove_if(_recursiveChildren.begin(), _recursiveChildren.end(), [this](Monitor* monitor)
     {
-      // the monitor
-      const auto monitor = (*it);
-
       if (!monitor->Completed())
       {
-        continue;
+        return false;
+      }
+
+      // the path might have been re-added with a new monitor, we do not want to forget that one.
+      const auto child = _childrenByPath.find(Io::NormalizeFolder(monitor->Path()));
+      if (child != _childrenByPath.end() && child->second == monitor)
+      {
+        _childrenByPath.erase(child);
       }
 
       // this item is complete, we can get rid of it.
       delete monitor;
-      _recursiveChildren.erase(it);
-
-      // then we want to restart
-      it = _recursiveChildren.begin();
-    }
+      return true;
+    });
+    _recursiveChildren.erase(end, _recursiveChildren.end());
   }
 
   /**
@@ -190,15 +255,19 @@ namespace myoddweb::directorywatcher
       return;
     }
 
-    // cleanup folders
-    RemoveCompletedFoldersInLock();
+    // we might already be watching this folder.
+    const auto existing = FindChildInLock(path);
+    if (existing != nullptr && !existing->MustStop())
+    {
+      return;
+    }
 
     // a folder was added to this path
     // so we have to add this path as a child.
     const auto id = GetNextId();
-    const auto request = Request(path, true, _request.EventsCallbackRateMilliseconds(), _request.StatsCallbackRateMilliseconds() );
+    const auto request = Request(path, true, _request );
     const auto child = new WinMonitor(id, ParentId(), WorkerPool(), request );
-    _recursiveChildren.emplace_back(child); 
+    AddChildInLock(child);
 
     // add the child.
     WorkerPool().Add( *child );
@@ -215,21 +284,15 @@ namespace myoddweb::directorywatcher
       return;
     }
 
-    // cleanup folders
-    RemoveCompletedFoldersInLock();
-
     // the 'path' folder was removed.
     // so we have to remove it as well as all the child folders.
     // 'cause if it was removed ... then so were the others.
-    const auto child = FindChildInLock(path);
-    if (child == _recursiveChildren.end())
+    const auto monitor = FindChildInLock(path);
+    if (monitor == nullptr)
     {
       return;
     }
 
-    // the monitor
-    const auto monitor = (*child);
-
     // stop it...
     monitor->Stop();
 
@@ -253,12 +316,14 @@ namespace myoddweb::directorywatcher
 
   /**
    * \brief process the parent events
-   * \return events the events we will be adding to
+   * \param events the events we will be adding to, one run per parent.
+   * \param runs the index of the first event of each parent is added to it.
+   * \param memory the arena that will hold the events.
    */
-  std::vector<Event*> MultipleWinMonitor::GetAndProcessParentEventsInLock()
+  void MultipleWinMonitor::GetAndProcessParentEventsInLock(std::vector<Event*>& events, std::vector<size_t>& runs, Arena& memory)
   {
-    // get the events
-    std::vector<Event*> events;
+    // cleanup the folders that completed since the last time, once for all the events.
+    RemoveCompletedFoldersInLock();
 
     // the current events.
     std::vector<Event*> levents;
@@ -269,14 +334,14 @@ namespace myoddweb::directorywatcher
         // if we are stopped or stopping, there is nothing for us to do.
         if (Is(State::stopped) || Is(State::stopping))
         {
-          return events;
+          return;
         }
 
         // the monitor
         auto& monitor = *(*it);
 
         // get this directory events
-        if (0 == monitor.GetEvents(levents))
+        if (0 == monitor.GetEvents(levents, memory))
         {
           continue;
         }
@@ -316,6 +381,7 @@ namespace myoddweb::directorywatcher
         }
 
         // add them to our list of events.
+        runs.emplace_back(events.size());
         events.insert(events.end(), levents.begin(), levents.end());
 
         // clear the list
@@ -326,58 +392,50 @@ namespace myoddweb::directorywatcher
         SaveCurrentException();
       }
     }
-    return events;
   }
 
   /**
    * \brief process the cildren events
-   * \return events the events we will be adding to
+   * \param events the events we will be adding to, one run per child.
+   * \param runs the index of the first event of each child is added to it.
+   * \param memory the arena that will hold the events.
    */
-  std::vector<Event*> MultipleWinMonitor::GetAndProcessChildEventsInLock() const
+  void MultipleWinMonitor::GetAndProcessChildEventsInLock(std::vector<Event*>& events, std::vector<size_t>& runs, Arena& memory) const
   {
-    // all the events.
-    std::vector<Event*> events;
     for (auto monitor : _recursiveChildren)
     {
-      const auto levents = GetEvents(monitor);
-      if (levents.empty())
+      const auto start = events.size();
+      GetEvents(monitor, events, memory);
+      if (events.size() != start)
       {
-        continue;
+        runs.emplace_back(start);
       }
-      events.insert(events.end(), levents.begin(), levents.end());
     }
-    return events;
   }
 
   /**
-   * \brief process the children events
+   * \brief get the events of one of our monitors.
    * \param monitor the monitor we are getting the events for.
-   * \rerturn events the events we will be adding to
+   * \param events the events we will be adding to.
+   * \param memory the arena that will hold the events.
    */
-  std::vector<Event*> MultipleWinMonitor::GetEvents(Monitor* monitor) const
+  void MultipleWinMonitor::GetEvents(Monitor* monitor, std::vector<Event*>& events, Arena& memory) const
   {
     try
     {
       // if we are stopped or stopping, there is nothing for us to do.
       if (Is(State::stopped) || Is(State::stopping))
       {
-        return {};
+        return;
       }
 
-      // the current events.
-      std::vector<Event*> events;
-
-      // get this directory events
-      monitor->GetEvents(events);
-
-      // add them to our list of events.
-      return events;
+      // get this directory events, they are added to the ones we already have.
+      monitor->GetEvents(events, memory);
     }
     catch (...)
     {
       SaveCurrentException();
     }
-    return {};
   }
 
   /**
@@ -420,6 +478,7 @@ namespace myoddweb::directorywatcher
 
     // delete the children
     DeleteInLock(_recursiveChildren);
+    _childrenByPath.clear();
 
     // and the parents
     DeleteInLock(_nonRecursiveParents);
@@ -481,48 +540,113 @@ namespace myoddweb::directorywatcher
   }
 
   /**
-   * \brief Create all the sub-requests for a prarent request.
-   * \param parent the parent request itselft.
+   * \brief Create all the monitors for our request, the sub-folders are looked at by a few threads at a time.
    */
-  void MultipleWinMonitor::CreateMonitors(const Request& parent )
+  void MultipleWinMonitor::CreateMonitors()
   {
-    // if we are stopping, then we cannot go further.
-    if (Is(State::stopping))
-    {
-      return;
-    }
-
-    // get the next id.
-    const auto id = GetNextId();
+    MYODDWEB_PROFILE_FUNCTION();
 
 #ifdef _DEBUG
     // this whole class expects recursive requests
     // so we should not be able to have anything
     // other than recursive.
-    assert(parent.Recursive());
+    assert(_request.Recursive());
 #endif
 
-    // look for all the sub-paths
-    const auto subPaths = Io::GetAllSubFolders(parent.Path());
-    if (subPaths.empty() || TotalSize() > MYODDWEB_MAX_NUMBER_OF_SUBPATH)
+    // each monitor is created as soon as we know what kind of monitor the folder needs.
+    DirectoryCrawler crawler;
+    crawler.Crawl(_request.Path(),
+      [this](const std::wstring& folder)
+      {
+        return EnterFolder(folder);
+      },
+      [this](const std::wstring& folder, const std::vector<std::wstring>& subFolders)
+      {
+        return AddFolder(folder, subFolders);
+      });
+
+    Logger::Log(ParentId(), LogLevel::Information, L"Looked at %lld folder(s) in %lldms", crawler.NumberOfFolders(), StartupMilliseconds());
+  }
+
+  /**
+   * \brief called before we look for the sub-folders of a folder.
+   * \param folder the folder we are about to look at.
+   * \return if we want the sub-folders or not.
+   */
+  bool MultipleWinMonitor::EnterFolder(const std::wstring& folder)
+  {
+    // if we are stopping, then we cannot go further.
+    if (Is(State::stopping))
+    {
+      return false;
+    }
+
+    MYODDWEB_LOCK(_lock);
+    if (TotalSize() <= MYODDWEB_MAX_NUMBER_OF_SUBPATH)
+    {
+      return true;
+    }
+
+    // we already breached the limit, there is no need to look for the sub-folders.
+    AddRecursiveChildInLock(folder);
+    return false;
+  }
+
+  /**
+   * \brief add the monitor for a folder once we know its sub-folders.
+   * \param folder the folder we looked at.
+   * \param subFolders all the sub-folders of that folder.
+   * \return if we want to look at the sub-folders as well.
+   */
+  bool MultipleWinMonitor::AddFolder(const std::wstring& folder, const std::vector<std::wstring>& subFolders)
+  {
+    MYODDWEB_LOCK(_lock);
+    if (subFolders.empty() || TotalSize() > MYODDWEB_MAX_NUMBER_OF_SUBPATH)
     {
       // we will breach the depth
-      _recursiveChildren.push_back(new WinMonitor(id, ParentId(), WorkerPool(), parent ));
-      return;
+      AddRecursiveChildInLock(folder);
+      return false;
     }
-    
+
     // adding all the sub-paths will not breach the limit.
     // so we can add the parent, but non-recuresive.
-    const auto request = Request(parent.Path(), false, parent.EventsCallbackRateMilliseconds(), parent.StatsCallbackRateMilliseconds());
-    _nonRecursiveParents.emplace_back(new WinMonitor(id, ParentId(), WorkerPool(), request ));
+    const auto request = Request(folder.c_str(), false, _request);
+    const auto monitor = new WinMonitor(GetNextId(), ParentId(), WorkerPool(), request);
+    _nonRecursiveParents.emplace_back(monitor);
 
-    // now try and add all the subpath
-    for (const auto& path : subPaths)
+    // we already know that all the sub-paths are directories.
+    monitor->AddKnownDirectories(subFolders);
+    return true;
+  }
+
+  /**
+   * \brief add a recursive monitor for a folder we found.
+   * \param folder the folder we are monitoring.
+   */
+  void MultipleWinMonitor::AddRecursiveChildInLock(const std::wstring& folder)
+  {
+    // our own folder keeps the full request.
+    if (folder == _request.Path())
+    {
+      AddChildInLock(new WinMonitor(GetNextId(), ParentId(), WorkerPool(), _request));
+      return;
+    }
+    const auto request = Request(folder.c_str(), true, _request);
+    AddChildInLock(new WinMonitor(GetNextId(), ParentId(), WorkerPool(), request));
+  }
+
+  /**
+   * \brief the time it took to create and start all our monitors, so far if we are still starting.
+   * \return the number of ms.
+   */
+  long long MultipleWinMonitor::StartupMilliseconds() const
+  {
+    const auto startup = _startupMilliseconds.load();
+    if (startup >= 0)
     {
-      // add one more to the list.
-      const auto subRequest = Request(path.c_str(), true, parent.EventsCallbackRateMilliseconds(), parent.StatsCallbackRateMilliseconds());
-      CreateMonitors( subRequest );
+      return startup;
     }
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _creationTime).count();
   }
 #pragma endregion
 }
@@ -2,8 +2,13 @@
 // Florent Guelfucci licenses this file to you under the MIT license.
 // See the LICENSE file in the project root for more information.
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <unordered_map>
 #include "Monitor.h"
 #include "WinMonitor.h"
+#include "../utils/EventsMerger.h"
 
 namespace myoddweb
 {
@@ -21,7 +26,20 @@ namespace myoddweb
       MultipleWinMonitor(const MultipleWinMonitor&) = delete;
       MultipleWinMonitor& operator=(const MultipleWinMonitor&) = delete;
 
-      void OnGetEvents(std::vector<Event*>& events) override;
+      void OnGetEvents(std::vector<Event*>& events, Arena& memory) override;
+
+      /**
+       * \brief check if we, or any of our monitors, have events that have not been published yet.
+       * \return if we have events waiting.
+       */
+      [[nodiscard]]
+      bool HasEvents() const override;
+
+      /**
+       * \brief add the statistics of all our monitors, as well as the time it took us to start them.
+       * \param statistics the statistics we are adding to.
+       */
+      void AddMonitorStatistics(MonitorStatistics& statistics) const override;
 
       [[nodiscard]]
       const long long& ParentId() const override;
@@ -53,7 +71,7 @@ namespace myoddweb
       /**
        * \brief the locks so we can add data.
        */
-      MYODDWEB_MUTEX _lock;
+      mutable MYODDWEB_MUTEX _lock;
 
       /**
        * \brief the non recursive parents, we will monitor new folder for those.
@@ -65,6 +83,32 @@ namespace myoddweb
        */
       std::vector<Monitor*> _recursiveChildren;
 
+      /**
+       * \brief the recursive children by normalized path, (see Io::NormalizeFolder( ... ) ).
+       *        if a folder was re-added while the old monitor was stopping, this is the new monitor.
+       */
+      std::unordered_map<std::wstring, Monitor*> _childrenByPath;
+
+      /**
+       * \brief merges the events of all our monitors, each monitor gives us its events in time order.
+       */
+      EventsMerger _merger;
+
+      /**
+       * \brief the index of the first event of each monitor, used to merge them.
+       */
+      std::vector<size_t> _runs;
+
+      /**
+       * \brief when we were created, we start looking for the sub-folders straight away.
+       */
+      const std::chrono::steady_clock::time_point _creationTime;
+
+      /**
+       * \brief the time it took to create and start all our monitors, -1 until they are all started.
+       */
+      std::atomic<long long> _startupMilliseconds;
+
       /**
        * \brief A running count of Ids
        */
@@ -84,10 +128,37 @@ namespace myoddweb
       long TotalSize() const;
 
       /**
-       * \brief Create all the sub-requests for a prarent request.
-       * \param parent the parent request itselft.
+       * \brief Create all the monitors for our request, the sub-folders are looked at by a few threads at a time.
+       */
+      void CreateMonitors();
+
+      /**
+       * \brief called before we look for the sub-folders of a folder.
+       * \param folder the folder we are about to look at.
+       * \return if we want the sub-folders or not.
+       */
+      bool EnterFolder(const std::wstring& folder);
+
+      /**
+       * \brief add the monitor for a folder once we know its sub-folders.
+       * \param folder the folder we looked at.
+       * \param subFolders all the sub-folders of that folder.
+       * \return if we want to look at the sub-folders as well.
+       */
+      bool AddFolder(const std::wstring& folder, const std::vector<std::wstring>& subFolders);
+
+      /**
+       * \brief add a recursive monitor for a folder we found.
+       * \param folder the folder we are monitoring.
        */
-      void CreateMonitors(const Request& parent );
+      void AddRecursiveChildInLock(const std::wstring& folder);
+
+      /**
+       * \brief the time it took to create and start all our monitors, so far if we are still starting.
+       * \return the number of ms.
+       */
+      [[nodiscard]]
+      long long StartupMilliseconds() const;
 
       /**
        * \brief Clear all the current data
@@ -118,33 +189,43 @@ namespace myoddweb
        */
       void RemoveCompletedFoldersInLock();
 
+      /**
+       * \brief add a recursive child and index it by path.
+       * \param child the child we are adding, we own it.
+       */
+      void AddChildInLock(Monitor* child);
+
       /**
        * \brief process the parent events
-       * \return events the events we will be adding to
+       * \param events the events we will be adding to, one run per parent.
+       * \param runs the index of the first event of each parent is added to it.
+       * \param memory the arena that will hold the events.
        */
-      std::vector<Event*> GetAndProcessParentEventsInLock();
+      void GetAndProcessParentEventsInLock(std::vector<Event*>& events, std::vector<size_t>& runs, Arena& memory);
 
       /**
        * \brief process the children events
-       * \rerturn events the events we will be adding to
+       * \param events the events we will be adding to, one run per child.
+       * \param runs the index of the first event of each child is added to it.
+       * \param memory the arena that will hold the events.
        */
-      [[nodiscard]]
-      std::vector<Event*> GetAndProcessChildEventsInLock() const;
+      void GetAndProcessChildEventsInLock(std::vector<Event*>& events, std::vector<size_t>& runs, Arena& memory) const;
 
       /**
-       * \brief process the children events
+       * \brief get the events of one of our monitors.
        * \param monitor the monitor we are getting the events for.
-       * \rerturn events the events we will be adding to
+       * \param events the events we will be adding to.
+       * \param memory the arena that will hold the events.
        */
-      std::vector<Event*> GetEvents( Monitor* monitor ) const;
+      void GetEvents( Monitor* monitor, std::vector<Event*>& events, Arena& memory ) const;
 
       /**
        * \brief look for a posible child with a matching path.
        * \param path the path we are looking for.
-       * \return if we find it, the iterator of the child monitor.
+       * \return the child monitor or null if we do not have one.
        */
       [[nodiscard]]
-      std::vector<Monitor*>::const_iterator FindChildInLock(const std::wstring& path) const;
+      Monitor* FindChildInLock(const std::wstring& path) const;
 
       /**
        * \brief Clear the container data
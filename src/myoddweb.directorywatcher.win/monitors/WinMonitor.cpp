@@ -2,7 +2,9 @@
 // Florent Guelfucci licenses this file to you under the MIT license.
 // See the LICENSE file in the project root for more information.
 #include "WinMonitor.h"
+#include <algorithm>
 #include <string>
+#include <string_view>
 
 #include "../utils/Instrumentor.h"
 #include "Base.h"
@@ -48,13 +50,14 @@ namespace myoddweb:: directorywatcher
    * \param parentId the id of the owner of this monitor, (top level)
    * \param workerPool the worker pool
    * \param request details of the request.
-   * \param bufferLength the size of the buffer
+   * \param bufferLength the largest size of the buffers, they start smaller and grow when they overflow.
    */
   WinMonitor::WinMonitor(const long long id, const long long parentId, threads::WorkerPool& workerPool, const Request& request, const unsigned long bufferLength) :
     Monitor( id, workerPool, request),
     _directories(nullptr),
     _files(nullptr),
-    _bufferLength(bufferLength),
+    _directoriesBufferSize(MYODDWEB_READ_BUFFER_MIN_SIZE, bufferLength, MYODDWEB_READ_BUFFER_INITIAL_SIZE),
+    _filesBufferSize(MYODDWEB_READ_BUFFER_MIN_SIZE, bufferLength, MYODDWEB_READ_BUFFER_INITIAL_SIZE),
     _parentId( parentId )
   {
   }
@@ -73,8 +76,9 @@ namespace myoddweb:: directorywatcher
   /**
    * \brief process the collected events add/remove them.
    * \param events the collected events.
+   * \param memory the arena that holds the events.
    */
-  void WinMonitor::OnGetEvents(std::vector<Event*>& events)
+  void WinMonitor::OnGetEvents(std::vector<Event*>& events, Arena& memory)
   {
     //  nothing to do
   }
@@ -105,7 +109,7 @@ namespace myoddweb:: directorywatcher
     try
     {
       // create the directories monitor
-      _directories = new win::Directories(*this, _bufferLength);
+      _directories = new win::Directories(*this, _entries, _directoriesBufferSize);
 
       // add the files as well as the directories to the worker pool.
       if( !_directories->Start() )
@@ -116,7 +120,7 @@ namespace myoddweb:: directorywatcher
       }
 
       // and then the files monitor.
-      _files = new win::Files(*this, _bufferLength);
+      _files = new win::Files(*this, _entries, _filesBufferSize);
 
       if( !_files->Start() )
       {
@@ -165,6 +169,64 @@ namespace myoddweb:: directorywatcher
     return Monitor::OnWorkerUpdate(fElapsedTimeMilliseconds);
   }
 
+  /**
+   * \brief how long we are happy to wait before our next update if nothing wakes us up.
+   * \return the number of ms before we next need an update.
+   */
+  float WinMonitor::OnWorkerNextUpdateMilliseconds() const
+  {
+    // if we lost one of the handles we need to be updated when it is time to re-open it.
+    auto milliseconds = Monitor::OnWorkerNextUpdateMilliseconds();
+    if (_directories != nullptr)
+    {
+      milliseconds = (std::min)(milliseconds, _directories->MillisecondsUntilReopen());
+    }
+    if (_files != nullptr)
+    {
+      milliseconds = (std::min)(milliseconds, _files->MillisecondsUntilReopen());
+    }
+    return milliseconds;
+  }
+
+  /**
+   * \brief add the number of times we knew, (or not), if an entry was a file
+   *        as well as the size of our read buffers and how often they overflowed.
+   * \param statistics the statistics we are adding to.
+   */
+  void WinMonitor::AddMonitorStatistics(MonitorStatistics& statistics) const
+  {
+    Monitor::AddMonitorStatistics(statistics);
+    statistics.NumberOfEntryCacheHits += _entries.NumberOfHits();
+    statistics.NumberOfEntryCacheMisses += _entries.NumberOfMisses();
+    statistics.ReadBufferSize += _directoriesBufferSize.Size() + _filesBufferSize.Size();
+    statistics.NumberOfReadOverflows += _directoriesBufferSize.NumberOfOverflows() + _filesBufferSize.NumberOfOverflows();
+  }
+
+  /**
+   * \brief let the monitor know about directories we already found
+   *        so it does not need to ask the file system when they are changed.
+   * \param paths the full paths of the directories, only the ones in our path are used.
+   */
+  void WinMonitor::AddKnownDirectories(const std::vector<std::wstring>& paths)
+  {
+    const std::wstring_view root = Path();
+    for (const auto& path : paths)
+    {
+      if (path.size() <= root.size() || std::wstring_view(path).compare(0, root.size(), root) != 0)
+      {
+        continue;
+      }
+
+      // the events are relative to our path.
+      auto relative = std::wstring_view(path).substr(root.size());
+      while (!relative.empty() && (relative.front() == L'\\' || relative.front() == L'/'))
+      {
+        relative.remove_prefix(1);
+      }
+      _entries.Set(relative, false);
+    }
+  }
+
   /**
    * \brief called when the worker has completed
    */
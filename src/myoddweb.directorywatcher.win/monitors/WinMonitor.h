@@ -3,7 +3,11 @@
 // See the LICENSE file in the project root for more information.
 #pragma once
 #include <Windows.h>
+#include <string>
+#include <vector>
 #include "Monitor.h"
+#include "../utils/BufferSizePolicy.h"
+#include "../utils/EntryCache.h"
 #include "win/Common.h"
 
 namespace myoddweb
@@ -27,11 +31,25 @@ namespace myoddweb
       const WinMonitor& operator=(const WinMonitor&) = delete;
       WinMonitor&& operator=(WinMonitor&&) = delete;
 
-      void OnGetEvents(std::vector<Event*>& events) override;
+      void OnGetEvents(std::vector<Event*>& events, Arena& memory) override;
 
       [[nodiscard]]
       const long long& ParentId() const override;
 
+      /**
+       * \brief add the number of times we knew, (or not), if an entry was a file
+       *        as well as the size of our read buffers and how often they overflowed.
+       * \param statistics the statistics we are adding to.
+       */
+      void AddMonitorStatistics(MonitorStatistics& statistics) const override;
+
+      /**
+       * \brief let the monitor know about directories we already found
+       *        so it does not need to ask the file system when they are changed.
+       * \param paths the full paths of the directories, only the ones in our path are used.
+       */
+      void AddKnownDirectories(const std::vector<std::wstring>& paths);
+
     protected:
       /**
        * \brief the non blocking stop function
@@ -53,6 +71,13 @@ namespace myoddweb
        */
       bool OnWorkerUpdate(float fElapsedTimeMilliseconds) override;
 
+      /**
+       * \brief how long we are happy to wait before our next update if nothing wakes us up.
+       * \return the number of ms before we next need an update.
+       */
+      [[nodiscard]]
+      float OnWorkerNextUpdateMilliseconds() const override;
+
       /**
        * \brief called when the worker has completed
        */
@@ -62,7 +87,16 @@ namespace myoddweb
       win::Common* _directories;
       win::Common* _files;
 
-      const unsigned long _bufferLength;
+      /**
+       * \brief the entries we know are files or directories, shared by the files and directories watchers.
+       */
+      EntryCache _entries;
+
+      /**
+       * \brief the size of the buffers the directories and files watchers read into.
+       */
+      BufferSizePolicy _directoriesBufferSize;
+      BufferSizePolicy _filesBufferSize;
 
       const long long _parentId;
     };
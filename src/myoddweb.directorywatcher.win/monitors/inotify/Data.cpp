@@ -0,0 +1,516 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#if defined(__linux__)
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <dirent.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Data.h"
+#include "../../utils/BufferPool.h"
+#include "../../utils/Instrumentor.h"
+#include "../../utils/Io.h"
+#include "../../utils/Logger.h"
+#include "../../utils/LogLevel.h"
+#include "../Base.h"
+
+namespace myoddweb:: directorywatcher:: inotify
+{
+  /**
+   * \brief what we wish to be notified about, this is as close as posible to the windows filters.
+   *        we only want folders, (IN_ONLYDIR), and we do not want events for files that are already unlinked.
+   * \see http://man7.org/linux/man-pages/man7/inotify.7.html
+   */
+  constexpr uint32_t NotifyMask =
+    IN_CREATE | IN_DELETE | IN_MODIFY | IN_ATTRIB |
+    IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF |
+    IN_EXCL_UNLINK | IN_ONLYDIR;
+
+  /**
+   * \brief the maximum number of reads we will do in a single update
+   *        this prevents one very busy folder from holding the worker pool forever.
+   *        whatever is left will stay in the kernel queue until the next update.
+   */
+  constexpr auto MaxReadsPerUpdate = 16;
+
+  Data::Data(Monitor& parent, BufferSizePolicy& bufferSize) :
+    EventSource(bufferSize),
+    _parent(parent),
+    _fd(-1),
+    _path(Io::ToUtf8(parent.Path())),
+    _rootWatch(-1),
+    _reopenMilliseconds(0)
+  {
+    // the buffer that will receive our data is only borrowed from the shared pool when we read.
+  }
+
+  Data::~Data()
+  {
+    Stop();
+  }
+
+  /**
+   * \brief Check if the file descriptor is valid
+   */
+  bool Data::IsValidHandle() const
+  {
+    return _fd != -1;
+  }
+
+  /**
+   * \brief open the inotify file descriptor and add the watch(es) for our path.
+   * \return if we managed to start the monitoring or not.
+   */
+  bool Data::Start()
+  {
+    MYODDWEB_PROFILE_FUNCTION();
+
+    // check if this was done already
+    if (IsValidHandle())
+    {
+      return true;
+    }
+
+    // non blocking, we will read everything that is available during our update.
+    _fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (!IsValidHandle())
+    {
+      Logger::Log(_parent.Id(), LogLevel::Warning, L"Unable to create inotify instance, (error: %d).", errno);
+      return false;
+    }
+
+    // reset the handle wait.
+    _reopenMilliseconds = 0;
+
+    // add the root and, if needed, all the sub folders.
+    AddWatches("", false);
+    if (_rootWatch == -1)
+    {
+      // we could not access this
+      Logger::Log(_parent.Id(), LogLevel::Warning, L"Unable to read directory: %ls", _parent.Path());
+      Stop();
+      return false;
+    }
+
+    // the worker pool will wake our monitor when there is something to read.
+    _parent.WorkerPool().Watch(_fd, _parent);
+    return true;
+  }
+
+  /**
+   * \brief close the file descriptor and release all the watches.
+   */
+  void Data::Stop()
+  {
+    // give back whatever we might still have borrowed.
+    ReleaseBuffers();
+    if (!IsValidHandle())
+    {
+      return;
+    }
+
+    // closing the file descriptor releases all the watches
+    // but we must stop waiting for it first.
+    _parent.WorkerPool().Unwatch(_fd);
+    ::close(_fd);
+    _fd = -1;
+    _rootWatch = -1;
+    _watches.clear();
+    _pendingMoves.clear();
+  }
+
+  /**
+   * \brief add a single watch for a folder relative to our root.
+   * \param relativePath the folder relative to the root, (empty for the root itself).
+   * \return the watch descriptor or -1 if we could not add it.
+   */
+  int Data::AddWatch(const std::string& relativePath)
+  {
+    const auto isRoot = relativePath.empty();
+    const auto path = isRoot ? _path : _path + "/" + relativePath;
+
+    // we follow the root if it is a link, but not the sub folders.
+    const auto wd = inotify_add_watch(_fd, path.c_str(), NotifyMask | (isRoot ? 0 : IN_DONT_FOLLOW));
+    if (wd == -1)
+    {
+      if (errno == ENOSPC)
+      {
+        Logger::Log(_parent.Id(), LogLevel::Warning, L"The user limit on the total number of inotify watches was reached, (see fs.inotify.max_user_watches).");
+      }
+      return -1;
+    }
+
+    if (isRoot)
+    {
+      _rootWatch = wd;
+    }
+    _watches[wd] = relativePath;
+    return wd;
+  }
+
+  /**
+   * \brief add a watch for a folder and, if recursive, for all the sub folders.
+   * \param relativePath the folder relative to the root.
+   * \param addEvents if we want to raise 'added' events for everything we find
+   */
+  void Data::AddWatches(const std::string& relativePath, const bool addEvents)
+  {
+    if (-1 == AddWatch(relativePath))
+    {
+      return;
+    }
+
+    // inotify is not recursive, so we need to add the sub folders ourselves.
+    if (!_parent.Recursive())
+    {
+      return;
+    }
+
+    const auto path = relativePath.empty() ? _path : _path + "/" + relativePath;
+    const auto dir = ::opendir(path.c_str());
+    if (nullptr == dir)
+    {
+      return;
+    }
+
+    for (auto entry = ::readdir(dir); entry != nullptr; entry = ::readdir(dir))
+    {
+      if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+      {
+        continue;
+      }
+
+      const auto child = relativePath.empty() ? std::string(entry->d_name) : relativePath + "/" + entry->d_name;
+
+      // some file systems do not give us the type.
+      auto isDirectory = entry->d_type == DT_DIR;
+      if (entry->d_type == DT_UNKNOWN)
+      {
+        struct stat st = {};
+        isDirectory = ::lstat((_path + "/" + child).c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+      }
+
+      if (addEvents)
+      {
+        AddEvent(EventAction::Added, child, !isDirectory);
+      }
+
+      if (isDirectory)
+      {
+        AddWatches(child, addEvents);
+      }
+    }
+    ::closedir(dir);
+  }
+
+  /**
+   * \brief remove all the watches for a given folder, and its sub folders.
+   * \param relativePath the folder relative to the root.
+   */
+  void Data::RemoveWatches(const std::string& relativePath)
+  {
+    const auto prefix = relativePath + "/";
+    for (auto it = _watches.begin(); it != _watches.end();)
+    {
+      if (it->second == relativePath || it->second.compare(0, prefix.length(), prefix) == 0)
+      {
+        // the watch might already be gone, so we do not care about the error.
+        inotify_rm_watch(_fd, it->first);
+        it = _watches.erase(it);
+        continue;
+      }
+      ++it;
+    }
+  }
+
+  /**
+   * \brief update all the watches of a folder that was renamed.
+   * \param oldPath the old relative path.
+   * \param newPath the new relative path.
+   */
+  void Data::RenameWatches(const std::string& oldPath, const std::string& newPath)
+  {
+    const auto prefix = oldPath + "/";
+    for (auto& watch : _watches)
+    {
+      if (watch.second == oldPath)
+      {
+        watch.second = newPath;
+      }
+      else if (watch.second.compare(0, prefix.length(), prefix) == 0)
+      {
+        watch.second = newPath + watch.second.substr(oldPath.length());
+      }
+    }
+  }
+
+  /**
+   * \brief read everything the kernel has queued for us, in as few reads as posible
+   *        and pass the events to the parent monitor.
+   */
+  void Data::Update()
+  {
+    MYODDWEB_PROFILE_FUNCTION();
+    if (!IsValidHandle())
+    {
+      return;
+    }
+
+    for (auto i = 0; i < MaxReadsPerUpdate; ++i)
+    {
+      // one read will give us as many events as will fit in our buffer
+      // the buffer is only borrowed for the duration of the read and the processing.
+      const auto buffer = BeginRead();
+      const auto length = ::read(_fd, buffer, ReadLength());
+      if (length > 0)
+      {
+        _parent.MonitorMetrics().Add(Metrics::Counter::BytesRead, static_cast<long long>(length));
+      }
+      if (length > 0 && CompleteRead(static_cast<unsigned long>(length)))
+      {
+        for (const auto& notification : Get())
+        {
+          ProcessEvents(notification.Buffer, static_cast<long>(notification.Length));
+          BufferPool::Shared().Release(notification.Buffer);
+        }
+        continue;
+      }
+      CancelRead();
+
+      if (length == -1 && errno == EINTR)
+      {
+        continue;
+      }
+
+      if (length == -1 && errno != EAGAIN)
+      {
+        Logger::Log(_parent.Id(), LogLevel::Warning, L"Warning: There was an error reading inotify events %d.", errno);
+      }
+
+      // nothing else to read.
+      break;
+    }
+
+    // all the moves that were not matched are removals.
+    FlushPendingMoves();
+
+    // the watch only fires once, so we need to re-arm it
+    // if there is anything left to read we will be woken up again right away.
+    _parent.WorkerPool().Watch(_fd, _parent);
+  }
+
+  /**
+   * \brief process a single buffer returned by read( ... )
+   * \param buffer the buffer we read.
+   * \param length the number of bytes in the buffer.
+   */
+  void Data::ProcessEvents(const unsigned char* buffer, const long length)
+  {
+    MYODDWEB_PROFILE_FUNCTION();
+    try
+    {
+      for (auto offset = 0L; offset < length; )
+      {
+        const auto event = reinterpret_cast<const inotify_event*>(buffer + offset);
+        offset += static_cast<long>(sizeof(inotify_event) + event->len);
+
+        // the kernel queue is full, we lost some events.
+        if ((event->mask & IN_Q_OVERFLOW) != 0)
+        {
+          // we could not read fast enough, read more at a time.
+          OverflowRead();
+          _parent.AddEventError(EventError::Overflow);
+          continue;
+        }
+
+        // the watch was removed, either explicitly or because the folder is gone.
+        if ((event->mask & IN_IGNORED) != 0)
+        {
+          if (event->wd == _rootWatch)
+          {
+            _rootWatch = -1;
+          }
+          _watches.erase(event->wd);
+          continue;
+        }
+
+        if (_watches.find(event->wd) == _watches.end())
+        {
+          continue;
+        }
+
+        // the folder itself was moved/deleted, the parent folder will tell us about it
+        // unless it is the root folder, in that case we will need to re-open it.
+        if ((event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) != 0)
+        {
+          if (event->wd == _rootWatch && (event->mask & IN_MOVE_SELF) != 0)
+          {
+            // this will give us an IN_IGNORED event.
+            inotify_rm_watch(_fd, event->wd);
+          }
+          continue;
+        }
+
+        const auto isFile = (event->mask & IN_ISDIR) == 0;
+        const auto relativePath = Relative(event->wd, event->len > 0 ? event->name : nullptr);
+        if ((event->mask & IN_CREATE) != 0)
+        {
+          AddEvent(EventAction::Added, relativePath, isFile);
+          if (!isFile && _parent.Recursive())
+          {
+            AddWatches(relativePath, true);
+          }
+        }
+        else if ((event->mask & IN_DELETE) != 0)
+        {
+          AddEvent(EventAction::Removed, relativePath, isFile);
+        }
+        else if ((event->mask & (IN_MODIFY | IN_ATTRIB)) != 0)
+        {
+          // we do not listen for changes in folders, only files.
+          if (isFile)
+          {
+            AddEvent(EventAction::Touched, relativePath, isFile);
+          }
+        }
+        else if ((event->mask & IN_MOVED_FROM) != 0)
+        {
+          _pendingMoves.push_back({ event->cookie, relativePath, isFile });
+        }
+        else if ((event->mask & IN_MOVED_TO) != 0)
+        {
+          auto it = _pendingMoves.begin();
+          for (; it != _pendingMoves.end(); ++it)
+          {
+            if (it->cookie == event->cookie)
+            {
+              break;
+            }
+          }
+
+          if (it == _pendingMoves.end())
+          {
+            // moved from outside our folder, so it is new to us.
+            AddEvent(EventAction::Added, relativePath, isFile);
+            if (!isFile && _parent.Recursive())
+            {
+              AddWatches(relativePath, true);
+            }
+            continue;
+          }
+
+          _parent.AddRenameEvent(Io::FromUtf8(relativePath), Io::FromUtf8(it->path), isFile);
+          if (!isFile)
+          {
+            RenameWatches(it->path, relativePath);
+          }
+          _pendingMoves.erase(it);
+        }
+      }
+    }
+    catch (...)
+    {
+      _parent.AddEventError(EventError::Memory);
+    }
+  }
+
+  /**
+   * \brief any orphan move, (from without a to), is a removal.
+   */
+  void Data::FlushPendingMoves()
+  {
+    for (const auto& move : _pendingMoves)
+    {
+      AddEvent(EventAction::Removed, move.path, move.isFile);
+      if (!move.isFile)
+      {
+        // the folder was moved outside of our root, we no longer care about it.
+        RemoveWatches(move.path);
+      }
+    }
+    _pendingMoves.clear();
+  }
+
+  /**
+   * \brief get the relative path of an event
+   * \param wd the watch descriptor
+   * \param name the name given to us, (if any)
+   * \return the relative path
+   */
+  std::string Data::Relative(const int wd, const char* name) const
+  {
+    const auto& folder = _watches.at(wd);
+    if (nullptr == name || name[0] == '\0')
+    {
+      return folder;
+    }
+    return folder.empty() ? std::string(name) : folder + "/" + name;
+  }
+
+  /**
+   * \brief pass an event to the parent monitor.
+   * \param action the action that was performed
+   * \param relativePath the path relative to the root.
+   * \param isFile if it is a file or not.
+   */
+  void Data::AddEvent(const EventAction action, const std::string& relativePath, const bool isFile) const
+  {
+    _parent.AddEvent(action, Io::FromUtf8(relativePath), isFile);
+  }
+
+  /**
+   * \brief how long until we try and re-open the root watch we lost.
+   * \return the number of ms until we re-open it, or the max float value if the root is watched.
+   */
+  float Data::MillisecondsUntilReopen() const
+  {
+    if (IsValidHandle() && _rootWatch != -1)
+    {
+      return (std::numeric_limits<float>::max)();
+    }
+
+    // if we have not checked it yet, we need to do it now.
+    const auto reopen = _reopenMilliseconds.load();
+    return reopen == 0 ? 0 : static_cast<float>((std::max)(reopen - threads::WorkerPool::NowMilliseconds(), 0LL));
+  }
+
+  /**
+   * \brief check that the root watch is still valid
+   *        if not then we will try and re-open it after a while.
+   */
+  void Data::CheckStillValid()
+  {
+    if (IsValidHandle() && _rootWatch != -1)
+    {
+      // The root is good, so we can reset the value
+      _reopenMilliseconds = 0;
+      return;
+    }
+
+    // the first time we see it we decide when we will re-open it.
+    const auto now = threads::WorkerPool::NowMilliseconds();
+    if (_reopenMilliseconds == 0)
+    {
+      _reopenMilliseconds = now + MYODDWEB_INVALID_HANDLE_SLEEP;
+      return;
+    }
+    if (now < _reopenMilliseconds)
+    {
+      // we need to wait a little longer before we re-open
+      return;
+    }
+
+    // we will reopen, so reset the wait time.
+    _reopenMilliseconds = 0;
+
+    // close whatever is left and try again
+    // if this does not work then it is fine because we have reset the timer
+    Stop();
+    Start();
+  }
+}
+#endif
@@ -0,0 +1,175 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#pragma once
+#if defined(__linux__)
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../EventSource.h"
+#include "../Monitor.h"
+
+namespace myoddweb:: directorywatcher:: inotify
+{
+  class Data final : public EventSource
+  {
+  public:
+    Data(Monitor& parent, BufferSizePolicy& bufferSize);
+    ~Data();
+
+    /**
+     * \brief Prevent copy construction
+     */
+    Data() = delete;
+    Data(const Data&) = delete;
+    Data(Data&&) = delete;
+    Data& operator=(const Data&) = delete;
+    Data& operator=(Data&& other) = delete;
+
+    /**
+     * \brief open the inotify file descriptor and add the watch(es) for our path.
+     * \return if we managed to start the monitoring or not.
+     */
+    bool Start() override;
+
+    /**
+     * \brief close the file descriptor and release all the watches.
+     */
+    void Stop() override;
+
+    /**
+     * \brief read everything the kernel has queued for us, in as few reads as posible
+     *        and pass the events to the parent monitor.
+     */
+    void Update();
+
+    /**
+     * \brief check that the root watch is still valid
+     *        if not then we will try and re-open it after a while.
+     */
+    void CheckStillValid();
+
+    /**
+     * \brief how long until we try and re-open the root watch we lost.
+     * \return the number of ms until we re-open it, or the max float value if the root is watched.
+     */
+    [[nodiscard]]
+    float MillisecondsUntilReopen() const;
+
+  private:
+    /**
+     * \brief a rename 'from' that is still waiting for the matching 'to'.
+     */
+    struct PendingMove
+    {
+      uint32_t cookie;
+      std::string path;
+      bool isFile;
+    };
+
+    /**
+     * \brief Check if the file descriptor is valid
+     */
+    [[nodiscard]]
+    bool IsValidHandle() const;
+
+    /**
+     * \brief add a single watch for a folder relative to our root.
+     * \param relativePath the folder relative to the root, (empty for the root itself).
+     * \return the watch descriptor or -1 if we could not add it.
+     */
+    int AddWatch(const std::string& relativePath);
+
+    /**
+     * \brief add a watch for a folder and, if recursive, for all the sub folders.
+     * \param relativePath the folder relative to the root.
+     * \param addEvents if we want to raise 'added' events for everything we find
+     *        this is used for folders that are created while we are watching, as we might
+     *        have missed some files created before our watch was in place.
+     */
+    void AddWatches(const std::string& relativePath, bool addEvents);
+
+    /**
+     * \brief remove all the watches for a given folder, and its sub folders.
+     * \param relativePath the folder relative to the root.
+     */
+    void RemoveWatches(const std::string& relativePath);
+
+    /**
+     * \brief update all the watches of a folder that was renamed.
+     * \param oldPath the old relative path.
+     * \param newPath the new relative path.
+     */
+    void RenameWatches(const std::string& oldPath, const std::string& newPath);
+
+    /**
+     * \brief process a single buffer returned by read( ... )
+     * \param buffer the buffer we read.
+     * \param length the number of bytes in the buffer.
+     */
+    void ProcessEvents(const unsigned char* buffer, long length);
+
+    /**
+     * \brief get the relative path of an event
+     * \param wd the watch descriptor
+     * \param name the name given to us, (if any)
+     * \return the relative path
+     */
+    [[nodiscard]]
+    std::string Relative(int wd, const char* name) const;
+
+    /**
+     * \brief pass an event to the parent monitor.
+     * \param action the action that was performed
+     * \param relativePath the path relative to the root.
+     * \param isFile if it is a file or not.
+     */
+    void AddEvent(EventAction action, const std::string& relativePath, bool isFile) const;
+
+    /**
+     * \brief any orphan move, (from without a to), is a removal.
+     */
+    void FlushPendingMoves();
+
+    #pragma region Variables
+    /**
+     * \brief the parent monitor
+     */
+    Monitor& _parent;
+
+    /**
+     * \brief the inotify file descriptor.
+     */
+    int _fd;
+
+    /**
+     * \brief the root path in utf-8
+     */
+    const std::string _path;
+
+    /**
+     * \brief all the watch descriptors and the relative path they are watching.
+     */
+    std::unordered_map<int, std::string> _watches;
+
+    /**
+     * \brief the moves that are still waiting for the second half.
+     */
+    std::vector<PendingMove> _pendingMoves;
+
+    /**
+     * \brief the watch descriptor of the root folder, -1 if the root is not watched.
+     */
+    int _rootWatch;
+
+    /**
+     * \brief when we will try and re-open the root we lost, 0 if we have not lost it yet.
+     *        (see threads::WorkerPool::NowMilliseconds( ... ) ).
+     */
+    std::atomic<long long> _reopenMilliseconds;
+    #pragma endregion
+  };
+}
+#endif
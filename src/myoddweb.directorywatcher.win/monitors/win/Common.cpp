@@ -2,22 +2,35 @@
 // Florent Guelfucci licenses this file to you under the MIT license.
 // See the LICENSE file in the project root for more information.
 #include "Common.h"
+#include <cstddef>
+#include <limits>
+#include "NotificationParser.h"
+#include "../../utils/BufferPool.h"
 #include "../../utils/Io.h"
 #include "../../utils/EventError.h"
 #include "../../utils/Instrumentor.h"
 
 namespace myoddweb ::directorywatcher :: win
 {
+  // the parser re-declares the layout so it does not need <Windows.h>, make sure it matches.
+  static_assert(sizeof(NotifyInformation) == sizeof(FILE_NOTIFY_INFORMATION), "The notify information layout does not match.");
+  static_assert(offsetof(NotifyInformation, NextEntryOffset) == offsetof(FILE_NOTIFY_INFORMATION, NextEntryOffset), "The notify information layout does not match.");
+  static_assert(offsetof(NotifyInformation, Action) == offsetof(FILE_NOTIFY_INFORMATION, Action), "The notify information layout does not match.");
+  static_assert(offsetof(NotifyInformation, FileNameLength) == offsetof(FILE_NOTIFY_INFORMATION, FileNameLength), "The notify information layout does not match.");
+  static_assert(offsetof(NotifyInformation, FileName) == offsetof(FILE_NOTIFY_INFORMATION, FileName), "The notify information layout does not match.");
+
   /**
    * \brief Create the Monitor that uses ReadDirectoryChanges
    */
   Common::Common(
     Monitor& parent,
-    const unsigned long bufferLength
+    EntryCache& entries,
+    BufferSizePolicy& bufferSize
   ) :
     _data(nullptr),
     _parent(parent),
-    _bufferLength(bufferLength)
+    _entries(entries),
+    _bufferSize(bufferSize)
   {
   }
 
@@ -37,11 +50,9 @@ namespace myoddweb ::directorywatcher :: win
 
     // create the data
     _data = new Data(
-      _parent.Id(),
-      _parent.Path(),
+      _parent,
       notifyFilter, 
-      _parent.Recursive(), 
-      _bufferLength);
+      _bufferSize);
 
     // then start monitoring
     return _data->Start();
@@ -59,14 +70,23 @@ namespace myoddweb ::directorywatcher :: win
     const auto rawData = _data->Get();
     for( const auto& raw : rawData )
     {
-      ProcessNotification(raw);
-      delete[] raw;
+      ProcessNotification(raw.Buffer, raw.Length);
+      BufferPool::Shared().Release(raw.Buffer);
     }
 
     // ensure that the data is still valid
     _data->CheckStillValid();
   }
 
+  /**
+   * \brief how long until we try and re-open the handle we lost.
+   * \return the number of ms until we re-open it, or the max float value if the handle is valid.
+   */
+  float Common::MillisecondsUntilReopen() const
+  {
+    return _data == nullptr ? (std::numeric_limits<float>::max)() : _data->MillisecondsUntilReopen();
+  }
+
   /**
    * \brief complete all the data collection
    */
@@ -85,10 +105,13 @@ namespace myoddweb ::directorywatcher :: win
 
   /**
    * \brief this function is called _after_ we received a folder change request
-   *        we own this buffer and we mus delete it at the end.
-   * \param pBuffer
+   *        we own this buffer and we must give it back to the pool at the end.
+   *        The names are views into the buffer, nothing is copied until the collector
+   *        writes the full path in its own memory.
+   * \param pBuffer the buffer received
+   * \param length the number of bytes in the buffer.
    */
-  void Common::ProcessNotification(const unsigned char* pBuffer) const
+  void Common::ProcessNotification(const unsigned char* pBuffer, const unsigned long length) const
   {
     MYODDWEB_PROFILE_FUNCTION();
 
@@ -102,37 +125,38 @@ namespace myoddweb ::directorywatcher :: win
       }
 
       // rename filenames.
-      std::wstring newFilename;
-      std::wstring oldFilename;
+      std::wstring_view newFilename;
+      std::wstring_view oldFilename;
 
       // get the file information
-      auto pRecord = (FILE_NOTIFY_INFORMATION*)pBuffer;
-      for (;;)
+      NotificationParser parser(pBuffer, length);
+      NotificationRecord record = {};
+      while (parser.Next(record))
       {
-        // get the filename
-        const auto wFilename = std::wstring(pRecord->FileName, pRecord->FileNameLength / sizeof(wchar_t));
-        switch (pRecord->Action)
+        const auto& wFilename = record.FileName;
+        switch (record.Action)
         {
         case FILE_ACTION_ADDED:
-          _parent.AddEvent(EventAction::Added, wFilename, IsFile(EventAction::Added, wFilename));
+          _parent.AddEvent(EventAction::Added, wFilename, IsKnownFile(EventAction::Added, wFilename));
           break;
 
         case FILE_ACTION_REMOVED:
-          _parent.AddEvent(EventAction::Removed, wFilename, IsFile(EventAction::Removed, wFilename));
+          _parent.AddEvent(EventAction::Removed, wFilename, IsKnownFile(EventAction::Removed, wFilename));
           break;
 
         case FILE_ACTION_MODIFIED:
-          _parent.AddEvent(EventAction::Touched, wFilename, IsFile(EventAction::Touched, wFilename));
+          _parent.AddEvent(EventAction::Touched, wFilename, IsKnownFile(EventAction::Touched, wFilename));
           break;
 
         case FILE_ACTION_RENAMED_OLD_NAME:
           oldFilename = wFilename;
+          _entries.Remove(oldFilename);
           if (!newFilename.empty())
           {
             // if we already have a new filename then we can add the rename event
             // and then clear both filenames so we do not add again
-            _parent.AddRenameEvent(newFilename, oldFilename, IsFile(EventAction::Renamed, newFilename));
-            newFilename = oldFilename = L"";
+            _parent.AddRenameEvent(newFilename, oldFilename, IsKnownFile(EventAction::Renamed, newFilename));
+            newFilename = oldFilename = {};
           }
           break;
 
@@ -142,32 +166,31 @@ namespace myoddweb ::directorywatcher :: win
           {
             // if we already have an old filename then we can add the rename event
             // and then clear both filenames so we do not add again
-            _parent.AddRenameEvent(newFilename, oldFilename, IsFile(EventAction::Renamed, newFilename));
-            newFilename = oldFilename = L"";
+            _parent.AddRenameEvent(newFilename, oldFilename, IsKnownFile(EventAction::Renamed, newFilename));
+            newFilename = oldFilename = {};
           }
           break;
 
         default:
-          _parent.AddEvent(EventAction::Unknown, wFilename, IsFile(EventAction::Unknown, wFilename));
-          break;
-        }
-
-        // more files?
-        if (0 == pRecord->NextEntryOffset)
-        {
+          _parent.AddEvent(EventAction::Unknown, wFilename, IsKnownFile(EventAction::Unknown, wFilename));
           break;
         }
-        pRecord = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(&reinterpret_cast<unsigned char*>(pRecord)[pRecord->NextEntryOffset]);
       }
 
       // check for orphan renames...
       if (!oldFilename.empty())
       {
-        _parent.AddEvent(EventAction::Removed, oldFilename, IsFile(EventAction::Removed, oldFilename));
+        _parent.AddEvent(EventAction::Removed, oldFilename, IsKnownFile(EventAction::Removed, oldFilename));
       }
       if (!newFilename.empty())
       {
-        _parent.AddEvent(EventAction::Added, newFilename, IsFile(EventAction::Added, newFilename));
+        _parent.AddEvent(EventAction::Added, newFilename, IsKnownFile(EventAction::Added, newFilename));
+      }
+
+      if (parser.IsMalformed())
+      {
+        // we could not read everything, some events were lost.
+        _parent.AddEventError(EventError::Overflow);
       }
     }
     catch (...)
@@ -178,17 +201,56 @@ namespace myoddweb ::directorywatcher :: win
     }
   }
 
+  /**
+   * \brief check if a given string is a file or a directory, using the known entries if we can
+   *        and keeping the known entries up to date with the action.
+   * \param action the action we are looking at
+   * \param path the file we are checking.
+   * \return if the string given is a file or not.
+   */
+  bool Common::IsKnownFile(const EventAction action, const std::wstring_view path) const
+  {
+    auto isFile = false;
+    switch (action)
+    {
+    case EventAction::Removed:
+      // it is gone, so we can forget it, (and all its content if it was a directory).
+      isFile = IsFile(action, path);
+      _entries.Remove(path);
+      return isFile;
+
+    case EventAction::Added:
+    case EventAction::Renamed:
+      // the old name of a rename was already removed.
+      isFile = IsFile(action, path);
+      _entries.Set(path, isFile);
+      return isFile;
+
+    default:
+      if (_entries.TryGet(path, isFile))
+      {
+        return isFile;
+      }
+      isFile = IsFile(action, path);
+      _entries.Set(path, isFile);
+      return isFile;
+    }
+  }
+
   /**
    * \brief check if a given string is a file or a directory.
    * \param action the action we are looking at
    * \param path the file we are checking.
    * \return if the string given is a file or not.
    */
-  bool Common::IsFile(const EventAction action, const std::wstring& path) const
+  bool Common::IsFile(const EventAction action, const std::wstring_view path) const
   {
     try
     {
-      const auto fullPath = Io::Combine(_parent.Path(), path);
+      // the string is kept per thread so, once it is big enough, we no longer allocate.
+      static thread_local std::wstring fullPath;
+      fullPath.resize(Io::CombineLength(_parent.Path(), path));
+      fullPath.resize(Io::Combine(fullPath.data(), _parent.Path(), path));
       return Io::IsFile(fullPath);
     }
     catch (...)
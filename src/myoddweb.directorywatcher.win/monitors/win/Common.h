@@ -3,9 +3,12 @@
 // See the LICENSE file in the project root for more information.
 #pragma once
 #include <Windows.h>
+#include <string_view>
 
 #include "Data.h"
 #include "../Monitor.h"
+#include "../../utils/BufferSizePolicy.h"
+#include "../../utils/EntryCache.h"
 #include "../../utils/EventAction.h"
 #include "../../utils/Threads/Thread.h"
 
@@ -18,7 +21,7 @@ namespace myoddweb
       class Common
       {
       protected:
-        Common(Monitor& parent, unsigned long bufferLength);
+        Common(Monitor& parent, EntryCache& entries, BufferSizePolicy& bufferSize);
 
       public:
         /**
@@ -35,6 +38,13 @@ namespace myoddweb
         bool Start();
         void Update() const;
         void Stop();
+
+        /**
+         * \brief how long until we try and re-open the handle we lost.
+         * \return the number of ms until we re-open it, or the max float value if the handle is valid.
+         */
+        [[nodiscard]]
+        float MillisecondsUntilReopen() const;
       protected:
         /**
          * \brief Get the notification filter.
@@ -50,7 +60,22 @@ namespace myoddweb
          */
         bool CreateAndStartData();
 
-        void ProcessNotification(const unsigned char* pBuffer) const;
+        /**
+         * \brief process the records of a notification buffer.
+         * \param pBuffer the buffer received
+         * \param length the number of bytes in the buffer.
+         */
+        void ProcessNotification(const unsigned char* pBuffer, unsigned long length) const;
+
+        /**
+         * \brief check if a given string is a file or a directory, using the known entries if we can
+         *        and keeping the known entries up to date with the action.
+         * \param action the action we are looking at
+         * \param path the file we are checking.
+         * \return if the string given is a file or not.
+         */
+        [[nodiscard]]
+        bool IsKnownFile(EventAction action, std::wstring_view path) const;
 
         /**
          * \brief all the data used by the monitor.
@@ -63,9 +88,14 @@ namespace myoddweb
         Monitor& _parent;
 
         /**
-         * \brief the max length of the buffers.
+         * \brief the entries we know are files or directories, shared with the other watcher of the monitor.
+         */
+        EntryCache& _entries;
+
+        /**
+         * \brief the size of the buffer we read into.
          */
-        const unsigned long _bufferLength;
+        BufferSizePolicy& _bufferSize;
 
       protected:
         /**
@@ -75,7 +105,7 @@ namespace myoddweb
          * \return if the string given is a file or not.
          */
         [[nodiscard]]
-        virtual bool IsFile(EventAction action, const std::wstring& path) const;
+        virtual bool IsFile(EventAction action, std::wstring_view path) const;
       };
     }
   }
@@ -1,40 +1,35 @@
 // Licensed to Florent Guelfucci under one or more agreements.
 // Florent Guelfucci licenses this file to you under the MIT license.
 // See the LICENSE file in the project root for more information.
+#include <algorithm>
 #include <cstring>
-#include <utility>
+#include <limits>
 #include "Data.h"
 #include "../../utils/Instrumentor.h"
-#include "../../utils/Lock.h"
 #include "../../utils/Logger.h"
 #include "../../utils/LogLevel.h"
-#include "../../utils/Wait.h"
 #include "../Base.h"
 
 namespace myoddweb:: directorywatcher:: win
 {
   Data::Data(
-    const long long id,
-    const wchar_t* path,
+    Monitor& parent,
     const unsigned long notifyFilter,
-    const bool recursive,
-    const unsigned long bufferLength
+    BufferSizePolicy& bufferSize
     )
     :
-    _invalidHandleWait(0),
+    EventSource(bufferSize),
+    _reopenMilliseconds(0),
     _notifyFilter(notifyFilter),
-    _recursive(recursive),
+    _recursive(parent.Recursive()),
     _operationAborted( false ),
     _hDirectory(nullptr),
-    _buffer(nullptr),
-    _bufferLength(bufferLength),
-    _path( path ),
-    _id( id ),
+    _path( parent.Path() ),
+    _id( parent.Id() ),
+    _parent( parent ),
     _overlapped(nullptr)
   {
-    // prepapre the buffer that will receive our data
-    // create the buffer if needed.
-    _buffer = new unsigned char[_bufferLength];
+    // the buffer that will receive our data is only borrowed from the shared pool when we read.
   }
 
   Data::~Data()
@@ -53,9 +48,6 @@ namespace myoddweb:: directorywatcher:: win
       return;
     }
     
-    // restart the buffer.
-    memset(_buffer, 0, sizeof(unsigned char)*_bufferLength);
-
     // reset our overlappped object
     ClearOverlapped();
 
@@ -89,7 +81,7 @@ namespace myoddweb:: directorywatcher:: win
     }
 
     // reset the handle wait.
-    _invalidHandleWait = 0;
+    _reopenMilliseconds = 0;
 
     // start reading.
     Listen();
@@ -107,14 +99,11 @@ namespace myoddweb:: directorywatcher:: win
       // close the handle 
       ClearHandle();
 
-      // the buffer.
-      ClearBuffer();
-
       // clear the overlapped structure.
       ClearOverlapped();
 
-      // clear the buffer of data that might be left
-      ClearData();
+      // give back the read buffer and the data that might be left
+      ReleaseBuffers();
     }
     catch (const std::exception& e)
     {
@@ -171,20 +160,19 @@ namespace myoddweb:: directorywatcher:: win
         }
 
         // then wait a little for the operation to be cancelled.
-        if (!_operationAborted && !Wait::SpinUntil([&]
-          {
-            if( _operationAborted != true )
-            {
-              // wait a little to ensure that the aborted message is given.
-              // we will return as soon as the message is recived.
-              // if we do not wait for the abort message, we might get other
-              // messages out of sequence.
-              MYODDWEB_YIELD();
-            }
-            return _operationAborted == true;
-          }, MYODDWEB_WAITFOR_OPERATION_ABORTED_COMPLETION))
+        // the aborted message is given to our completion routine, so we sleep in an alertable state
+        // and we are woken up as soon as it is recived rather than checking over and over.
+        // if we do not wait for the abort message, we might get other messages out of sequence.
+        const auto until = ::GetTickCount64() + MYODDWEB_WAITFOR_OPERATION_ABORTED_COMPLETION;
+        while (!_operationAborted)
         {
-          Logger::Log(_id, LogLevel::Warning, L"Timeout waiting operation aborted message!" );
+          const auto now = ::GetTickCount64();
+          if (now >= until)
+          {
+            Logger::Log(_id, LogLevel::Warning, L"Timeout waiting operation aborted message!");
+            break;
+          }
+          ::SleepEx(static_cast<DWORD>(until - now), true);
         }
       }
       else
@@ -207,43 +195,6 @@ namespace myoddweb:: directorywatcher:: win
     // the directory is closed.
   }
 
-  /**
-   * \brief clear the buffer data.
-   */
-  void Data::ClearBuffer()
-  {
-    try
-    {
-      if (_buffer == nullptr)
-      {
-        return;
-      }
-
-      delete[] _buffer;
-      _buffer = nullptr;
-    }
-    catch (const std::exception& e)
-    {
-      // the callback did something wrong!
-      // log the error
-      Logger::Log(LogLevel::Error, L"Caught exception '%hs' in PublishStatistics, check the callback!", e.what());
-      _buffer = nullptr;
-    }
-  }
-
-  /// <summary>
-  /// Clear all the data that is left in the vector
-  /// </summary>
-  void Data::ClearData()
-  {
-    MYODDWEB_LOCK(_dataLock);
-    for( const auto &raw : _data )
-    {
-      delete[] raw;
-    }
-    _data.clear();
-  }
-
   /**
    * \brief clear the overlapped structure.
    */
@@ -262,44 +213,6 @@ namespace myoddweb:: directorywatcher:: win
     return _hDirectory != nullptr && _hDirectory != INVALID_HANDLE_VALUE;
   }
 
-  /**
-   * \brief clone up to 'ulSize' bytes into a buffer.
-   *        it is up to the caller to clear/delete the buffer.
-   * \param ulSize the max numberof bytes we want to copy
-   * \return the cloned data.
-   */
-  unsigned char* Data::Clone(const unsigned long ulSize) const
-  {
-    try
-    {
-      // if the size if more than we can offer we need to prevent an overflow.
-      if (ulSize > _bufferLength)
-      {
-        return nullptr;
-      }
-
-      // create the clone
-      const auto pBuffer = new unsigned char[ulSize];
-      if (_buffer == nullptr)
-      {
-        return nullptr;
-      }
-
-      // copy it.
-      memcpy(pBuffer, _buffer, ulSize);
-
-      // return it.
-      return pBuffer;
-    }
-    catch (const std::exception& e)
-    {
-      // the callback did something wrong!
-      // log the error
-      Logger::Log(LogLevel::Error, L"Caught exception '%hs' in PublishStatistics, check the callback!", e.what());
-      return nullptr;
-    }
-  }
-
   /**
    * \brief set the directory handle
    * \return if success or not.
@@ -361,11 +274,14 @@ namespace myoddweb:: directorywatcher:: win
       // prepare all the values
       PrepareForRead();
 
+      // borrow the buffer, it stays ours until the read completes.
+      const auto buffer = BeginRead();
+
       // do the actual read.
       if (::ReadDirectoryChangesW(
         _hDirectory,
-        _buffer,
-        _bufferLength,
+        buffer,
+        ReadLength(),
         _recursive ? 1 : 0,
         _notifyFilter,
         nullptr,                // bytes returned, (not used here as we are async)
@@ -440,6 +356,11 @@ namespace myoddweb:: directorywatcher:: win
     case ERROR_SUCCESS:// all good, continue;
       break;
 
+    case ERROR_NOTIFY_ENUM_DIR:
+      // too many changes for our buffer, they were lost.
+      ProcessOverflow();
+      break;
+
     case ERROR_OPERATION_ABORTED:
       // set the flag _after_ we posted the message above
       // as what happens after this is undefined.
@@ -449,11 +370,17 @@ namespace myoddweb:: directorywatcher:: win
     case ERROR_NETNAME_DELETED:
       Stop();
       Logger::Log(LogLevel::Warning, L"Warning: The network connection to '%' has been deleted.", _path.c_str() );
+
+      // the monitor will need to try and re-open the handle.
+      _parent.Wake();
       return;
 
     case ERROR_ACCESS_DENIED:
       Stop();
       Logger::Log(LogLevel::Warning, L"Warning: Acess to '%s' is denied", _path.c_str() );
+
+      // the monitor will need to try and re-open the handle.
+      _parent.Wake();
       return;
 
     default:
@@ -471,43 +398,50 @@ namespace myoddweb:: directorywatcher:: win
   {
     if (dwNumberOfBytesTransfered == 0)
     {
-      // Get the new read issued as fast as possible. The documentation
-      // says that the original OVERLAPPED structure will not be used
-      // again once the completion routine is called.
-      Listen();
-
-      // we are done
+      // the buffer overflowed, the changes are lost
+      // the next read will use a bigger buffer.
+      ProcessOverflow();
       return;
     }
 
     // Can't use sizeof(FILE_NOTIFY_INFORMATION) because
     // the structure is padded to 16 bytes.
     _ASSERTE(dwNumberOfBytesTransfered >= offsetof(FILE_NOTIFY_INFORMATION, FileName) + sizeof(WCHAR));
+    _parent.MonitorMetrics().Add(Metrics::Counter::BytesRead, static_cast<long long>(dwNumberOfBytesTransfered));
 
-    // clone the data now
-    const auto clone = Clone(dwNumberOfBytesTransfered);
+    // hand the buffer over to the data waiting to be processed, nothing is copied.
+    if (!CompleteRead(dwNumberOfBytesTransfered))
+    {
+      // more than we can hold, we cannot trust what we received.
+      ProcessOverflow();
+      return;
+    }
 
     // Get the new read issued as fast as possible. The documentation
     // says that the original OVERLAPPED structure will not be used
     // again once the completion routine is called.
+    // this will borrow a new buffer from the pool.
     Listen();
 
-    // call the derived function to handle this.
-    MYODDWEB_LOCK(_dataLock);
-    _data.emplace_back( clone );
+    // let the monitor know that it has some work to do.
+    _parent.Wake();
   }
 
-  std::vector<unsigned char*> Data::Get()
+  /**
+   * \brief the buffer was too small and the changes were lost.
+   */
+  void Data::ProcessOverflow()
   {
-    MYODDWEB_LOCK(_dataLock);
-    const auto clone = _data;
+    OverflowRead();
 
-    // clear that list
-    // we do not want to use `shrink_to_fit` as the reserved value
-    // will probably be reused.
-    _data.clear();
+    // Get the new read issued as fast as possible. The documentation
+    // says that the original OVERLAPPED structure will not be used
+    // again once the completion routine is called.
+    Listen();
 
-    return clone;
+    Logger::Log(_id, LogLevel::Warning, L"Warning: Too many changes in '%s', some were lost.", _path.c_str());
+    _parent.AddEventError(EventError::Overflow);
+    _parent.Wake();
   }
 
   /**
@@ -519,13 +453,18 @@ namespace myoddweb:: directorywatcher:: win
     if (IsValidHandle())
     {
       // The handle is good, so we can reset the value
-      _invalidHandleWait = 0;
+      _reopenMilliseconds = 0;
       return;
     }
 
-    // wait a little bit longer.
-    _invalidHandleWait += MYODDWEB_MIN_THREAD_SLEEP;
-    if (_invalidHandleWait < MYODDWEB_INVALID_HANDLE_SLEEP)
+    // the first time we see it we decide when we will re-open it.
+    const auto now = threads::WorkerPool::NowMilliseconds();
+    if (_reopenMilliseconds == 0)
+    {
+      _reopenMilliseconds = now + MYODDWEB_INVALID_HANDLE_SLEEP;
+      return;
+    }
+    if (now < _reopenMilliseconds)
     {
       // we need to wait a little longer before we re-open
       return;
@@ -535,10 +474,26 @@ namespace myoddweb:: directorywatcher:: win
     _hDirectory = nullptr;
 
     // we will reopen, so reset the wait time.
-    _invalidHandleWait = 0;
+    _reopenMilliseconds = 0;
 
     // try open again, if this does not work then it is fine
     // because we have reset the timer
     Start();
   }
+
+  /**
+   * \brief how long until we try and re-open the handle we lost.
+   * \return the number of ms until we re-open it, or the max float value if the handle is valid.
+   */
+  float Data::MillisecondsUntilReopen() const
+  {
+    if (IsValidHandle())
+    {
+      return (std::numeric_limits<float>::max)();
+    }
+
+    // if we have not checked it yet, we need to do it now.
+    const auto reopen = _reopenMilliseconds.load();
+    return reopen == 0 ? 0 : static_cast<float>((std::max)(reopen - threads::WorkerPool::NowMilliseconds(), 0LL));
+  }
 }
@@ -3,22 +3,22 @@
 // See the LICENSE file in the project root for more information.
 #pragma once
 #include <Windows.h>
+#include <atomic>
+#include "../EventSource.h"
 #include "../Monitor.h"
 
 namespace myoddweb:: directorywatcher:: win
 {
-  class Data final
+  class Data final : public EventSource
   {
     typedef struct _OVERLAPPED_DATA : _OVERLAPPED {
       Data* pdata;
     } OVERLAPPED_DATA, * LPOVERLAPPED_DATA;
   public:
     explicit Data(
-      long long id,
-      const wchar_t* path,
+      Monitor& parent,
       unsigned long notifyFilter,
-      bool recursive,
-      unsigned long bufferLength);
+      BufferSizePolicy& bufferSize);
     ~Data();
 
     /**
@@ -34,31 +34,32 @@ namespace myoddweb:: directorywatcher:: win
      * \brief start monitoring the given folder.
      * \return if we managed to start the monitoring or not.
      */
-    bool Start();
+    bool Start() override;
 
     /**
      * \brief Clear all the data
      */
-    void Stop();
-
-    std::vector<unsigned char*> Get();
+    void Stop() override;
 
     /**
      * \brief check that he current handle is still valie
      *        if not then we will close the connection.
      */
     void CheckStillValid();
-  private:
 
-    MYODDWEB_MUTEX _dataLock;
-    std::vector<unsigned char*> _data;
+    /**
+     * \brief how long until we try and re-open the handle we lost.
+     * \return the number of ms until we re-open it, or the max float value if the handle is valid.
+     */
+    [[nodiscard]]
+    float MillisecondsUntilReopen() const;
 
     /**
      * \brief Check if the handle is valid
      */
     [[nodiscard]]
     bool IsValidHandle() const;
-
+  private:
     /**
      * \brief set the directory handle
      * \return if success or not.
@@ -76,6 +77,11 @@ namespace myoddweb:: directorywatcher:: win
      */
     void PrepareForRead();
 
+    /**
+     * \brief the buffer was too small and the changes were lost.
+     */
+    void ProcessOverflow();
+
     /**
      * \brief process a read received.
      * \param dwNumberOfBytesTransfered the number of bytes received.
@@ -88,15 +94,6 @@ namespace myoddweb:: directorywatcher:: win
      */
     void ProcessError(unsigned long errorCode);
 
-    /**
-     * \brief clone up to 'ulSize' bytes into a buffer.
-     *        it is up to the caller to clear/delete the buffer.
-     * \param ulSize the max number of bytes we want to copy
-     * \return the cloned data.
-     */
-    [[nodiscard]]
-    unsigned char* Clone(unsigned long ulSize) const;
-
     /// <summary>
     /// The function that will be called when a file event is detected.
     /// </summary>
@@ -113,10 +110,10 @@ namespace myoddweb:: directorywatcher:: win
     #pragma region Variables
 
     /**
-     * \brief the number of times we had an invalid handle.
-     *        after a certain count we will close this.
+     * \brief when we will try and re-open the handle we lost, 0 if we have not lost it yet.
+     *        (see threads::WorkerPool::NowMilliseconds( ... ) ).
      */
-    int _invalidHandleWait;
+    std::atomic<long long> _reopenMilliseconds;
 
     /**
      * \brief what we wish to be notified about
@@ -140,16 +137,6 @@ namespace myoddweb:: directorywatcher:: win
      */
     void* _hDirectory;
 
-    /**
-     * \brief the buffer that we read
-     */
-    unsigned char* _buffer;
-
-    /**
-     * \brief the buffer length
-     */
-    const unsigned long _bufferLength;
-
     /**
      * \brief the path
      */
@@ -160,6 +147,11 @@ namespace myoddweb:: directorywatcher:: win
     /// </summary>
     const long long _id;
 
+    /**
+     * \brief the parent monitor, we wake it up when we receive some data.
+     */
+    Monitor& _parent;
+
     /// <summary>
     /// The overlapped structure used to listen for changes.
     /// </summary>
@@ -169,21 +161,11 @@ namespace myoddweb:: directorywatcher:: win
     #pragma endregion
 
     #pragma region Clearup
-    /// <summary>
-    /// Clear all the data that is left in the vector
-    /// </summary>
-    void ClearData();
-
     /**
      * \brief Clear the handle
      */
     void ClearHandle();
 
-    /**
-     * \brief clear the buffer data.
-     */
-    void ClearBuffer();
-
     /**
      * \brief clear the overlapped structure.
      */
@@ -9,8 +9,8 @@ namespace myoddweb:: directorywatcher:: win
   /**
    * \brief Create the Monitor that uses ReadDirectoryChanges
    */
-  Directories::Directories(Monitor& parent, const unsigned long bufferLength) :
-    Common(parent, bufferLength)
+  Directories::Directories(Monitor& parent, EntryCache& entries, BufferSizePolicy& bufferSize) :
+    Common(parent, entries, bufferSize)
   {
   }
 
@@ -37,7 +37,7 @@ namespace myoddweb:: directorywatcher:: win
    * \param path the file we are checking.
    * \return if the string given is a file or not.
    */
-  bool Directories::IsFile(const EventAction action, const std::wstring& path) const
+  bool Directories::IsFile(const EventAction action, const std::wstring_view path) const
   {
     // we are the directory monitor
     // so it can never be a file.
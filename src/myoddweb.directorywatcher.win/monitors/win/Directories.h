@@ -14,7 +14,7 @@ namespace myoddweb
       class Directories final : public Common
       {
       public:
-        Directories(Monitor& parent, unsigned long bufferLength);
+        Directories(Monitor& parent, EntryCache& entries, BufferSizePolicy& bufferSize);
         virtual ~Directories() = default;
 
         Directories(const Directories&) = delete;
@@ -37,7 +37,7 @@ namespace myoddweb
          * \return if the string given is a file or not.
          */
         [[nodiscard]]
-        bool IsFile(EventAction action, const std::wstring& path) const override;
+        bool IsFile(EventAction action, std::wstring_view path) const override;
       };
     }
   }
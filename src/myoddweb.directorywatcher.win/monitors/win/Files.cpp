@@ -9,8 +9,8 @@ namespace myoddweb:: directorywatcher:: win
   /**
    * \brief Create the Monitor that uses ReadDirectoryChanges
    */
-  Files::Files(Monitor& parent, const unsigned long bufferLength) :
-    Common(parent, bufferLength)
+  Files::Files(Monitor& parent, EntryCache& entries, BufferSizePolicy& bufferSize) :
+    Common(parent, entries, bufferSize)
   {
   }
 
@@ -64,7 +64,7 @@ namespace myoddweb:: directorywatcher:: win
    * \param path the file we are checking.
    * \return if the string given is a file or not.
    */
-  bool Files::IsFile(const EventAction action, const std::wstring& path) const
+  bool Files::IsFile(const EventAction action, const std::wstring_view path) const
   {
     try
     {
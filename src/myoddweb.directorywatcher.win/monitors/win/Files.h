@@ -15,7 +15,7 @@ namespace myoddweb
       class Files final : public Common
       {
       public:
-        Files( Monitor& parent, unsigned long bufferLength);
+        Files( Monitor& parent, EntryCache& entries, BufferSizePolicy& bufferSize);
         virtual ~Files() = default;
 
         Files(const Files&) = delete;
@@ -38,7 +38,7 @@ namespace myoddweb
          * \return if the string given is a file or not.
          */
         [[nodiscard]]
-        bool IsFile(EventAction action, const std::wstring& path) const override;
+        bool IsFile(EventAction action, std::wstring_view path) const override;
       };
     }
   }
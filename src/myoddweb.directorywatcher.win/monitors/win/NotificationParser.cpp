@@ -0,0 +1,79 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#include "NotificationParser.h"
+
+namespace myoddweb:: directorywatcher:: win
+{
+  /**
+   * \brief the size of a record without the name.
+   *        we cannot use sizeof(NotifyInformation) because the structure is padded.
+   */
+  static constexpr size_t HeaderLength = offsetof(NotifyInformation, FileName);
+
+  /**
+   * \brief the parser of a buffer.
+   * \param buffer the buffer, it must be aligned for NotifyInformation.
+   * \param length the number of bytes in the buffer.
+   */
+  NotificationParser::NotificationParser(const unsigned char* buffer, const size_t length) :
+    _buffer(buffer),
+    _length(buffer == nullptr ? 0 : length),
+    _offset(0),
+    _malformed(false)
+  {
+  }
+
+  /**
+   * \brief get the next record in the buffer.
+   * \param record the record we are filling.
+   * \return false if there are no more records, (or if the buffer is malformed).
+   */
+  bool NotificationParser::Next(NotificationRecord& record)
+  {
+    if (_offset >= _length)
+    {
+      return false;
+    }
+
+    // the header must be in the buffer, and so must the name.
+    const auto remaining = _length - _offset;
+    const auto information = reinterpret_cast<const NotifyInformation*>(_buffer + _offset);
+    if (remaining < HeaderLength || information->FileNameLength > remaining - HeaderLength)
+    {
+      _malformed = true;
+      _offset = _length;
+      return false;
+    }
+
+    record.Action = information->Action;
+    record.FileName = std::wstring_view(information->FileName, information->FileNameLength / sizeof(wchar_t));
+
+    // move to the next record, the offset must move forward, stay in the buffer and stay aligned.
+    const auto next = information->NextEntryOffset;
+    if (0 == next)
+    {
+      _offset = _length;
+    }
+    else if (next > remaining || next % alignof(NotifyInformation) != 0)
+    {
+      // we can still use this record, but we cannot trust where the next one is.
+      _malformed = true;
+      _offset = _length;
+    }
+    else
+    {
+      _offset += next;
+    }
+    return true;
+  }
+
+  /**
+   * \brief check if we stopped because the buffer is malformed.
+   * \return if the buffer is malformed.
+   */
+  bool NotificationParser::IsMalformed() const
+  {
+    return _malformed;
+  }
+}
@@ -0,0 +1,84 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#pragma once
+#include <cstddef>
+#include <string_view>
+
+namespace myoddweb:: directorywatcher:: win
+{
+  /**
+   * \brief the layout of FILE_NOTIFY_INFORMATION, re-declared so the parser does not need <Windows.h>
+   *        and can be tested and benchmarked on any platform.
+   *        On windows it is checked against the real structure, (see Common.cpp).
+   * \see https://docs.microsoft.com/en-us/windows/win32/api/winnt/ns-winnt-file_notify_information
+   */
+  struct NotifyInformation
+  {
+    unsigned long NextEntryOffset;
+    unsigned long Action;
+    unsigned long FileNameLength;
+    wchar_t FileName[1];
+  };
+
+  /**
+   * \brief one record of the notification buffer, the name is borrowed from the buffer
+   *        and is only valid for as long as the buffer is.
+   */
+  struct NotificationRecord
+  {
+    unsigned long Action;
+    std::wstring_view FileName;
+  };
+
+  /**
+   * \brief walk the records of a notification buffer, as filled by ReadDirectoryChangesW( ... )
+   *        Nothing is copied or allocated, the names are views into the buffer.
+   *        We never read past the given length, a malformed buffer simply stops the parsing.
+   */
+  class NotificationParser final
+  {
+  public:
+    /**
+     * \brief the parser of a buffer.
+     * \param buffer the buffer, it must be aligned for NotifyInformation.
+     * \param length the number of bytes in the buffer.
+     */
+    NotificationParser(const unsigned char* buffer, size_t length);
+
+    /**
+     * \brief get the next record in the buffer.
+     * \param record the record we are filling.
+     * \return false if there are no more records, (or if the buffer is malformed).
+     */
+    bool Next(NotificationRecord& record);
+
+    /**
+     * \brief check if we stopped because the buffer is malformed.
+     * \return if the buffer is malformed.
+     */
+    [[nodiscard]]
+    bool IsMalformed() const;
+
+  private:
+    /**
+     * \brief the buffer we are parsing.
+     */
+    const unsigned char* const _buffer;
+
+    /**
+     * \brief the number of bytes in the buffer.
+     */
+    const size_t _length;
+
+    /**
+     * \brief where the next record is, or _length once we are done.
+     */
+    size_t _offset;
+
+    /**
+     * \brief if we stopped because the buffer is malformed.
+     */
+    bool _malformed;
+  };
+}
@@ -0,0 +1,156 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#include "Arena.h"
+#include <cwchar>
+#include "BufferPool.h"
+
+namespace myoddweb
+{
+  namespace directorywatcher
+  {
+    /**
+     * \brief create the arena, no memory is allocated until we need it.
+     * \param blockSize the size of each block of memory.
+     */
+    Arena::Arena(const size_t blockSize) :
+      _blockSize(blockSize),
+      _current(0),
+      _used(0),
+      _bytesUsed(0)
+    {
+    }
+
+    Arena::~Arena()
+    {
+      for (auto& block : _blocks)
+      {
+        Free(block);
+      }
+    }
+
+    /**
+     * \brief give the memory of a block back to the shared pool.
+     * \param block the block we are freeing.
+     */
+    void Arena::Free(Block& block)
+    {
+      BufferPool::Shared().Release(block.Data);
+      block.Data = nullptr;
+      block.Size = 0;
+    }
+
+    /**
+     * \brief get some raw memory from the arena
+     * \param size the number of bytes we want.
+     * \param alignment the alignment of the memory, must be a power of 2.
+     * \return the memory, it is valid until the arena is reset.
+     */
+    void* Arena::Allocate(const size_t size, const size_t alignment)
+    {
+      auto offset = (_used + alignment - 1) & ~(alignment - 1);
+      if (_blocks.empty() || offset + size > _blocks[_current].Size)
+      {
+        NextBlock(size, alignment);
+        offset = 0;
+      }
+
+      _bytesUsed += size + (offset - _used);
+      _used = offset + size;
+      return _blocks[_current].Data + offset;
+    }
+
+    /**
+     * \brief move to the next block that can hold the given number of bytes
+     *        creating a new block if need be.
+     * \param size the number of bytes we want to allocate.
+     * \param alignment the alignment of the memory.
+     */
+    void Arena::NextBlock(const size_t size, const size_t alignment)
+    {
+      // the blocks after the current one are all the normal size
+      // so if it fits in a normal block we can use the next one, (if we have one).
+      const auto next = _blocks.empty() ? 0 : _current + 1;
+      if (size + alignment <= _blockSize)
+      {
+        if (next == _blocks.size())
+        {
+          _blocks.push_back({ BufferPool::Shared().Acquire(_blockSize), _blockSize });
+        }
+      }
+      else
+      {
+        // this is a very large allocation, give it a block of its own.
+        const auto blockSize = size + alignment;
+        _blocks.insert(_blocks.begin() + static_cast<std::vector<Block>::difference_type>(next), { BufferPool::Shared().Acquire(blockSize), blockSize });
+      }
+      _current = next;
+      _used = 0;
+    }
+
+    /**
+     * \brief allocate a null terminated string, the content is not set
+     *        other than the null terminator.
+     * \param length the number of characters, excluding the null terminator.
+     * \return the string, valid until the arena is reset.
+     */
+    wchar_t* Arena::AllocateString(const size_t length)
+    {
+      const auto string = static_cast<wchar_t*>(Allocate((length + 1) * sizeof(wchar_t), alignof(wchar_t)));
+      string[length] = L'\0';
+      return string;
+    }
+
+    /**
+     * \brief copy a string in the arena
+     * \param source the string we want to copy.
+     * \return the null terminated copy, valid until the arena is reset.
+     */
+    const wchar_t* Arena::Copy(const std::wstring_view source)
+    {
+      const auto string = AllocateString(source.length());
+      wmemcpy(string, source.data(), source.length());
+      return string;
+    }
+
+    /**
+     * \brief release all the memory in one go, the blocks are given back to the shared pool.
+     *        All the pointers given out by the arena are no longer valid.
+     */
+    void Arena::Reset()
+    {
+      // we do not keep anything ourselves, an idle arena holds no memory
+      // and the next round gets its blocks back from the pool.
+      for (auto& block : _blocks)
+      {
+        Free(block);
+      }
+      _blocks.clear();
+
+      _current = 0;
+      _used = 0;
+      _bytesUsed = 0;
+    }
+
+    /**
+     * \brief the number of bytes currently handed out.
+     */
+    size_t Arena::BytesUsed() const
+    {
+      return _bytesUsed;
+    }
+
+    /**
+     * \brief the number of bytes we are holding in our blocks.
+     */
+    size_t Arena::BytesReserved() const
+    {
+      size_t reserved = 0;
+      for (const auto& block : _blocks)
+      {
+        reserved += block.Size;
+      }
+      return reserved;
+    }
+  }
+}
@@ -0,0 +1,143 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#pragma once
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../monitors/Base.h"
+
+namespace myoddweb
+{
+  namespace directorywatcher
+  {
+    /**
+     * \brief a simple bump allocator, memory is taken from large blocks
+     *        and it is all released in one go when the arena is reset.
+     *        The blocks come from the shared BufferPool and go back to it once the arena is reset
+     *        so the next round of allocations does not need the heap, and an idle arena holds no memory.
+     *        This class is not thread safe, the owner must make sure that only one thread uses it at a time.
+     */
+    class Arena final
+    {
+    public:
+      explicit Arena(size_t blockSize = MYODDWEB_ARENA_BLOCK_SIZE);
+      ~Arena();
+
+      Arena(const Arena&) = delete;
+      Arena(Arena&&) = delete;
+      const Arena& operator=(const Arena&) = delete;
+      Arena& operator=(Arena&&) = delete;
+
+      /**
+       * \brief get some raw memory from the arena
+       * \param size the number of bytes we want.
+       * \param alignment the alignment of the memory, must be a power of 2.
+       * \return the memory, it is valid until the arena is reset.
+       */
+      [[nodiscard]]
+      void* Allocate(size_t size, size_t alignment);
+
+      /**
+       * \brief create an object in the arena, the destructor is never called
+       *        so we only allow objects that do not need one.
+       * \param args the arguments passed to the constructor.
+       * \return the newly created object, valid until the arena is reset.
+       */
+      template<typename T, typename... Args>
+      [[nodiscard]]
+      T* Create(Args&&... args)
+      {
+        static_assert(std::is_trivially_destructible<T>::value, "Objects in the arena are never destroyed.");
+        return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+      }
+
+      /**
+       * \brief allocate a null terminated string, the content is not set
+       *        other than the null terminator.
+       * \param length the number of characters, excluding the null terminator.
+       * \return the string, valid until the arena is reset.
+       */
+      [[nodiscard]]
+      wchar_t* AllocateString(size_t length);
+
+      /**
+       * \brief copy a string in the arena
+       * \param source the string we want to copy.
+       * \return the null terminated copy, valid until the arena is reset.
+       */
+      [[nodiscard]]
+      const wchar_t* Copy(std::wstring_view source);
+
+      /**
+       * \brief release all the memory in one go, the blocks are given back to the shared pool.
+       *        All the pointers given out by the arena are no longer valid.
+       */
+      void Reset();
+
+      /**
+       * \brief the number of bytes currently handed out.
+       */
+      [[nodiscard]]
+      size_t BytesUsed() const;
+
+      /**
+       * \brief the number of bytes we are holding in our blocks.
+       */
+      [[nodiscard]]
+      size_t BytesReserved() const;
+
+    private:
+      /**
+       * \brief one contiguous block of memory.
+       */
+      struct Block
+      {
+        unsigned char* Data;
+        size_t Size;
+      };
+
+      /**
+       * \brief move to the next block that can hold the given number of bytes
+       *        creating a new block if need be.
+       * \param size the number of bytes we want to allocate.
+       * \param alignment the alignment of the memory.
+       */
+      void NextBlock(size_t size, size_t alignment);
+
+      /**
+       * \brief give the memory of a block back to the shared pool.
+       * \param block the block we are freeing.
+       */
+      static void Free(Block& block);
+
+      /**
+       * \brief the size of a normal block.
+       */
+      const size_t _blockSize;
+
+      /**
+       * \brief all our blocks, everything after the current block is unused.
+       */
+      std::vector<Block> _blocks;
+
+      /**
+       * \brief the index of the block we are currently allocating from.
+       */
+      size_t _current;
+
+      /**
+       * \brief the number of bytes used in the current block.
+       */
+      size_t _used;
+
+      /**
+       * \brief the total number of bytes handed out.
+       */
+      size_t _bytesUsed;
+    };
+  }
+}
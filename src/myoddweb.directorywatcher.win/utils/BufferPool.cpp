@@ -0,0 +1,164 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#include "BufferPool.h"
+#include "Lock.h"
+
+namespace myoddweb:: directorywatcher
+{
+  BufferPool::BufferPool() :
+    _numberOfHits(0),
+    _numberOfMisses(0)
+  {
+  }
+
+  BufferPool::~BufferPool()
+  {
+    for (auto& freeList : _freeLists)
+    {
+      MYODDWEB_LOCK(freeList.Lock);
+      for (const auto buffer : freeList.Buffers)
+      {
+        Free(buffer);
+      }
+      freeList.Buffers.clear();
+    }
+  }
+
+  /**
+   * \brief the pool shared by all the monitors.
+   */
+  BufferPool& BufferPool::Shared()
+  {
+    static BufferPool pool;
+    return pool;
+  }
+
+  /**
+   * \brief get the size class that can hold the given number of bytes.
+   * \param size the number of bytes.
+   * \return the class, or NumberOfClasses if it is too large to be pooled.
+   */
+  int BufferPool::ClassOf(const size_t size)
+  {
+    auto sizeClass = 0;
+    while (sizeClass < NumberOfClasses && (static_cast<size_t>(1) << (sizeClass + MYODDWEB_BUFFERPOOL_MIN_SIZE_SHIFT)) < size)
+    {
+      ++sizeClass;
+    }
+    return sizeClass;
+  }
+
+  /**
+   * \brief allocate a new buffer, with room for the header in front of it.
+   *        the header keeps the class so the buffer can be released without its size.
+   * \param size the number of usable bytes.
+   * \param sizeClass the class we save in the header.
+   * \return the usable part of the buffer.
+   */
+  unsigned char* BufferPool::Allocate(const size_t size, const int sizeClass)
+  {
+    static_assert(sizeof(int) <= Alignment, "The header must fit in front of the buffer.");
+    const auto raw = new unsigned char[size + Alignment];
+    *reinterpret_cast<int*>(raw) = sizeClass;
+    return raw + Alignment;
+  }
+
+  /**
+   * \brief free a buffer created with Allocate( ... )
+   * \param buffer the usable part of the buffer.
+   */
+  void BufferPool::Free(unsigned char* buffer)
+  {
+    delete[] (buffer - Alignment);
+  }
+
+  /**
+   * \brief get a buffer of at least the given size, the content is not set.
+   * \param size the number of bytes we want.
+   * \return the buffer, it must be given back with Release( ... )
+   */
+  unsigned char* BufferPool::Acquire(const size_t size)
+  {
+    const auto sizeClass = ClassOf(size);
+    if (sizeClass == NumberOfClasses)
+    {
+      // too large for us to keep.
+      ++_numberOfMisses;
+      return Allocate(size, sizeClass);
+    }
+
+    {
+      auto& freeList = _freeLists[sizeClass];
+      MYODDWEB_LOCK(freeList.Lock);
+      if (!freeList.Buffers.empty())
+      {
+        const auto buffer = freeList.Buffers.back();
+        freeList.Buffers.pop_back();
+        ++_numberOfHits;
+        return buffer;
+      }
+    }
+
+    // we always allocate the full size of the class so it can be reused by any request of that class.
+    ++_numberOfMisses;
+    return Allocate(static_cast<size_t>(1) << (sizeClass + MYODDWEB_BUFFERPOOL_MIN_SIZE_SHIFT), sizeClass);
+  }
+
+  /**
+   * \brief give a buffer back to the pool so it can be used again.
+   * \param buffer the buffer we got from Acquire( ... ), null is ignored.
+   */
+  void BufferPool::Release(unsigned char* buffer)
+  {
+    if (nullptr == buffer)
+    {
+      return;
+    }
+
+    const auto sizeClass = *reinterpret_cast<const int*>(buffer - Alignment);
+    if (sizeClass >= 0 && sizeClass < NumberOfClasses)
+    {
+      auto& freeList = _freeLists[sizeClass];
+      MYODDWEB_LOCK(freeList.Lock);
+      if (freeList.Buffers.size() < MYODDWEB_BUFFERPOOL_MAX_FREE_BUFFERS)
+      {
+        freeList.Buffers.emplace_back(buffer);
+        return;
+      }
+    }
+
+    // too large, or we already have enough of them.
+    Free(buffer);
+  }
+
+  /**
+   * \brief the number of buffers that were recycled.
+   */
+  long long BufferPool::NumberOfHits() const
+  {
+    return _numberOfHits;
+  }
+
+  /**
+   * \brief the number of buffers that had to be allocated.
+   */
+  long long BufferPool::NumberOfMisses() const
+  {
+    return _numberOfMisses;
+  }
+
+  /**
+   * \brief the number of free buffers we are holding on to.
+   */
+  size_t BufferPool::NumberOfFreeBuffers() const
+  {
+    size_t count = 0;
+    for (const auto& freeList : _freeLists)
+    {
+      MYODDWEB_LOCK(freeList.Lock);
+      count += freeList.Buffers.size();
+    }
+    return count;
+  }
+}
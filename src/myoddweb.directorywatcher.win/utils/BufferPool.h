@@ -0,0 +1,115 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include "../monitors/Base.h"
+
+namespace myoddweb:: directorywatcher
+{
+  /**
+   * \brief a thread safe pool of raw buffers, the buffers are grouped by size, (powers of 2),
+   *        and given back to the pool once used so the next request of the same size does not need the heap.
+   *        Buffers larger than the largest size are not kept.
+   */
+  class BufferPool final
+  {
+  public:
+    BufferPool();
+    ~BufferPool();
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool(BufferPool&&) = delete;
+    const BufferPool& operator=(const BufferPool&) = delete;
+    BufferPool& operator=(BufferPool&&) = delete;
+
+    /**
+     * \brief the pool shared by all the monitors.
+     */
+    static BufferPool& Shared();
+
+    /**
+     * \brief the alignment of all the buffers we give out.
+     */
+    static constexpr size_t Alignment = 16;
+
+    /**
+     * \brief get a buffer of at least the given size, the content is not set.
+     * \param size the number of bytes we want.
+     * \return the buffer, it must be given back with Release( ... )
+     */
+    [[nodiscard]]
+    unsigned char* Acquire(size_t size);
+
+    /**
+     * \brief give a buffer back to the pool so it can be used again.
+     * \param buffer the buffer we got from Acquire( ... ), null is ignored.
+     */
+    void Release(unsigned char* buffer);
+
+    /**
+     * \brief the number of buffers that were recycled.
+     */
+    [[nodiscard]]
+    long long NumberOfHits() const;
+
+    /**
+     * \brief the number of buffers that had to be allocated.
+     */
+    [[nodiscard]]
+    long long NumberOfMisses() const;
+
+    /**
+     * \brief the number of free buffers we are holding on to.
+     */
+    [[nodiscard]]
+    size_t NumberOfFreeBuffers() const;
+
+  private:
+    /**
+     * \brief the number of sizes we keep.
+     */
+    static constexpr int NumberOfClasses = MYODDWEB_BUFFERPOOL_MAX_SIZE_SHIFT - MYODDWEB_BUFFERPOOL_MIN_SIZE_SHIFT + 1;
+
+    /**
+     * \brief the free buffers of one size.
+     */
+    struct FreeList
+    {
+      mutable MYODDWEB_MUTEX Lock;
+      std::vector<unsigned char*> Buffers;
+    };
+
+    /**
+     * \brief get the size class that can hold the given number of bytes.
+     * \param size the number of bytes.
+     * \return the class, or NumberOfClasses if it is too large to be pooled.
+     */
+    static int ClassOf(size_t size);
+
+    /**
+     * \brief allocate a new buffer, with room for the header in front of it.
+     * \param size the number of usable bytes.
+     * \param sizeClass the class we save in the header.
+     * \return the usable part of the buffer.
+     */
+    static unsigned char* Allocate(size_t size, int sizeClass);
+
+    /**
+     * \brief free a buffer created with Allocate( ... )
+     * \param buffer the usable part of the buffer.
+     */
+    static void Free(unsigned char* buffer);
+
+    /**
+     * \brief the free buffers, one list per size.
+     */
+    FreeList _freeLists[NumberOfClasses];
+
+    std::atomic<long long> _numberOfHits;
+    std::atomic<long long> _numberOfMisses;
+  };
+}
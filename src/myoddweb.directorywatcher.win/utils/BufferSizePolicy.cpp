@@ -0,0 +1,126 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#include "BufferSizePolicy.h"
+#include <algorithm>
+#include <chrono>
+#include "../monitors/Base.h"
+
+namespace myoddweb:: directorywatcher
+{
+  /**
+   * \brief a buffer at least that full, (in 1/4), is a sign that we might soon overflow.
+   */
+  static constexpr unsigned long long FullQuarters = 3;
+
+  /**
+   * \brief a buffer at most that full, (in 1/4), is lightly used.
+   */
+  static constexpr unsigned long long LightQuarters = 1;
+
+  /**
+   * \brief create the policy
+   * \param minimumSize the smallest size we will go to.
+   * \param maximumSize the largest size we will go to.
+   * \param initialSize the size we start with.
+   */
+  BufferSizePolicy::BufferSizePolicy(const unsigned long minimumSize, const unsigned long maximumSize, const unsigned long initialSize) :
+    _minimumSize((std::min)(minimumSize, maximumSize)),
+    _maximumSize(maximumSize),
+    _size((std::max)(_minimumSize, (std::min)(initialSize, _maximumSize))),
+    _numberOfOverflows(0),
+    _lastBusyMilliseconds(-1)
+  {
+  }
+
+  /**
+   * \brief the current time, in ms, from a steady clock.
+   */
+  long long BufferSizePolicy::NowMilliseconds()
+  {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  /**
+   * \brief a read completed, the size might change for the next read.
+   * \param numberOfBytes the number of bytes we received in a buffer of Size() bytes.
+   */
+  void BufferSizePolicy::OnRead(const unsigned long numberOfBytes)
+  {
+    OnRead(numberOfBytes, NowMilliseconds());
+  }
+
+  /**
+   * \brief a read completed, the size might change for the next read.
+   * \param numberOfBytes the number of bytes we received in a buffer of Size() bytes.
+   * \param nowMilliseconds the current time, in ms.
+   */
+  void BufferSizePolicy::OnRead(const unsigned long numberOfBytes, const long long nowMilliseconds)
+  {
+    const unsigned long long size = _size;
+    const auto quarters = static_cast<unsigned long long>(numberOfBytes) * 4;
+    if (_lastBusyMilliseconds < 0 || quarters > LightQuarters * size)
+    {
+      _lastBusyMilliseconds = nowMilliseconds;
+    }
+
+    if (quarters >= FullQuarters * size)
+    {
+      // we nearly ran out of room, do not wait for the overflow.
+      Resize(size * 2);
+      return;
+    }
+
+    if (nowMilliseconds - _lastBusyMilliseconds >= MYODDWEB_READ_BUFFER_IDLE_MILLISECONDS)
+    {
+      // we have not needed that much room for a while
+      // the next shrink will only happen after another idle period.
+      Resize(size / 2);
+      _lastBusyMilliseconds = nowMilliseconds;
+    }
+  }
+
+  /**
+   * \brief the buffer was too small and some changes were lost, the next read will use a larger buffer.
+   */
+  void BufferSizePolicy::OnOverflow()
+  {
+    OnOverflow(NowMilliseconds());
+  }
+
+  /**
+   * \brief the buffer was too small and some changes were lost, the next read will use a larger buffer.
+   * \param nowMilliseconds the current time, in ms.
+   */
+  void BufferSizePolicy::OnOverflow(const long long nowMilliseconds)
+  {
+    ++_numberOfOverflows;
+    _lastBusyMilliseconds = nowMilliseconds;
+    Resize(static_cast<unsigned long long>(_size) * 2);
+  }
+
+  /**
+   * \brief change the size, within our bounds.
+   * \param size the size we want.
+   */
+  void BufferSizePolicy::Resize(const unsigned long long size)
+  {
+    _size = static_cast<unsigned long>((std::max)(static_cast<unsigned long long>(_minimumSize), (std::min)(size, static_cast<unsigned long long>(_maximumSize))));
+  }
+
+  /**
+   * \brief the size the next read should use.
+   */
+  unsigned long BufferSizePolicy::Size() const
+  {
+    return _size;
+  }
+
+  /**
+   * \brief the number of times the buffer overflowed.
+   */
+  long long BufferSizePolicy::NumberOfOverflows() const
+  {
+    return _numberOfOverflows;
+  }
+}
@@ -0,0 +1,89 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#pragma once
+#include <atomic>
+
+namespace myoddweb:: directorywatcher
+{
+  /**
+   * \brief decide how large the buffer a monitor reads its changes into should be.
+   *        The size doubles when the buffer overflows or is nearly full
+   *        and halves when it has been mostly empty for a while, always within the min/max bounds.
+   *        Only one thread should report the reads/overflows, the size and counters can be read by any thread.
+   */
+  class BufferSizePolicy final
+  {
+  public:
+    BufferSizePolicy(unsigned long minimumSize, unsigned long maximumSize, unsigned long initialSize);
+    ~BufferSizePolicy() = default;
+
+    BufferSizePolicy(const BufferSizePolicy&) = delete;
+    BufferSizePolicy(BufferSizePolicy&&) = delete;
+    const BufferSizePolicy& operator=(const BufferSizePolicy&) = delete;
+    BufferSizePolicy& operator=(BufferSizePolicy&&) = delete;
+
+    /**
+     * \brief a read completed, the size might change for the next read.
+     * \param numberOfBytes the number of bytes we received in a buffer of Size() bytes.
+     */
+    void OnRead(unsigned long numberOfBytes);
+
+    /**
+     * \brief a read completed, the size might change for the next read.
+     * \param numberOfBytes the number of bytes we received in a buffer of Size() bytes.
+     * \param nowMilliseconds the current time, in ms.
+     */
+    void OnRead(unsigned long numberOfBytes, long long nowMilliseconds);
+
+    /**
+     * \brief the buffer was too small and some changes were lost, the next read will use a larger buffer.
+     */
+    void OnOverflow();
+
+    /**
+     * \brief the buffer was too small and some changes were lost, the next read will use a larger buffer.
+     * \param nowMilliseconds the current time, in ms.
+     */
+    void OnOverflow(long long nowMilliseconds);
+
+    /**
+     * \brief the size the next read should use.
+     */
+    [[nodiscard]]
+    unsigned long Size() const;
+
+    /**
+     * \brief the number of times the buffer overflowed.
+     */
+    [[nodiscard]]
+    long long NumberOfOverflows() const;
+
+  private:
+    /**
+     * \brief the current time, in ms, from a steady clock.
+     */
+    static long long NowMilliseconds();
+
+    /**
+     * \brief change the size, within our bounds.
+     * \param size the size we want.
+     */
+    void Resize(unsigned long long size);
+
+    const unsigned long _minimumSize;
+    const unsigned long _maximumSize;
+
+    /**
+     * \brief the size the next read should use.
+     */
+    std::atomic<unsigned long> _size;
+
+    std::atomic<long long> _numberOfOverflows;
+
+    /**
+     * \brief the last time the buffer was more than lightly used.
+     */
+    long long _lastBusyMilliseconds;
+  };
+}
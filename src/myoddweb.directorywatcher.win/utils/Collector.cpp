@@ -1,7 +1,10 @@
 // Licensed to Florent Guelfucci under one or more agreements.
 // Florent Guelfucci licenses this file to you under the MIT license.
 // See the LICENSE file in the project root for more information.
-#include <Windows.h>
+#include <algorithm>
+#include <cwchar>
+#include <limits>
+#include <thread>
 #include "Collector.h"
 #include "Lock.h"
 #include "Io.h"
@@ -16,18 +19,47 @@ namespace myoddweb:: directorywatcher
    * \brief the comnstructor
    * \param maxCleanupAgeMilliseconds the maximum amount of time we want the collector to keep data
    *        this is only a GUIDE because the data is only cleanned when needed.
+   * \param coalesceEvents if we want to reduce the events of each path to their net effect, (see EventsCoalescer).
+   * \param settleMilliseconds how long a touched file must not change before we return it, (0 to return them straight away).
+   * \param metrics where we count the events, (null to keep our own).
    */
-  Collector::Collector( const long long maxCleanupAgeMilliseconds) :
+  Collector::Collector( const long long maxCleanupAgeMilliseconds, const bool coalesceEvents, const long long settleMilliseconds, Metrics* metrics) :
     _maxCleanupAgeMilliseconds(maxCleanupAgeMilliseconds ),
-    _currentEvents(nullptr)
+    _coalesceEvents(coalesceEvents),
+    _metrics(metrics == nullptr ? new Metrics() : metrics),
+    _ownsMetrics(metrics == nullptr),
+    _settleQueue(nullptr),
+    _shards(nullptr),
+    _backlogMemory(nullptr),
+    _spareBacklogMemory(nullptr)
   {
-    // calculate the max age
-    _currentEvents = new EventsInformation();
+    // each shard starts with its first epoch, the second one is the spare.
+    _shards = new Shard[MYODDWEB_COLLECTOR_SHARDS];
+    for (auto i = 0; i < MYODDWEB_COLLECTOR_SHARDS; ++i)
+    {
+      _shards[i].Current = &_shards[i].Epochs[0];
+      _shards[i].Spare = &_shards[i].Epochs[1];
+    }
+
+    _backlogMemory = new Arena();
+    _spareBacklogMemory = new Arena();
+
+    if (settleMilliseconds > 0)
+    {
+      _settleQueue = new SettleQueue(settleMilliseconds, settleMilliseconds * MYODDWEB_SETTLE_MAX_HOLD_FACTOR);
+    }
   }
 
   Collector::~Collector()
   {
-    ClearEvents(_currentEvents);
+    delete _settleQueue;
+    delete[] _shards;
+    delete _backlogMemory;
+    delete _spareBacklogMemory;
+    if (_ownsMetrics)
+    {
+      delete _metrics;
+    }
   }
 
   /**
@@ -54,7 +86,7 @@ namespace myoddweb:: directorywatcher
    * \param isFile if this is a file or a folder.
    * \param error if there was an error related
    */
-  void Collector::Add(const EventAction action, const std::wstring& path, const std::wstring& filename, bool isFile, EventError error)
+  void Collector::Add(const EventAction action, const std::wstring& path, const std::wstring_view filename, bool isFile, EventError error)
   {
     MYODDWEB_PROFILE_FUNCTION();
 
@@ -70,7 +102,7 @@ namespace myoddweb:: directorywatcher
    * \param isFile if this is a file or a folder.
    * \param error if there is an error related to the rename
    */
-  void Collector::AddRename(const std::wstring& path, const std::wstring& newFilename, const std::wstring& oldFilename, bool isFile, EventError error)
+  void Collector::AddRename(const std::wstring& path, const std::wstring_view newFilename, const std::wstring_view oldFilename, bool isFile, EventError error)
   {
     MYODDWEB_PROFILE_FUNCTION();
 
@@ -87,7 +119,7 @@ namespace myoddweb:: directorywatcher
    * \param isFile if this is a file or a folder.
    * \param error if there was an error related to the action
    */
-  void Collector::Add( const EventAction action, const std::wstring& path, const std::wstring& filename, const std::wstring& oldFileName, const bool isFile, EventError error)
+  void Collector::Add( const EventAction action, const std::wstring& path, const std::wstring_view filename, const std::wstring_view oldFileName, const bool isFile, EventError error)
   {
     MYODDWEB_PROFILE_FUNCTION();
 
@@ -99,26 +131,49 @@ namespace myoddweb:: directorywatcher
 
     try
     {
-      // get the combined path.
-      const auto combinedPath = filename.empty() ? (isFile ? L"" : path) : Io::Combine(path, filename);
-
-      // We first create the event outside the lock
-      // that way, we only have the lock for the shortest
-      // posible amount of time.
-      const auto ofn = oldFileName.empty() ? L"" : Io::Combine(path, oldFileName);
-      const auto eventInformation = new EventInformation(
-          GetMillisecondsNowUtc(),
-          action,
-          error,
-          combinedPath.c_str(),
-          ofn.c_str(),
-        isFile);
-
-      // we can now add the event to our vector.
-      AddEventInformation(eventInformation);
-
-      // try and cleanup the events if need be.
-      CleanupEvents();
+      const auto timeMillisecondsUtc = GetMillisecondsNowUtc();
+      {
+        // the event and the paths are written straight into the arena of the shard
+        // there is no lock, other threads are either using other shards or allocating next to us.
+        auto& epoch = EnterEpoch(CurrentShard());
+        try
+        {
+          auto& memory = epoch.Memory;
+
+          // get the combined path.
+          const auto combinedPath = filename.empty() ? (isFile ? L"" : memory.Copy(path)) : Combine(memory, path, filename);
+          const auto ofn = oldFileName.empty() ? L"" : Combine(memory, path, oldFileName);
+          const auto node = memory.Create<EventNode>(
+            timeMillisecondsUtc,
+            action,
+            error,
+            combinedPath,
+            ofn,
+            isFile);
+
+          // push it to the head of the list.
+          node->Next = epoch.Head.load(std::memory_order_relaxed);
+          while (!epoch.Head.compare_exchange_weak(node->Next, node, std::memory_order_release, std::memory_order_relaxed))
+          {
+          }
+        }
+        catch (...)
+        {
+          // we must leave the epoch or the consumer will wait for us forever.
+          LeaveEpoch(epoch);
+          throw;
+        }
+        LeaveEpoch(epoch);
+      }
+      _metrics->Add(Metrics::Counter::ReceivedEvents);
+
+      // when we want to check for the next cleanup
+      // if the time is zero then we will use the event time + the max time.
+      if (_nextCleanupTimeCheck == 0)
+      {
+        auto expected = 0LL;
+        _nextCleanupTimeCheck.compare_exchange_strong(expected, timeMillisecondsUtc + (_maxCleanupAgeMilliseconds + MYODDWEB_MAX_EVENT_AGE_BUFFER));
+      }
     }
     catch (const std::exception& e)
     {
@@ -128,35 +183,163 @@ namespace myoddweb:: directorywatcher
   }
 
   /**
-   * \brief copy the current content of the events into a local variable.
-   * Then erase the current content so we can continue receiving data.
+   * \brief combine the path and filename straight into the arena.
+   * \param memory the arena that will hold the path.
+   * \param path the root path
+   * \param filename the file from the path.
+   * \return the null terminated combined path.
    */
-  Collector::EventsInformation* Collector::CloneEventsAndEraseCurrent()
+  const wchar_t* Collector::Combine(ConcurrentArena& memory, const std::wstring& path, const std::wstring_view filename)
   {
-    MYODDWEB_PROFILE_FUNCTION();
+    const auto combined = memory.AllocateString(Io::CombineLength(path, filename));
+    Io::Combine(combined, path, filename);
+    return combined;
+  }
+
+  /**
+   * \brief get the shard that the current thread adds events to.
+   *        each thread is given the next shard the first time it adds an event
+   *        so, up to the number of shards, no two threads share the same shard.
+   */
+  Collector::Shard& Collector::CurrentShard() const
+  {
+    static std::atomic<unsigned int> nextShard = 0;
+    static thread_local const auto shard = nextShard++ % MYODDWEB_COLLECTOR_SHARDS;
+    return _shards[shard];
+  }
 
-    // if we have nothing to do, no point in calling the extra functions.
-    // this is thread safe, so we can check out of lock
-    if (_nextCleanupTimeCheck == 0)
+  /**
+   * \brief get the current epoch of a shard and register as one of its writers.
+   *        the consumer will not read the epoch until we leave it.
+   * \param shard the shard we want to add to.
+   * \return the epoch we can add to.
+   */
+  Collector::ShardEpoch& Collector::EnterEpoch(Shard& shard)
+  {
+    for (;;)
     {
-      return nullptr;
+      const auto epoch = shard.Current.load();
+      ++epoch->Writers;
+
+      // if the consumer swapped the epoch before we registered, it might already
+      // be reading it, so we have to try again with the new one.
+      if (shard.Current.load() == epoch)
+      {
+        return *epoch;
+      }
+      --epoch->Writers;
     }
+  }
 
-    // we can reset the internal counter.
-    // and we erased all the data, there is nothing else to do.
-    _nextCleanupTimeCheck = 0;
+  /**
+   * \brief stop being one of the writers of an epoch.
+   * \param epoch the epoch we are leaving.
+   */
+  void Collector::LeaveEpoch(ShardEpoch& epoch)
+  {
+    --epoch.Writers;
+  }
 
-    // lock
-    MYODDWEB_LOCK(_lock);
+  /**
+   * \brief take all the events from all the shards and merge them with the backlog
+   *        the backlog is then ordered from the oldest to the newest.
+   *        the lock must be held and the drained epochs must be released once we are done with the events.
+   * \return the epochs we drained.
+   */
+  Collector::DrainedEpochs Collector::DrainShardsInLock()
+  {
+    MYODDWEB_PROFILE_FUNCTION();
+
+    // the backlog is already in order, it is the first run.
+    std::vector<size_t> runs = { 0, _backlog.size() };
 
-    // copy the address, it is up to the clone now to handle it all.
-    const auto clone = _currentEvents;
+    DrainedEpochs drained;
+    for (auto i = 0; i < MYODDWEB_COLLECTOR_SHARDS; ++i)
+    {
+      auto& shard = _shards[i];
+      if (shard.Current.load()->Head.load() == nullptr)
+      {
+        // nothing was added to this shard.
+        continue;
+      }
 
-    // create a brand new container.
-    _currentEvents = new EventsInformation();
+      // swap the epochs, new events will now go to the spare one
+      // and we wait for the threads still adding to the old one.
+      const auto epoch = shard.Current.exchange(shard.Spare);
+      shard.Spare = nullptr;
+      while (epoch->Writers.load() != 0)
+      {
+        std::this_thread::yield();
+      }
+      drained.emplace_back(&shard, epoch);
 
-    // return the number of items
-    return clone;
+      // the list is from the newest to the oldest so we reverse it.
+      const auto start = _backlog.size();
+      for (auto node = epoch->Head.load(std::memory_order_acquire); node != nullptr; node = node->Next)
+      {
+        _backlog.emplace_back(&node->Information);
+      }
+      std::reverse(_backlog.begin() + start, _backlog.end());
+
+      // the time is taken before the event is pushed, so two threads
+      // sharing a shard could, in rare cases, push their events out of order.
+      if (!std::is_sorted(_backlog.begin() + start, _backlog.end(), SortInformationByTimeMillisecondsUtc))
+      {
+        std::stable_sort(_backlog.begin() + start, _backlog.end(), SortInformationByTimeMillisecondsUtc);
+      }
+      runs.emplace_back(_backlog.size());
+    }
+
+    // merge the runs two by two until we only have one.
+    // the merge is stable so, for the same time, the events stay in the order they were added.
+    while (runs.size() > 2)
+    {
+      std::vector<size_t> merged = { 0 };
+      for (size_t i = 1; i < runs.size(); i += 2)
+      {
+        if (i + 1 < runs.size())
+        {
+          std::inplace_merge(_backlog.begin() + runs[i - 1], _backlog.begin() + runs[i], _backlog.begin() + runs[i + 1], SortInformationByTimeMillisecondsUtc);
+          merged.emplace_back(runs[i + 1]);
+        }
+        else
+        {
+          merged.emplace_back(runs[i]);
+        }
+      }
+      runs.swap(merged);
+    }
+    return drained;
+  }
+
+  /**
+   * \brief clear the epochs we took from the shards and give them back.
+   * \param drained the epochs we want to give back.
+   */
+  void Collector::ReleaseDrainedInLock(DrainedEpochs& drained)
+  {
+    for (auto& shardAndEpoch : drained)
+    {
+      // no one is using it anymore, the memory is released in one go.
+      auto& epoch = *shardAndEpoch.second;
+      epoch.Head = nullptr;
+      epoch.Memory.Reset();
+
+      // it is now the spare epoch.
+      shardAndEpoch.first->Spare = &epoch;
+    }
+    drained.clear();
+  }
+
+  /**
+   * \brief sort events information by TimeMillisecondsUtc
+   * \param lhs the lhs element we are checking.
+   * \param rhs the rhs element we are checking.
+   * \return if lhs is older than rhs.
+   */
+  bool Collector::SortInformationByTimeMillisecondsUtc(const EventInformation* lhs, const EventInformation* rhs)
+  {
+    return lhs->TimeMillisecondsUtc < rhs->TimeMillisecondsUtc;
   }
 
   /**
@@ -173,86 +356,212 @@ namespace myoddweb:: directorywatcher
   /**
    * \brief fill the vector with all the values currently on record.
    * \param events the events we will be filling
-   * \return the number of events we found.
+   * \param memory the arena that will hold the events, they are valid until it is reset.
    */
-  void Collector::GetEvents( std::vector<Event*>& events )
+  void Collector::GetEvents( std::vector<Event*>& events, Arena& memory )
   {
     MYODDWEB_PROFILE_FUNCTION();
 
-    // quickly make a copy of the current list
-    // and erase the current contents.
-    // the lock is released as soon as posible making sure that other threads
-    // can keep adding to the list.
-    const auto clone = CloneEventsAndEraseCurrent();
-    if(clone == nullptr )
+    // the producers never wait for us, we only share the lock with the cleanup.
+    MYODDWEB_LOCK(_consumerLock);
+
+    // take everything from the shards, the events are added to the backlog.
+    auto drained = DrainShardsInLock();
+
+    // hold the touched files that are still changing, and add the ones that settled.
+    if (_settleQueue != nullptr)
+    {
+      SettleInLock(GetMillisecondsNowUtc());
+    }
+
+    if (_backlog.empty())
     {
+      // everything we drained is being held until it settles
+      // but the epochs must still be given back or the shards have no spare.
+      _hasBacklog = false;
+      ReleaseDrainedInLock(drained);
       return;
     }
 
-    // the lock has been released, we are now working with the clone
+    // we can reset the internal counter.
+    // and we erased all the data, there is nothing else to do.
+    _nextCleanupTimeCheck = 0;
+
+    // only keep the net effect of what happened to each path.
+    _metrics->Add(Metrics::Counter::CollectedEvents, static_cast<long long>(_backlog.size()));
+    if (_coalesceEvents)
+    {
+      const auto numberOfEvents = _backlog.size();
+      _coalescer.Coalesce(_backlog, *_backlogMemory);
+      _metrics->Add(Metrics::Counter::CoalescedEvents, static_cast<long long>(numberOfEvents - _backlog.size()));
+    }
 
     // we can now reserve some space in our return vector.
     // we know that it will be a maximum of that size.
     // but we will not be adding more to id.
-    events.reserve( clone->size() );
+    const auto first = events.size();
+    events.reserve( first + _backlog.size() );
+
+    // the events we have already added, keyed by name, action and type.
+    EventKeys keys;
+    keys.reserve(_backlog.size());
+    auto numberOfDuplicates = 0ll;
 
     // go around the data from the newest to the oldest.
-    // and we will add them in reverse as well.
-    // this is useful to make sure that we remove 'older' dulicates.
-    for( auto it = clone->rbegin(); it != clone->rend(); ++it )
+    // this is useful to make sure that we remove 'older' dulicates
+    // as the newest event will always be the first one we see.
+    for( auto it = _backlog.rbegin(); it != _backlog.rend(); ++it )
     {
       const auto& eventInformation = (*it);
-
-      const auto e = new Event(
-        eventInformation->Name,
-        eventInformation->OldName,
-        ConvertEventAction(eventInformation->Action),
-        ConvertEventError(eventInformation->Error),
-        eventInformation->TimeMillisecondsUtc,
-        eventInformation->IsFile);
-      if (IsOlderDuplicate(events, *e))
+      if (IsOlderDuplicate(keys, *eventInformation))
       {
         // it is an older duplicate
         // so we do not want to add it,
-        delete e;
+        ++numberOfDuplicates;
         continue;
       }
 
       // it is not a duplicate, so we can add it.
-      // because we are getting the data in reverse we will add the data
-      // in the front, it is older than the previous one.
-      // the caller will now be in charge of cleanning up the memory
-      events.insert( events.begin(), e);
+      // the event is copied to the caller's arena, it will release it all in one go.
+      events.push_back( memory.Create<Event>(
+        memory.Copy(eventInformation->Name),
+        memory.Copy(eventInformation->OldName),
+        ConvertEventAction(eventInformation->Action),
+        ConvertEventError(eventInformation->Error),
+        eventInformation->TimeMillisecondsUtc,
+        eventInformation->IsFile));
     }
 
+    _metrics->Add(Metrics::Counter::DeduplicatedEvents, numberOfDuplicates);
+
+    // because we got the data in reverse, we need to put it back
+    // in the order it was added, from the oldest to the newest.
+    std::reverse(events.begin() + first, events.end());
+
     // last step is to cleanup all the renames.
     ValidateRenames(events);
 
-    // finally we can cleanup the clone
-    // we took ownership of the data ... so we have to clean it all up.
-    ClearEvents(clone);
+    // finally we can release everything
+    // all the data is released in one go.
+    _backlog.clear();
+    _hasBacklog = false;
+    _backlogMemory->Reset();
+    ReleaseDrainedInLock(drained);
   }
 
   /**
-   * \brief clear all the events information and delete all the data.
-   * \param events the data we want to clear.
+   * \brief check if we have any events waiting to be collected.
+   *        This is thread safe and never waits for the producers or the consumer.
+   * \return if we have at least one event.
    */
-  void Collector::ClearEvents(EventsInformation* events)
+  bool Collector::HasEvents() const
   {
-    if( nullptr == events )
+    // events moved to the backlog during a cleanup, or touched files waiting to settle.
+    if (_hasBacklog || _numberOfSettlingPaths > 0)
     {
-      return;
+      return true;
+    }
+
+    // or events still in one of the shards.
+    for (auto i = 0; i < MYODDWEB_COLLECTOR_SHARDS; ++i)
+    {
+      if (_shards[i].Current.load()->Head.load() != nullptr)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * \brief the number of events we collected, before they were coalesced or their duplicates removed.
+   */
+  long long Collector::NumberOfCollectedEvents() const
+  {
+    return _metrics->Get(Metrics::Counter::CollectedEvents);
+  }
+
+  /**
+   * \brief the number of events that were removed because they did not change the net effect.
+   */
+  long long Collector::NumberOfCoalescedEvents() const
+  {
+    return _metrics->Get(Metrics::Counter::CoalescedEvents);
+  }
+
+  /**
+   * \brief the number of events that were removed because a newer event of the same path and action was collected.
+   */
+  long long Collector::NumberOfDeduplicatedEvents() const
+  {
+    return _metrics->Get(Metrics::Counter::DeduplicatedEvents);
+  }
+
+  /**
+   * \brief the number of touched paths we are holding until they settle.
+   */
+  long long Collector::NumberOfSettlingPaths() const
+  {
+    return _numberOfSettlingPaths;
+  }
+
+  /**
+   * \brief hold the touched files of the backlog until they settle and add the ones that did to the backlog.
+   *        any other event of a path we are holding releases it first, so the order of the events of a path never changes.
+   *        the lock must be held.
+   * \param nowMillisecondsUtc the current time.
+   */
+  void Collector::SettleInLock(const long long nowMillisecondsUtc)
+  {
+    MYODDWEB_PROFILE_FUNCTION();
+
+    auto& memory = *_backlogMemory;
+    const auto release = [&](const wchar_t* name, const bool isFile, EventsInformation& events)
+    {
+      long long timeMillisecondsUtc;
+      if (name != nullptr && _settleQueue->Release(name, isFile, timeMillisecondsUtc))
+      {
+        events.push_back(memory.Create<EventInformation>(timeMillisecondsUtc, EventAction::Touched, EventError::None, memory.Copy(name), L"", isFile));
+      }
+    };
+
+    // the paths we release go before the event releasing them, so the order of the events of a path is kept.
+    EventsInformation events;
+    events.reserve(_backlog.size());
+    for (const auto eventInformation : _backlog)
+    {
+      const auto name = eventInformation->Name;
+      if (eventInformation->Action == EventAction::Touched &&
+          eventInformation->Error == EventError::None &&
+          name != nullptr && *name != L'\0')
+      {
+        _settleQueue->Change(name, eventInformation->IsFile, eventInformation->TimeMillisecondsUtc);
+        continue;
+      }
+
+      release(name, eventInformation->IsFile, events);
+      if (eventInformation->Action == EventAction::Renamed)
+      {
+        release(eventInformation->OldName, eventInformation->IsFile, events);
+      }
+      events.push_back(eventInformation);
+    }
+
+    std::vector<SettleQueue::Settled> settled;
+    _settleQueue->TakeSettled(nowMillisecondsUtc, settled);
+    for (const auto& path : settled)
+    {
+      events.push_back(memory.Create<EventInformation>(path.TimeMillisecondsUtc, EventAction::Touched, EventError::None, memory.Copy(path.Name), L"", path.IsFile));
     }
 
-    // delete each events in the container.
-    for (auto it = events->begin(); it != events->end(); ++it)
+    // the paths we released, or that settled, changed before some of the events we already have.
+    if (!std::is_sorted(events.begin(), events.end(), SortInformationByTimeMillisecondsUtc))
     {
-      delete (*it);
+      std::stable_sort(events.begin(), events.end(), SortInformationByTimeMillisecondsUtc);
     }
 
-    // finaly delete the container itself
-    delete events;
-    events = nullptr;
+    _backlog = std::move(events);
+    _numberOfSettlingPaths = static_cast<long long>(_settleQueue->Size());
   }
 
   /**
@@ -303,40 +612,46 @@ namespace myoddweb:: directorywatcher
   }
 
   /**
-   * \brief check if the given information already exists in the source
-   * \param source the collection of events we will be looking in
+   * \brief check if the given information was already added
+   *        if it was not then the key is added to our list of keys.
+   * \param keys the keys of the events we already added.
    * \param duplicate the event information we want to add.
-   * \return if the event information is already in the 'source'
+   * \return if the event information is already in the 'keys'
    */
-  bool Collector::IsOlderDuplicate(const std::vector<Event*>& source, const Event& duplicate)
+  bool Collector::IsOlderDuplicate(EventKeys& keys, const EventInformation& duplicate)
   {
     MYODDWEB_PROFILE_FUNCTION();
 
-    for( auto it = source.begin(); it != source.end(); ++it )
+    // events without a name are never duplicates.
+    if (duplicate.Name == nullptr)
     {
-      const auto& e = (*it);
-
-      // they must both be of the same type.
-      if (e->IsFile != duplicate.IsFile)
-      {
-        continue;
-      }
+      return false;
+    }
 
-      // if the actions are not the same, then it is not an older duplicate.
-      if(e->Action != duplicate.Action)
-      {
-        continue;
-      }
+    // if we cannot insert it, then it was already there.
+    return !keys.insert(EventKey{ duplicate.Name, duplicate.Action, duplicate.IsFile }).second;
+  }
 
-      if (e->Name != nullptr && duplicate.Name != nullptr && wcscmp(duplicate.Name, e->Name) == 0 )
-      {
-        // they are the same!
-        return true;
-      }
-    }
+  /**
+   * \brief create the hash of an event key
+   * \param key the key we want to hash
+   * \return the hash value
+   */
+  size_t Collector::EventKeyHash::operator()(const EventKey& key) const noexcept
+  {
+    const auto hash = std::hash<std::wstring_view>()(key.Name);
+    return hash ^ ((static_cast<size_t>(key.Action) << 1) | (key.IsFile ? 1 : 0));
+  }
 
-    // if we made it here, then it is not an older duplicate
-    return false;
+  /**
+   * \brief check if two event keys are the same
+   * \param lhs the lhs element we are checking.
+   * \param rhs the rhs element we are checking.
+   * \return if both keys are the same.
+   */
+  bool Collector::EventKeyEqual::operator()(const EventKey& lhs, const EventKey& rhs) const noexcept
+  {
+    return lhs.IsFile == rhs.IsFile && lhs.Action == rhs.Action && lhs.Name == rhs.Name;
   }
 
   /**
@@ -358,28 +673,17 @@ namespace myoddweb:: directorywatcher
   }
 
   /**
-   * \brief add an event to the array
-   * At regular intervals we will be removing old data.
-   * \param event the event we are adding to the vector.
+   * \brief how long until the backlog needs to be cleaned up.
+   * \return the number of ms until the next cleanup or the max float value if we have nothing to clean.
    */
-  void Collector::AddEventInformation(const EventInformation* event)
+  float Collector::MillisecondsUntilCleanup() const
   {
-    MYODDWEB_PROFILE_FUNCTION();
-
-    // we can now get the lock so we can add data.
-    // the lock is released automatically.
-    MYODDWEB_LOCK(_lock);
-
-    // add it.
-    _currentEvents->emplace_back(event);
-
-    // update the internal counter.
-    if(_nextCleanupTimeCheck == 0 )
+    const auto next = _nextCleanupTimeCheck.load();
+    if (next == 0)
     {
-      // when we want to check for the next cleanup
-      // if the time is zero then we will use the event time + the max time.
-      _nextCleanupTimeCheck = event->TimeMillisecondsUtc + (_maxCleanupAgeMilliseconds + MYODDWEB_MAX_EVENT_AGE_BUFFER);
+      return (std::numeric_limits<float>::max)();
     }
+    return static_cast<float>((std::max)(next - GetMillisecondsNowUtc(), 0LL));
   }
 
   /**
@@ -394,8 +698,6 @@ namespace myoddweb:: directorywatcher
     const auto now = GetMillisecondsNowUtc();
 
     // do we need to clean up? First check outside the lock.
-    // we don't really need to check the lock here
-    // even if that is true a nano second after we check this the next event will clean it
     // remember that this is only a guide as for when to clean up the vector
     // this is thread safe so we can check this now.
     if (_nextCleanupTimeCheck != 0 && _nextCleanupTimeCheck > now)
@@ -403,50 +705,46 @@ namespace myoddweb:: directorywatcher
       return;
     }
 
+    // if another thread is getting or cleaning the events then there is nothing for us to do
+    // we never want a producer to wait.
+    std::unique_lock<MYODDWEB_MUTEX> lock(_consumerLock, std::try_to_lock);
+    if (!lock.owns_lock())
+    {
+      return;
+    }
+
     // reset the counter so we can check again later.
     _nextCleanupTimeCheck = 0;
 
-    // lock and check again if we need to do the work.
-    // and if not, get out straight away.
-    MYODDWEB_LOCK(_lock);
+    // move everything from the shards to the backlog.
+    auto drained = DrainShardsInLock();
 
-    // get the current time.
+    // because everything is ordered from older to newer
+    // we only need to find the first item that is newer than our older time.
     const auto old = now - (_maxCleanupAgeMilliseconds + MYODDWEB_MAX_EVENT_AGE_BUFFER);
-    auto begin = _currentEvents->end();
-    auto end = _currentEvents->end();
-    for( auto it = _currentEvents->begin();; ++it )
+    auto end = _backlog.begin();
+    while (end != _backlog.end() && (*end)->TimeMillisecondsUtc <= old)
     {
-      // get the first iterator.
-      if (it == _currentEvents->end())
-      {
-        // we reached the end of the list
-        end = it;
-        break;
-      }
-
-      // is this item newer than our oler time.
-      if ((*it)->TimeMillisecondsUtc > old)
-      {
-        // because everything is ordered from 
-        // older to newer, there is no point in going any further.
-        break;
-      }
-
-      // have we already set the begining?
-      if ( begin == _currentEvents->end() )
-      {
-        begin = it;
-      }
+      ++end;
     }
+    _backlog.erase(_backlog.begin(), end);
 
-    // do we hae anything to delete?
-    if (begin != _currentEvents->end())
+    // the events we are keeping are copied to the spare memory
+    // so the memory of the old events, and the shards, can be released.
+    auto& memory = *_spareBacklogMemory;
+    for (auto& eventInformation : _backlog)
     {
-      for (auto it = begin; it != end; ++it)
-      {
-        delete* it;
-      }
-      _currentEvents->erase(begin, end);
+      eventInformation = memory.Create<EventInformation>(
+        eventInformation->TimeMillisecondsUtc,
+        eventInformation->Action,
+        eventInformation->Error,
+        memory.Copy(eventInformation->Name),
+        memory.Copy(eventInformation->OldName),
+        eventInformation->IsFile);
     }
+    std::swap(_backlogMemory, _spareBacklogMemory);
+    _spareBacklogMemory->Reset();
+    ReleaseDrainedInLock(drained);
+    _hasBacklog = !_backlog.empty();
   }
 }
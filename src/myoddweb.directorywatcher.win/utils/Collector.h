@@ -4,13 +4,21 @@
 #pragma once
 #include <atomic>
 #include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 #include <mutex>
 
 #include "../monitors/Base.h"
+#include "Arena.h"
+#include "ConcurrentArena.h"
 #include "EventAction.h"
 #include "EventInformation.h"
 #include "Event.h"
+#include "EventsCoalescer.h"
+#include "Metrics.h"
+#include "SettleQueue.h"
 
 namespace myoddweb
 {
@@ -22,7 +30,14 @@ namespace myoddweb
     class Collector final
     {
     public:
-      explicit Collector(long long maxCleanupAgeMilliseconds);
+      /**
+       * \brief create the collector.
+       * \param maxCleanupAgeMilliseconds the maximum amount of time we want the collector to keep data.
+       * \param coalesceEvents if we want to reduce the events of each path to their net effect, (see EventsCoalescer).
+       * \param settleMilliseconds how long a touched file must not change before we return it, (0 to return them straight away).
+       * \param metrics where we count the events, (null to keep our own).
+       */
+      explicit Collector(long long maxCleanupAgeMilliseconds, bool coalesceEvents = false, long long settleMilliseconds = 0, Metrics* metrics = nullptr);
       ~Collector();
 
       /**
@@ -33,17 +48,70 @@ namespace myoddweb
        */
       static bool SortByTimeMillisecondsUtc(const Event* lhs, const Event* rhs);
 
-      void Add(EventAction action, const std::wstring& path, const std::wstring& filename, bool isFile, EventError error);
-      void AddRename(const std::wstring& path, const std::wstring&newFilename, const std::wstring&oldFilename, bool isFile, EventError error);
+      /**
+       * \brief Get the time now in milliseconds since 1970
+       * \return the current ms time
+       */
+      static long long GetMillisecondsNowUtc();
+
+      void Add(EventAction action, const std::wstring& path, std::wstring_view filename, bool isFile, EventError error);
+      void AddRename(const std::wstring& path, std::wstring_view newFilename, std::wstring_view oldFilename, bool isFile, EventError error);
 
       /**
        * \brief fill the vector with all the values currently on record.
        * \param events the events we will be filling
+       * \param memory the arena that will hold the events, they are valid until it is reset.
+       */
+      void GetEvents( std::vector<Event*>& events, Arena& memory);
+
+      /**
+       * \brief check if we have any events waiting to be collected.
+       *        This is thread safe and never waits for the producers or the consumer.
+       * \return if we have at least one event.
+       */
+      [[nodiscard]]
+      bool HasEvents() const;
+
+      /**
+       * \brief the number of events we collected, before they were coalesced or their duplicates removed.
+       */
+      [[nodiscard]]
+      long long NumberOfCollectedEvents() const;
+
+      /**
+       * \brief the number of events that were removed because they did not change the net effect.
+       */
+      [[nodiscard]]
+      long long NumberOfCoalescedEvents() const;
+
+      /**
+       * \brief the number of events that were removed because a newer event of the same path and action was collected.
+       */
+      [[nodiscard]]
+      long long NumberOfDeduplicatedEvents() const;
+
+      /**
+       * \brief the number of touched paths we are holding until they settle.
+       */
+      [[nodiscard]]
+      long long NumberOfSettlingPaths() const;
+
+      /**
+       * \brief cleanup the backlog if our internal counter has being reached.
+       *        this is only done if no other thread is already getting/cleaning the events.
+       *        The producers never do it themselves, the owner calls it when it is due, (see MillisecondsUntilCleanup( ... ) ).
+       */
+      void CleanupEvents();
+
+      /**
+       * \brief how long until the backlog needs to be cleaned up.
+       * \return the number of ms until the next cleanup or the max float value if we have nothing to clean.
        */
-      void GetEvents( std::vector<Event*>& events);
+      [[nodiscard]]
+      float MillisecondsUntilCleanup() const;
 
     private:
-      void Add(EventAction action, const std::wstring& path, const std::wstring& filename, const std::wstring& oldFileName, bool isFile, EventError error);
+      void Add(EventAction action, const std::wstring& path, std::wstring_view filename, std::wstring_view oldFileName, bool isFile, EventError error);
 
       /**
        * \brief This is the oldest number of ms we want something to be.
@@ -51,49 +119,202 @@ namespace myoddweb
        */
       const long long _maxCleanupAgeMilliseconds;
 
+      /**
+       * \brief if we reduce the events of each path to their net effect.
+       */
+      const bool _coalesceEvents;
+
+      /**
+       * \brief reduces the events to their net effect, only used by the consumer.
+       */
+      EventsCoalescer _coalescer;
+
+      /**
+       * \brief where we count the events we received, collected and removed.
+       */
+      Metrics* _metrics;
+
+      /**
+       * \brief if we created the metrics ourselves, and must delete them.
+       */
+      const bool _ownsMetrics;
+
+      /**
+       * \brief the touched files we are holding until they settle, only used by the consumer.
+       *        null if the touched files are returned straight away.
+       */
+      SettleQueue* _settleQueue;
+
+      /**
+       * \brief the number of paths in the settle queue,
+       *        so we can tell that we have events waiting without taking the consumer lock.
+       */
+      std::atomic<long long> _numberOfSettlingPaths = 0;
+
+      /**
+       * \brief hold the touched files of the backlog until they settle and add the ones that did to the backlog.
+       *        any other event of a path we are holding releases it first, so the order of the events of a path never changes.
+       *        the lock must be held.
+       * \param nowMillisecondsUtc the current time.
+       */
+      void SettleInLock(long long nowMillisecondsUtc);
+
       /**
        * \brief The next time we want to check for cleanup
        *        We will be using an atomic variable to make sure that it is thread safe.
        */
       std::atomic<long long> _nextCleanupTimeCheck = 0;
 
+
       /**
-       * \brief cleanup the vector if our internal counter has being reached.
+       * \brief combine the path and filename straight into the arena.
+       * \param memory the arena that will hold the path.
+       * \param path the root path
+       * \param filename the file from the path.
+       * \return the null terminated combined path.
        */
-      void CleanupEvents();
+      static const wchar_t* Combine(ConcurrentArena& memory, const std::wstring& path, std::wstring_view filename);
 
       /**
-       * \brief Add an event to the vector and remove older events.
-       * \param event
+       * \brief the events list
        */
-      void AddEventInformation(const EventInformation* event);
+      typedef std::vector<const EventInformation*> EventsInformation;
 
       /**
-       * \brief the locks so we can add data.
+       * \brief an event in the lock free list of a shard.
        */
-      MYODDWEB_MUTEX _lock;
+      struct EventNode
+      {
+        template<typename... Args>
+        explicit EventNode(Args&&... args) :
+          Information(std::forward<Args>(args)...),
+          Next(nullptr)
+        {
+        }
+
+        EventInformation Information;
+        EventNode* Next;
+      };
 
       /**
-       * \brief the events list
+       * \brief all the events added to a shard between two calls to GetEvents( ... )
+       *        the events are pushed to the head of the list, so the newest event is first.
        */
-      typedef std::vector<const EventInformation*> EventsInformation;
+      struct ShardEpoch
+      {
+        /**
+         * \brief the newest event.
+         */
+        std::atomic<EventNode*> Head = nullptr;
+
+        /**
+         * \brief the number of threads currently adding to this epoch.
+         */
+        std::atomic<long> Writers = 0;
+
+        /**
+         * \brief the memory that holds the events and the paths.
+         */
+        ConcurrentArena Memory;
+      };
 
       /**
-       * \brief this is the event that we are _currently adding data to.
+       * \brief the producers are spread across shards so they do not all update the same list
+       *        each shard has 2 epochs, the one we add to and the one being read.
        */
-      EventsInformation* _currentEvents;
+      struct alignas(64) Shard
+      {
+        /**
+         * \brief the epoch the producers are adding to.
+         */
+        std::atomic<ShardEpoch*> Current;
+
+        /**
+         * \brief the epoch that will replace the current one, only used by the consumer.
+         */
+        ShardEpoch* Spare;
+
+        ShardEpoch Epochs[2];
+      };
 
       /**
-       * \brief clear all the events information and delete all the data.
-       * \param events the data we want to clear.
+       * \brief all our shards.
        */
-      static void ClearEvents(EventsInformation* events);
+      Shard* _shards;
 
       /**
-       * \brief Get the time now in milliseconds since 1970
-       * \return the current ms time
+       * \brief get the shard that the current thread adds events to.
        */
-      static long long GetMillisecondsNowUtc();
+      Shard& CurrentShard() const;
+
+      /**
+       * \brief get the current epoch of a shard and register as one of its writers.
+       *        the consumer will not read the epoch until we leave it.
+       * \param shard the shard we want to add to.
+       * \return the epoch we can add to.
+       */
+      static ShardEpoch& EnterEpoch(Shard& shard);
+
+      /**
+       * \brief stop being one of the writers of an epoch.
+       * \param epoch the epoch we are leaving.
+       */
+      static void LeaveEpoch(ShardEpoch& epoch);
+
+      /**
+       * \brief the lock used by the consumers, (GetEvents and the cleanup)
+       *        the producers never use this lock.
+       */
+      MYODDWEB_MUTEX _consumerLock;
+
+      /**
+       * \brief the events that were removed from the shards during a cleanup
+       *        but that have not been read yet, only used by the consumer.
+       */
+      EventsInformation _backlog;
+
+      /**
+       * \brief set when the backlog has events that were not read yet
+       *        so we can tell without taking the consumer lock.
+       */
+      std::atomic<bool> _hasBacklog = false;
+
+      /**
+       * \brief the memory that holds the backlog.
+       */
+      Arena* _backlogMemory;
+
+      /**
+       * \brief the memory that will hold the backlog after the next cleanup.
+       */
+      Arena* _spareBacklogMemory;
+
+      /**
+       * \brief the epochs we took from the shards while draining them.
+       */
+      typedef std::vector<std::pair<Shard*, ShardEpoch*>> DrainedEpochs;
+
+      /**
+       * \brief take all the events from all the shards and merge them with the backlog
+       *        the backlog is then ordered from the oldest to the newest.
+       *        the lock must be held and the drained epochs must be released once we are done with the events.
+       * \return the epochs we drained.
+       */
+      DrainedEpochs DrainShardsInLock();
+
+      /**
+       * \brief clear the epochs we took from the shards and give them back.
+       * \param drained the epochs we want to give back.
+       */
+      static void ReleaseDrainedInLock(DrainedEpochs& drained);
+
+      /**
+       * \brief sort events information by TimeMillisecondsUtc
+       * \param lhs the lhs element we are checking.
+       * \param rhs the rhs element we are checking.
+       * \return if lhs is older than rhs.
+       */
+      static bool SortInformationByTimeMillisecondsUtc(const EventInformation* lhs, const EventInformation* rhs);
 
       /**
        * \brief convert an EventAction to an un-managed IAction
@@ -108,12 +329,45 @@ namespace myoddweb
       static int ConvertEventError(const EventError& error);
 
       /**
-       * \brief check if the given information already exists in the source
-       * \param source the collection of events we will be looking in
+       * \brief the values that make an event unique, the name points to the event information
+       *        so it is only valid for as long as the event information itself.
+       */
+      struct EventKey
+      {
+        std::wstring_view Name;
+        EventAction Action;
+        bool IsFile;
+      };
+
+      /**
+       * \brief hash an event key.
+       */
+      struct EventKeyHash
+      {
+        size_t operator()(const EventKey& key) const noexcept;
+      };
+
+      /**
+       * \brief compare two event keys.
+       */
+      struct EventKeyEqual
+      {
+        bool operator()(const EventKey& lhs, const EventKey& rhs) const noexcept;
+      };
+
+      /**
+       * \brief all the event keys we already added.
+       */
+      typedef std::unordered_set<EventKey, EventKeyHash, EventKeyEqual> EventKeys;
+
+      /**
+       * \brief check if the given information was already added
+       *        if it was not then the key is added to our list of keys.
+       * \param keys the keys of the events we already added.
        * \param duplicate the event information we want to add.
-       * \return if the event information is already in the 'source'
+       * \return if the event information is already in the 'keys'
        */
-      static bool IsOlderDuplicate(const std::vector<Event*>& source, const Event& duplicate);
+      static bool IsOlderDuplicate(EventKeys& keys, const EventInformation& duplicate);
 
       /**
        * \brief go around all the renamed events and look the the ones that are 'invalid'
@@ -121,13 +375,6 @@ namespace myoddweb
        * \param source the collection of events we will be looking in
        */
       static void ValidateRenames(std::vector<Event*>& source );
-
-      /**
-       * \brief copy the current content of the events into a local variable.
-       * Then erase the current content so we can continue receiving data.
-       * \return the number of items.
-       */
-      EventsInformation* CloneEventsAndEraseCurrent();
     };
   }
 }
\ No newline at end of file
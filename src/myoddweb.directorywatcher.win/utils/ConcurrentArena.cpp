@@ -0,0 +1,163 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#include "ConcurrentArena.h"
+#include <algorithm>
+#include <cwchar>
+#include "BufferPool.h"
+
+namespace myoddweb
+{
+  namespace directorywatcher
+  {
+    ConcurrentArena::Block::Block(const size_t size) :
+      Data(BufferPool::Shared().Acquire(size)),
+      Size(size),
+      Used(0),
+      Next(nullptr)
+    {
+    }
+
+    ConcurrentArena::Block::~Block()
+    {
+      BufferPool::Shared().Release(Data);
+    }
+
+    /**
+     * \brief create the arena, no memory is allocated until we need it.
+     * \param blockSize the size of each block of memory.
+     */
+    ConcurrentArena::ConcurrentArena(const size_t blockSize) :
+      _blockSize(blockSize),
+      _first(nullptr),
+      _current(nullptr)
+    {
+    }
+
+    ConcurrentArena::~ConcurrentArena()
+    {
+      auto block = _first.load();
+      while (block != nullptr)
+      {
+        const auto next = block->Next.load();
+        delete block;
+        block = next;
+      }
+    }
+
+    /**
+     * \brief get some raw memory from the arena, this is thread safe.
+     * \param size the number of bytes we want.
+     * \return the memory, aligned to 'Alignment' and valid until the arena is reset.
+     */
+    void* ConcurrentArena::Allocate(size_t size)
+    {
+      // we keep everything aligned by only giving out multiples of the alignment.
+      size = (size + Alignment - 1) & ~(Alignment - 1);
+      for (;;)
+      {
+        const auto block = _current.load(std::memory_order_acquire);
+        if (block != nullptr)
+        {
+          const auto offset = block->Used.fetch_add(size, std::memory_order_relaxed);
+          if (offset + size <= block->Size)
+          {
+            return block->Data + offset;
+          }
+        }
+
+        // the block is full, (or we do not have one yet)
+        Advance(block, size);
+      }
+    }
+
+    /**
+     * \brief move past the given block as it cannot hold the given number of bytes.
+     *        we use the next block in the chain or create a new one if need be.
+     * \param block the block that is full, (null if we have no blocks yet).
+     * \param size the number of bytes we want to allocate.
+     */
+    void ConcurrentArena::Advance(Block* block, const size_t size)
+    {
+      auto& link = block == nullptr ? _first : block->Next;
+      auto next = link.load(std::memory_order_acquire);
+      if (next == nullptr || next->Size < size)
+      {
+        // we need a new block, if another thread beats us to it
+        // then we will use theirs, (even if it is too small, we will simply come back here).
+        const auto fresh = new Block(std::max(_blockSize, size));
+        fresh->Next.store(next, std::memory_order_relaxed);
+        if (link.compare_exchange_strong(next, fresh, std::memory_order_acq_rel))
+        {
+          next = fresh;
+        }
+        else
+        {
+          delete fresh;
+        }
+      }
+
+      // move to the next block, if another thread already did, it does not matter.
+      auto expected = block;
+      _current.compare_exchange_strong(expected, next, std::memory_order_acq_rel);
+    }
+
+    /**
+     * \brief allocate a null terminated string, the content is not set
+     *        other than the null terminator.
+     * \param length the number of characters, excluding the null terminator.
+     * \return the string, valid until the arena is reset.
+     */
+    wchar_t* ConcurrentArena::AllocateString(const size_t length)
+    {
+      const auto string = static_cast<wchar_t*>(Allocate((length + 1) * sizeof(wchar_t)));
+      string[length] = L'\0';
+      return string;
+    }
+
+    /**
+     * \brief copy a string in the arena
+     * \param source the string we want to copy.
+     * \return the null terminated copy, valid until the arena is reset.
+     */
+    const wchar_t* ConcurrentArena::Copy(const std::wstring_view source)
+    {
+      const auto string = AllocateString(source.length());
+      wmemcpy(string, source.data(), source.length());
+      return string;
+    }
+
+    /**
+     * \brief release all the memory in one go, the blocks are given back to the shared pool.
+     *        This is not thread safe, no other thread can be using the arena.
+     */
+    void ConcurrentArena::Reset()
+    {
+      // we do not keep anything ourselves, an idle arena holds no memory
+      // and the next round gets its blocks back from the pool.
+      auto block = _first.load();
+      while (block != nullptr)
+      {
+        const auto next = block->Next.load();
+        delete block;
+        block = next;
+      }
+      _first = nullptr;
+      _current = nullptr;
+    }
+
+    /**
+     * \brief the number of bytes we are holding in our blocks.
+     *        This is not thread safe, no other thread can be using the arena.
+     */
+    size_t ConcurrentArena::BytesReserved() const
+    {
+      size_t reserved = 0;
+      for (auto block = _first.load(); block != nullptr; block = block->Next.load())
+      {
+        reserved += block->Size;
+      }
+      return reserved;
+    }
+  }
+}
@@ -0,0 +1,145 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#pragma once
+#include <atomic>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "../monitors/Base.h"
+
+namespace myoddweb
+{
+  namespace directorywatcher
+  {
+    /**
+     * \brief a bump allocator that more than one thread can allocate from at the same time without a lock.
+     *        Like the Arena, the memory is all released in one go when the arena is reset
+     *        but the reset itself is not thread safe, no one can be allocating at the time.
+     *        The blocks come from the shared BufferPool and go back to it once the arena is reset.
+     */
+    class ConcurrentArena final
+    {
+    public:
+      explicit ConcurrentArena(size_t blockSize = MYODDWEB_ARENA_BLOCK_SIZE);
+      ~ConcurrentArena();
+
+      ConcurrentArena(const ConcurrentArena&) = delete;
+      ConcurrentArena(ConcurrentArena&&) = delete;
+      const ConcurrentArena& operator=(const ConcurrentArena&) = delete;
+      ConcurrentArena& operator=(ConcurrentArena&&) = delete;
+
+      /**
+       * \brief the alignment of all the memory we give out.
+       */
+      static constexpr size_t Alignment = alignof(long long);
+
+      /**
+       * \brief get some raw memory from the arena, this is thread safe.
+       * \param size the number of bytes we want.
+       * \return the memory, aligned to 'Alignment' and valid until the arena is reset.
+       */
+      [[nodiscard]]
+      void* Allocate(size_t size);
+
+      /**
+       * \brief create an object in the arena, the destructor is never called
+       *        so we only allow objects that do not need one.
+       * \param args the arguments passed to the constructor.
+       * \return the newly created object, valid until the arena is reset.
+       */
+      template<typename T, typename... Args>
+      [[nodiscard]]
+      T* Create(Args&&... args)
+      {
+        static_assert(std::is_trivially_destructible<T>::value, "Objects in the arena are never destroyed.");
+        static_assert(alignof(T) <= Alignment, "The object alignment is not supported.");
+        return new (Allocate(sizeof(T))) T(std::forward<Args>(args)...);
+      }
+
+      /**
+       * \brief allocate a null terminated string, the content is not set
+       *        other than the null terminator.
+       * \param length the number of characters, excluding the null terminator.
+       * \return the string, valid until the arena is reset.
+       */
+      [[nodiscard]]
+      wchar_t* AllocateString(size_t length);
+
+      /**
+       * \brief copy a string in the arena
+       * \param source the string we want to copy.
+       * \return the null terminated copy, valid until the arena is reset.
+       */
+      [[nodiscard]]
+      const wchar_t* Copy(std::wstring_view source);
+
+      /**
+       * \brief release all the memory in one go, the blocks are given back to the shared pool.
+       *        This is not thread safe, no other thread can be using the arena.
+       */
+      void Reset();
+
+      /**
+       * \brief the number of bytes we are holding in our blocks.
+       *        This is not thread safe, no other thread can be using the arena.
+       */
+      [[nodiscard]]
+      size_t BytesReserved() const;
+
+    private:
+      /**
+       * \brief one contiguous block of memory from the shared pool, the blocks are chained together.
+       */
+      struct Block
+      {
+        explicit Block(size_t size);
+        ~Block();
+
+        Block(const Block&) = delete;
+        Block(Block&&) = delete;
+        const Block& operator=(const Block&) = delete;
+        Block& operator=(Block&&) = delete;
+
+        unsigned char* const Data;
+        const size_t Size;
+
+        /**
+         * \brief the number of bytes used, this can go past the size
+         *        when more than one thread try to use the last few bytes.
+         */
+        std::atomic<size_t> Used;
+
+        /**
+         * \brief the next block in the chain.
+         */
+        std::atomic<Block*> Next;
+      };
+
+      /**
+       * \brief move past the given block as it cannot hold the given number of bytes.
+       *        we use the next block in the chain or create a new one if need be.
+       * \param block the block that is full, (null if we have no blocks yet).
+       * \param size the number of bytes we want to allocate.
+       */
+      void Advance(Block* block, size_t size);
+
+      /**
+       * \brief the size of a normal block.
+       */
+      const size_t _blockSize;
+
+      /**
+       * \brief the first block in the chain.
+       */
+      std::atomic<Block*> _first;
+
+      /**
+       * \brief the block we are currently allocating from.
+       */
+      std::atomic<Block*> _current;
+    };
+  }
+}
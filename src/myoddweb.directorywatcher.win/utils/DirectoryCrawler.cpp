@@ -0,0 +1,114 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#include "DirectoryCrawler.h"
+#include <algorithm>
+#include "Instrumentor.h"
+#include "Io.h"
+#include "Lock.h"
+#include "Logger.h"
+#include "LogLevel.h"
+
+namespace myoddweb:: directorywatcher
+{
+  /**
+   * \brief create the crawler and start the threads.
+   * \param numberOfThreads the number of folders we can list at the same time.
+   */
+  DirectoryCrawler::DirectoryCrawler(const unsigned int numberOfThreads) :
+    _executor((std::max)(1u, numberOfThreads)),
+    _pendingFolders(0),
+    _numberOfFolders(0)
+  {
+  }
+
+  /**
+   * \brief look at the folder and all its sub-folders, returns once they have all been looked at.
+   * \param folder the folder we are starting from.
+   * \param enter called before we list a folder.
+   * \param found called with the sub-folders of a folder.
+   */
+  void DirectoryCrawler::Crawl(const std::wstring& folder, const TEnter& enter, const TFound& found)
+  {
+    MYODDWEB_PROFILE_FUNCTION();
+    Post(folder, enter, found);
+
+    std::unique_lock<MYODDWEB_MUTEX> lock(_lock);
+    _done.wait(lock, [this] { return _pendingFolders == 0; });
+  }
+
+  /**
+   * \brief queue a folder to be looked at by one of the threads.
+   * \param folder the folder we are queuing.
+   * \param enter called before we list the folder.
+   * \param found called with the sub-folders of the folder.
+   */
+  void DirectoryCrawler::Post(const std::wstring& folder, const TEnter& enter, const TFound& found)
+  {
+    {
+      MYODDWEB_LOCK(_lock);
+      ++_pendingFolders;
+    }
+
+    // the callbacks belong to the caller of Crawl( ... ) that is waiting for us.
+    if (!_executor.Post([this, folder, &enter, &found] { Visit(folder, enter, found); }))
+    {
+      Done();
+    }
+  }
+
+  /**
+   * \brief look at a single folder and queue its sub-folders.
+   * \param folder the folder we are looking at.
+   * \param enter called before we list the folder.
+   * \param found called with the sub-folders of the folder.
+   */
+  void DirectoryCrawler::Visit(const std::wstring& folder, const TEnter& enter, const TFound& found)
+  {
+    try
+    {
+      if (enter(folder))
+      {
+        const auto subFolders = Io::GetAllSubFolders(folder);
+        ++_numberOfFolders;
+        if (found(folder, subFolders))
+        {
+          for (const auto& subFolder : subFolders)
+          {
+            Post(subFolder, enter, found);
+          }
+        }
+      }
+    }
+    catch (const std::exception& e)
+    {
+      // we cannot let this go, otherwise the caller would wait for this folder forever.
+      Logger::Log(LogLevel::Error, L"Caught exception '%hs' trying to look at folder '%ls'.", e.what(), folder.c_str());
+    }
+    catch (...)
+    {
+      Logger::Log(LogLevel::Error, L"Caught an unknown exception trying to look at folder '%ls'.", folder.c_str());
+    }
+    Done();
+  }
+
+  /**
+   * \brief a queued folder has been looked at, wake the caller if it was the last one.
+   */
+  void DirectoryCrawler::Done()
+  {
+    MYODDWEB_LOCK(_lock);
+    if (--_pendingFolders == 0)
+    {
+      _done.notify_all();
+    }
+  }
+
+  /**
+   * \brief the number of folders we listed.
+   */
+  long long DirectoryCrawler::NumberOfFolders() const
+  {
+    return _numberOfFolders;
+  }
+}
@@ -0,0 +1,102 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "../monitors/Base.h"
+#include "Threads/Executor.h"
+
+namespace myoddweb:: directorywatcher
+{
+  /**
+   * \brief look for all the sub-folders of a folder, a few folders at a time.
+   *        Each folder is listed by one of the threads and the sub-folders it contains
+   *        are queued so an idle thread can take them, (see threads::Executor).
+   *        The callbacks are called from the crawler threads, in no particular order.
+   */
+  class DirectoryCrawler final
+  {
+  public:
+    /**
+     * \brief called when we reach a folder, before we list it.
+     *        return false if we do not want to look inside that folder.
+     */
+    typedef std::function<bool(const std::wstring& folder)> TEnter;
+
+    /**
+     * \brief called once we have listed the sub-folders of a folder.
+     *        return false if we do not want to look inside those sub-folders.
+     */
+    typedef std::function<bool(const std::wstring& folder, const std::vector<std::wstring>& subFolders)> TFound;
+
+    explicit DirectoryCrawler(unsigned int numberOfThreads = MYODDWEB_CRAWLER_THREADS);
+    ~DirectoryCrawler() = default;
+
+    DirectoryCrawler(const DirectoryCrawler&) = delete;
+    DirectoryCrawler(DirectoryCrawler&&) = delete;
+    const DirectoryCrawler& operator=(const DirectoryCrawler&) = delete;
+    DirectoryCrawler& operator=(DirectoryCrawler&&) = delete;
+
+    /**
+     * \brief look at the folder and all its sub-folders, returns once they have all been looked at.
+     * \param folder the folder we are starting from.
+     * \param enter called before we list a folder.
+     * \param found called with the sub-folders of a folder.
+     */
+    void Crawl(const std::wstring& folder, const TEnter& enter, const TFound& found);
+
+    /**
+     * \brief the number of folders we listed.
+     */
+    [[nodiscard]]
+    long long NumberOfFolders() const;
+
+  private:
+    /**
+     * \brief look at a single folder and queue its sub-folders.
+     * \param folder the folder we are looking at.
+     * \param enter called before we list the folder.
+     * \param found called with the sub-folders of the folder.
+     */
+    void Visit(const std::wstring& folder, const TEnter& enter, const TFound& found);
+
+    /**
+     * \brief queue a folder to be looked at by one of the threads.
+     * \param folder the folder we are queuing.
+     * \param enter called before we list the folder.
+     * \param found called with the sub-folders of the folder.
+     */
+    void Post(const std::wstring& folder, const TEnter& enter, const TFound& found);
+
+    /**
+     * \brief a queued folder has been looked at, wake the caller if it was the last one.
+     */
+    void Done();
+
+    /**
+     * \brief the threads listing the folders.
+     */
+    threads::Executor _executor;
+
+    /**
+     * \brief the number of folders queued but not yet looked at.
+     */
+    long long _pendingFolders;
+
+    /**
+     * \brief the number of folders we listed.
+     */
+    std::atomic<long long> _numberOfFolders;
+
+    /**
+     * \brief the lock and condition used to wait for the pending folders.
+     */
+    MYODDWEB_MUTEX _lock;
+    std::condition_variable _done;
+  };
+}
@@ -0,0 +1,150 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#include "EntryCache.h"
+#include "Lock.h"
+
+namespace myoddweb:: directorywatcher
+{
+  /**
+   * \brief create the cache, no entries are known.
+   * \param maxNumberOfEntries the maximum number of entries we keep.
+   */
+  EntryCache::EntryCache(const size_t maxNumberOfEntries) :
+    _maxNumberOfEntries(maxNumberOfEntries),
+    _numberOfHits(0),
+    _numberOfMisses(0)
+  {
+  }
+
+  /**
+   * \brief look for an entry, if found it becomes the most recently used.
+   * \param path the path of the entry, relative to the monitor.
+   * \param isFile if the entry is a file or a directory, only set if found.
+   * \return if we know this entry.
+   */
+  bool EntryCache::TryGet(const std::wstring_view path, bool& isFile)
+  {
+    MYODDWEB_LOCK(_lock);
+    const auto it = _index.find(path);
+    if (it == _index.end())
+    {
+      ++_numberOfMisses;
+      return false;
+    }
+
+    // move it to the front, the iterators and the path are not changed.
+    _entries.splice(_entries.begin(), _entries, it->second);
+    isFile = it->second->IsFile;
+    ++_numberOfHits;
+    return true;
+  }
+
+  /**
+   * \brief add or update an entry, it becomes the most recently used.
+   * \param path the path of the entry, relative to the monitor.
+   * \param isFile if the entry is a file or a directory.
+   */
+  void EntryCache::Set(const std::wstring_view path, const bool isFile)
+  {
+    if (_maxNumberOfEntries == 0 || path.empty())
+    {
+      return;
+    }
+
+    MYODDWEB_LOCK(_lock);
+    const auto it = _index.find(path);
+    if (it != _index.end())
+    {
+      it->second->IsFile = isFile;
+      _entries.splice(_entries.begin(), _entries, it->second);
+      return;
+    }
+
+    _entries.push_front({ std::wstring(path), isFile });
+    _index.emplace(_entries.front().Path, _entries.begin());
+
+    // remove the one we used the longest time ago.
+    if (_entries.size() > _maxNumberOfEntries)
+    {
+      _index.erase(_entries.back().Path);
+      _entries.pop_back();
+    }
+  }
+
+  /**
+   * \brief forget an entry, if it was a directory we also forget everything in it.
+   * \param path the path of the entry, relative to the monitor.
+   */
+  void EntryCache::Remove(const std::wstring_view path)
+  {
+    MYODDWEB_LOCK(_lock);
+    const auto it = _index.find(path);
+    if (it == _index.end())
+    {
+      return;
+    }
+
+    const auto entry = it->second;
+    _index.erase(it);
+    if (entry->IsFile)
+    {
+      _entries.erase(entry);
+      return;
+    }
+
+    // this is rare, so we can afford to look at all the entries.
+    for (auto child = _entries.begin(); child != _entries.end();)
+    {
+      if (IsInDirectory(child->Path, entry->Path))
+      {
+        _index.erase(child->Path);
+        child = _entries.erase(child);
+        continue;
+      }
+      ++child;
+    }
+    _entries.erase(entry);
+  }
+
+  /**
+   * \brief check if a path is inside the given directory.
+   * \param path the path we are checking.
+   * \param directory the directory.
+   * \return if the path is in the directory, (or one of its sub-directories).
+   */
+  bool EntryCache::IsInDirectory(const std::wstring_view path, const std::wstring_view directory)
+  {
+    if (path.size() <= directory.size() || path.compare(0, directory.size(), directory) != 0)
+    {
+      return false;
+    }
+    const auto separator = path[directory.size()];
+    return separator == L'\\' || separator == L'/';
+  }
+
+  /**
+   * \brief the number of entries we know about.
+   */
+  size_t EntryCache::Size() const
+  {
+    MYODDWEB_LOCK(_lock);
+    return _entries.size();
+  }
+
+  /**
+   * \brief the number of times we knew the entry.
+   */
+  long long EntryCache::NumberOfHits() const
+  {
+    return _numberOfHits;
+  }
+
+  /**
+   * \brief the number of times we did not know the entry.
+   */
+  long long EntryCache::NumberOfMisses() const
+  {
+    return _numberOfMisses;
+  }
+}
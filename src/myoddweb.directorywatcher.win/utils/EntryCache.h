@@ -0,0 +1,110 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "../monitors/Base.h"
+
+namespace myoddweb:: directorywatcher
+{
+  /**
+   * \brief remember if the entries of a monitor are files or directories
+   *        so we do not need to ask the file system for every event.
+   *        The size is limited, once full the entry used the longest time ago is removed.
+   *        This class is thread safe.
+   */
+  class EntryCache final
+  {
+  public:
+    explicit EntryCache(size_t maxNumberOfEntries = MYODDWEB_ENTRYCACHE_MAX_ENTRIES);
+    ~EntryCache() = default;
+
+    EntryCache(const EntryCache&) = delete;
+    EntryCache(EntryCache&&) = delete;
+    const EntryCache& operator=(const EntryCache&) = delete;
+    EntryCache& operator=(EntryCache&&) = delete;
+
+    /**
+     * \brief look for an entry, if found it becomes the most recently used.
+     * \param path the path of the entry, relative to the monitor.
+     * \param isFile if the entry is a file or a directory, only set if found.
+     * \return if we know this entry.
+     */
+    bool TryGet(std::wstring_view path, bool& isFile);
+
+    /**
+     * \brief add or update an entry, it becomes the most recently used.
+     * \param path the path of the entry, relative to the monitor.
+     * \param isFile if the entry is a file or a directory.
+     */
+    void Set(std::wstring_view path, bool isFile);
+
+    /**
+     * \brief forget an entry, if it was a directory we also forget everything in it.
+     * \param path the path of the entry, relative to the monitor.
+     */
+    void Remove(std::wstring_view path);
+
+    /**
+     * \brief the number of entries we know about.
+     */
+    [[nodiscard]]
+    size_t Size() const;
+
+    /**
+     * \brief the number of times we knew the entry.
+     */
+    [[nodiscard]]
+    long long NumberOfHits() const;
+
+    /**
+     * \brief the number of times we did not know the entry.
+     */
+    [[nodiscard]]
+    long long NumberOfMisses() const;
+
+  private:
+    /**
+     * \brief one known entry, the index points at the path of the entry itself.
+     */
+    struct Entry
+    {
+      std::wstring Path;
+      bool IsFile;
+    };
+
+    /**
+     * \brief check if a path is inside the given directory.
+     * \param path the path we are checking.
+     * \param directory the directory.
+     * \return if the path is in the directory, (or one of its sub-directories).
+     */
+    static bool IsInDirectory(std::wstring_view path, std::wstring_view directory);
+
+    /**
+     * \brief the maximum number of entries.
+     */
+    const size_t _maxNumberOfEntries;
+
+    mutable MYODDWEB_MUTEX _lock;
+
+    /**
+     * \brief the entries, the most recently used at the front.
+     */
+    std::list<Entry> _entries;
+
+    /**
+     * \brief the entries by path, the keys are views of the paths in the list.
+     */
+    std::unordered_map<std::wstring_view, std::list<Entry>::iterator> _index;
+
+    std::atomic<long long> _numberOfHits;
+    std::atomic<long long> _numberOfMisses;
+  };
+}
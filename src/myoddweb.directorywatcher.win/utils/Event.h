@@ -2,7 +2,6 @@
 // Florent Guelfucci licenses this file to you under the MIT license.
 // See the LICENSE file in the project root for more information.
 #pragma once
-#include <string>
 
 namespace myoddweb
 {
@@ -10,6 +9,7 @@ namespace myoddweb
   {
     /**
      * \brief unmanaged implementation of IEvent
+     *        The strings are not owned by the event, they live in the same arena as the event itself.
      */
     class Event
     {
@@ -26,14 +26,13 @@ namespace myoddweb
       }
 
       Event(const wchar_t* name, const wchar_t* oldName, const int action, const int error, const long long timeMillisecondsUtc, const bool isFile) :
-        Event()
+        Name(name),
+        OldName(oldName),
+        Action(action),
+        Error(error),
+        TimeMillisecondsUtc(timeMillisecondsUtc),
+        IsFile(isFile)
       {
-        Assign(name, oldName, action, error, timeMillisecondsUtc, isFile);
-      }
-
-      ~Event()
-      {
-        Clear();
       }
 
       // prevent copy and move
@@ -42,98 +41,22 @@ namespace myoddweb
       const Event& operator=(const Event& src) = delete;
       const Event& operator=(Event&& src) = delete;
 
-    private:
-      void Assign(const wchar_t* name, const wchar_t* oldName, const int action, const int error, const long long timeMillisecondsUtc, const bool isFile)
-      {
-        // clear the old values.
-        Clear();
-
-        // and set the values.
-        Action = action;
-        Error = error;
-        TimeMillisecondsUtc = timeMillisecondsUtc;
-        IsFile = isFile;
-
-        if (name != nullptr)
-        {
-          const auto len = wcslen(name);
-          Name = new wchar_t[len + 1];
-          wmemset(Name, L'\0', len + 1);
-          wcscpy_s(Name, len + 1, name);
-        }
-
-        if (oldName != nullptr)
-        {
-          const auto len = wcslen(oldName);
-          OldName = new wchar_t[len + 1];
-          wmemset(OldName, L'\0', len + 1);
-          wcscpy_s(OldName, len + 1, oldName);
-        }
-      }
-
-      /**
-       * \brief free all the memory
-       */
-      void Clear()
-      {
-        ClearName();
-        ClearOldName();
-      }
-
-      /**
-       * \brief free the name memory
-       */
-      void ClearName()
-      {
-        if (Name == nullptr)
-        {
-          return;
-        }
-        delete[] Name;
-        Name = nullptr;
-      }
-
-      /**
-       * \brief free the old name memory
-       */
-      void ClearOldName()
-      {
-        if (OldName == nullptr)
-        {
-          return;
-        }
-        delete[] OldName;
-        OldName = nullptr;
-      }
-
-    public:
       void MoveOldNameToName()
       {
-        // get rid of the current name
-        ClearName();
-
-        // copy one over the other
-        if (OldName != nullptr)
-        {
-          const auto len = wcslen(OldName);
-          Name = new wchar_t[len + 1];
-          wmemset(Name, L'\0', len + 1);
-          wcscpy_s(Name, len + 1, OldName);
-        }
-
-        // we can get rid of the old name
-        ClearOldName();
+        // the old name becomes the name, both point to the same arena.
+        Name = OldName;
+        OldName = nullptr;
       }
 
       /**
        * \brief The path that was changed.
        */
-      wchar_t* Name;
+      const wchar_t* Name;
 
       /**
        * \brief Extra information, (used for rename and so on).
        */
-      wchar_t* OldName;
+      const wchar_t* OldName;
 
       /**
        * \brief the action.
@@ -156,4 +79,4 @@ namespace myoddweb
       bool IsFile;
     };
   }
-}
+}
\ No newline at end of file
@@ -2,7 +2,6 @@
 // Florent Guelfucci licenses this file to you under the MIT license.
 // See the LICENSE file in the project root for more information.
 #pragma once
-#include <string>
 #include "EventAction.h"
 #include "EventError.h"
 
@@ -12,20 +11,11 @@ namespace myoddweb
   {
     /**
      * \brief Information about a file/folder event.
+     *        The strings are not owned by the event, they live in the same arena as the event itself.
      */
     class EventInformation
     {
     public:
-      EventInformation() :
-        TimeMillisecondsUtc(0),
-        Action(EventAction::Unknown),
-        Error(EventError::None ),
-        Name( nullptr ),
-        OldName( nullptr ),
-        IsFile( false )
-      {
-      }
-
       EventInformation(
         const long long timeMillisecondsUtc,
         const EventAction action,
@@ -33,15 +23,14 @@ namespace myoddweb
         const wchar_t* name,
         const wchar_t* oldName,
         const bool isFile
-      )
-      : EventInformation()
+      ) :
+        TimeMillisecondsUtc(timeMillisecondsUtc),
+        Action(action),
+        Error(error),
+        Name(name),
+        OldName(oldName),
+        IsFile(isFile)
       {
-        Assign(name, oldName, action, error, timeMillisecondsUtc, isFile);
-      }
-
-      ~EventInformation()
-      {
-        Clear();
       }
 
       EventInformation(const EventInformation&) = delete;
@@ -65,78 +54,17 @@ namespace myoddweb
       /**
        * \brief the filename/folder that was updated.
        */
-      wchar_t* Name;
+      const wchar_t* Name;
 
       /**
        * \brief the old name in the case of a rename.
        */
-      wchar_t* OldName;
+      const wchar_t* OldName;
 
       /**
      * \brief Boolean if the update is a file or a directory.
        */
       bool IsFile;
-
-    private:
-      void Assign(const wchar_t* name, const wchar_t* oldName, const EventAction action, const EventError error, const long long timeMillisecondsUtc, const bool isFile)
-      {
-        // clear the old values.
-        Clear();
-
-        // and set the values.
-        Action = action;
-        Error = error;
-        TimeMillisecondsUtc = timeMillisecondsUtc;
-        IsFile = isFile;
-
-        if (name != nullptr)
-        {
-          const auto len = wcslen(name);
-          Name = new wchar_t[len + 1];
-          wmemset(Name, L'\0', len + 1);
-          wcscpy_s(Name, len + 1, name);
-        }
-
-        if (oldName != nullptr)
-        {
-          const auto len = wcslen(oldName);
-          OldName = new wchar_t[len + 1];
-          wmemset(OldName, L'\0', len + 1);
-          wcscpy_s(OldName, len + 1, oldName);
-        }
-      }
-
-      void Clear()
-      {
-        ClearName();
-        ClearOldName();
-      }
-
-      /**
-       * \brief free the name memory
-       */
-      void ClearName()
-      {
-        if (Name == nullptr)
-        {
-          return;
-        }
-        delete[] Name;
-        Name = nullptr;
-      }
-
-      /**
-       * \brief free the old name memory
-       */
-      void ClearOldName()
-      {
-        if (OldName == nullptr)
-        {
-          return;
-        }
-        delete[] OldName;
-        OldName = nullptr;
-      }
     };
   }
 }
\ No newline at end of file
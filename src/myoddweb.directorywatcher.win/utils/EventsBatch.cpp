@@ -0,0 +1,175 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#include "EventsBatch.h"
+#include <cstring>
+#include <cwchar>
+#include "Event.h"
+
+namespace myoddweb:: directorywatcher
+{
+  EventsBatch::EventsBatch() = default;
+
+  /**
+   * \brief replace the current batch with the given events.
+   * \param events the events, from the oldest to the newest.
+   */
+  void EventsBatch::Build(const std::vector<Event*>& events)
+  {
+    // work out how much room we need first, so we only grow the memory once.
+    auto namesLength = static_cast<size_t>(0);
+    for (const auto& event : events)
+    {
+      namesLength += Length(event->Name) + 1 + Length(event->OldName) + 1;
+    }
+
+    // the memory is kept, so once we have seen a batch this size we no longer allocate.
+    _records.resize(events.size());
+    _names.resize(namesLength);
+
+    auto offset = 0;
+    auto record = _records.data();
+    for (const auto& event : events)
+    {
+      record->DateTimeUtc = event->TimeMillisecondsUtc;
+      record->Action = event->Action;
+      record->Error = event->Error;
+      record->IsFile = event->IsFile ? 1 : 0;
+
+      // the name is always there, even if it is empty.
+      record->NameOffset = offset;
+      record->NameLength = CopyName(event->Name, Length(event->Name), offset);
+
+      // but the old name is only there if we have one.
+      const auto oldNameLength = Length(event->OldName);
+      record->OldNameOffset = oldNameLength == 0 ? -1 : offset;
+      record->OldNameLength = oldNameLength == 0 ? 0 : CopyName(event->OldName, oldNameLength, offset);
+      ++record;
+    }
+
+    // the missing old names did not use any room.
+    _names.resize(offset);
+  }
+
+  /**
+   * \brief the length of a name that might be null.
+   * \param name the name we are checking.
+   * \return the number of characters, excluding the null terminator.
+   */
+  size_t EventsBatch::Length(const wchar_t* name)
+  {
+    return name == nullptr ? 0 : std::wcslen(name);
+  }
+
+  /**
+   * \brief copy a name and its null terminator in the names block.
+   * \param name the name we are adding, can be null if the length is 0.
+   * \param length the number of characters in the name.
+   * \param offset where we are adding the name, moved past the null terminator.
+   * \return the number of characters in the name.
+   */
+  int EventsBatch::CopyName(const wchar_t* name, const size_t length, int& offset)
+  {
+    if (length > 0)
+    {
+      std::memcpy(_names.data() + offset, name, length * sizeof(wchar_t));
+    }
+    _names[offset + length] = L'\0';
+    offset += static_cast<int>(length) + 1;
+    return static_cast<int>(length);
+  }
+
+  /**
+   * \brief remove all the records and names, the memory is kept for the next batch.
+   */
+  void EventsBatch::Clear()
+  {
+    _records.clear();
+    _names.clear();
+  }
+
+  /**
+   * \brief the records, valid until the next Build( ... ) or Clear( ... )
+   */
+  const EventRecord* EventsBatch::Records() const
+  {
+    return _records.data();
+  }
+
+  /**
+   * \brief the number of records in the batch.
+   */
+  int EventsBatch::NumberOfRecords() const
+  {
+    return static_cast<int>(_records.size());
+  }
+
+  /**
+   * \brief the names block, valid until the next Build( ... ) or Clear( ... )
+   */
+  const wchar_t* EventsBatch::Names() const
+  {
+    return _names.data();
+  }
+
+  /**
+   * \brief the number of characters in the names block, including all the null terminators.
+   */
+  int EventsBatch::NamesLength() const
+  {
+    return static_cast<int>(_names.size());
+  }
+
+  /**
+   * \brief copy as many records as we can, and their names, to the given buffers.
+   *        The offsets of the copied records are relative to the given names buffer.
+   * \param first the index of the first record we want to copy.
+   * \param events where we are copying the records to.
+   * \param eventsCapacity the number of records we can copy.
+   * \param names where we are copying the names to.
+   * \param namesCapacity the number of characters we can copy.
+   * \return the number of records copied.
+   */
+  int EventsBatch::CopyTo(const int first, EventRecord* events, const int eventsCapacity, wchar_t* names, const int namesCapacity) const
+  {
+    const auto numberOfRecords = NumberOfRecords();
+    if (first < 0 || first >= numberOfRecords || eventsCapacity <= 0)
+    {
+      return 0;
+    }
+
+    // the names of a record are right after the names of the previous record
+    // so the names of a run of records are all in one block.
+    const auto namesStart = _records[first].NameOffset;
+    auto last = first;
+    auto namesEnd = namesStart;
+    while (last < numberOfRecords && last - first < eventsCapacity)
+    {
+      const auto next = last + 1 < numberOfRecords ? _records[last + 1].NameOffset : NamesLength();
+      if (next - namesStart > namesCapacity)
+      {
+        break;
+      }
+      namesEnd = next;
+      ++last;
+    }
+
+    const auto count = last - first;
+    if (count == 0)
+    {
+      return 0;
+    }
+
+    std::memcpy(names, _names.data() + namesStart, static_cast<size_t>(namesEnd - namesStart) * sizeof(wchar_t));
+    for (auto i = 0; i < count; ++i)
+    {
+      events[i] = _records[first + i];
+      events[i].NameOffset -= namesStart;
+      if (events[i].OldNameOffset != -1)
+      {
+        events[i].OldNameOffset -= namesStart;
+      }
+    }
+    return count;
+  }
+}
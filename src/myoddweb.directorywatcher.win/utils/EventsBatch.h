@@ -0,0 +1,105 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#pragma once
+#include <cstddef>
+#include <vector>
+
+#include "../monitors/Callbacks.h"
+
+namespace myoddweb:: directorywatcher
+{
+  class Event;
+
+  /**
+   * \brief a batch of events laid out as one array of fixed size records
+   *        with all the names in one shared block, so they can be published in a single call.
+   *        The memory is kept between batches so building the next one does not need the heap.
+   *        This class is not thread safe, the owner must make sure that only one thread uses it at a time.
+   */
+  class EventsBatch final
+  {
+  public:
+    EventsBatch();
+    ~EventsBatch() = default;
+
+    EventsBatch(const EventsBatch&) = delete;
+    EventsBatch(EventsBatch&&) = delete;
+    const EventsBatch& operator=(const EventsBatch&) = delete;
+    EventsBatch& operator=(EventsBatch&&) = delete;
+
+    /**
+     * \brief replace the current batch with the given events.
+     * \param events the events, from the oldest to the newest.
+     */
+    void Build(const std::vector<Event*>& events);
+
+    /**
+     * \brief remove all the records and names, the memory is kept for the next batch.
+     */
+    void Clear();
+
+    /**
+     * \brief the records, valid until the next Build( ... ) or Clear( ... )
+     */
+    [[nodiscard]]
+    const EventRecord* Records() const;
+
+    /**
+     * \brief the number of records in the batch.
+     */
+    [[nodiscard]]
+    int NumberOfRecords() const;
+
+    /**
+     * \brief the names block, valid until the next Build( ... ) or Clear( ... )
+     */
+    [[nodiscard]]
+    const wchar_t* Names() const;
+
+    /**
+     * \brief the number of characters in the names block, including all the null terminators.
+     */
+    [[nodiscard]]
+    int NamesLength() const;
+
+    /**
+     * \brief copy as many records as we can, and their names, to the given buffers.
+     *        The offsets of the copied records are relative to the given names buffer.
+     * \param first the index of the first record we want to copy.
+     * \param events where we are copying the records to.
+     * \param eventsCapacity the number of records we can copy.
+     * \param names where we are copying the names to.
+     * \param namesCapacity the number of characters we can copy.
+     * \return the number of records copied.
+     */
+    int CopyTo(int first, EventRecord* events, int eventsCapacity, wchar_t* names, int namesCapacity) const;
+
+  private:
+    /**
+     * \brief the length of a name that might be null.
+     * \param name the name we are checking.
+     * \return the number of characters, excluding the null terminator.
+     */
+    static size_t Length(const wchar_t* name);
+
+    /**
+     * \brief copy a name and its null terminator in the names block.
+     * \param name the name we are adding, can be null if the length is 0.
+     * \param length the number of characters in the name.
+     * \param offset where we are adding the name, moved past the null terminator.
+     * \return the number of characters in the name.
+     */
+    int CopyName(const wchar_t* name, size_t length, int& offset);
+
+    /**
+     * \brief all the records.
+     */
+    std::vector<EventRecord> _records;
+
+    /**
+     * \brief all the names, one after the other.
+     */
+    std::vector<wchar_t> _names;
+  };
+}
@@ -0,0 +1,256 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#include "EventsCoalescer.h"
+#include <string>
+#include "Instrumentor.h"
+
+namespace myoddweb:: directorywatcher
+{
+  /**
+   * \brief the index of a slot that does not exist.
+   */
+  static constexpr auto npos = static_cast<size_t>(-1);
+
+  /**
+   * \brief replace the events with their net effect, the remaining events are still in time order.
+   * \param events the events, from the oldest to the newest.
+   * \param memory the arena that will hold the events we need to create.
+   */
+  void EventsCoalescer::Coalesce(std::vector<const EventInformation*>& events, Arena& memory)
+  {
+    MYODDWEB_PROFILE_FUNCTION();
+
+    _slots.clear();
+    _latest.clear();
+    _slots.reserve(events.size());
+    for (const auto information : events)
+    {
+      if (!CanCoalesce(*information))
+      {
+        _slots.push_back({ information, npos, true });
+        continue;
+      }
+
+      switch (information->Action)
+      {
+      case EventAction::Touched:
+        AddTouched(information);
+        break;
+
+      case EventAction::Removed:
+        AddRemoved(information, memory);
+        break;
+
+      case EventAction::Renamed:
+        AddRenamed(information, memory);
+        break;
+
+      default:
+        Push(information);
+        break;
+      }
+    }
+
+    // a newer event is always added after the older ones, so they are still in time order.
+    events.clear();
+    for (const auto& slot : _slots)
+    {
+      if (slot.Live)
+      {
+        events.push_back(slot.Information);
+      }
+    }
+  }
+
+  /**
+   * \brief check if an event can be combined with the others.
+   * \param information the event we are checking.
+   * \return if we can change that event.
+   */
+  bool EventsCoalescer::CanCoalesce(const EventInformation& information)
+  {
+    if (information.Error != EventError::None || information.Name == nullptr || *information.Name == L'\0')
+    {
+      return false;
+    }
+
+    // a rename without an old name will be changed to something else later.
+    return information.Action != EventAction::Renamed || (information.OldName != nullptr && *information.OldName != L'\0');
+  }
+
+  /**
+   * \brief the newest event of a path.
+   * \param key the path we are looking for.
+   * \return the index of the slot or npos if we do not have any.
+   */
+  size_t EventsCoalescer::Latest(const Key& key) const
+  {
+    const auto latest = _latest.find(key);
+    return latest == _latest.end() ? npos : latest->second;
+  }
+
+  /**
+   * \brief set, (or forget), the newest event of a path.
+   * \param key the path.
+   * \param index the index of the slot or npos to forget it.
+   */
+  void EventsCoalescer::SetLatest(const Key& key, const size_t index)
+  {
+    if (index == npos)
+    {
+      _latest.erase(key);
+      return;
+    }
+    _latest[key] = index;
+  }
+
+  /**
+   * \brief add an event as the newest event of its path.
+   * \param information the event.
+   */
+  void EventsCoalescer::Push(const EventInformation* information)
+  {
+    const Key key{ information->Name, information->IsFile };
+    _slots.push_back({ information, Latest(key), true });
+    _latest[key] = _slots.size() - 1;
+  }
+
+  /**
+   * \brief a path was touched, (it is still added if it was added).
+   * \param information the event.
+   */
+  void EventsCoalescer::AddTouched(const EventInformation* information)
+  {
+    const auto latest = Latest({ information->Name, information->IsFile });
+    if (latest != npos && _slots[latest].Information->Action == EventAction::Added)
+    {
+      return;
+    }
+    Push(information);
+  }
+
+  /**
+   * \brief a path was removed, it cancels what happened to that path since it was added.
+   * \param information the event.
+   * \param memory the arena that will hold the events we need to create.
+   */
+  void EventsCoalescer::AddRemoved(const EventInformation* information, Arena& memory)
+  {
+    const Key key{ information->Name, information->IsFile };
+    auto current = Latest(key);
+    while (current != npos)
+    {
+      auto& slot = _slots[current];
+      switch (slot.Information->Action)
+      {
+      case EventAction::Touched:
+        // the changes do not matter anymore.
+        slot.Live = false;
+        current = slot.Previous;
+        continue;
+
+      case EventAction::Added:
+        // it was added and removed, so nothing happened.
+        slot.Live = false;
+        SetLatest(key, slot.Previous);
+        return;
+
+      case EventAction::Renamed:
+        // what was removed is the path before the rename.
+        slot.Live = false;
+        SetLatest(key, slot.Previous);
+        Push(memory.Create<EventInformation>(
+          information->TimeMillisecondsUtc,
+          EventAction::Removed,
+          EventError::None,
+          slot.Information->OldName,
+          L"",
+          information->IsFile));
+        return;
+
+      default:
+        break;
+      }
+      break;
+    }
+
+    SetLatest(key, current);
+    Push(information);
+  }
+
+  /**
+   * \brief a path was renamed, it continues the event that gave us the old name.
+   * \param information the event.
+   * \param memory the arena that will hold the events we need to create.
+   */
+  void EventsCoalescer::AddRenamed(const EventInformation* information, Arena& memory)
+  {
+    // the old name does not exist anymore.
+    const Key oldKey{ information->OldName, information->IsFile };
+    const auto previous = Latest(oldKey);
+    _latest.erase(oldKey);
+    if (previous == npos)
+    {
+      Push(information);
+      return;
+    }
+
+    auto& slot = _slots[previous];
+    switch (slot.Information->Action)
+    {
+    case EventAction::Added:
+      // it was added with the new name.
+      slot.Live = false;
+      Push(memory.Create<EventInformation>(
+        information->TimeMillisecondsUtc,
+        EventAction::Added,
+        EventError::None,
+        information->Name,
+        L"",
+        information->IsFile));
+      return;
+
+    case EventAction::Renamed:
+      slot.Live = false;
+      if (std::wstring_view(slot.Information->OldName) == std::wstring_view(information->Name))
+      {
+        // it was renamed back to what it was.
+        return;
+      }
+      Push(memory.Create<EventInformation>(
+        information->TimeMillisecondsUtc,
+        EventAction::Renamed,
+        EventError::None,
+        information->Name,
+        slot.Information->OldName,
+        information->IsFile));
+      return;
+
+    default:
+      Push(information);
+      return;
+    }
+  }
+
+  /**
+   * \brief create the hash of a key
+   * \param key the key we want to hash
+   * \return the hash value
+   */
+  size_t EventsCoalescer::KeyHash::operator()(const Key& key) const noexcept
+  {
+    return std::hash<std::wstring_view>()(key.Name) ^ (key.IsFile ? 1 : 0);
+  }
+
+  /**
+   * \brief check if two keys are the same
+   * \param lhs the lhs element we are checking.
+   * \param rhs the rhs element we are checking.
+   * \return if both keys are the same.
+   */
+  bool EventsCoalescer::KeyEqual::operator()(const Key& lhs, const Key& rhs) const noexcept
+  {
+    return lhs.IsFile == rhs.IsFile && lhs.Name == rhs.Name;
+  }
+}
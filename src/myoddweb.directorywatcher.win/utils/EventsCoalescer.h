@@ -0,0 +1,145 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#pragma once
+#include <cstddef>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Arena.h"
+#include "EventInformation.h"
+
+namespace myoddweb:: directorywatcher
+{
+  /**
+   * \brief reduce the events of each path to their net effect.
+   *        - Added then Removed cancel each other, (as well as anything in between).
+   *        - Added then Touched is still Added.
+   *        - Touched then Removed is Removed.
+   *        - Renamed A to B then B to C is Renamed A to C, and nothing at all if C is A.
+   *        - Added A then Renamed A to B is Added B and Renamed A to B then Removed B is Removed A.
+   *        Events with an error are never changed.
+   *        The memory used is kept so it can be reused by the next call.
+   */
+  class EventsCoalescer final
+  {
+  public:
+    EventsCoalescer() = default;
+    ~EventsCoalescer() = default;
+
+    EventsCoalescer(const EventsCoalescer&) = delete;
+    EventsCoalescer(EventsCoalescer&&) = delete;
+    const EventsCoalescer& operator=(const EventsCoalescer&) = delete;
+    EventsCoalescer& operator=(EventsCoalescer&&) = delete;
+
+    /**
+     * \brief replace the events with their net effect, the remaining events are still in time order.
+     * \param events the events, from the oldest to the newest.
+     * \param memory the arena that will hold the events we need to create.
+     */
+    void Coalesce(std::vector<const EventInformation*>& events, Arena& memory);
+
+  private:
+    /**
+     * \brief one of the events we are keeping, (unless it is cancelled by a newer one).
+     */
+    struct Slot
+    {
+      const EventInformation* Information;
+
+      /**
+       * \brief the previous event of the same path, if any.
+       */
+      size_t Previous;
+
+      /**
+       * \brief if the event is still part of the net effect.
+       */
+      bool Live;
+    };
+
+    /**
+     * \brief the path of an event and if it is a file or a directory.
+     *        the name points to the event information, so it is valid for as long as the event is.
+     */
+    struct Key
+    {
+      std::wstring_view Name;
+      bool IsFile;
+    };
+
+    /**
+     * \brief hash a key.
+     */
+    struct KeyHash
+    {
+      size_t operator()(const Key& key) const noexcept;
+    };
+
+    /**
+     * \brief compare two keys.
+     */
+    struct KeyEqual
+    {
+      bool operator()(const Key& lhs, const Key& rhs) const noexcept;
+    };
+
+    /**
+     * \brief check if an event can be combined with the others.
+     * \param information the event we are checking.
+     * \return if we can change that event.
+     */
+    static bool CanCoalesce(const EventInformation& information);
+
+    /**
+     * \brief the newest event of a path.
+     * \param key the path we are looking for.
+     * \return the index of the slot or npos if we do not have any.
+     */
+    size_t Latest(const Key& key) const;
+
+    /**
+     * \brief set, (or forget), the newest event of a path.
+     * \param key the path.
+     * \param index the index of the slot or npos to forget it.
+     */
+    void SetLatest(const Key& key, size_t index);
+
+    /**
+     * \brief add an event as the newest event of its path.
+     * \param information the event.
+     */
+    void Push(const EventInformation* information);
+
+    /**
+     * \brief a path was touched, (it is still added if it was added).
+     * \param information the event.
+     */
+    void AddTouched(const EventInformation* information);
+
+    /**
+     * \brief a path was removed, it cancels what happened to that path since it was added.
+     * \param information the event.
+     * \param memory the arena that will hold the events we need to create.
+     */
+    void AddRemoved(const EventInformation* information, Arena& memory);
+
+    /**
+     * \brief a path was renamed, it continues the event that gave us the old name.
+     * \param information the event.
+     * \param memory the arena that will hold the events we need to create.
+     */
+    void AddRenamed(const EventInformation* information, Arena& memory);
+
+    /**
+     * \brief the events, cancelled or not, in the order they were added.
+     */
+    std::vector<Slot> _slots;
+
+    /**
+     * \brief the newest slot of each path.
+     */
+    std::unordered_map<Key, size_t, KeyHash, KeyEqual> _latest;
+  };
+}
@@ -0,0 +1,115 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#include "EventsMerger.h"
+#include <algorithm>
+#include <limits>
+#include "Collector.h"
+#include "Instrumentor.h"
+
+namespace myoddweb:: directorywatcher
+{
+  /**
+   * \brief merge the runs of events into one list ordered by time.
+   *        For the same time the events of an earlier run come first and the events of a run keep their order.
+   * \param events all the runs, one after the other, they are merged in place.
+   * \param runs the index of the first event of each run, in order.
+   */
+  void EventsMerger::Merge(std::vector<Event*>& events, const std::vector<size_t>& runs)
+  {
+    MYODDWEB_PROFILE_FUNCTION();
+
+    _cursors.clear();
+    for (size_t i = 0; i < runs.size(); ++i)
+    {
+      const auto start = runs[i];
+      const auto end = i + 1 < runs.size() ? runs[i + 1] : events.size();
+      if (start >= end)
+      {
+        continue;
+      }
+
+      // the runs should already be in order, but we cannot merge them if they are not.
+      if (!std::is_sorted(events.begin() + start, events.begin() + end, Collector::SortByTimeMillisecondsUtc))
+      {
+        std::stable_sort(events.begin() + start, events.begin() + end, Collector::SortByTimeMillisecondsUtc);
+      }
+      _cursors.push_back({ events[start]->TimeMillisecondsUtc, start, end });
+    }
+
+    // nothing to merge.
+    const auto numberOfRuns = _cursors.size();
+    if (numberOfRuns < 2)
+    {
+      return;
+    }
+
+    // build the tree, the sentinel wins every match so each run replaces it
+    // as it is played, once all the runs are played the sentinel is gone.
+    _cursors.push_back({ (std::numeric_limits<long long>::min)(), 0, 0 });
+    _tree.assign(numberOfRuns, numberOfRuns);
+    for (auto run = numberOfRuns; run > 0; --run)
+    {
+      Replay(run - 1);
+    }
+
+    // the sentinel now loses every match, an empty run becomes the sentinel.
+    const Cursor done = { (std::numeric_limits<long long>::max)(), (std::numeric_limits<size_t>::max)(), 0 };
+    _cursors.back() = done;
+
+    const auto numberOfEvents = events.size() - runs.front();
+    _merged.clear();
+    _merged.reserve(numberOfEvents);
+    for (size_t i = 0; i < numberOfEvents; ++i)
+    {
+      const auto winner = _tree[0];
+      auto& cursor = _cursors[winner];
+      _merged.push_back(events[cursor.Position]);
+      if (++cursor.Position == cursor.End)
+      {
+        // that run is done.
+        cursor = done;
+      }
+      else
+      {
+        cursor.Time = events[cursor.Position]->TimeMillisecondsUtc;
+      }
+      Replay(winner);
+    }
+
+    // the events that were given to us, (if any), before the first run are not moved.
+    std::copy(_merged.begin(), _merged.end(), events.begin() + runs.front());
+  }
+
+  /**
+   * \brief check if the next event of a cursor must come before the next event of another.
+   *        the runs are one after the other, so for the same time the lowest position
+   *        is the one of the earliest run, or the earliest in the run.
+   * \param lhs the first cursor.
+   * \param rhs the other cursor.
+   * \return if the lhs comes first.
+   */
+  bool EventsMerger::IsBefore(const Cursor& lhs, const Cursor& rhs)
+  {
+    return lhs.Time != rhs.Time ? lhs.Time < rhs.Time : lhs.Position < rhs.Position;
+  }
+
+  /**
+   * \brief play the matches of a run from its leaf to the top of the tree
+   *        after its cursor changed, the overall winner ends up at the top.
+   * \param run the run that changed.
+   */
+  void EventsMerger::Replay(size_t run)
+  {
+    const auto numberOfRuns = _tree.size();
+    for (auto node = (run + numberOfRuns) / 2; node > 0; node /= 2)
+    {
+      // the loser stays at that node and the winner plays the next match.
+      if (IsBefore(_cursors[_tree[node]], _cursors[run]))
+      {
+        std::swap(run, _tree[node]);
+      }
+    }
+    _tree[0] = run;
+  }
+}
@@ -0,0 +1,79 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "Event.h"
+
+namespace myoddweb:: directorywatcher
+{
+  /**
+   * \brief merge runs of events, each already ordered by time, into one list ordered by time.
+   *        This uses a loser tree, so it is O(n log k), for k runs, rather than sorting everything again.
+   *        The memory used for the merge is kept so it can be reused by the next merge.
+   */
+  class EventsMerger final
+  {
+  public:
+    EventsMerger() = default;
+    ~EventsMerger() = default;
+
+    EventsMerger(const EventsMerger&) = delete;
+    EventsMerger(EventsMerger&&) = delete;
+    const EventsMerger& operator=(const EventsMerger&) = delete;
+    EventsMerger& operator=(EventsMerger&&) = delete;
+
+    /**
+     * \brief merge the runs of events into one list ordered by time.
+     *        For the same time the events of an earlier run come first and the events of a run keep their order.
+     * \param events all the runs, one after the other, they are merged in place.
+     * \param runs the index of the first event of each run, in order.
+     */
+    void Merge(std::vector<Event*>& events, const std::vector<size_t>& runs);
+
+  private:
+    /**
+     * \brief the next event of a run, its time and the end of that run.
+     *        the time is kept here so we do not need to look at the event itself to compare.
+     */
+    struct Cursor
+    {
+      long long Time;
+      size_t Position;
+      size_t End;
+    };
+
+    /**
+     * \brief check if the next event of a cursor must come before the next event of another.
+     *        the runs are one after the other, so for the same time the lowest position
+     *        is the one of the earliest run, or the earliest in the run.
+     * \param lhs the first cursor.
+     * \param rhs the other cursor.
+     * \return if the lhs comes first.
+     */
+    static bool IsBefore(const Cursor& lhs, const Cursor& rhs);
+
+    /**
+     * \brief play the matches of a run from its leaf to the top of the tree
+     *        after its cursor changed, the overall winner ends up at the top.
+     * \param run the run that changed.
+     */
+    void Replay(size_t run);
+
+    /**
+     * \brief the cursor of each run, with one extra cursor used as a sentinel.
+     */
+    std::vector<Cursor> _cursors;
+
+    /**
+     * \brief the loser of the match played at each node, the overall winner is at the top, (0).
+     */
+    std::vector<size_t> _tree;
+
+    /**
+     * \brief the merged events, before they are copied back to the events given to us.
+     */
+    std::vector<Event*> _merged;
+  };
+}
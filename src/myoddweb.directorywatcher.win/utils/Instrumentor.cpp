@@ -0,0 +1,286 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#include "Instrumentor.h"
+#include <filesystem>
+#include <iomanip>
+#include "Lock.h"
+
+namespace myoddweb::directorywatcher
+{
+  /**
+   * \brief gives the buffer of a thread back once the thread ends so another thread can use it.
+   */
+  struct ProfileBufferOwner
+  {
+    ProfileBuffer* Buffer = nullptr;
+    ~ProfileBufferOwner()
+    {
+      if (Buffer != nullptr)
+      {
+        Buffer->InUse.store(false, std::memory_order_release);
+      }
+    }
+  };
+
+  static thread_local ProfileBufferOwner profileBufferOwner;
+
+  Instrumentor::Instrumentor() :
+    _buffers{},
+    _numberOfBuffers(0),
+    _enabled(false),
+    _sampleEvery(1),
+    _dropped(0),
+    _thread(nullptr),
+    _mustStop(false)
+  {
+  }
+
+  Instrumentor::~Instrumentor()
+  {
+    // the buffers are not freed as threads that are still running could be using them.
+    if (_thread == nullptr)
+    {
+      return;
+    }
+
+    // we are unloaded in the middle of a session, the thread might have been killed already
+    // and we cannot wait for it here, so we leave it alone, the trace is not complete.
+    _enabled = false;
+    _mustStop = true;
+    _notifier.NotifyAll();
+    _thread->detach();
+  }
+
+  Instrumentor& Instrumentor::Get()
+  {
+    static Instrumentor instance;
+    return instance;
+  }
+
+  /**
+   * \brief start recording, if a session is already started it is ended first.
+   * \param filepath where the trace is written to.
+   * \param sampleEvery record one scope every that many scopes of each thread, 1 to record them all.
+   * \return if the file could be created and the session started.
+   */
+  bool Instrumentor::BeginSession(const std::string& filepath, const unsigned int sampleEvery)
+  {
+    MYODDWEB_LOCK(_lock);
+    EndSessionWithLock();
+    _outputStream.open(std::filesystem::path(filepath));
+    return BeginSessionWithLock(sampleEvery);
+  }
+
+  /**
+   * \brief start recording, if a session is already started it is ended first.
+   * \param filepath where the trace is written to.
+   * \param sampleEvery record one scope every that many scopes of each thread, 1 to record them all.
+   * \return if the file could be created and the session started.
+   */
+  bool Instrumentor::BeginSession(const std::wstring& filepath, const unsigned int sampleEvery)
+  {
+    MYODDWEB_LOCK(_lock);
+    EndSessionWithLock();
+    _outputStream.open(std::filesystem::path(filepath));
+    return BeginSessionWithLock(sampleEvery);
+  }
+
+  /**
+   * \brief start recording once the file is opened, the lock must be held.
+   */
+  bool Instrumentor::BeginSessionWithLock(const unsigned int sampleEvery)
+  {
+    if (!_outputStream.is_open())
+    {
+      return false;
+    }
+    _outputStream << std::setprecision(3) << std::fixed;
+    _outputStream << "{\"otherData\": {},\"traceEvents\":[{}";
+
+    // whatever was recorded after the last session ended is not part of this one.
+    const auto numberOfBuffers = _numberOfBuffers.load(std::memory_order_acquire);
+    for (auto i = 0u; i < numberOfBuffers; ++i)
+    {
+      _buffers[i]->Tail.store(_buffers[i]->Head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    _sampleEvery = sampleEvery == 0 ? 1 : sampleEvery;
+    _mustStop = false;
+    _thread = new std::thread(&Instrumentor::Flush, this);
+    _enabled = true;
+    return true;
+  }
+
+  /**
+   * \brief stop recording and write what is left, the trace is complete once this returns.
+   */
+  void Instrumentor::EndSession()
+  {
+    MYODDWEB_LOCK(_lock);
+    EndSessionWithLock();
+  }
+
+  /**
+   * \brief stop recording and write what is left, the lock must be held.
+   */
+  void Instrumentor::EndSessionWithLock()
+  {
+    if (_thread == nullptr)
+    {
+      return;
+    }
+
+    // the thread writes what is left before it stops.
+    _enabled = false;
+    _mustStop = true;
+    _notifier.NotifyAll();
+    _thread->join();
+    delete _thread;
+    _thread = nullptr;
+
+    _outputStream << "]}";
+    _outputStream.close();
+  }
+
+  /**
+   * \brief the number of spans that were dropped because a thread had no more room for them.
+   */
+  long long Instrumentor::Dropped() const
+  {
+    return _dropped.load();
+  }
+
+  /**
+   * \brief get the buffer of the current thread if this scope must be recorded.
+   * \return the buffer or null if the scope is not recorded.
+   */
+  ProfileBuffer* Instrumentor::BeginScope()
+  {
+    if (!IsEnabled())
+    {
+      return nullptr;
+    }
+    const auto buffer = ThreadBuffer();
+    if (nullptr == buffer)
+    {
+      return nullptr;
+    }
+    const auto sampleEvery = _sampleEvery.load(std::memory_order_relaxed);
+    if (sampleEvery > 1 && ++buffer->Scopes % sampleEvery != 0)
+    {
+      return nullptr;
+    }
+    return buffer;
+  }
+
+  /**
+   * \brief add a span to the buffer of the current thread.
+   * \param buffer the buffer given by BeginScope()
+   * \param span the span we are adding.
+   */
+  void Instrumentor::WriteProfile(ProfileBuffer& buffer, const ProfileSpan& span)
+  {
+    const auto head = buffer.Head.load(std::memory_order_relaxed);
+    if (head - buffer.Tail.load(std::memory_order_acquire) >= MYODDWEB_PROFILE_BUFFER)
+    {
+      // the flush thread has not caught up with us.
+      ++_dropped;
+      return;
+    }
+    buffer.Spans[head % MYODDWEB_PROFILE_BUFFER] = span;
+    buffer.Head.store(head + 1, std::memory_order_release);
+  }
+
+  /**
+   * \brief the buffer of the current thread, created or reused the first time the thread records a scope.
+   * \return the buffer or null if too many threads are recording.
+   */
+  ProfileBuffer* Instrumentor::ThreadBuffer()
+  {
+    if (profileBufferOwner.Buffer != nullptr)
+    {
+      return profileBufferOwner.Buffer;
+    }
+
+    MYODDWEB_LOCK(_lock);
+    const auto numberOfBuffers = _numberOfBuffers.load(std::memory_order_acquire);
+    for (auto i = 0u; i < numberOfBuffers; ++i)
+    {
+      // reuse the buffer of a thread that ended.
+      auto inUse = false;
+      if (_buffers[i]->InUse.compare_exchange_strong(inUse, true, std::memory_order_acquire))
+      {
+        profileBufferOwner.Buffer = _buffers[i];
+        return profileBufferOwner.Buffer;
+      }
+    }
+
+    if (numberOfBuffers == MYODDWEB_PROFILE_MAX_THREADS)
+    {
+      ++_dropped;
+      return nullptr;
+    }
+
+    const auto buffer = new ProfileBuffer();
+    buffer->Head = 0;
+    buffer->Tail = 0;
+    buffer->ThreadNumber = numberOfBuffers + 1;
+    buffer->InUse = true;
+    buffer->Scopes = 0;
+    _buffers[numberOfBuffers] = buffer;
+    _numberOfBuffers.store(numberOfBuffers + 1, std::memory_order_release);
+    profileBufferOwner.Buffer = buffer;
+    return buffer;
+  }
+
+  /**
+   * \brief write the spans until the session ends, this runs on our own thread.
+   */
+  void Instrumentor::Flush()
+  {
+    for (;;)
+    {
+      _notifier.WaitUntil([this] { return _mustStop.load(); }, MYODDWEB_PROFILE_FLUSH_MILLISECONDS);
+      WriteBuffers();
+      if (_mustStop)
+      {
+        break;
+      }
+    }
+  }
+
+  /**
+   * \brief write the spans of all the threads.
+   */
+  void Instrumentor::WriteBuffers()
+  {
+    const auto numberOfBuffers = _numberOfBuffers.load(std::memory_order_acquire);
+    for (auto i = 0u; i < numberOfBuffers; ++i)
+    {
+      auto& buffer = *_buffers[i];
+      const auto head = buffer.Head.load(std::memory_order_acquire);
+      for (auto tail = buffer.Tail.load(std::memory_order_relaxed); tail != head; ++tail)
+      {
+        const auto& span = buffer.Spans[tail % MYODDWEB_PROFILE_BUFFER];
+        _outputStream << ",{";
+        _outputStream << "\"cat\":\"function\",";
+        _outputStream << "\"dur\":" << static_cast<double>(span.ElapsedTime) / 1000.0 << ',';
+        _outputStream << "\"name\":\"";
+        for (auto c = span.Name; *c != '\0'; ++c)
+        {
+          // the function signatures can contain quotes.
+          _outputStream << (*c == '"' ? '\'' : *c == '\\' ? '/' : *c);
+        }
+        _outputStream << "\",";
+        _outputStream << "\"ph\":\"X\",";
+        _outputStream << "\"pid\":0,";
+        _outputStream << "\"tid\":" << buffer.ThreadNumber << ",";
+        _outputStream << "\"ts\":" << static_cast<double>(span.Start) / 1000.0;
+        _outputStream << "}";
+      }
+      buffer.Tail.store(head, std::memory_order_release);
+    }
+    _outputStream.flush();
+  }
+}
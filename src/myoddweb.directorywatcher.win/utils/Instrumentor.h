@@ -2,227 +2,249 @@
 // Florent Guelfucci licenses this file to you under the MIT license.
 // See the LICENSE file in the project root for more information.
 #pragma once
-#include <string>
-#include <sstream>
+#include <atomic>
 #include <chrono>
 #include <fstream>
 #include <mutex>
-#include <iomanip>
+#include <string>
 #include <thread>
 
 #include "../monitors/Base.h"
+#include "Threads/Notifier.h"
+
+/**
+ * \brief the number of spans each thread can hold until they are written to disk.
+ *        the bigger the size, the more memory each thread uses, when full the spans are dropped and counted.
+ */
+#define MYODDWEB_PROFILE_BUFFER 4096
+
+/**
+ * \brief how often, in ms, the spans of all the threads are written to disk.
+ */
+#define MYODDWEB_PROFILE_FLUSH_MILLISECONDS 100
 
 /**
- * \brief how often we want to flush log data to disk.
- *        the bigger the size, the more memory will be used.
- *        it is all lost when we crash ... but then again the json doc is corrupted by then.
+ * \brief the maximum number of threads that can record spans at the same time,
+ *        the buffer of a thread that ended is reused by the next thread.
  */
-#define MYODDWEB_PROFILE_BUFFER 1000
+#define MYODDWEB_PROFILE_MAX_THREADS 256
 
 // from https://github.com/TheCherno/Hazel
 // go to chrome://tracing/
 namespace myoddweb::directorywatcher
 {
-  using FloatingPointMicroseconds = std::chrono::duration<double, std::micro>;
-
-  struct ProfileResult
+  /**
+   * \brief a single timed scope, the name is the literal given to the scope so it is never copied.
+   */
+  struct ProfileSpan
   {
-    std::string Name;
-
-    FloatingPointMicroseconds Start;
-    std::chrono::microseconds ElapsedTime;
-    std::thread::id ThreadID;
+    const char* Name;
+    long long Start;
+    long long ElapsedTime;
   };
 
-  struct InstrumentationSession
+  /**
+   * \brief the spans of a single thread, only that thread adds spans and only the flush thread removes them
+   *        so neither of them needs a lock.
+   */
+  struct ProfileBuffer
   {
-    std::string Name;
+    ProfileSpan Spans[MYODDWEB_PROFILE_BUFFER];
+    alignas(64) std::atomic<size_t> Head;
+    alignas(64) std::atomic<size_t> Tail;
+
+    /**
+     * \brief the thread number shown in the trace and if a thread owns this buffer.
+     */
+    unsigned int ThreadNumber;
+    std::atomic<bool> InUse;
+
+    /**
+     * \brief the number of scopes this thread went through, used for the sampling.
+     */
+    unsigned int Scopes;
   };
 
-  class Instrumentor
+  /**
+   * \brief records the time spent in the scopes of all the threads and writes them in the chrome trace format.
+   *        Nothing is recorded until a session is started so it can stay in a release build and be turned on when needed.
+   *        Each thread records its spans in its own buffer without a lock and a thread writes them to disk in the background.
+   */
+  class Instrumentor final
   {
-  private:
-    std::mutex m_Mutex;
-    InstrumentationSession* m_CurrentSession;
-    std::ofstream m_OutputStream;
   public:
-    Instrumentor()
-      : m_CurrentSession(nullptr)
+    Instrumentor();
+    ~Instrumentor();
+
+    Instrumentor(const Instrumentor&) = delete;
+    Instrumentor(Instrumentor&&) = delete;
+    const Instrumentor& operator=(const Instrumentor&) = delete;
+    Instrumentor& operator=(Instrumentor&&) = delete;
+
+    /**
+     * \brief start recording, if a session is already started it is ended first.
+     * \param filepath where the trace is written to.
+     * \param sampleEvery record one scope every that many scopes of each thread, 1 to record them all.
+     * \return if the file could be created and the session started.
+     */
+    bool BeginSession(const std::string& filepath, unsigned int sampleEvery = 1);
+    bool BeginSession(const std::wstring& filepath, unsigned int sampleEvery = 1);
+
+    /**
+     * \brief stop recording and write what is left, the trace is complete once this returns.
+     */
+    void EndSession();
+
+    /**
+     * \brief if we are recording or not.
+     */
+    [[nodiscard]]
+    bool IsEnabled() const
     {
+      return _enabled.load(std::memory_order_relaxed);
     }
 
-    void BeginSession(const std::string& name, const std::string& filepath = "results.json")
-    {
-      std::lock_guard lock(m_Mutex);
-      if (m_CurrentSession)
-      {
-        // If there is already a current session, then close it before beginning new one.
-        // Subsequent profiling output meant for the original session will end up in the
-        // newly opened session instead.  That's better than having badly formatted
-        // profiling output.
-        //MYODDWEB_OUT("Instrumentor::BeginSession('{0}') when session '{1}' already open.", name, m_CurrentSession->Name);
-        InternalEndSession();
-      }
-      m_OutputStream.open(filepath);
-
-      if (m_OutputStream.is_open())
-      {
-        m_CurrentSession = new InstrumentationSession({ name });
-        WriteHeader();
-      }
-      else
-      {
-        //MYODDWEB_OUT(("Instrumentor could not open results file '{0}'.", filepath);
-      }
-    }
+    /**
+     * \brief the number of spans that were dropped because a thread had no more room for them.
+     */
+    [[nodiscard]]
+    long long Dropped() const;
 
-    void EndSession()
-    {
-      std::lock_guard lock(m_Mutex);
-      InternalEndSession();
-    }
+    /**
+     * \brief get the buffer of the current thread if this scope must be recorded.
+     * \return the buffer or null if the scope is not recorded.
+     */
+    ProfileBuffer* BeginScope();
 
-    void WriteProfile(const ProfileResult& result)
-    {
-      std::stringstream json;
-
-      json << std::setprecision(3) << std::fixed;
-      json << ",{";
-      json << "\"cat\":\"function\",";
-      json << "\"dur\":" << (result.ElapsedTime.count()) << ',';
-      json << "\"name\":\"" << result.Name << "\",";
-      json << "\"ph\":\"X\",";
-      json << "\"pid\":0,";
-      json << "\"tid\":" << result.ThreadID << ",";
-      json << "\"ts\":" << result.Start.count();
-      json << "}";
-
-      std::lock_guard lock(m_Mutex);
-      if (m_CurrentSession)
-      {
-        m_OutputStream << json.str();
-        m_OutputStream.flush();
-      }
-    }
+    /**
+     * \brief add a span to the buffer of the current thread.
+     * \param buffer the buffer given by BeginScope()
+     * \param span the span we are adding.
+     */
+    void WriteProfile(ProfileBuffer& buffer, const ProfileSpan& span);
 
-    static Instrumentor& Get()
-    {
-      static Instrumentor instance;
-      return instance;
-    }
+    static Instrumentor& Get();
 
   private:
-
-    void WriteHeader()
-    {
-      m_OutputStream << "{\"otherData\": {},\"traceEvents\":[{}";
-      m_OutputStream.flush();
-    }
-
-    void WriteFooter()
-    {
-      m_OutputStream << "]}";
-      m_OutputStream.flush();
-    }
-
-    // Note: you must already own lock on m_Mutex before
-    // calling InternalEndSession()
-    void InternalEndSession()
-    {
-      if (m_CurrentSession)
-      {
-        WriteFooter();
-        m_OutputStream.close();
-        delete m_CurrentSession;
-        m_CurrentSession = nullptr;
-      }
-    }
-
+    /**
+     * \brief the buffer of the current thread, created or reused the first time the thread records a scope.
+     * \return the buffer or null if too many threads are recording.
+     */
+    ProfileBuffer* ThreadBuffer();
+
+    /**
+     * \brief start recording once the file is opened, the lock must be held.
+     */
+    bool BeginSessionWithLock(unsigned int sampleEvery);
+
+    /**
+     * \brief stop recording and write what is left, the lock must be held.
+     */
+    void EndSessionWithLock();
+
+    /**
+     * \brief write the spans until the session ends, this runs on our own thread.
+     */
+    void Flush();
+
+    /**
+     * \brief write the spans of all the threads.
+     */
+    void WriteBuffers();
+
+    /**
+     * \brief the lock used to start and end sessions and to add buffers.
+     */
+    MYODDWEB_MUTEX _lock;
+
+    /**
+     * \brief the buffers of all the threads that ever recorded something, they are reused once their thread ends.
+     *        they are never moved or freed so the flush thread can read them while new ones are added.
+     */
+    ProfileBuffer* _buffers[MYODDWEB_PROFILE_MAX_THREADS];
+    std::atomic<unsigned int> _numberOfBuffers;
+
+    /**
+     * \brief if we are recording and one scope in how many we record.
+     */
+    std::atomic<bool> _enabled;
+    std::atomic<unsigned int> _sampleEvery;
+
+    /**
+     * \brief the total number of spans dropped.
+     */
+    std::atomic<long long> _dropped;
+
+    /**
+     * \brief the thread writing the spans and the file they are written to.
+     */
+    std::thread* _thread;
+    std::atomic<bool> _mustStop;
+    threads::Notifier _notifier;
+    std::ofstream _outputStream;
   };
 
-  class InstrumentationTimer
+  class InstrumentationTimer final
   {
   public:
-    InstrumentationTimer(const char* name)
-      : m_Name(name), m_Stopped(false)
+    explicit InstrumentationTimer(const char* name)
+      : _name(name),
+        _buffer(Instrumentor::Get().IsEnabled() ? Instrumentor::Get().BeginScope() : nullptr)
     {
-      m_StartTimepoint = std::chrono::steady_clock::now();
+      if (_buffer != nullptr)
+      {
+        _start = std::chrono::steady_clock::now();
+      }
     }
 
     ~InstrumentationTimer()
     {
-      if (!m_Stopped)
-        Stop();
+      if (_buffer == nullptr)
+      {
+        return;
+      }
+      const auto end = std::chrono::steady_clock::now();
+      Instrumentor::Get().WriteProfile(*_buffer,
+      {
+        _name,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(_start.time_since_epoch()).count(),
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - _start).count()
+      });
     }
 
-    void Stop()
-    {
-      auto endTimepoint = std::chrono::steady_clock::now();
-      auto highResStart = FloatingPointMicroseconds{ m_StartTimepoint.time_since_epoch() };
-      auto elapsedTime = std::chrono::time_point_cast<std::chrono::microseconds>(endTimepoint).time_since_epoch() - std::chrono::time_point_cast<std::chrono::microseconds>(m_StartTimepoint).time_since_epoch();
-
-      Instrumentor::Get().WriteProfile({ m_Name, highResStart, elapsedTime, std::this_thread::get_id() });
+    InstrumentationTimer(const InstrumentationTimer&) = delete;
+    InstrumentationTimer(InstrumentationTimer&&) = delete;
+    const InstrumentationTimer& operator=(const InstrumentationTimer&) = delete;
+    InstrumentationTimer& operator=(InstrumentationTimer&&) = delete;
 
-      m_Stopped = true;
-    }
   private:
-    const char* m_Name;
-    std::chrono::time_point<std::chrono::steady_clock> m_StartTimepoint;
-    bool m_Stopped;
+    const char* _name;
+    ProfileBuffer* _buffer;
+    std::chrono::time_point<std::chrono::steady_clock> _start;
   };
-
-  namespace InstrumentorUtils {
-
-    template <size_t N>
-    struct ChangeResult
-    {
-      char Data[N];
-    };
-
-    template <size_t N, size_t K>
-    constexpr auto CleanupOutputString(const char(&expr)[N], const char(&remove)[K])
-    {
-      ChangeResult<N> result = {};
-
-      size_t srcIndex = 0;
-      size_t dstIndex = 0;
-      while (srcIndex < N)
-      {
-        size_t matchIndex = 0;
-        while (matchIndex < K - 1 && srcIndex + matchIndex < N - 1 && expr[srcIndex + matchIndex] == remove[matchIndex])
-          matchIndex++;
-        if (matchIndex == K - 1)
-          srcIndex += matchIndex;
-        result.Data[dstIndex++] = expr[srcIndex] == '"' ? '\'' : expr[srcIndex];
-        srcIndex++;
-      }
-      return result;
-    }
-  }
 }
 
-#ifdef _DEBUG
- /**
-   * \brief turn profiling on/off, uses a _lot_ of disc space!
-   *        go to chrome://tracing/
-   *        open Profile-Global.json
-   */
-  #define MYODDWEB_PROFILE 0
+/**
+ * \brief compile the profiling in, nothing is recorded until a session is started
+ *        so it costs next to nothing until then, (see StartProfiling( ... ) ).
+ *        go to chrome://tracing/ and open the file.
+ */
+#define MYODDWEB_PROFILE 1
+
+#if defined(_MSC_VER)
+  #define MYODDWEB_FUNCTION_NAME __FUNCSIG__
 #else
-  #define MYODDWEB_PROFILE 0
-#endif // DEBUG
+  #define MYODDWEB_FUNCTION_NAME __PRETTY_FUNCTION__
+#endif
 
 #if MYODDWEB_PROFILE
-  #if !defined(_DEBUG)
-    #error "You cannot use profiling in release mode!"
-  #endif
-  #define MYODDWEB_PROFILE_BEGIN_SESSION(name, filepath) ::myoddweb::directorywatcher::Instrumentor::Get().BeginSession(name, filepath)
+  #define MYODDWEB_PROFILE_BEGIN_SESSION(filepath, sampleEvery) ::myoddweb::directorywatcher::Instrumentor::Get().BeginSession(filepath, sampleEvery)
   #define MYODDWEB_PROFILE_END_SESSION() ::myoddweb::directorywatcher::Instrumentor::Get().EndSession()
-  #define MYODDWEB_PROFILE_SCOPE(name) ::myoddweb::directorywatcher::InstrumentationTimer timer##__LINE__(name);
-  #define MYODDWEB_PROFILE_FUNCTION() MYODDWEB_PROFILE_SCOPE(__FUNCSIG__)
+  #define MYODDWEB_PROFILE_SCOPE(name) const ::myoddweb::directorywatcher::InstrumentationTimer MYODDWEB_DEC(__LINE__)(name);
+  #define MYODDWEB_PROFILE_FUNCTION() MYODDWEB_PROFILE_SCOPE(MYODDWEB_FUNCTION_NAME)
 #else
-  #define MYODDWEB_PROFILE_BEGIN_SESSION(name, filepath)
+  #define MYODDWEB_PROFILE_BEGIN_SESSION(filepath, sampleEvery) false
   #define MYODDWEB_PROFILE_END_SESSION()
   #define MYODDWEB_PROFILE_SCOPE(name)
   #define MYODDWEB_PROFILE_FUNCTION()
-#endif
\ No newline at end of file
+#endif
@@ -1,9 +1,22 @@
 // Licensed to Florent Guelfucci under one or more agreements.
 // Florent Guelfucci licenses this file to you under the MIT license.
 // See the LICENSE file in the project root for more information.
+#if defined(_WIN32)
 #include <Windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 #include "Io.h"
-#include  <cctype>
+#include "BufferPool.h"
+#include "../monitors/Base.h"
+#include <cstddef>
+#include <cwctype>
 
 namespace myoddweb
 {
@@ -16,6 +29,14 @@ namespace myoddweb
      */
     bool Io::IsFile(const std::wstring& path)
     {
+#if !defined(_WIN32)
+      struct stat st = {};
+      if (::stat(ToUtf8(path).c_str(), &st) == 0)
+      {
+        return !S_ISDIR(st.st_mode);
+      }
+      return true;
+#else
       try
       {
         const auto cpath = path.c_str();
@@ -43,6 +64,7 @@ namespace myoddweb
       {
         return false;
       }
+#endif
     }
 
     /**
@@ -55,78 +77,82 @@ namespace myoddweb
      */
     std::wstring Io::Combine(const std::wstring& lhs, const std::wstring& rhs)
     {
-      // sanity check, if the lhs.length is 0, then we just return the rhs.
-      const auto sl = lhs.length();
-      const auto sr = rhs.length();
-      if (sl == 0 && sr == 0)
-      {
-        return L"";
-      }
+      // we know the exact size so we only need the one allocation.
+      std::wstring combined(CombineLength(lhs, rhs), L'\0');
+      Combine(combined.data(), lhs, rhs);
+      return combined;
+    }
 
+    /**
+     * \brief remove the trailing separators of the lhs and the leading separators of the rhs.
+     * \param lhs the left hand side of the path
+     * \param rhs the right hand side of the path
+     */
+    void Io::TrimSeparators(std::wstring_view& lhs, std::wstring_view& rhs)
+    {
       // the two type of separators.
       const auto sep1 = L'/';
       const auto sep2 = L'\\';
 
-      // and the one we will be using
-#ifdef WIN32
-      const auto sep = L'\\';
-#else
-      const auto sep = L'/';
-#endif
-
-      // we know that they are not both empty
-      // if the right hand side is empty then the lhs cannot be
-      if (sr == 0)
+      while (!lhs.empty() && (lhs.back() == sep1 || lhs.back() == sep2))
       {
-        const auto l = lhs[sl - 1];
-        // no separator
-        if (l != sep1 && l != sep2)
-        {
-          return lhs + sep;
-        }
-        // just go back one step
-        return Combine(lhs.substr(0, sl - 1), rhs);
+        lhs.remove_suffix(1);
       }
-
-      // we know that they are not both empty
-      // if the left hand side is empty then the rhs cannot be
-      if (sl == 0)
+      while (!rhs.empty() && (rhs.front() == sep1 || rhs.front() == sep2))
       {
-        const auto r = rhs[0];
-        // no separator
-        if (r != sep1 && r != sep2)
-        {
-          return sep + rhs;
-        }
-        // just move forward one step
-        return Combine(lhs, rhs.substr(1, sr - 1));
+        rhs.remove_prefix(1);
       }
+    }
 
-      // if we are here, they both not zero
-      const auto l = lhs[sl - 1];
-      const auto r = rhs[0];
+    /**
+     * \brief get the number of characters needed to combine 2 paths, (excluding the null terminator).
+     * \param lhs the left hand side of the path
+     * \param rhs the right hand side of the path
+     * \return the number of characters Combine( ... ) will write.
+     */
+    size_t Io::CombineLength(std::wstring_view lhs, std::wstring_view rhs)
+    {
+      TrimSeparators(lhs, rhs);
 
-      // simple case where we have neither '/' not '\' on either sides.
-      // neither of them has a back slash
-      if (l != sep1 && l != sep2 && r != sep1 && r != sep2)
+      // if both values are empty we return empty string
+      // otherwise there is always exactly one separator between them.
+      if (lhs.empty() && rhs.empty())
       {
-        return lhs + sep + rhs;
+        return 0;
       }
+      return lhs.length() + 1 + rhs.length();
+    }
 
-      // lhs does not have a back slash but the rhs does
-      if (l != sep1 && l != sep2 && (r == sep1 || r == sep2))
+    /**
+     * \brief combine 2 paths together in a buffer we already have, no memory is allocated.
+     *        the destination must be able to hold CombineLength( lhs, rhs ) + 1 characters.
+     * \param destination where we will write the null terminated path.
+     * \param lhs the left hand side of the path
+     * \param rhs the right hand side of the path
+     * \return the number of characters written, (excluding the null terminator).
+     */
+    size_t Io::Combine(wchar_t* destination, std::wstring_view lhs, std::wstring_view rhs)
+    {
+      TrimSeparators(lhs, rhs);
+      if (lhs.empty() && rhs.empty())
       {
-        return Combine(lhs, rhs.substr(1, sr - 1));
+        destination[0] = L'\0';
+        return 0;
       }
 
-      // rhs does not have a back slash but the lhs does
-      if ((l == sep1 || l == sep2) && r != sep1 && r != sep2)
-      {
-        return Combine(lhs.substr(0, sl - 1), rhs);
-      }
+      // the separator we will be using
+#if defined(_WIN32)
+      const auto sep = L'\\';
+#else
+      const auto sep = L'/';
+#endif
 
-      // if we are here, they both seem to have a backslash
-      return Combine(lhs.substr(0, sl - 1), rhs.substr(1, sr - 1));
+      // lhs + sep + rhs, either side could be empty.
+      auto length = lhs.copy(destination, lhs.length());
+      destination[length++] = sep;
+      length += rhs.copy(destination + length, rhs.length());
+      destination[length] = L'\0';
+      return length;
     }
 
     /**
@@ -147,15 +173,84 @@ namespace myoddweb
     std::vector<std::wstring> Io::GetAllSubFolders(const std::wstring& folder)
     {
       std::vector<std::wstring> subFolders;
-      auto searchPath = Io::Combine(folder, L"/*.*");
+#if defined(__linux__)
+      // read the entries in large batches rather than one readdir( ... ) at a time.
+      const auto dir = ::open(ToUtf8(folder).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+      if (dir < 0)
+      {
+        return subFolders;
+      }
+
+      // the layout the kernel uses for each entry.
+      struct LinuxDirent64
+      {
+        ino64_t d_ino;
+        off64_t d_off;
+        unsigned short d_reclen;
+        unsigned char d_type;
+        char d_name[1];
+      };
+
+      auto& pool = BufferPool::Shared();
+      const auto buffer = pool.Acquire(MYODDWEB_CRAWLER_BUFFER_SIZE);
+      for (;;)
+      {
+        const auto length = ::syscall(SYS_getdents64, dir, buffer, MYODDWEB_CRAWLER_BUFFER_SIZE);
+        if (length <= 0)
+        {
+          break;
+        }
+        for (long position = 0; position < length;)
+        {
+          const auto entry = reinterpret_cast<const LinuxDirent64*>(buffer + position);
+          position += entry->d_reclen;
+
+          const auto name = FromUtf8(entry->d_name);
+          if (Io::IsDot(name))
+          {
+            continue;
+          }
+          auto path = Io::Combine(folder, name);
+          if (entry->d_type == DT_DIR || (entry->d_type == DT_UNKNOWN && !Io::IsFile(path)))
+          {
+            subFolders.emplace_back(std::move(path));
+          }
+        }
+      }
+      pool.Release(buffer);
+      ::close(dir);
+#elif !defined(_WIN32)
+      const auto dir = ::opendir(ToUtf8(folder).c_str());
+      if (nullptr == dir)
+      {
+        return subFolders;
+      }
+      for (auto entry = ::readdir(dir); entry != nullptr; entry = ::readdir(dir))
+      {
+        const auto name = FromUtf8(entry->d_name);
+        if (Io::IsDot(name))
+        {
+          continue;
+        }
+        const auto path = Io::Combine(folder, name);
+        if (entry->d_type == DT_DIR || (entry->d_type == DT_UNKNOWN && !Io::IsFile(path)))
+        {
+          subFolders.emplace_back(path);
+        }
+      }
+      ::closedir(dir);
+#else
+      // we do not need the short names and we only want the directories, (if the file system can filter them).
+      // a large fetch gets more entries per call, this helps a lot with network shares.
+      const auto searchPath = Io::Combine(folder, L"/*.*");
       WIN32_FIND_DATA fd = {};
-      const auto hFind = ::FindFirstFile(searchPath.c_str(), &fd);
+      const auto hFind = ::FindFirstFileEx(searchPath.c_str(), FindExInfoBasic, &fd, FindExSearchLimitToDirectories, nullptr, FIND_FIRST_EX_LARGE_FETCH);
       if (hFind != INVALID_HANDLE_VALUE)
       {
         do
         {
-          // read all (real) files in current folder
-          // , delete '!' read other 2 default folder . and ..
+          // FindExSearchLimitToDirectories is only advisory, we might still get files.
+          // and we do not want the 2 default folders, . and ..
           if ((fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY)
           {
             if (!Io::IsDot(fd.cFileName))
@@ -166,40 +261,50 @@ namespace myoddweb
         } while (::FindNextFile(hFind, &fd));
         ::FindClose(hFind);
       }
+#endif
       return subFolders;
     }
 
-    std::wstring TidyFolderName(const std::wstring& lhs)
+    /**
+     * \brief get the normalized version of a folder, two folders are the same if their normalized versions are equal.
+     *        the separators are all the same, doubled and trailing separators are removed and the case is lowered.
+     * \param folder the folder we want to normalize.
+     * \return the normalized folder.
+     */
+    std::wstring Io::NormalizeFolder(const std::wstring_view folder)
     {
-#ifdef WIN32
+#if defined(_WIN32)
       const auto sep = L'\\';
-      const std::wstring ssep = L"\\\\";
       const auto badsep = L'/';
 #else
       const auto sep = L'/';
-      const std::wstring ssep = L"//";
       const auto badsep = L'\\';
 #endif
-      auto llhs = lhs;
-      auto found = llhs.find_first_of(badsep);
-      while (found != std::string::npos)
+      std::wstring normalized;
+      normalized.reserve(folder.length());
+      for (auto c : folder)
       {
-        llhs[found] = sep;
-        found = llhs.find_first_of(badsep);
+        if (c == badsep)
+        {
+          c = sep;
+        }
+
+        // we only want one separator at a time.
+        if (c == sep && !normalized.empty() && normalized.back() == sep)
+        {
+          continue;
+        }
+        normalized += static_cast<wchar_t>(std::towlower(c));
       }
 
-      const auto r = std::wstring() + sep;
-      found = llhs.find( ssep, 0 );
-      while (found != std::string::npos)
+      // and no trailing separators.
+      while (!normalized.empty() && normalized.back() == sep)
       {
-        llhs.replace( found, 2, r );
-        found = llhs.find(ssep, 0);
+        normalized.pop_back();
       }
-
-      return llhs;
+      return normalized;
     }
 
-
     /**
      * \brief Compare if 2 folders are the same
      * \param lhs the first folder
@@ -208,53 +313,100 @@ namespace myoddweb
      */
     bool Io::AreSameFolders(const std::wstring& lhs, const std::wstring& rhs)
     {
-#ifdef WIN32
-      const auto sep = L'\\';
-#else
-      const auto sep = L'/';
-#endif
-      auto llhs = TidyFolderName(lhs);
-      auto rrhs = TidyFolderName(rhs);
-
-      auto sl = llhs.length();
-      while( sl > 0 && (llhs[sl-1] == sep ))
-      {
-        llhs = llhs.substr(0, --sl );
-      }
-
-      auto sr = rrhs.length();
-      while (sr > 0 && (rrhs[sr - 1] == sep))
-      {
-        rrhs = rrhs.substr(0, --sr);
-      }
+      return NormalizeFolder(lhs) == NormalizeFolder(rhs);
+    }
 
-      // if the length is both zero
-      // then I guess they are the same.
-      if (sl == 0 && sr == 0 )
+#if !defined(_WIN32)
+    /**
+     * \brief convert a wide string to a utf-8 string, as used by the file system api.
+     * \param source the wide string
+     * \return the utf-8 string
+     */
+    std::string Io::ToUtf8(const std::wstring& source)
+    {
+      std::string result;
+      result.reserve(source.length());
+      for (const auto c : source)
       {
-        return true;
+        const auto cp = static_cast<unsigned long>(c);
+        if (cp < 0x80)
+        {
+          result += static_cast<char>(cp);
+        }
+        else if (cp < 0x800)
+        {
+          result += static_cast<char>(0xC0 | (cp >> 6));
+          result += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        else if (cp < 0x10000)
+        {
+          result += static_cast<char>(0xE0 | (cp >> 12));
+          result += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+          result += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        else
+        {
+          result += static_cast<char>(0xF0 | (cp >> 18));
+          result += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+          result += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+          result += static_cast<char>(0x80 | (cp & 0x3F));
+        }
       }
+      return result;
+    }
 
-      // if they are not the same length then they are not the same
-      if (sl != sr )
+    /**
+     * \brief convert a utf-8 string, as given by the file system api, to a wide string.
+     *        invalid sequences are copied byte by byte so we never lose a file name.
+     * \param source the utf-8 string
+     * \return the wide string
+     */
+    std::wstring Io::FromUtf8(const std::string& source)
+    {
+      std::wstring result;
+      result.reserve(source.length());
+      const auto length = source.length();
+      for (size_t i = 0; i < length;)
       {
-        return false;
-      }
+        const auto c = static_cast<unsigned char>(source[i]);
+        auto extra = 0;
+        unsigned long cp = c;
+        if ((c & 0xE0) == 0xC0)
+        {
+          extra = 1;
+          cp = c & 0x1F;
+        }
+        else if ((c & 0xF0) == 0xE0)
+        {
+          extra = 2;
+          cp = c & 0x0F;
+        }
+        else if ((c & 0xF8) == 0xF0)
+        {
+          extra = 3;
+          cp = c & 0x07;
+        }
 
-      for (auto i = 0; i < sl; ++i )
-      {
-        if (llhs[i] == rrhs[i] )
+        // make sure that the continuation bytes are valid.
+        auto valid = i + extra < length;
+        for (auto j = 1; valid && j <= extra; ++j)
         {
-          continue;
+          const auto cc = static_cast<unsigned char>(source[i + j]);
+          valid = (cc & 0xC0) == 0x80;
+          cp = (cp << 6) | (cc & 0x3F);
         }
-        if( llhs[i] != std::tolower(rrhs[i]) )
+
+        if (!valid)
         {
-          return false;
+          result += static_cast<wchar_t>(c);
+          ++i;
+          continue;
         }
+        result += static_cast<wchar_t>(cp);
+        i += extra + 1;
       }
-
-      // if we are here, they are the same
-      return true;
+      return result;
     }
+#endif
   }
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace myoddweb
@@ -27,6 +28,24 @@ namespace myoddweb
        */
       static std::wstring Combine(const std::wstring& lhs, const std::wstring& rhs);
 
+      /**
+       * \brief get the number of characters needed to combine 2 paths, (excluding the null terminator).
+       * \param lhs the left hand side of the path
+       * \param rhs the right hand side of the path
+       * \return the number of characters Combine( ... ) will write.
+       */
+      static size_t CombineLength(std::wstring_view lhs, std::wstring_view rhs);
+
+      /**
+       * \brief combine 2 paths together in a buffer we already have, no memory is allocated.
+       *        the destination must be able to hold CombineLength( lhs, rhs ) + 1 characters.
+       * \param destination where we will write the null terminated path.
+       * \param lhs the left hand side of the path
+       * \param rhs the right hand side of the path
+       * \return the number of characters written, (excluding the null terminator).
+       */
+      static size_t Combine(wchar_t* destination, std::wstring_view lhs, std::wstring_view rhs);
+
       /**
        * \brief check if a given string is a file or a directory.
        * \param path the file we are checking.
@@ -55,6 +74,38 @@ namespace myoddweb
        * \return if both folders are similar.
        */
       static bool AreSameFolders(const std::wstring& lhs, const std::wstring& rhs);
+
+      /**
+       * \brief get the normalized version of a folder, two folders are the same if their normalized versions are equal.
+       *        the separators are all the same, doubled and trailing separators are removed and the case is lowered.
+       * \param folder the folder we want to normalize.
+       * \return the normalized folder.
+       */
+      static std::wstring NormalizeFolder(std::wstring_view folder);
+
+#if !defined(_WIN32)
+      /**
+       * \brief convert a wide string to a utf-8 string, as used by the file system api.
+       * \param source the wide string
+       * \return the utf-8 string
+       */
+      static std::string ToUtf8(const std::wstring& source);
+
+      /**
+       * \brief convert a utf-8 string, as given by the file system api, to a wide string.
+       * \param source the utf-8 string
+       * \return the wide string
+       */
+      static std::wstring FromUtf8(const std::string& source);
+#endif
+
+    private:
+      /**
+       * \brief remove the trailing separators of the lhs and the leading separators of the rhs.
+       * \param lhs the left hand side of the path
+       * \param rhs the right hand side of the path
+       */
+      static void TrimSeparators(std::wstring_view& lhs, std::wstring_view& rhs);
     };
   }
 }
@@ -0,0 +1,183 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#include "LogRing.h"
+#include <cwchar>
+
+namespace myoddweb:: directorywatcher
+{
+  /**
+   * \brief round the capacity up to the next power of 2, and at least 2.
+   */
+  static size_t RoundUpCapacity(const size_t capacity)
+  {
+    size_t rounded = 2;
+    while (rounded < capacity)
+    {
+      rounded <<= 1;
+    }
+    return rounded;
+  }
+
+  LogRing::LogRing(const size_t capacity) :
+    _slots(nullptr),
+    _mask(RoundUpCapacity(capacity) - 1),
+    _head(0),
+    _tail(0)
+  {
+    _slots = new Slot[_mask + 1];
+    for (size_t i = 0; i <= _mask; ++i)
+    {
+      _slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  LogRing::~LogRing()
+  {
+    delete[] _slots;
+  }
+
+  /**
+   * \brief format a record into the next free slot, a message that is too long is truncated.
+   * \param id the id of the monitor, (0 if global)
+   * \param level the message log level
+   * \param format the message format
+   * \param args the list of arguments.
+   * \return false if the ring is full and the record was not added.
+   */
+  bool LogRing::TryPush(const long long id, const LogLevel level, const wchar_t* format, va_list args)
+  {
+    bool isNext;
+    return TryPush(id, level, format, args, isNext);
+  }
+
+  /**
+   * \brief format a record into the next free slot and tell if the reader might be waiting for it.
+   * \param id the id of the monitor, (0 if global)
+   * \param level the message log level
+   * \param format the message format
+   * \param args the list of arguments.
+   * \param isNext set if all the records before it were taken, the reader has nothing else to take until then.
+   * \return false if the ring is full and the record was not added.
+   */
+  bool LogRing::TryPush(const long long id, const LogLevel level, const wchar_t* format, va_list args, bool& isNext)
+  {
+    isNext = false;
+    auto position = _head.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;)
+    {
+      slot = &_slots[position & _mask];
+      const auto sequence = slot->sequence.load(std::memory_order_acquire);
+      const auto difference = static_cast<long long>(sequence) - static_cast<long long>(position);
+      if (difference == 0)
+      {
+        // the slot is free, try and claim it.
+        if (_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+        {
+          break;
+        }
+      }
+      else if (difference < 0)
+      {
+        // the reader has not freed this slot yet, we are full.
+        return false;
+      }
+      else
+      {
+        // another writer claimed it before us.
+        position = _head.load(std::memory_order_relaxed);
+      }
+    }
+
+    // the slot is ours, nobody else can touch it until we publish it.
+    auto& record = slot->record;
+    record.id = id;
+    record.level = level;
+    record.message[0] = L'\0';
+    if (nullptr != format)
+    {
+#if defined(_WIN32)
+      _vsnwprintf_s(record.message, MYODDWEB_LOGGER_MAX_MESSAGE, _TRUNCATE, format, args);
+#else
+      vswprintf(record.message, MYODDWEB_LOGGER_MAX_MESSAGE, format, args);
+#endif
+    }
+    // a message that could not be fully formatted is truncated or empty, but it is always terminated.
+    record.message[MYODDWEB_LOGGER_MAX_MESSAGE - 1] = L'\0';
+
+    slot->sequence.store(position + 1, std::memory_order_release);
+
+    // either the reader sees our record when it checks for one, or we see that it reached our slot.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    isNext = _tail.load(std::memory_order_relaxed) == position;
+    return true;
+  }
+
+  /**
+   * \brief copy the oldest record and free its slot.
+   * \param record where the record is copied to.
+   * \return false if there was nothing to get.
+   */
+  bool LogRing::TryPop(Record& record)
+  {
+    auto position = _tail.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;)
+    {
+      slot = &_slots[position & _mask];
+      const auto sequence = slot->sequence.load(std::memory_order_acquire);
+      const auto difference = static_cast<long long>(sequence) - static_cast<long long>(position + 1);
+      if (difference == 0)
+      {
+        if (_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+        {
+          break;
+        }
+      }
+      else if (difference < 0)
+      {
+        // nothing was published in that slot yet.
+        return false;
+      }
+      else
+      {
+        position = _tail.load(std::memory_order_relaxed);
+      }
+    }
+
+    record = slot->record;
+
+    // give the slot back to the writers for the next lap.
+    slot->sequence.store(position + _mask + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * \brief if there is a record ready to be taken.
+   */
+  bool LogRing::CanPop() const
+  {
+    // pairs with the fence of the writers, (see TryPush( ... ) ).
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const auto position = _tail.load(std::memory_order_relaxed);
+    const auto& slot = _slots[position & _mask];
+    return slot.sequence.load(std::memory_order_acquire) == position + 1;
+  }
+
+  /**
+   * \brief the total number of records that were added since we were created.
+   */
+  long long LogRing::Pushed() const
+  {
+    return static_cast<long long>(_head.load(std::memory_order_acquire));
+  }
+
+  /**
+   * \brief the number of records we can hold.
+   */
+  size_t LogRing::Capacity() const
+  {
+    return _mask + 1;
+  }
+}
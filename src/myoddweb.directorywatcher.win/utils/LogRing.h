@@ -0,0 +1,120 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#pragma once
+#include <atomic>
+#include <cstdarg>
+#include <cstddef>
+
+#include "../monitors/Base.h"
+#include "LogLevel.h"
+
+namespace myoddweb:: directorywatcher
+{
+  /**
+   * \brief a bounded queue of log records that any number of threads can add to without a lock.
+   *        Each record is formatted straight into its slot so adding a record never uses the heap,
+   *        when the queue is full the record is refused rather than waiting for room.
+   */
+  class LogRing final
+  {
+  public:
+    /**
+     * \brief a single log record.
+     */
+    struct Record
+    {
+      long long id;
+      LogLevel level;
+      wchar_t message[MYODDWEB_LOGGER_MAX_MESSAGE];
+    };
+
+    /**
+     * \brief create the ring
+     * \param capacity the number of records we can hold, rounded up to a power of 2.
+     */
+    explicit LogRing(size_t capacity);
+    ~LogRing();
+
+    LogRing(const LogRing&) = delete;
+    LogRing(LogRing&&) = delete;
+    const LogRing& operator=(const LogRing&) = delete;
+    LogRing& operator=(LogRing&&) = delete;
+
+    /**
+     * \brief format a record into the next free slot, a message that is too long is truncated.
+     * \param id the id of the monitor, (0 if global)
+     * \param level the message log level
+     * \param format the message format
+     * \param args the list of arguments.
+     * \return false if the ring is full and the record was not added.
+     */
+    bool TryPush(long long id, LogLevel level, const wchar_t* format, va_list args);
+
+    /**
+     * \brief format a record into the next free slot and tell if the reader might be waiting for it.
+     * \param id the id of the monitor, (0 if global)
+     * \param level the message log level
+     * \param format the message format
+     * \param args the list of arguments.
+     * \param isNext set if all the records before it were taken, the reader has nothing else to take until then.
+     * \return false if the ring is full and the record was not added.
+     */
+    bool TryPush(long long id, LogLevel level, const wchar_t* format, va_list args, bool& isNext);
+
+    /**
+     * \brief copy the oldest record and free its slot.
+     * \param record where the record is copied to.
+     * \return false if there was nothing to get.
+     */
+    bool TryPop(Record& record);
+
+    /**
+     * \brief if there is a record ready to be taken.
+     *        A reader that checks this before waiting is always woken by a writer whose record is next, (see TryPush( ... ) ).
+     */
+    [[nodiscard]]
+    bool CanPop() const;
+
+    /**
+     * \brief the total number of records that were added since we were created.
+     */
+    [[nodiscard]]
+    long long Pushed() const;
+
+    /**
+     * \brief the number of records we can hold.
+     */
+    [[nodiscard]]
+    size_t Capacity() const;
+
+  private:
+    /**
+     * \brief a slot of the ring, the sequence tells who owns the slot.
+     *        the writer owns it when it is equal to the position it wants to write to
+     *        and the reader owns it when it is one more than the position it wants to read.
+     */
+    struct Slot
+    {
+      std::atomic<size_t> sequence;
+      Record record;
+    };
+
+    /**
+     * \brief all our slots.
+     */
+    Slot* _slots;
+
+    /**
+     * \brief the number of slots - 1, the number of slots is a power of 2.
+     */
+    const size_t _mask;
+
+    /**
+     * \brief the next position to write to and the next position to read from,
+     *        on their own cache lines so the writers and the reader do not fight over them.
+     */
+    alignas(64) std::atomic<size_t> _head;
+    alignas(64) std::atomic<size_t> _tail;
+  };
+}
@@ -1,4 +1,5 @@
 #include <stdarg.h>
+#include <cwchar>
 #include "Logger.h"
 #include "Lock.h"
 
@@ -6,8 +7,51 @@ namespace myoddweb::directorywatcher
 {
   Logger Logger::_instance;
   MYODDWEB_MUTEX Logger::_lock;
+  MYODDWEB_MUTEX Logger::_lockThread;
 
-  Logger::Logger() = default;
+  /**
+   * \brief if the current thread is the one delivering the messages.
+   */
+  static thread_local bool _isDraining = false;
+
+  /**
+   * \brief the rank of a level, the lower the rank the more verbose the level.
+   */
+  static int Rank(const LogLevel level)
+  {
+    return level == LogLevel::Debug ? 0 : static_cast<int>(level);
+  }
+
+  Logger::Logger() :
+    _numberOfLoggers(0),
+#if defined(_DEBUG)
+    _level(Rank(LogLevel::Debug)),
+#else
+    _level(Rank(LogLevel::Information)),
+#endif
+    _ring(nullptr),
+    _dropped(0),
+    _delivered(0),
+    _reported(0),
+    _thread(nullptr),
+    _mustStop(false)
+  {
+  }
+
+  Logger::~Logger()
+  {
+    if (_thread == nullptr)
+    {
+      delete _ring;
+      return;
+    }
+
+    // we are unloaded while there are still loggers, the thread might have been killed already
+    // and we cannot wait for it here, so we leave it, and the ring it uses, alone.
+    _mustStop = true;
+    _notifier.NotifyAll();
+    _thread->detach();
+  }
 
   Logger& Logger::Instance()
   {
@@ -25,25 +69,45 @@ namespace myoddweb::directorywatcher
     {
       return;
     }
+    MYODDWEB_LOCK(_lockThread);
+    auto& instance = Instance();
+
+    // the ring and the thread must be ready before anyone sees that we have a logger.
+    instance.StartWithLock();
+
     MYODDWEB_LOCK(_lock);
-    Instance()._loggers[id] = logger;
+    instance._loggers[id] = logger;
+    instance._numberOfLoggers = static_cast<int>(instance._loggers.size());
   }
 
   /**
-   * \brief remove a logger from the list.
+   * \brief remove a logger from the list, the messages already logged are delivered first.
    * \param id the id we are logging for.
    */
   void Logger::Remove(const long long id)
   {
-    MYODDWEB_LOCK(_lock);
-    for(;;)
+    MYODDWEB_LOCK(_lockThread);
+    auto& instance = Instance();
     {
-      const auto logger = Instance()._loggers.find(id);
-      if( logger == Instance()._loggers.end())
+      MYODDWEB_LOCK(_lock);
+      if (instance._loggers.find(id) == instance._loggers.end())
       {
-        break;
+        return;
       }
-      Instance()._loggers.erase(logger);
+    }
+
+    // give the logger a chance to get what was logged for it.
+    instance.FlushWithLock(MYODDWEB_LOGGER_FLUSH_TIMEOUT);
+
+    {
+      MYODDWEB_LOCK(_lock);
+      instance._loggers.erase(id);
+      instance._numberOfLoggers = static_cast<int>(instance._loggers.size());
+    }
+
+    if (!HasAnyLoggers())
+    {
+      instance.StopWithLock();
     }
   }
 
@@ -56,29 +120,15 @@ namespace myoddweb::directorywatcher
   void Logger::Log(const LogLevel level, const wchar_t* format, ...)
   {
     //  shortcut
-    if(HasAnyLoggers())
+    if(!HasAnyLoggers() || !IsEnabled(level))
     {
       return;
     }
 
     va_list args;
     va_start(args, format);
-    const auto message = MakeMessage(format, args);
+    Instance().Push(0, level, format, args);
     va_end(args);
-
-    MYODDWEB_LOCK(_lock);
-    for (const auto logger : Instance()._loggers)
-    {
-      try
-      {
-        Log(logger.second, 0, level, message.c_str());
-      }
-      catch ( ... )
-      {
-        // we cannot log a log message that faied
-        MYODDWEB_OUT("There was an issue logging a message");
-      }
-    }
   }
 
   /**
@@ -91,49 +141,237 @@ namespace myoddweb::directorywatcher
   void Logger::Log(const long long id, const LogLevel level, const wchar_t* format, ...)
   {
     //  shortcut
-    if (HasAnyLoggers())
+    if (!HasAnyLoggers() || !IsEnabled(level))
     {
       return;
     }
 
     va_list args;
     va_start(args, format);
-    const auto message = MakeMessage(format, args);
+    Instance().Push(id, level, format, args);
     va_end(args);
+  }
 
-    MYODDWEB_LOCK(_lock);
-    if( id != 0 )
+  /**
+   * \brief set the most verbose level we log, Debug logs everything.
+   * \param level the level
+   */
+  void Logger::SetLevel(const LogLevel level)
+  {
+    Instance()._level = Rank(level);
+  }
+
+  /**
+   * \brief if a message of that level would be logged.
+   * \param level the message log level
+   */
+  bool Logger::IsEnabled(const LogLevel level)
+  {
+    return Rank(level) >= Instance()._level.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * \brief wait for all the messages logged so far to be delivered to the loggers.
+   * \param milliseconds how long we want to wait, -1 to wait forever.
+   * \return if all the messages were delivered.
+   */
+  bool Logger::Flush(const long long milliseconds)
+  {
+    // a logger flushing from our own thread would wait for itself.
+    if (_isDraining)
+    {
+      return false;
+    }
+    MYODDWEB_LOCK(_lockThread);
+    return Instance().FlushWithLock(milliseconds);
+  }
+
+  /**
+   * \brief wait for all the messages logged so far to be delivered, the thread lock must be held.
+   * \param milliseconds how long we want to wait, -1 to wait forever.
+   * \return if all the messages were delivered.
+   */
+  bool Logger::FlushWithLock(const long long milliseconds)
+  {
+    if (nullptr == _thread)
+    {
+      return true;
+    }
+    if (_isDraining)
+    {
+      return false;
+    }
+
+    // the messages that were dropped will never be delivered, but they were never counted as pushed either.
+    const auto target = _ring->Pushed();
+    return _notifier.WaitUntil([this, target]
     {
-      const auto logger = Instance()._loggers.find(id);
-      if (logger != Instance()._loggers.end())
+      return _delivered.load() >= target;
+    }, milliseconds);
+  }
+
+  /**
+   * \brief the total number of messages that were dropped because the loggers could not keep up.
+   */
+  long long Logger::Dropped()
+  {
+    return Instance()._dropped.load();
+  }
+
+  /**
+   * \brief add a message to the ring, or count it as dropped if the ring is full.
+   * \param id owner the id
+   * \param level the message log level
+   * \param format the message format
+   * \param args the list of arguments.
+   */
+  void Logger::Push(const long long id, const LogLevel level, const wchar_t* format, va_list args)
+  {
+    // the arguments do not outlive this call so the message is formatted now, straight into the ring.
+    auto isNext = false;
+    if (!_ring->TryPush(id, level, format, args, isNext))
+    {
+      // the thread is busy with a full ring, it only needs to be told about the first drop.
+      if (_dropped++ == _reported.load())
       {
-        try
-        {
-          Log(logger->second, id, level, message.c_str());
-        }
-        catch (...)
-        {
-          // we cannot log a log message that faied
-          MYODDWEB_OUT("There was an issue logging a message");
-        }
+        _notifier.NotifyAll();
+      }
+      return;
+    }
+
+    // otherwise the thread will get to our message once it has delivered the ones before it.
+    if (isNext)
+    {
+      _notifier.NotifyAll();
+    }
+  }
+
+  /**
+   * \brief deliver the messages until we are told to stop, this runs on our thread.
+   */
+  void Logger::Drain()
+  {
+    _isDraining = true;
+    LogRing::Record record = {};
+    std::vector<LoggerCallback> loggers;
+    for (;;)
+    {
+      _notifier.WaitUntil([this]
+      {
+        return _mustStop || _ring->CanPop() || _dropped.load() != _reported;
+      }, -1);
+
+      // deliver everything that is ready, whoever is flushing is told once per batch.
+      auto delivered = 0ll;
+      while (delivered < static_cast<long long>(_ring->Capacity()) && _ring->TryPop(record))
+      {
+        Deliver(record, loggers);
+        ++delivered;
+      }
+      _delivered += delivered;
+
+      // let the loggers know if we had to drop some messages.
+      const auto dropped = _dropped.load();
+      if (dropped != _reported && IsEnabled(LogLevel::Warning))
+      {
+        record.id = 0;
+        record.level = LogLevel::Warning;
+        swprintf(record.message, MYODDWEB_LOGGER_MAX_MESSAGE, L"%lld log message(s) were dropped, (%lld in total), the loggers cannot keep up.", dropped - _reported, dropped);
+        Deliver(record, loggers);
+      }
+      _reported = dropped;
+
+      // let whoever is flushing know what was delivered.
+      _notifier.NotifyAll();
+
+      if (_mustStop && !_ring->CanPop())
+      {
+        break;
       }
     }
-    else
+  }
+
+  /**
+   * \brief deliver a single message to its logger, or to all of them if the id is 0.
+   * \param record the message.
+   * \param loggers the list the loggers are copied to so we do not call them while holding the lock.
+   */
+  void Logger::Deliver(const LogRing::Record& record, std::vector<LoggerCallback>& loggers)
+  {
+    loggers.clear();
     {
-      // the value was 0 so we will send to all.
-      for (const auto logger : Instance()._loggers)
+      MYODDWEB_LOCK(_lock);
+      if (record.id != 0)
       {
-        try
+        const auto logger = _loggers.find(record.id);
+        if (logger != _loggers.end())
         {
-          Log(logger.second, id, level, message.c_str());
+          loggers.push_back(logger->second);
         }
-        catch (...)
+      }
+      else
+      {
+        // the value was 0 so we will send to all.
+        for (const auto& logger : _loggers)
         {
-          // we cannot log a log message that faied
-          MYODDWEB_OUT("There was an issue logging a message");
+          loggers.push_back(logger.second);
         }
       }
     }
+
+    for (const auto& logger : loggers)
+    {
+      try
+      {
+        Log(logger, record.id, record.level, record.message);
+      }
+      catch (...)
+      {
+        // we cannot log a log message that faied
+        MYODDWEB_OUT("There was an issue logging a message");
+      }
+    }
+  }
+
+  /**
+   * \brief start the thread delivering the messages if it is not running already.
+   */
+  void Logger::StartWithLock()
+  {
+    if (nullptr == _ring)
+    {
+      _ring = new LogRing(MYODDWEB_LOGGER_RING_SIZE);
+    }
+    if (nullptr != _thread)
+    {
+      return;
+    }
+    _mustStop = false;
+    _thread = new std::thread(&Logger::Drain, this);
+  }
+
+  /**
+   * \brief stop the thread delivering the messages, the messages left are delivered first.
+   */
+  void Logger::StopWithLock()
+  {
+    if (nullptr == _thread)
+    {
+      return;
+    }
+
+    // a logger removing itself from our own thread cannot wait for it,
+    // the thread keeps running and will be used by the next logger.
+    if (_thread->get_id() == std::this_thread::get_id())
+    {
+      return;
+    }
+
+    _mustStop = true;
+    _notifier.NotifyAll();
+    _thread->join();
+    delete _thread;
+    _thread = nullptr;
   }
 
   /**
@@ -163,40 +401,6 @@ namespace myoddweb::directorywatcher
    */
   bool Logger::HasAnyLoggers()
   {
-    MYODDWEB_LOCK(_lock);
-    return Instance()._loggers.size() > 0;
-  }
-
-
-  /**
-   * \brief create a message, and take ownership of the string
-   * \param format the message format
-   * \param args the list of arguments.
-   */
-  std::wstring Logger::MakeMessage(const wchar_t* format, va_list args)
-  {
-    // sanity check
-    if( nullptr == format )
-    {
-      return L"";
-    }
-
-    // get the final size
-    const auto size = vswprintf(nullptr, 0, format, args);
-    if (size <= 0)
-    {
-      return L"";
-    }
-
-    // build the string
-    std::wstring output;
-    const auto buffSize = size + 1;
-    output.reserve(buffSize);
-    if (vswprintf_s(output.data(), buffSize, format, args) < 0)// create the string
-    {
-      output.clear();                                     // Empty the string if there is a problem
-    }
-    return output;
+    return Instance()._numberOfLoggers.load() > 0;
   }
-
 }
@@ -2,14 +2,24 @@
 // Florent Guelfucci licenses this file to you under the MIT license.
 // See the LICENSE file in the project root for more information.
 #pragma once
+#include <atomic>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 #include "../monitors/Base.h"
 #include "../monitors/Callbacks.h"
+#include "LogLevel.h"
+#include "LogRing.h"
+#include "Threads/Notifier.h"
 
 namespace myoddweb:: directorywatcher
 {
-  enum class LogLevel;
-
+  /**
+   * \brief the loggers of the monitors.
+   *        Logging a message only formats it into a lock free ring, the loggers are called on our own thread
+   *        so a slow logger never delays the thread that logged the message.
+   *        When the ring is full the messages are dropped and counted rather than waiting for room.
+   */
   class Logger final
   {
     /**
@@ -17,11 +27,54 @@ namespace myoddweb:: directorywatcher
      */
     std::unordered_map<long long, LoggerCallback> _loggers;
 
+    /**
+     * \brief the number of loggers, so we can check if there are any without a lock.
+     */
+    std::atomic<int> _numberOfLoggers;
+
+    /**
+     * \brief the most verbose level we log, anything more verbose is ignored before it is formatted.
+     */
+    std::atomic<int> _level;
+
+    /**
+     * \brief the messages waiting to be delivered, created with the first logger.
+     */
+    LogRing* _ring;
+
+    /**
+     * \brief the total number of messages dropped because the ring was full
+     *        and the number of messages delivered to the loggers.
+     */
+    std::atomic<long long> _dropped;
+    std::atomic<long long> _delivered;
+
+    /**
+     * \brief the number of dropped messages the loggers were told about, only changed by our thread.
+     */
+    std::atomic<long long> _reported;
+
+    /**
+     * \brief the thread delivering the messages to the loggers, it only runs while we have loggers.
+     */
+    std::thread* _thread;
+    std::atomic<bool> _mustStop;
+
+    /**
+     * \brief wakes the thread when it has something to deliver and whoever is waiting for the messages to be delivered.
+     */
+    threads::Notifier _notifier;
+
     /**
      * \brief the lock to ensure single access.
      */
     static MYODDWEB_MUTEX _lock;
 
+    /**
+     * \brief the lock to start and stop the thread, it is never used by the thread itself.
+     */
+    static MYODDWEB_MUTEX _lockThread;
+
     // the singleton
     static Logger _instance;
     static Logger& Instance();
@@ -29,6 +82,7 @@ namespace myoddweb:: directorywatcher
     explicit Logger();
 
   public:
+    ~Logger();
     Logger(const Logger&) = delete;
     Logger(Logger&&) = delete;
     const Logger& operator=(const Logger&) = delete;
@@ -42,7 +96,7 @@ namespace myoddweb:: directorywatcher
     static void Add( long long id, const LoggerCallback& logger);
 
     /**
-     * \brief remove a logger from the list.
+     * \brief remove a logger from the list, the messages already logged are delivered first.
      * \param id the id we are logging for.
      */
     static void Remove(long long id );
@@ -64,7 +118,72 @@ namespace myoddweb:: directorywatcher
      */
     static void Log(LogLevel level, const wchar_t* format, ...);
 
+    /**
+     * \brief set the most verbose level we log, Debug logs everything.
+     * \param level the level
+     */
+    static void SetLevel(LogLevel level);
+
+    /**
+     * \brief if a message of that level would be logged.
+     * \param level the message log level
+     */
+    [[nodiscard]]
+    static bool IsEnabled(LogLevel level);
+
+    /**
+     * \brief wait for all the messages logged so far to be delivered to the loggers.
+     * \param milliseconds how long we want to wait, -1 to wait forever.
+     * \return if all the messages were delivered.
+     */
+    static bool Flush(long long milliseconds);
+
+    /**
+     * \brief the total number of messages that were dropped because the loggers could not keep up.
+     */
+    [[nodiscard]]
+    static long long Dropped();
+
   private:
+    /**
+     * \brief add a message to the ring, or count it as dropped if the ring is full.
+     *        The thread is only woken up when it could be waiting for this message, or for the first drop.
+     * \param id owner the id
+     * \param level the message log level
+     * \param format the message format
+     * \param args the list of arguments.
+     */
+    void Push(long long id, LogLevel level, const wchar_t* format, va_list args);
+
+    /**
+     * \brief wait for all the messages logged so far to be delivered, the thread lock must be held.
+     * \param milliseconds how long we want to wait, -1 to wait forever.
+     * \return if all the messages were delivered.
+     */
+    bool FlushWithLock(long long milliseconds);
+
+    /**
+     * \brief deliver the messages until we are told to stop, this runs on our thread.
+     */
+    void Drain();
+
+    /**
+     * \brief deliver a single message to its logger, or to all of them if the id is 0.
+     * \param record the message.
+     * \param loggers the list the loggers are copied to so we do not call them while holding the lock.
+     */
+    void Deliver(const LogRing::Record& record, std::vector<LoggerCallback>& loggers);
+
+    /**
+     * \brief start the thread delivering the messages if it is not running already.
+     */
+    void StartWithLock();
+
+    /**
+     * \brief stop the thread delivering the messages, the messages left are delivered first.
+     */
+    void StopWithLock();
+
     /**
      * \brief log a message to a single logger
      * \param logger the logger we will be logging to
@@ -74,14 +193,6 @@ namespace myoddweb:: directorywatcher
      */
     static void Log(const LoggerCallback& logger, long long id, LogLevel level, const wchar_t* message);
 
-    /**
-     * \brief create a message, and take ownership of the string
-     * \param format the message format
-     * \param args the list of arguments.
-     */
-    [[nodiscard]]
-    static std::wstring MakeMessage(const wchar_t* format, va_list args);
-
     /**
      * \brief check if we have any loggers in our list
      */
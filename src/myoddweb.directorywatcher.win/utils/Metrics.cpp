@@ -0,0 +1,217 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#include "Metrics.h"
+#include <algorithm>
+
+namespace myoddweb:: directorywatcher
+{
+  Metrics::Shard::Shard()
+  {
+    for (auto& counter : Counters)
+    {
+      counter = 0;
+    }
+    for (auto& histogram : Histograms)
+    {
+      histogram.Count = 0;
+      histogram.TotalMicroseconds = 0;
+      histogram.MaxMicroseconds = 0;
+      for (auto& bucket : histogram.Buckets)
+      {
+        bucket = 0;
+      }
+    }
+  }
+
+  Metrics::Metrics()
+  {
+    for (auto& shard : _shards)
+    {
+      shard = nullptr;
+    }
+  }
+
+  Metrics::~Metrics()
+  {
+    for (auto& shard : _shards)
+    {
+      delete shard.load();
+    }
+  }
+
+  /**
+   * \brief get the shard that the current thread adds to.
+   *        each thread is given the next shard the first time it adds something
+   *        so, up to the number of shards, no two threads share the same shard.
+   *        The shard is created the first time one of its threads adds to it.
+   */
+  Metrics::Shard& Metrics::CurrentShard()
+  {
+    static std::atomic<unsigned int> nextShard = 0;
+    static thread_local const auto shard = nextShard++ % MYODDWEB_METRICS_SHARDS;
+    auto& slot = _shards[shard];
+    auto current = slot.load(std::memory_order_acquire);
+    if (current != nullptr)
+    {
+      return *current;
+    }
+
+    // if another thread sharing the slot beats us to it, we use theirs.
+    const auto fresh = new Shard();
+    if (slot.compare_exchange_strong(current, fresh, std::memory_order_acq_rel))
+    {
+      return *fresh;
+    }
+    delete fresh;
+    return *current;
+  }
+
+  /**
+   * \brief add to one of the counters, this is thread safe and never waits.
+   * \param counter the counter we are adding to.
+   * \param value the value we are adding.
+   */
+  void Metrics::Add(const Counter counter, const long long value)
+  {
+    CurrentShard().Counters[static_cast<int>(counter)].fetch_add(value, std::memory_order_relaxed);
+  }
+
+  /**
+   * \brief the total of a counter across all the threads.
+   * \param counter the counter we want.
+   */
+  long long Metrics::Get(const Counter counter) const
+  {
+    auto total = 0ll;
+    for (const auto& slot : _shards)
+    {
+      const auto shard = slot.load(std::memory_order_acquire);
+      if (shard != nullptr)
+      {
+        total += shard->Counters[static_cast<int>(counter)].load(std::memory_order_relaxed);
+      }
+    }
+    return total;
+  }
+
+  /**
+   * \brief add a duration to one of the histograms, this is thread safe and never waits.
+   * \param timing the histogram we are adding to.
+   * \param milliseconds the duration, negative values are counted as zero.
+   */
+  void Metrics::Record(const Timing timing, const double milliseconds)
+  {
+    const auto microseconds = milliseconds > 0 ? static_cast<long long>(milliseconds * 1000.0) : 0ll;
+    auto& histogram = CurrentShard().Histograms[static_cast<int>(timing)];
+    histogram.Count.fetch_add(1, std::memory_order_relaxed);
+    histogram.TotalMicroseconds.fetch_add(microseconds, std::memory_order_relaxed);
+    histogram.Buckets[Bucket(microseconds)].fetch_add(1, std::memory_order_relaxed);
+
+    // another thread sharing the shard could be updating the max at the same time.
+    auto max = histogram.MaxMicroseconds.load(std::memory_order_relaxed);
+    while (microseconds > max && !histogram.MaxMicroseconds.compare_exchange_weak(max, microseconds, std::memory_order_relaxed))
+    {
+    }
+  }
+
+  /**
+   * \brief add our values to the statistics, the percentiles are not calculated, (see CalculatePercentiles( ... ) ).
+   * \param statistics the statistics we are adding to.
+   */
+  void Metrics::AddTo(MonitorStatistics& statistics) const
+  {
+    statistics.NumberOfEvents += Get(Counter::PulledEvents);
+    statistics.NumberOfReceivedEvents += Get(Counter::ReceivedEvents);
+    statistics.NumberOfCollectedEvents += Get(Counter::CollectedEvents);
+    statistics.NumberOfCoalescedEvents += Get(Counter::CoalescedEvents);
+    statistics.NumberOfDeduplicatedEvents += Get(Counter::DeduplicatedEvents);
+    statistics.NumberOfBytesRead += Get(Counter::BytesRead);
+
+    MonitorHistogram* histograms[] =
+    {
+      &statistics.PublishMilliseconds,
+      &statistics.CallbackMilliseconds,
+      &statistics.EventAgeMilliseconds
+    };
+    for (auto timing = 0; timing < static_cast<int>(Timing::NumberOfTimings); ++timing)
+    {
+      auto& to = *histograms[timing];
+      for (const auto& slot : _shards)
+      {
+        const auto shard = slot.load(std::memory_order_acquire);
+        if (shard == nullptr)
+        {
+          // no thread added to this shard.
+          continue;
+        }
+        const auto& from = shard->Histograms[timing];
+        to.Count += from.Count.load(std::memory_order_relaxed);
+        to.TotalMilliseconds += static_cast<double>(from.TotalMicroseconds.load(std::memory_order_relaxed)) / 1000.0;
+        to.MaxMilliseconds = (std::max)(to.MaxMilliseconds, static_cast<double>(from.MaxMicroseconds.load(std::memory_order_relaxed)) / 1000.0);
+        for (auto bucket = 0; bucket < MYODDWEB_METRICS_HISTOGRAM_BUCKETS; ++bucket)
+        {
+          to.Buckets[bucket] += from.Buckets[bucket].load(std::memory_order_relaxed);
+        }
+      }
+    }
+  }
+
+  /**
+   * \brief the histogram bucket of a duration.
+   * \param microseconds the duration
+   * \return the bucket, 0 for anything under 1 microsecond, n for anything under 2^n microseconds.
+   */
+  int Metrics::Bucket(long long microseconds)
+  {
+    auto bucket = 0;
+    while (microseconds > 0 && bucket < MYODDWEB_METRICS_HISTOGRAM_BUCKETS - 1)
+    {
+      microseconds >>= 1;
+      ++bucket;
+    }
+    return bucket;
+  }
+
+  /**
+   * \brief estimate the percentiles of a histogram from its buckets, once all the values have been added to it.
+   *        each percentile is the upper bound of the bucket it falls in, (and never more than the max).
+   * \param histogram the histogram we are updating.
+   */
+  void Metrics::CalculatePercentiles(MonitorHistogram& histogram)
+  {
+    histogram.P50Milliseconds = Percentile(histogram, 0.50);
+    histogram.P90Milliseconds = Percentile(histogram, 0.90);
+    histogram.P99Milliseconds = Percentile(histogram, 0.99);
+  }
+
+  /**
+   * \brief estimate a single percentile from the buckets.
+   * \param histogram the histogram with all the values.
+   * \param percentile the percentile we want, (0.5 for the median).
+   * \return the estimated duration in milliseconds.
+   */
+  double Metrics::Percentile(const MonitorHistogram& histogram, const double percentile)
+  {
+    if (histogram.Count == 0)
+    {
+      return 0;
+    }
+
+    // the rank of the value we are looking for, starting from 1.
+    const auto rank = (std::max)(1ll, static_cast<long long>(percentile * static_cast<double>(histogram.Count) + 0.5));
+    auto count = 0ll;
+    for (auto bucket = 0; bucket < MYODDWEB_METRICS_HISTOGRAM_BUCKETS - 1; ++bucket)
+    {
+      count += histogram.Buckets[bucket];
+      if (count >= rank)
+      {
+        const auto upperBound = static_cast<double>(1ll << bucket) / 1000.0;
+        return (std::min)(upperBound, histogram.MaxMilliseconds);
+      }
+    }
+
+    // the last bucket has no upper bound.
+    return histogram.MaxMilliseconds;
+  }
+}
@@ -0,0 +1,173 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#pragma once
+#include <atomic>
+
+#include "../monitors/Base.h"
+#include "../monitors/Callbacks.h"
+
+namespace myoddweb:: directorywatcher
+{
+  /**
+   * \brief the counters and the duration histograms of each stage of a monitor, from the changes we read to the events we deliver.
+   *        Each thread adds to its own copy of the values so the threads never fight over the same cache line,
+   *        the copies are only added together when the statistics are read.
+   *        A copy is only created the first time one of its threads adds to it, so an idle monitor holds next to nothing.
+   */
+  class Metrics final
+  {
+  public:
+    /**
+     * \brief what we are counting.
+     */
+    enum class Counter
+    {
+      /**
+       * \brief the events given to the collector, before anything was removed.
+       */
+      ReceivedEvents,
+
+      /**
+       * \brief the events taken from the collector, before they were coalesced or their duplicates removed.
+       */
+      CollectedEvents,
+
+      /**
+       * \brief the events removed because they did not change the net effect of their path.
+       */
+      CoalescedEvents,
+
+      /**
+       * \brief the events removed because a newer event of the same path and action was collected.
+       */
+      DeduplicatedEvents,
+
+      /**
+       * \brief the events the host took itself, (see Request::IsPullingEvents( ... ) ).
+       */
+      PulledEvents,
+
+      /**
+       * \brief the number of bytes of changes read from the file system.
+       */
+      BytesRead,
+
+      NumberOfCounters
+    };
+
+    /**
+     * \brief what we are timing.
+     */
+    enum class Timing
+    {
+      /**
+       * \brief the time it took to take the events from the monitor and queue them for delivery.
+       */
+      Publish,
+
+      /**
+       * \brief the time spent in the events callback, once per window of events.
+       */
+      Callback,
+
+      /**
+       * \brief how old each event was when it was given to the host.
+       */
+      EventAge,
+
+      NumberOfTimings
+    };
+
+    Metrics();
+    ~Metrics();
+
+    Metrics(const Metrics&) = delete;
+    Metrics(Metrics&&) = delete;
+    const Metrics& operator=(const Metrics&) = delete;
+    Metrics& operator=(Metrics&&) = delete;
+
+    /**
+     * \brief add to one of the counters, this is thread safe and never waits.
+     * \param counter the counter we are adding to.
+     * \param value the value we are adding.
+     */
+    void Add(Counter counter, long long value = 1);
+
+    /**
+     * \brief the total of a counter across all the threads.
+     * \param counter the counter we want.
+     */
+    [[nodiscard]]
+    long long Get(Counter counter) const;
+
+    /**
+     * \brief add a duration to one of the histograms, this is thread safe and never waits.
+     * \param timing the histogram we are adding to.
+     * \param milliseconds the duration, negative values are counted as zero.
+     */
+    void Record(Timing timing, double milliseconds);
+
+    /**
+     * \brief add our values to the statistics, the percentiles are not calculated, (see CalculatePercentiles( ... ) ).
+     * \param statistics the statistics we are adding to.
+     */
+    void AddTo(MonitorStatistics& statistics) const;
+
+    /**
+     * \brief the histogram bucket of a duration.
+     * \param microseconds the duration
+     * \return the bucket, 0 for anything under 1 microsecond, n for anything under 2^n microseconds.
+     */
+    [[nodiscard]]
+    static int Bucket(long long microseconds);
+
+    /**
+     * \brief estimate the percentiles of a histogram from its buckets, once all the values have been added to it.
+     *        each percentile is the upper bound of the bucket it falls in, (and never more than the max).
+     * \param histogram the histogram we are updating.
+     */
+    static void CalculatePercentiles(MonitorHistogram& histogram);
+
+  private:
+    /**
+     * \brief the values of a single histogram, the durations are in microseconds.
+     */
+    struct Histogram
+    {
+      std::atomic<long long> Count;
+      std::atomic<long long> TotalMicroseconds;
+      std::atomic<long long> MaxMicroseconds;
+      std::atomic<long long> Buckets[MYODDWEB_METRICS_HISTOGRAM_BUCKETS];
+    };
+
+    /**
+     * \brief the copy of the values used by some of the threads, on its own cache line.
+     */
+    struct alignas(64) Shard
+    {
+      Shard();
+
+      std::atomic<long long> Counters[static_cast<int>(Counter::NumberOfCounters)];
+      Histogram Histograms[static_cast<int>(Timing::NumberOfTimings)];
+    };
+
+    /**
+     * \brief get the shard that the current thread adds to, it is created if need be.
+     */
+    Shard& CurrentShard();
+
+    /**
+     * \brief estimate a single percentile from the buckets.
+     * \param histogram the histogram with all the values.
+     * \param percentile the percentile we want, (0.5 for the median).
+     * \return the estimated duration in milliseconds.
+     */
+    static double Percentile(const MonitorHistogram& histogram, double percentile);
+
+    /**
+     * \brief all our shards, null until a thread adds to it.
+     */
+    std::atomic<Shard*> _shards[MYODDWEB_METRICS_SHARDS];
+  };
+}
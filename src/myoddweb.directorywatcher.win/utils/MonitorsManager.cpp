@@ -2,11 +2,16 @@
 // Florent Guelfucci licenses this file to you under the MIT license.
 // See the LICENSE file in the project root for more information.
 #include "MonitorsManager.h"
+#include <algorithm>
 #include "Lock.h"
 #include "../utils/Wait.h"
 #include "../monitors/Base.h"
+#if defined(__linux__)
+#include "../monitors/LinuxMonitor.h"
+#else
 #include "../monitors/WinMonitor.h"
 #include "../monitors/MultipleWinMonitor.h"
+#endif
 #include "Instrumentor.h"
 #include "Logger.h"
 #include "LogLevel.h"
@@ -58,9 +63,6 @@ namespace myoddweb
         return _instance;
       }
 
-      // Start the global profiling session.
-      MYODDWEB_PROFILE_BEGIN_SESSION( "Monitor Global", "Profile-Global.json" );
-
       try
       {
         // create a new instance
@@ -148,12 +150,7 @@ namespace myoddweb
         const auto result = Instance()->StopAndDeleteWithLock(id);
 
         // delete our instance if we are the last one
-        if (Instance()->_monitors.empty())
-        {
-          delete _instance;
-          _instance = nullptr;
-          MYODDWEB_PROFILE_END_SESSION();
-        }
+        DeleteInstanceIfEmptyWithLock();
         return result;
       }
       catch (const std::exception& e)
@@ -165,6 +162,146 @@ namespace myoddweb
       }
     }
 
+    /**
+     * \brief stop and remove many monitors at once, they are all told to stop
+     *        and then we wait once for all of them rather than one after the other.
+     * \param ids the ids of the monitors we want to stop.
+     * \param numberOfIds the number of ids.
+     * \param stoppedIds where we copy the ids of the monitors we stopped, room for numberOfIds, (or null).
+     * \return the number of monitors we stopped or -1 if there was an error.
+     */
+    int MonitorsManager::StopMany(const long long* ids, const int numberOfIds, long long* stoppedIds)
+    {
+      MYODDWEB_PROFILE_FUNCTION();
+      if (nullptr == ids || numberOfIds < 0)
+      {
+        return -1;
+      }
+
+      try
+      {
+        MYODDWEB_LOCK(_lock);
+
+        // if we do not have an instance... then we have nothing.
+        if (_instance == nullptr)
+        {
+          return 0;
+        }
+
+        // try and remove them all.
+        const auto stopped = Instance()->StopAndDeleteWithLock(std::vector<long long>(ids, ids + numberOfIds));
+
+        // delete our instance if we removed the last ones
+        DeleteInstanceIfEmptyWithLock();
+
+        // let the caller know which ones are gone, the others might still be running.
+        if (stoppedIds != nullptr)
+        {
+          std::copy(stopped.begin(), stopped.end(), stoppedIds);
+        }
+        return static_cast<int>(stopped.size());
+      }
+      catch (const std::exception& e)
+      {
+        // log the error
+        Logger::Log(LogLevel::Panic, L"Caught exception '%hs' trying to stop many monitors!", e.what());
+
+        return -1;
+      }
+    }
+
+    /**
+     * \brief delete our instance if we no longer have any monitors, we will assume we have the lock.
+     */
+    void MonitorsManager::DeleteInstanceIfEmptyWithLock()
+    {
+      if (_instance == nullptr || !_instance->_monitors.empty())
+      {
+        return;
+      }
+      delete _instance;
+      _instance = nullptr;
+    }
+
+    /**
+     * \brief copy the pending events of a monitor to the buffers given by the host.
+     * \param id the id of the monitor we want the events of.
+     * \param events where we are copying the events to.
+     * \param eventsCapacity the number of events we can copy.
+     * \param names where we are copying the names to, the offsets in the events are relative to it.
+     * \param namesCapacity the number of characters we can copy.
+     * \param cursor 0 to get the next events or the value returned by the previous call to continue.
+     * \return the number of events copied or -1 if there was an error.
+     */
+    int MonitorsManager::GetEvents(const long long id, EventRecord* events, const int eventsCapacity, wchar_t* names, const int namesCapacity, long long& cursor)
+    {
+      MYODDWEB_PROFILE_FUNCTION();
+      if (nullptr == events || nullptr == names || eventsCapacity <= 0 || namesCapacity <= 0)
+      {
+        return -1;
+      }
+
+      try
+      {
+        // the lock makes sure that the monitor is not deleted while we copy.
+        MYODDWEB_LOCK(_lock);
+
+        // if we do not have an instance... then we have nothing.
+        if (_instance == nullptr)
+        {
+          return -1;
+        }
+
+        const auto monitor = _instance->_monitors.find(id);
+        if (monitor == _instance->_monitors.end())
+        {
+          return -1;
+        }
+        return monitor->second->PullEvents(events, eventsCapacity, names, namesCapacity, cursor);
+      }
+      catch (const std::exception& e)
+      {
+        // log the error
+        Logger::Log(id, LogLevel::Error, L"Caught exception '%hs' trying to get the events of a monitor!", e.what());
+
+        return -1;
+      }
+    }
+
+    /**
+     * \brief get how well the host is keeping up with the events of a monitor.
+     * \param id the id of the monitor we want the statistics of.
+     * \param statistics the statistics we are filling, its size must be set to sizeof(MonitorStatistics).
+     * \return if the monitor exists and the statistics were filled.
+     */
+    bool MonitorsManager::GetStatistics(const long long id, MonitorStatistics& statistics)
+    {
+      MYODDWEB_PROFILE_FUNCTION();
+
+      // the host was built with another layout, we cannot write to it.
+      if (statistics.Size != static_cast<int>(sizeof(MonitorStatistics)))
+      {
+        Logger::Log(id, LogLevel::Error, L"The statistics are %d bytes but we expected %d bytes.", statistics.Size, static_cast<int>(sizeof(MonitorStatistics)));
+        return false;
+      }
+
+      MYODDWEB_LOCK(_lock);
+
+      // if we do not have an instance... then we have nothing.
+      if (_instance == nullptr)
+      {
+        return false;
+      }
+
+      const auto monitor = _instance->_monitors.find(id);
+      if (monitor == _instance->_monitors.end())
+      {
+        return false;
+      }
+      monitor->second->GetStatistics(statistics);
+      return true;
+    }
+
     /**
      * \brief Try and get an usued id
      * \return a random id number
@@ -172,7 +309,7 @@ namespace myoddweb
     long long MonitorsManager::GetId()
     {
       MYODDWEB_PROFILE_FUNCTION();
-      return (static_cast<__int64>(rand()) << (sizeof(int) * 8)) | rand();
+      return (static_cast<long long>(rand()) << (sizeof(int) * 8)) | rand();
     }
 
     /***
@@ -201,6 +338,10 @@ namespace myoddweb
 
           // create the new monitor
           Monitor* monitor;
+#if defined(__linux__)
+          // inotify handles both recursive and non recursive requests.
+          monitor = new LinuxMonitor(id, *_workersPool, request);
+#else
           if (request.Recursive())
           {
             monitor = new MultipleWinMonitor(id, *_workersPool, request);
@@ -209,6 +350,7 @@ namespace myoddweb
           {
             monitor = new WinMonitor(id, *_workersPool, request);
           }
+#endif
 
           // add it to the ilist
           _monitors[monitor->Id()] = monitor;
@@ -220,7 +362,7 @@ namespace myoddweb
       catch (const std::exception& e)
       {
         // log the error
-        Logger::Log(LogLevel::Panic, L"Caught exception '%hs' trying to create a monitor for '%s'!", e.what(), request.Path() );
+        Logger::Log(LogLevel::Panic, L"Caught exception '%hs' trying to create a monitor for '%ls'!", e.what(), request.Path() );
 
         // something broke while trying to create this monitor.
         return nullptr;
@@ -245,7 +387,7 @@ namespace myoddweb
         // we could not create the monitor for some reason
         if( nullptr == monitor)
         {
-          Logger::Log(LogLevel::Panic, L"I was unable to create and start a monitor for '%s'!", request.Path());
+          Logger::Log(LogLevel::Panic, L"I was unable to create and start a monitor for '%ls'!", request.Path());
           return nullptr;
         }
 
@@ -258,7 +400,7 @@ namespace myoddweb
       catch (const std::exception& e)
       {
         // log the error
-        Logger::Log(LogLevel::Panic, L"Caught exception '%hs' trying to create and start the monitor, '%s'!", e.what(), request.Path() );
+        Logger::Log(LogLevel::Panic, L"Caught exception '%hs' trying to create and start the monitor, '%ls'!", e.what(), request.Path() );
 
         // exception while trying to start
         // remove the one we just added.
@@ -279,47 +421,75 @@ namespace myoddweb
      * \return false if there was a problem or if it does not exist.
      */
     bool MonitorsManager::StopAndDeleteWithLock(const long long id)
+    {
+      return StopAndDeleteWithLock(std::vector<long long>{ id }).size() == 1;
+    }
+
+    /**
+     * \brief stop many monitors and then get rid of them, we will assume we have the lock.
+     * \param ids the ids we want to delete, the ones that do not exist are ignored.
+     * \return the ids of the monitors we stopped and deleted.
+     */
+    std::vector<long long> MonitorsManager::StopAndDeleteWithLock(const std::vector<long long>& ids)
     {
       MYODDWEB_PROFILE_FUNCTION();
       try
       {
-        const auto monitor = _monitors.find(id);
-        if (monitor == _monitors.end())
+        // take the monitors out of our list, so an id given more than once is only stopped once.
+        std::vector<Monitor*> monitors;
+        monitors.reserve(ids.size());
+        for (const auto id : ids)
         {
-          // does not exist.
-          return false;
+          const auto monitor = _monitors.find(id);
+          if (monitor == _monitors.end())
+          {
+            // does not exist.
+            continue;
+          }
+          monitors.emplace_back(monitor->second);
+          _monitors.erase(monitor);
         }
 
-        // stop everything
-        if(threads::WaitResult::complete != _workersPool->StopAndWait( *monitor->second, MYODDWEB_WAITFOR_WORKER_COMPLETION ))
+        std::vector<long long> stopped;
+        if (monitors.empty())
         {
-          Logger::Log(LogLevel::Warning, L"Timeout while waiting for worker to complete.");
+          return stopped;
         }
 
-        try
+        // stop everything, they are all told to stop before we wait for any of them.
+        if(threads::WaitResult::complete != _workersPool->StopAndWait( std::vector<threads::Worker*>(monitors.begin(), monitors.end()), MYODDWEB_WAITFOR_WORKER_COMPLETION ))
         {
-          // delete it
-          delete monitor->second;
+          Logger::Log(LogLevel::Warning, L"Timeout while waiting for worker to complete.");
         }
-        catch (const std::exception& e)
+
+        stopped.reserve(monitors.size());
+        for (const auto monitor : monitors)
         {
-          // log the error
-          Logger::Log(LogLevel::Panic, L"Caught exception '%hs' trying to free monitor memory!", e.what());
-        }
-        // remove it
-        _monitors.erase(monitor);
+          const auto id = monitor->Id();
+          stopped.emplace_back(id);
+          try
+          {
+            // delete it
+            delete monitor;
+          }
+          catch (const std::exception& e)
+          {
+            // log the error
+            Logger::Log(LogLevel::Panic, L"Caught exception '%hs' trying to free monitor memory!", e.what());
+          }
 
-        // remove the logger
-        Logger::Remove(id);
+          // remove the logger
+          Logger::Remove(id);
+        }
 
         // we are done
-        return true;
+        return stopped;
       }
       catch (const std::exception& e)
       {
         // log the error
-        Logger::Log(id, LogLevel::Panic, L"Caught exception '%hs' trying to stop and delete a monitor!", e.what());
-        return false;
+        Logger::Log(LogLevel::Panic, L"Caught exception '%hs' trying to stop and delete monitors!", e.what());
+        return {};
       }
     }
   }
@@ -4,6 +4,7 @@
 #pragma once
 #include <mutex>
 #include <unordered_map>
+#include <vector>
 #include "Request.h"
 #include "../monitors/Monitor.h"
 
@@ -30,6 +31,36 @@ namespace myoddweb:: directorywatcher
      */
     static bool Stop(long long id);
 
+    /**
+     * \brief stop and remove many monitors at once, they are all told to stop
+     *        and then we wait once for all of them rather than one after the other.
+     * \param ids the ids of the monitors we want to stop.
+     * \param numberOfIds the number of ids.
+     * \param stoppedIds where we copy the ids of the monitors we stopped, room for numberOfIds, (or null).
+     * \return the number of monitors we stopped or -1 if there was an error.
+     */
+    static int StopMany(const long long* ids, int numberOfIds, long long* stoppedIds = nullptr);
+
+    /**
+     * \brief copy the pending events of a monitor to the buffers given by the host.
+     * \param id the id of the monitor we want the events of.
+     * \param events where we are copying the events to.
+     * \param eventsCapacity the number of events we can copy.
+     * \param names where we are copying the names to, the offsets in the events are relative to it.
+     * \param namesCapacity the number of characters we can copy.
+     * \param cursor 0 to get the next events or the value returned by the previous call to continue.
+     * \return the number of events copied or -1 if there was an error.
+     */
+    static int GetEvents(long long id, EventRecord* events, int eventsCapacity, wchar_t* names, int namesCapacity, long long& cursor);
+
+    /**
+     * \brief get how well the host is keeping up with the events of a monitor.
+     * \param id the id of the monitor we want the statistics of.
+     * \param statistics the statistics we are filling, its size must be set to sizeof(MonitorStatistics).
+     * \return if the monitor exists and the statistics were filled.
+     */
+    static bool GetStatistics(long long id, MonitorStatistics& statistics);
+
     /**
      * \brief If the monitor manager is ready or not.
      * \return if it is ready or not.
@@ -58,6 +89,18 @@ namespace myoddweb:: directorywatcher
      */
     bool StopAndDeleteWithLock(long long id);
 
+    /**
+     * \brief stop many monitors and then get rid of them, we will assume we have the lock.
+     * \param ids the ids we want to delete, the ones that do not exist are ignored.
+     * \return the ids of the monitors we stopped and deleted.
+     */
+    std::vector<long long> StopAndDeleteWithLock(const std::vector<long long>& ids);
+
+    /**
+     * \brief delete our instance if we no longer have any monitors, we will assume we have the lock.
+     */
+    static void DeleteInstanceIfEmptyWithLock();
+
     /**
      * \brief Get a random id
      * We do not check for colisions, it is up to the caller.
@@ -16,7 +16,10 @@ namespace myoddweb:: directorywatcher
     _statisticsCallback(nullptr),
     _eventsCallbackRateMs(0),
     _statisticsCallbackRateMs(0),
-    _loggerCallback(nullptr)
+    _loggerCallback(nullptr),
+    _eventsBatchCallback(nullptr),
+    _coalesceEvents(false),
+    _settleMilliseconds(0)
   {
   }
 
@@ -29,6 +32,9 @@ namespace myoddweb:: directorywatcher
    * \param statisticsCallback where the statistics are logged
    * \param eventsCallbackRateMs how fast we want messages published
    * \param statisticsCallbackRateMs how fast we want statistics to be published.
+   * \param eventsBatchCallback where we will receive the events in batches, (if set it is used instead of the events callback).
+   * \param coalesceEvents if we only want the net effect of the events of each path.
+   * \param settleMilliseconds how long a touched path must not change before it is published, (0 to publish them straight away).
    */
   Request::Request(
     const wchar_t* path, 
@@ -37,10 +43,13 @@ namespace myoddweb:: directorywatcher
     const EventCallback& eventsCallback, 
     const StatisticsCallback& statisticsCallback, 
     long long eventsCallbackRateMs, 
-    long long statisticsCallbackRateMs) :
+    long long statisticsCallbackRateMs,
+    const EventsBatchCallback& eventsBatchCallback,
+    const bool coalesceEvents,
+    const long long settleMilliseconds) :
     Request()
   {
-    Assign(path, recursive, loggerCallback, eventsCallback, statisticsCallback, eventsCallbackRateMs, statisticsCallbackRateMs);
+    Assign(path, recursive, loggerCallback, eventsCallback, statisticsCallback, eventsCallbackRateMs, statisticsCallbackRateMs, eventsBatchCallback, coalesceEvents, settleMilliseconds);
   }
 
   /**
@@ -58,15 +67,15 @@ namespace myoddweb:: directorywatcher
 
   /**
    * \brief create from a parent request, (no callback)
+   *        the rates and the options are the ones of the parent.
    * \param path the path being watched.
    * \param recursive if the request is recursive or not.
-   * \param eventsCallbackRateMs how long we want to keep our events for.
-   * \param statisticsCallbackRateMs how long we want to keep stats data for.
+   * \param parent the request we are watching a part of.
    */
-  Request::Request(const wchar_t* path, bool recursive, const long long eventsCallbackRateMs, const long long statisticsCallbackRateMs) :
+  Request::Request(const wchar_t* path, bool recursive, const Request& parent) :
     Request()
   {
-    Assign(path, recursive, nullptr, nullptr, nullptr, eventsCallbackRateMs, statisticsCallbackRateMs);
+    Assign(path, recursive, nullptr, nullptr, nullptr, parent._eventsCallbackRateMs, parent._statisticsCallbackRateMs, nullptr, parent._coalesceEvents, parent._settleMilliseconds);
   }
     
   Request::Request(const Request& request) :
@@ -90,6 +99,7 @@ namespace myoddweb:: directorywatcher
   {
     _loggerCallback = nullptr;
     _eventsCallback = nullptr;
+    _eventsBatchCallback = nullptr;
     _statisticsCallback = nullptr;
     if (_path == nullptr)
     {
@@ -108,7 +118,7 @@ namespace myoddweb:: directorywatcher
     {
       return;
     }
-    Assign( request._path, request._recursive, request._loggerCallback, request._eventsCallback, request._statisticsCallback, request._eventsCallbackRateMs, request._statisticsCallbackRateMs );
+    Assign( request._path, request._recursive, request._loggerCallback, request._eventsCallback, request._statisticsCallback, request._eventsCallbackRateMs, request._statisticsCallbackRateMs, request._eventsBatchCallback, request._coalesceEvents, request._settleMilliseconds );
   }
 
   /**
@@ -121,24 +131,30 @@ namespace myoddweb:: directorywatcher
     const EventCallback& eventsCallback,
     const StatisticsCallback& statisticsCallback,
     const long long eventsCallbackRateMs,
-    const long long statisticsCallbackRateMs)
+    const long long statisticsCallbackRateMs,
+    const EventsBatchCallback& eventsBatchCallback,
+    const bool coalesceEvents,
+    const long long settleMilliseconds)
   {
     // clean up
     Dispose();
 
     _loggerCallback = loggerCallback;
     _eventsCallback = eventsCallback;
+    _eventsBatchCallback = eventsBatchCallback;
     _eventsCallbackRateMs = eventsCallbackRateMs;
     _statisticsCallback = statisticsCallback;
     _statisticsCallbackRateMs = statisticsCallbackRateMs;
     _recursive = recursive;
+    _coalesceEvents = coalesceEvents;
+    _settleMilliseconds = settleMilliseconds;
 
     if (path != nullptr)
     {
       const auto l = wcslen(path);
       _path = new wchar_t[ l+1];
       wmemset(_path, L'\0', l+1);
-      wcscpy_s(_path, l+1, path );
+      wmemcpy(_path, path, l );
     }        
   }
 
@@ -170,6 +186,16 @@ namespace myoddweb:: directorywatcher
     return _eventsCallback;
   }
 
+  /**
+   * \brief the events batch callback, if set it is used instead of the events callback.
+   * \return the events batch callback
+   */
+  [[nodiscard]]
+  const EventsBatchCallback& Request::CallbackEventsBatch() const
+  {
+    return _eventsBatchCallback;
+  }
+
   /**
    * \brief the stats of the monitor
    */
@@ -206,13 +232,31 @@ namespace myoddweb:: directorywatcher
     return _statisticsCallbackRateMs;
   }
 
+  /**
+   * \brief if we only want the net effect of the events of each path, (an added then removed file is not reported at all).
+   */
+  [[nodiscard]]
+  bool Request::CoalesceEvents() const
+  {
+    return _coalesceEvents;
+  }
+
+  /**
+   * \brief how long a touched path must not change before it is published, (0 if they are published straight away).
+   */
+  [[nodiscard]]
+  long long Request::SettleMilliseconds() const
+  {
+    return _settleMilliseconds;
+  }
+
   /**
    * \brief return if we are using events or not
    */
   bool Request::IsUsingEvents() const
   {
-    // null is allowed
-    if (nullptr == CallbackEvents())
+    // null is allowed, but we need at least one of them.
+    if (nullptr == CallbackEvents() && nullptr == CallbackEventsBatch())
     {
       return false;
     }
@@ -245,4 +289,20 @@ namespace myoddweb:: directorywatcher
     // we are using it
     return true;
   }
+
+  /**
+   * \brief return if the events are kept for the host to pull rather than published.
+   *        This is when we have no events callbacks but we still have an events rate.
+   */
+  bool Request::IsPullingEvents() const
+  {
+    // if we publish them, they cannot be pulled.
+    if (nullptr != CallbackEvents() || nullptr != CallbackEventsBatch())
+    {
+      return false;
+    }
+
+    // the rate is how long the events are kept for.
+    return EventsCallbackRateMilliseconds() > 0;
+  }
 }
\ No newline at end of file
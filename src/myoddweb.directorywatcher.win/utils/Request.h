@@ -26,8 +26,11 @@ namespace myoddweb:: directorywatcher
      * \param statisticsCallback where the statistics are logged
      * \param eventsCallbackRateMs how fast we want messages published
      * \param statisticsCallbackRateMs how fast we want statistics to be published.
+     * \param eventsBatchCallback where we will receive the events in batches, (if set it is used instead of the events callback).
+     * \param coalesceEvents if we only want the net effect of the events of each path.
+     * \param settleMilliseconds how long a touched path must not change before it is published, (0 to publish them straight away).
      */
-    Request(const wchar_t* path, bool recursive, const LoggerCallback& loggerCallback, const EventCallback& eventsCallback, const StatisticsCallback& statisticsCallback, long long eventsCallbackRateMs, long long statisticsCallbackRateMs);
+    Request(const wchar_t* path, bool recursive, const LoggerCallback& loggerCallback, const EventCallback& eventsCallback, const StatisticsCallback& statisticsCallback, long long eventsCallbackRateMs, long long statisticsCallbackRateMs, const EventsBatchCallback& eventsBatchCallback = nullptr, bool coalesceEvents = false, long long settleMilliseconds = 0);
 
   public:
     /**
@@ -37,12 +40,12 @@ namespace myoddweb:: directorywatcher
 
     /**
      * \brief create from a parent request, (no callback)
+     *        the rates and the options are the ones of the parent.
      * \param path the path being watched.
      * \param recursive if the request is recursive or not.
-     * \param eventsCallbackRateMs how long we want to keep our events for.
-     * \param statisticsCallbackRateMs how long we want to keep stats data for.
+     * \param parent the request we are watching a part of.
      */
-    Request(const wchar_t* path, bool recursive, long long eventsCallbackRateMs, long long statisticsCallbackRateMs);
+    Request(const wchar_t* path, bool recursive, const Request& parent);
     ~Request();
 
     /**
@@ -76,8 +79,11 @@ namespace myoddweb:: directorywatcher
      * \param statisticsCallback where the statistics are logged
      * \param eventsCallbackRateMs how fast we want messages published
      * \param statisticsCallbackRateMs how fast we want statistics to be published.
+     * \param eventsBatchCallback where we will receive the events in batches.
+     * \param coalesceEvents if we only want the net effect of the events of each path.
+     * \param settleMilliseconds how long a touched path must not change before it is published.
      */
-    void Assign(const wchar_t* path, bool recursive, const LoggerCallback& loggerCallback, const EventCallback& eventsCallback, const StatisticsCallback& statisticsCallback, long long eventsCallbackRateMs, long long statisticsCallbackRateMs);
+    void Assign(const wchar_t* path, bool recursive, const LoggerCallback& loggerCallback, const EventCallback& eventsCallback, const StatisticsCallback& statisticsCallback, long long eventsCallbackRateMs, long long statisticsCallbackRateMs, const EventsBatchCallback& eventsBatchCallback, bool coalesceEvents, long long settleMilliseconds);
 
   public:
     /**
@@ -92,6 +98,13 @@ namespace myoddweb:: directorywatcher
     [[nodiscard]]
     bool IsUsingStatistics() const;
 
+    /**
+     * \brief return if the events are kept for the host to pull rather than published.
+     *        This is when we have no events callbacks but we still have an events rate.
+     */
+    [[nodiscard]]
+    bool IsPullingEvents() const;
+
     /**
      * \brief access the path
      */
@@ -111,6 +124,13 @@ namespace myoddweb:: directorywatcher
     [[nodiscard]]
     const EventCallback& CallbackEvents() const;
 
+    /**
+     * \brief the events batch callback, if set it is used instead of the events callback.
+     * \return the events batch callback
+     */
+    [[nodiscard]]
+    const EventsBatchCallback& CallbackEventsBatch() const;
+
     /**
      * \brief the stats of the monitor 
      */
@@ -135,6 +155,19 @@ namespace myoddweb:: directorywatcher
     [[nodiscard]]
     long long StatsCallbackRateMilliseconds() const;
 
+    /**
+     * \brief if we only want the net effect of the events of each path, (an added then removed file is not reported at all).
+     */
+    [[nodiscard]]
+    bool CoalesceEvents() const;
+
+    /**
+     * \brief how long a touched path must not change before it is published, (0 if they are published straight away).
+     *        a path that keeps changing is still published after MYODDWEB_SETTLE_MAX_HOLD_FACTOR times that.
+     */
+    [[nodiscard]]
+    long long SettleMilliseconds() const;
+
   private:
 
     /**
@@ -181,5 +214,20 @@ namespace myoddweb:: directorywatcher
      * \brief the logger callback
      */ 
     LoggerCallback _loggerCallback;
+
+    /**
+     * \brief the callback we want to use to publish all the events at once.
+     */
+    EventsBatchCallback _eventsBatchCallback;
+
+    /**
+     * \brief if we only want the net effect of the events of each path.
+     */
+    bool _coalesceEvents;
+
+    /**
+     * \brief how long a touched path must not change before it is published.
+     */
+    long long _settleMilliseconds;
   };
 }
@@ -0,0 +1,190 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#include "SettleQueue.h"
+#include <utility>
+
+namespace myoddweb:: directorywatcher
+{
+  /**
+   * \brief create the queue
+   * \param settleMilliseconds how long a path must not change before it settles.
+   * \param maxHoldMilliseconds the longest we will hold a path, from its first change.
+   */
+  SettleQueue::SettleQueue(const long long settleMilliseconds, const long long maxHoldMilliseconds) :
+    _settleMilliseconds(settleMilliseconds),
+    _maxHoldMilliseconds(maxHoldMilliseconds),
+    _firstChanged(nullptr),
+    _lastChanged(nullptr),
+    _firstHeld(nullptr),
+    _lastHeld(nullptr)
+  {
+  }
+
+  SettleQueue::~SettleQueue()
+  {
+    for (auto entry = _firstHeld; entry != nullptr;)
+    {
+      const auto next = entry->NextHeld;
+      delete entry;
+      entry = next;
+    }
+  }
+
+  /**
+   * \brief a path changed, we hold it until it settles.
+   * \param name the path that changed.
+   * \param isFile if the path is a file or a directory.
+   * \param timeMillisecondsUtc the time of the change.
+   */
+  void SettleQueue::Change(const std::wstring_view name, const bool isFile, const long long timeMillisecondsUtc)
+  {
+    const auto it = _entries.find({ name, isFile });
+    if (it != _entries.end())
+    {
+      // it changed again, so it goes to the back of the queue.
+      const auto entry = it->second;
+      entry->LastChangeMilliseconds = timeMillisecondsUtc;
+      UnlinkChanged(entry);
+      PushChanged(entry);
+      return;
+    }
+
+    const auto entry = new Entry{ std::wstring(name), isFile, timeMillisecondsUtc, timeMillisecondsUtc, nullptr, nullptr, nullptr, nullptr };
+    _entries.emplace(Key{ entry->Name, isFile }, entry);
+    PushChanged(entry);
+
+    // the first change never changes, so it is always added at the back.
+    entry->PreviousHeld = _lastHeld;
+    if (_lastHeld == nullptr)
+    {
+      _firstHeld = entry;
+    }
+    else
+    {
+      _lastHeld->NextHeld = entry;
+    }
+    _lastHeld = entry;
+  }
+
+  /**
+   * \brief stop holding a path, before it settled.
+   * \param name the path we no longer want to hold.
+   * \param isFile if the path is a file or a directory.
+   * \param timeMillisecondsUtc the time of the last change, if we were holding that path.
+   * \return if we were holding that path.
+   */
+  bool SettleQueue::Release(const std::wstring_view name, const bool isFile, long long& timeMillisecondsUtc)
+  {
+    const auto it = _entries.find({ name, isFile });
+    if (it == _entries.end())
+    {
+      return false;
+    }
+    const auto entry = it->second;
+    timeMillisecondsUtc = entry->LastChangeMilliseconds;
+    Remove(entry);
+    delete entry;
+    return true;
+  }
+
+  /**
+   * \brief take all the paths that settled, or that were held for too long.
+   * \param nowMillisecondsUtc the current time.
+   * \param settled where the paths are added, in no particular order.
+   */
+  void SettleQueue::TakeSettled(const long long nowMillisecondsUtc, std::vector<Settled>& settled)
+  {
+    for (;;)
+    {
+      Entry* entry;
+      if (_firstChanged != nullptr && _firstChanged->LastChangeMilliseconds + _settleMilliseconds <= nowMillisecondsUtc)
+      {
+        entry = _firstChanged;
+      }
+      else if (_firstHeld != nullptr && _firstHeld->FirstChangeMilliseconds + _maxHoldMilliseconds <= nowMillisecondsUtc)
+      {
+        // it is still changing, but we cannot hold it any longer.
+        entry = _firstHeld;
+      }
+      else
+      {
+        return;
+      }
+
+      Remove(entry);
+      settled.push_back({ std::move(entry->Name), entry->IsFile, entry->LastChangeMilliseconds });
+      delete entry;
+    }
+  }
+
+  /**
+   * \brief the number of paths we are holding.
+   */
+  size_t SettleQueue::Size() const
+  {
+    return _entries.size();
+  }
+
+  /**
+   * \brief add an entry at the back of the list ordered by the last change.
+   * \param entry the entry.
+   */
+  void SettleQueue::PushChanged(Entry* entry)
+  {
+    entry->PreviousChanged = _lastChanged;
+    entry->NextChanged = nullptr;
+    if (_lastChanged == nullptr)
+    {
+      _firstChanged = entry;
+    }
+    else
+    {
+      _lastChanged->NextChanged = entry;
+    }
+    _lastChanged = entry;
+  }
+
+  /**
+   * \brief remove an entry from the list ordered by the last change.
+   * \param entry the entry.
+   */
+  void SettleQueue::UnlinkChanged(Entry* entry)
+  {
+    (entry->PreviousChanged == nullptr ? _firstChanged : entry->PreviousChanged->NextChanged) = entry->NextChanged;
+    (entry->NextChanged == nullptr ? _lastChanged : entry->NextChanged->PreviousChanged) = entry->PreviousChanged;
+  }
+
+  /**
+   * \brief remove an entry from both lists and from the index, it is not deleted.
+   * \param entry the entry.
+   */
+  void SettleQueue::Remove(Entry* entry)
+  {
+    UnlinkChanged(entry);
+    (entry->PreviousHeld == nullptr ? _firstHeld : entry->PreviousHeld->NextHeld) = entry->NextHeld;
+    (entry->NextHeld == nullptr ? _lastHeld : entry->NextHeld->PreviousHeld) = entry->PreviousHeld;
+    _entries.erase({ entry->Name, entry->IsFile });
+  }
+
+  /**
+   * \brief create the hash of a key
+   * \param key the key we want to hash
+   * \return the hash value
+   */
+  size_t SettleQueue::KeyHash::operator()(const Key& key) const noexcept
+  {
+    return std::hash<std::wstring_view>()(key.Name) ^ (key.IsFile ? 1 : 0);
+  }
+
+  /**
+   * \brief check if two keys are the same
+   * \param lhs the lhs element we are checking.
+   * \param rhs the rhs element we are checking.
+   * \return if both keys are the same.
+   */
+  bool SettleQueue::KeyEqual::operator()(const Key& lhs, const Key& rhs) const noexcept
+  {
+    return lhs.IsFile == rhs.IsFile && lhs.Name == rhs.Name;
+  }
+}
@@ -0,0 +1,168 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace myoddweb:: directorywatcher
+{
+  /**
+   * \brief hold the paths that are being changed until they have not changed for a while, (they settled).
+   *        A path is never held longer than the max hold time, even if it keeps changing.
+   *        Every path is in 2 lists, one ordered by the last change and one ordered by the first change
+   *        as all the paths wait for the same time, the next path to settle is always at the front of one of the lists.
+   *        So adding, changing, releasing or taking a path is O(1).
+   *        This class is not thread safe.
+   */
+  class SettleQueue final
+  {
+  public:
+    /**
+     * \brief a path that settled.
+     */
+    struct Settled
+    {
+      std::wstring Name;
+      bool IsFile;
+
+      /**
+       * \brief the time of the last change.
+       */
+      long long TimeMillisecondsUtc;
+    };
+
+    /**
+     * \brief create the queue
+     * \param settleMilliseconds how long a path must not change before it settles.
+     * \param maxHoldMilliseconds the longest we will hold a path, from its first change.
+     */
+    SettleQueue(long long settleMilliseconds, long long maxHoldMilliseconds);
+    ~SettleQueue();
+
+    SettleQueue(const SettleQueue&) = delete;
+    SettleQueue(SettleQueue&&) = delete;
+    const SettleQueue& operator=(const SettleQueue&) = delete;
+    SettleQueue& operator=(SettleQueue&&) = delete;
+
+    /**
+     * \brief a path changed, we hold it until it settles.
+     * \param name the path that changed.
+     * \param isFile if the path is a file or a directory.
+     * \param timeMillisecondsUtc the time of the change.
+     */
+    void Change(std::wstring_view name, bool isFile, long long timeMillisecondsUtc);
+
+    /**
+     * \brief stop holding a path, before it settled.
+     * \param name the path we no longer want to hold.
+     * \param isFile if the path is a file or a directory.
+     * \param timeMillisecondsUtc the time of the last change, if we were holding that path.
+     * \return if we were holding that path.
+     */
+    bool Release(std::wstring_view name, bool isFile, long long& timeMillisecondsUtc);
+
+    /**
+     * \brief take all the paths that settled, or that were held for too long.
+     * \param nowMillisecondsUtc the current time.
+     * \param settled where the paths are added, in no particular order.
+     */
+    void TakeSettled(long long nowMillisecondsUtc, std::vector<Settled>& settled);
+
+    /**
+     * \brief the number of paths we are holding.
+     */
+    [[nodiscard]]
+    size_t Size() const;
+
+  private:
+    /**
+     * \brief one of the paths we are holding, it is in both lists.
+     */
+    struct Entry
+    {
+      std::wstring Name;
+      bool IsFile;
+      long long FirstChangeMilliseconds;
+      long long LastChangeMilliseconds;
+
+      /**
+       * \brief the list ordered by the last change.
+       */
+      Entry* PreviousChanged;
+      Entry* NextChanged;
+
+      /**
+       * \brief the list ordered by the first change.
+       */
+      Entry* PreviousHeld;
+      Entry* NextHeld;
+    };
+
+    /**
+     * \brief the path of an entry, the name points to the entry itself.
+     */
+    struct Key
+    {
+      std::wstring_view Name;
+      bool IsFile;
+    };
+
+    /**
+     * \brief hash a key.
+     */
+    struct KeyHash
+    {
+      size_t operator()(const Key& key) const noexcept;
+    };
+
+    /**
+     * \brief compare two keys.
+     */
+    struct KeyEqual
+    {
+      bool operator()(const Key& lhs, const Key& rhs) const noexcept;
+    };
+
+    /**
+     * \brief add an entry at the back of the list ordered by the last change.
+     * \param entry the entry.
+     */
+    void PushChanged(Entry* entry);
+
+    /**
+     * \brief remove an entry from the list ordered by the last change.
+     * \param entry the entry.
+     */
+    void UnlinkChanged(Entry* entry);
+
+    /**
+     * \brief remove an entry from both lists and from the index, it is not deleted.
+     * \param entry the entry.
+     */
+    void Remove(Entry* entry);
+
+    const long long _settleMilliseconds;
+    const long long _maxHoldMilliseconds;
+
+    /**
+     * \brief all the entries by path.
+     */
+    std::unordered_map<Key, Entry*, KeyHash, KeyEqual> _entries;
+
+    /**
+     * \brief the list ordered by the last change, the oldest change first.
+     */
+    Entry* _firstChanged;
+    Entry* _lastChanged;
+
+    /**
+     * \brief the list ordered by the first change, the oldest change first.
+     */
+    Entry* _firstHeld;
+    Entry* _lastHeld;
+  };
+}
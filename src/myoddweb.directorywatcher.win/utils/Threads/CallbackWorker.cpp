@@ -14,7 +14,7 @@ namespace myoddweb::directorywatcher::threads
   {
   }
 
-  bool CallbackWorker::OnWorkerUpdate(float fElapsedTimeMilliseconds)
+  bool CallbackWorker::OnWorkerUpdate(float /*fElapsedTimeMilliseconds*/)
   {
     MYODDWEB_PROFILE_FUNCTION();
 
@@ -0,0 +1,246 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#include "Executor.h"
+#include <algorithm>
+#include <chrono>
+#include "../Instrumentor.h"
+#include "../Lock.h"
+#include "../Logger.h"
+#include "../LogLevel.h"
+
+#if defined( _WIN32) || defined(_WIN64 )
+  #include <windows.h>
+#endif
+
+namespace myoddweb:: directorywatcher:: threads
+{
+  /**
+   * \brief the executor that owns the current thread, if any.
+   */
+  static thread_local const Executor* currentExecutor = nullptr;
+
+  /**
+   * \brief the index of the current thread in the executor that owns it.
+   */
+  static thread_local unsigned int currentIndex = 0;
+
+  /**
+   * \brief create the executor and start the threads.
+   * \param numberOfThreads the number of threads, 0 to use one thread per core.
+   */
+  Executor::Executor(unsigned int numberOfThreads) :
+    _nextQueue(0),
+    _pendingTasks(0),
+    _mustStop(false)
+  {
+    if (numberOfThreads == 0)
+    {
+      // hardware_concurrency can return 0 if it does not know.
+      numberOfThreads = (std::max)(1u, std::thread::hardware_concurrency());
+    }
+
+    // create all the queues before any of the threads start stealing from them.
+    _queues.reserve(numberOfThreads);
+    for (auto i = 0u; i < numberOfThreads; ++i)
+    {
+      _queues.emplace_back(new Queue());
+    }
+
+    _threads.reserve(numberOfThreads);
+    for (auto i = 0u; i < numberOfThreads; ++i)
+    {
+      _threads.emplace_back(&Executor::Run, this, i);
+    }
+  }
+
+  Executor::~Executor()
+  {
+    Stop();
+
+    for (auto queue : _queues)
+    {
+      delete queue;
+    }
+    _queues.clear();
+  }
+
+  /**
+   * \brief the number of threads running the tasks.
+   * \return the number of threads.
+   */
+  unsigned int Executor::NumberOfThreads() const
+  {
+    return static_cast<unsigned int>(_queues.size());
+  }
+
+  /**
+   * \brief queue a task to be run by one of the threads.
+   *        The task is not run if we have been stopped.
+   * \param task the task we want to run.
+   * \return if the task was queued or not.
+   */
+  bool Executor::Post(TCallback task)
+  {
+    if (_mustStop)
+    {
+      return false;
+    }
+
+    // a task posted by one of our own threads stays on that thread
+    // everything else is spread across all the queues.
+    const auto index = currentExecutor == this ? currentIndex : _nextQueue++ % NumberOfThreads();
+    {
+      auto& queue = *_queues[index];
+      MYODDWEB_LOCK(queue.Lock);
+      queue.Tasks.emplace_back(std::move(task));
+    }
+    ++_pendingTasks;
+
+    // wake one of the sleeping threads, the lock makes sure
+    // that it is not between checking for work and going to sleep.
+    {
+      MYODDWEB_LOCK(_lockIdle);
+    }
+    _idle.notify_one();
+    return true;
+  }
+
+  /**
+   * \brief run all the tasks still queued and wait for all the threads to complete.
+   *        No new tasks can be posted once this has been called.
+   */
+  void Executor::Stop()
+  {
+    MYODDWEB_PROFILE_FUNCTION();
+    {
+      MYODDWEB_LOCK(_lockIdle);
+      _mustStop = true;
+    }
+    _idle.notify_all();
+
+    for (auto& thread : _threads)
+    {
+      // we cannot join ourselves, a task should never stop its own executor.
+      if (thread.joinable() && thread.get_id() != std::this_thread::get_id())
+      {
+        thread.join();
+      }
+    }
+    _threads.clear();
+  }
+
+  /**
+   * \brief the main body of each of our threads.
+   * \param index the index of the thread, and of its queue.
+   */
+  void Executor::Run(const unsigned int index)
+  {
+    currentExecutor = this;
+    currentIndex = index;
+
+    TCallback task;
+    for (;;)
+    {
+      if (TryGetTask(index, task))
+      {
+        RunTask(task);
+        task = nullptr;
+        continue;
+      }
+
+      // we only get out once all the work is done.
+      if (_mustStop)
+      {
+        break;
+      }
+      WaitForTask();
+    }
+
+    currentExecutor = nullptr;
+  }
+
+  /**
+   * \brief take the newest task from our own queue or steal the oldest from another queue.
+   * \param index the index of the thread looking for work.
+   * \param task the task we found.
+   * \return if we found a task or not.
+   */
+  bool Executor::TryGetTask(const unsigned int index, TCallback& task)
+  {
+    if (_pendingTasks <= 0)
+    {
+      return false;
+    }
+
+    {
+      auto& queue = *_queues[index];
+      MYODDWEB_LOCK(queue.Lock);
+      if (!queue.Tasks.empty())
+      {
+        task = std::move(queue.Tasks.back());
+        queue.Tasks.pop_back();
+        --_pendingTasks;
+        return true;
+      }
+    }
+
+    // our own queue is empty, look at the others, starting with our neighbour
+    // so all the idle threads do not go after the same queue.
+    const auto numberOfThreads = NumberOfThreads();
+    for (auto i = 1u; i < numberOfThreads; ++i)
+    {
+      auto& queue = *_queues[(index + i) % numberOfThreads];
+      MYODDWEB_LOCK(queue.Lock);
+      if (!queue.Tasks.empty())
+      {
+        task = std::move(queue.Tasks.front());
+        queue.Tasks.pop_front();
+        --_pendingTasks;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * \brief run a single task and log any exception it throws.
+   * \param task the task to run.
+   */
+  void Executor::RunTask(const TCallback& task)
+  {
+    try
+    {
+      task();
+    }
+    catch (const std::exception& e)
+    {
+      // log the error
+      Logger::Log(LogLevel::Error, L"Caught exception '%hs' in executor task.", e.what());
+    }
+    catch (...)
+    {
+      Logger::Log(LogLevel::Error, L"Caught unknown exception in executor task.");
+    }
+  }
+
+  /**
+   * \brief put the thread to sleep until there is some work or we are stopped.
+   */
+  void Executor::WaitForTask()
+  {
+    {
+      std::unique_lock<MYODDWEB_MUTEX> lock(_lockIdle);
+      _idle.wait_for(lock, std::chrono::milliseconds(MYODDWEB_MIN_THREADPOOL_SLEEP), [this]
+      {
+        return _mustStop || _pendingTasks > 0;
+      });
+    }
+
+#if defined( _WIN32) || defined(_WIN64 )
+    // a task might have started some IO on this thread, the completion routines
+    // are only called when we are in an alertable state.
+    ::SleepEx(0, true);
+#endif
+  }
+}
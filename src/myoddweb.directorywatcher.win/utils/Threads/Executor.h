@@ -0,0 +1,125 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <vector>
+
+#include "../../monitors/Base.h"
+#include "Thread.h"
+
+namespace myoddweb:: directorywatcher:: threads
+{
+  /**
+   * \brief a fixed number of threads running short tasks.
+   *        Each thread has its own queue, tasks posted from one of our threads stay on that thread
+   *        and an idle thread will steal the oldest task from another thread's queue.
+   */
+  class Executor final
+  {
+    /**
+     * \brief the queue of tasks owned by one of our threads.
+     *        The owner takes the newest task, thieves take the oldest.
+     */
+    struct Queue
+    {
+      MYODDWEB_MUTEX Lock;
+      std::deque<TCallback> Tasks;
+    };
+
+    /**
+     * \brief one queue per thread.
+     */
+    std::vector<Queue*> _queues;
+
+    /**
+     * \brief the running threads.
+     */
+    std::vector<std::thread> _threads;
+
+    /**
+     * \brief the queue we will post to next when the caller is not one of our threads.
+     */
+    std::atomic<unsigned int> _nextQueue;
+
+    /**
+     * \brief the number of tasks posted but not yet taken by a thread.
+     */
+    std::atomic<long> _pendingTasks;
+
+    /**
+     * \brief set when we want the threads to finish the work and exit.
+     */
+    std::atomic<bool> _mustStop;
+
+    /**
+     * \brief the lock and condition used to put idle threads to sleep.
+     */
+    MYODDWEB_MUTEX _lockIdle;
+    std::condition_variable _idle;
+
+  public:
+    Executor(const Executor&) = delete;
+    Executor(Executor&&) = delete;
+    Executor() = delete;
+    const Executor& operator=(const Executor&) = delete;
+    const Executor& operator=(const Executor&&) = delete;
+
+    /**
+     * \brief create the executor and start the threads.
+     * \param numberOfThreads the number of threads, 0 to use one thread per core.
+     */
+    explicit Executor(unsigned int numberOfThreads);
+    ~Executor();
+
+    /**
+     * \brief the number of threads running the tasks.
+     * \return the number of threads.
+     */
+    [[nodiscard]]
+    unsigned int NumberOfThreads() const;
+
+    /**
+     * \brief queue a task to be run by one of the threads.
+     *        The task is not run if we have been stopped.
+     * \param task the task we want to run.
+     * \return if the task was queued or not.
+     */
+    bool Post(TCallback task);
+
+    /**
+     * \brief run all the tasks still queued and wait for all the threads to complete.
+     *        No new tasks can be posted once this has been called.
+     */
+    void Stop();
+
+  private:
+    /**
+     * \brief the main body of each of our threads.
+     * \param index the index of the thread, and of its queue.
+     */
+    void Run(unsigned int index);
+
+    /**
+     * \brief take the newest task from our own queue or steal the oldest from another queue.
+     * \param index the index of the thread looking for work.
+     * \param task the task we found.
+     * \return if we found a task or not.
+     */
+    bool TryGetTask(unsigned int index, TCallback& task);
+
+    /**
+     * \brief run a single task and log any exception it throws.
+     * \param task the task to run.
+     */
+    static void RunTask(const TCallback& task);
+
+    /**
+     * \brief put the thread to sleep until there is some work or we are stopped.
+     */
+    void WaitForTask();
+  };
+}
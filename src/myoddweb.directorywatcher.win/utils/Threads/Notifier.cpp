@@ -0,0 +1,63 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#include "Notifier.h"
+#include <chrono>
+#include <mutex>
+#include "../Lock.h"
+
+namespace myoddweb:: directorywatcher:: threads
+{
+  /**
+   * \brief wake all the waiting threads so they check their condition again.
+   *        This must be called after what the condition depends on has changed.
+   */
+  void Notifier::NotifyAll()
+  {
+    // make sure the change is visible before we check for waiting threads,
+    // a thread that starts waiting after this check will see the change when it checks its condition.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_numberOfWaitingThreads == 0)
+    {
+      return;
+    }
+
+    // a thread that checked the condition before the change is already waiting once we have the lock
+    // and a thread that checks it after we release it will see the change, so no wake up is lost.
+    {
+      MYODDWEB_LOCK(_lock);
+    }
+    _condition.notify_all();
+  }
+
+  /**
+   * \brief wait until the condition is true or until we timeout.
+   * \param condition the condition we are waiting for, it is checked while holding our lock.
+   * \param milliseconds how long we want to wait, -1 to wait forever.
+   * \return if the condition is true.
+   */
+  bool Notifier::WaitUntil(const std::function<bool()>& condition, const long long milliseconds)
+  {
+    std::unique_lock<MYODDWEB_MUTEX> lock(_lock);
+    ++_numberOfWaitingThreads;
+    auto result = true;
+    try
+    {
+      if (milliseconds < 0)
+      {
+        _condition.wait(lock, condition);
+      }
+      else
+      {
+        result = _condition.wait_for(lock, std::chrono::milliseconds(milliseconds), condition);
+      }
+    }
+    catch (...)
+    {
+      --_numberOfWaitingThreads;
+      throw;
+    }
+    --_numberOfWaitingThreads;
+    return result;
+  }
+}
@@ -0,0 +1,61 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+
+#include "../../monitors/Base.h"
+
+namespace myoddweb:: directorywatcher:: threads
+{
+  /**
+   * \brief lets any number of threads sleep until a condition is true.
+   *        Whoever changes what the condition depends on calls NotifyAll( ... ) and the waiting threads check it again.
+   *        Unlike Wait::SpinUntil( ... ) the waiting threads do not use any cpu while they wait
+   *        and notifying costs next to nothing when nobody is waiting.
+   *        The change must be made before calling NotifyAll( ... ), otherwise a waiting thread could miss it.
+   */
+  class Notifier final
+  {
+  public:
+    Notifier() = default;
+    ~Notifier() = default;
+
+    Notifier(const Notifier&) = delete;
+    Notifier(Notifier&&) = delete;
+    const Notifier& operator=(const Notifier&) = delete;
+    Notifier& operator=(Notifier&&) = delete;
+
+    /**
+     * \brief wake all the waiting threads so they check their condition again.
+     *        This must be called after what the condition depends on has changed.
+     */
+    void NotifyAll();
+
+    /**
+     * \brief wait until the condition is true or until we timeout.
+     * \param condition the condition we are waiting for, it is checked while holding our lock.
+     * \param milliseconds how long we want to wait, -1 to wait forever.
+     * \return if the condition is true.
+     */
+    bool WaitUntil(const std::function<bool()>& condition, long long milliseconds);
+
+  private:
+    /**
+     * \brief the lock the waiting threads check the condition with.
+     */
+    MYODDWEB_MUTEX _lock;
+
+    /**
+     * \brief the waiting threads.
+     */
+    std::condition_variable _condition;
+
+    /**
+     * \brief the number of threads waiting, if there are none we do not need to notify anyone.
+     */
+    std::atomic<int> _numberOfWaitingThreads = 0;
+  };
+}
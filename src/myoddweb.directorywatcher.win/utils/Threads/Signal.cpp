@@ -0,0 +1,207 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#include "Signal.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include "../Lock.h"
+
+#if defined(_WIN32)
+  #include <windows.h>
+#elif defined(__linux__)
+  #include <cerrno>
+  #include <cstdint>
+  #include <sys/epoll.h>
+  #include <sys/eventfd.h>
+  #include <unistd.h>
+#endif
+
+namespace myoddweb:: directorywatcher:: threads
+{
+#if defined(_WIN32)
+  Signal::Signal() :
+    _event(::CreateEventW(nullptr, FALSE, FALSE, nullptr))
+  {
+  }
+
+  Signal::~Signal()
+  {
+    if (_event != nullptr)
+    {
+      ::CloseHandle(_event);
+    }
+    _event = nullptr;
+  }
+
+  /**
+   * \brief wake the waiting thread, or the next thread that waits.
+   *        This is thread safe and never blocks.
+   */
+  void Signal::Set()
+  {
+    ::SetEvent(_event);
+  }
+
+  /**
+   * \brief wait for the signal to be set, or for the timeout.
+   * \param milliseconds how long we want to wait, -1 to wait forever.
+   * \return true if we were woken up, false if we timed out.
+   */
+  bool Signal::WaitFor(const long long milliseconds)
+  {
+    const auto timeout = milliseconds < 0 ? INFINITE : static_cast<DWORD>((std::min<long long>)(milliseconds, INFINITE - 1));
+
+    // the wait is alertable, if a completion routine is called we also return
+    // as it will have queued some data that needs to be processed.
+    switch (::WaitForSingleObjectEx(_event, timeout, TRUE))
+    {
+    case WAIT_OBJECT_0:
+    case WAIT_IO_COMPLETION:
+      return true;
+
+    default:
+      return false;
+    }
+  }
+#elif defined(__linux__)
+  Signal::Signal() :
+    _epoll(::epoll_create1(EPOLL_CLOEXEC)),
+    _eventFd(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+  {
+    // our own event has no flag, so we know when it is us.
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    ::epoll_ctl(_epoll, EPOLL_CTL_ADD, _eventFd, &event);
+  }
+
+  Signal::~Signal()
+  {
+    ::close(_eventFd);
+    ::close(_epoll);
+  }
+
+  /**
+   * \brief wake the waiting thread, or the next thread that waits.
+   *        This is thread safe and never blocks.
+   */
+  void Signal::Set()
+  {
+    const uint64_t value = 1;
+    (void)::write(_eventFd, &value, sizeof(value));
+  }
+
+  /**
+   * \brief wait for the signal to be set, or for the timeout.
+   * \param milliseconds how long we want to wait, -1 to wait forever.
+   * \return true if we were woken up, false if we timed out.
+   */
+  bool Signal::WaitFor(const long long milliseconds)
+  {
+    const auto timeout = milliseconds < 0 ? -1 : static_cast<int>((std::min<long long>)(milliseconds, INT_MAX));
+
+    epoll_event events[16];
+    const auto count = ::epoll_wait(_epoll, events, 16, timeout);
+    if (count < 0)
+    {
+      // interrupted, the caller will simply check everything again.
+      return errno == EINTR;
+    }
+
+    for (auto i = 0; i < count; ++i)
+    {
+      if (events[i].data.ptr == nullptr)
+      {
+        // reset our own event.
+        uint64_t value;
+        (void)::read(_eventFd, &value, sizeof(value));
+        continue;
+      }
+      _ready.push_back(events[i].data.ptr);
+    }
+    return count > 0;
+  }
+
+  /**
+   * \brief wake the waiting thread once the file descriptor has something to read.
+   *        The watch only fires once, call it again to re-arm it once the data has been read.
+   * \param fd the file descriptor we are watching.
+   * \param context what the file descriptor is for, (not null), given back by TakeReady( ... ) once it is ready.
+   * \return if the file descriptor is now watched.
+   */
+  bool Signal::Watch(const int fd, void* context)
+  {
+    epoll_event event = {};
+    event.events = EPOLLIN | EPOLLONESHOT;
+    event.data.ptr = context;
+
+    // re-arm it if we are already watching it.
+    if (::epoll_ctl(_epoll, EPOLL_CTL_MOD, fd, &event) == 0)
+    {
+      return true;
+    }
+    return errno == ENOENT && ::epoll_ctl(_epoll, EPOLL_CTL_ADD, fd, &event) == 0;
+  }
+
+  /**
+   * \brief stop watching a file descriptor, this must be done before it is closed.
+   * \param fd the file descriptor we no longer want to watch.
+   */
+  void Signal::Unwatch(const int fd)
+  {
+    ::epoll_ctl(_epoll, EPOLL_CTL_DEL, fd, nullptr);
+  }
+
+  /**
+   * \brief take the context of the file descriptors that were ready when we last waited.
+   *        This must be called by the waiting thread.
+   * \param ready where we add the contexts.
+   */
+  void Signal::TakeReady(std::vector<void*>& ready)
+  {
+    ready.insert(ready.end(), _ready.begin(), _ready.end());
+    _ready.clear();
+  }
+#else
+  Signal::Signal() :
+    _set(false)
+  {
+  }
+
+  Signal::~Signal() = default;
+
+  /**
+   * \brief wake the waiting thread, or the next thread that waits.
+   *        This is thread safe and never blocks.
+   */
+  void Signal::Set()
+  {
+    {
+      MYODDWEB_LOCK(_lock);
+      _set = true;
+    }
+    _condition.notify_one();
+  }
+
+  /**
+   * \brief wait for the signal to be set, or for the timeout.
+   * \param milliseconds how long we want to wait, -1 to wait forever.
+   * \return true if we were woken up, false if we timed out.
+   */
+  bool Signal::WaitFor(const long long milliseconds)
+  {
+    std::unique_lock<MYODDWEB_MUTEX> lock(_lock);
+    if (milliseconds < 0)
+    {
+      _condition.wait(lock, [this] { return _set; });
+    }
+    else if (!_condition.wait_for(lock, std::chrono::milliseconds(milliseconds), [this] { return _set; }))
+    {
+      return false;
+    }
+    _set = false;
+    return true;
+  }
+#endif
+}
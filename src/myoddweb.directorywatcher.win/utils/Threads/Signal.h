@@ -0,0 +1,96 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#pragma once
+#include <atomic>
+#include <vector>
+#if !defined(_WIN32) && !defined(__linux__)
+  #include <condition_variable>
+#endif
+
+#include "../../monitors/Base.h"
+
+namespace myoddweb:: directorywatcher:: threads
+{
+  /**
+   * \brief a wakeup that one or more threads can set and that one thread waits for.
+   *        Once the waiting thread wakes up the signal is reset.
+   *        On windows the wait is alertable so IO completion routines are called while we wait.
+   *        On linux file descriptors can also be watched, (see Watch( ... ) ).
+   */
+  class Signal final
+  {
+  public:
+    Signal();
+    ~Signal();
+
+    Signal(const Signal&) = delete;
+    Signal(Signal&&) = delete;
+    const Signal& operator=(const Signal&) = delete;
+    Signal& operator=(Signal&&) = delete;
+
+    /**
+     * \brief wake the waiting thread, or the next thread that waits.
+     *        This is thread safe and never blocks.
+     */
+    void Set();
+
+    /**
+     * \brief wait for the signal to be set, or for the timeout.
+     * \param milliseconds how long we want to wait, -1 to wait forever.
+     * \return true if we were woken up, false if we timed out.
+     */
+    bool WaitFor(long long milliseconds);
+
+#if defined(__linux__)
+    /**
+     * \brief wake the waiting thread once the file descriptor has something to read.
+     *        The watch only fires once, call it again to re-arm it once the data has been read.
+     * \param fd the file descriptor we are watching.
+     * \param context what the file descriptor is for, (not null), given back by TakeReady( ... ) once it is ready.
+     * \return if the file descriptor is now watched.
+     */
+    bool Watch(int fd, void* context);
+
+    /**
+     * \brief take the context of the file descriptors that were ready when we last waited.
+     *        This must be called by the waiting thread.
+     * \param ready where we add the contexts.
+     */
+    void TakeReady(std::vector<void*>& ready);
+
+    /**
+     * \brief stop watching a file descriptor, this must be done before it is closed.
+     * \param fd the file descriptor we no longer want to watch.
+     */
+    void Unwatch(int fd);
+#endif
+
+  private:
+#if defined(_WIN32)
+    /**
+     * \brief the auto reset event handle.
+     */
+    void* _event;
+#elif defined(__linux__)
+    /**
+     * \brief the epoll handle we wait on.
+     */
+    int _epoll;
+
+    /**
+     * \brief the event file descriptor we write to when we are set.
+     */
+    int _eventFd;
+
+    /**
+     * \brief the context of the watched file descriptors that are ready.
+     */
+    std::vector<void*> _ready;
+#else
+    MYODDWEB_MUTEX _lock;
+    std::condition_variable _condition;
+    bool _set;
+#endif
+  };
+}
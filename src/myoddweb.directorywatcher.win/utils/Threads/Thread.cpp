@@ -2,11 +2,11 @@
 // Florent Guelfucci licenses this file to you under the MIT license.
 // See the LICENSE file in the project root for more information.
 #include "Thread.h"
+#include <stdexcept>
 
 #include "../../monitors/Base.h"
 #include "../Logger.h"
 #include "../LogLevel.h"
-#include "../Wait.h"
 #include "CallbackWorker.h"
 #include "WaitResult.h"
 
@@ -85,7 +85,7 @@ namespace myoddweb::directorywatcher::threads
       break;
 
     default:
-      throw std::exception("Unknown worker type!");
+      throw std::runtime_error("Unknown worker type!");
     }
 
     // otherwise return if the parent is compelted or not.
@@ -122,7 +122,7 @@ namespace myoddweb::directorywatcher::threads
       break;
 
     default:
-      throw std::exception("Unknown worker type!");
+      throw std::runtime_error("Unknown worker type!");
     }
 
     // otherwise return if the parent is started or not.
@@ -149,7 +149,7 @@ namespace myoddweb::directorywatcher::threads
       break;
 
     default:
-      throw std::exception("Unknown worker type!");
+      throw std::runtime_error("Unknown worker type!");
     }
   }
 
@@ -202,9 +202,8 @@ namespace myoddweb::directorywatcher::threads
       return WaitResult::complete;
     }
 
-    if (!Wait::SpinUntil([&]
+    if (!Worker::WaitUntil([&]
       {
-        MYODDWEB_YIELD();
         return worker->Completed();
       },
       timeout))
@@ -0,0 +1,285 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#include "TimerWheel.h"
+#include <algorithm>
+
+namespace myoddweb:: directorywatcher:: threads
+{
+  /**
+   * \brief create a timer that is not scheduled.
+   * \param owner what the timer is for, given back when it expires.
+   */
+  TimerWheel::Timer::Timer(void* owner) :
+    _owner(owner),
+    _previous(nullptr),
+    _next(nullptr),
+    _deadlineTick(0),
+    _list(-1)
+  {
+  }
+
+  /**
+   * \brief what the timer is for.
+   */
+  void* TimerWheel::Timer::Owner() const
+  {
+    return _owner;
+  }
+
+  /**
+   * \brief if the timer is currently in a wheel.
+   */
+  bool TimerWheel::Timer::Scheduled() const
+  {
+    return _list != -1;
+  }
+
+  /**
+   * \brief create the wheel
+   * \param tickMilliseconds the number of ms in a tick.
+   * \param nowMilliseconds the current time, all the times given to the wheel must use the same clock.
+   */
+  TimerWheel::TimerWheel(const long long tickMilliseconds, const long long nowMilliseconds) :
+    _tickMilliseconds((std::max)(tickMilliseconds, 1LL)),
+    _originMilliseconds(nowMilliseconds),
+    _currentTick(0),
+    _lists{},
+    _size(0)
+  {
+  }
+
+  /**
+   * \brief add a timer to the wheel, if it was already scheduled it is moved.
+   * \param timer the timer we are adding.
+   * \param deadlineMilliseconds when the timer expires, if it is in the past it expires on the next advance.
+   */
+  void TimerWheel::Schedule(Timer& timer, const long long deadlineMilliseconds)
+  {
+    Cancel(timer);
+    timer._deadlineTick = ToTick(deadlineMilliseconds);
+    Insert(timer);
+  }
+
+  /**
+   * \brief remove a timer from the wheel, if it is scheduled.
+   * \param timer the timer we are removing.
+   */
+  void TimerWheel::Cancel(Timer& timer)
+  {
+    if (timer.Scheduled())
+    {
+      Unlink(timer);
+    }
+  }
+
+  /**
+   * \brief move the time forward and take all the timers that expired.
+   * \param nowMilliseconds the current time.
+   * \param expired where the timers that expired are added, they are no longer scheduled.
+   */
+  void TimerWheel::Advance(const long long nowMilliseconds, std::vector<Timer*>& expired)
+  {
+    TakeAll(DueList, expired);
+
+    const auto lastTick = (nowMilliseconds - _originMilliseconds) / _tickMilliseconds;
+    while (_currentTick <= lastTick)
+    {
+      if (_size == 0)
+      {
+        // nothing can expire, so there is no need to go around the slots.
+        _currentTick = lastTick + 1;
+        break;
+      }
+
+      // once a turn of a level is complete, the next slot of the level above is moved down.
+      for (auto level = 1; level < MYODDWEB_TIMERWHEEL_LEVELS; ++level)
+      {
+        if (((_currentTick >> (SlotBits * (level - 1))) & SlotMask) != 0)
+        {
+          break;
+        }
+        Cascade(level, (_currentTick >> (SlotBits * level)) & SlotMask);
+      }
+
+      // everything in the first level slot expires on that exact tick.
+      TakeAll(static_cast<int>(_currentTick & SlotMask), expired);
+      ++_currentTick;
+    }
+  }
+
+  /**
+   * \brief the next time we need to advance the wheel, either because a timer expires
+   *        or because a slot needs to be moved to a lower level.
+   *        This only looks at the first slot of each level, so it does not depend on the number of timers.
+   * \return the time in ms or MYODDWEB_TIMERWHEEL_NEVER if we have no timers.
+   */
+  long long TimerWheel::NextAdvanceMilliseconds() const
+  {
+    if (_size == 0)
+    {
+      return MYODDWEB_TIMERWHEEL_NEVER;
+    }
+    if (_lists[DueList] != nullptr)
+    {
+      return _originMilliseconds + (_currentTick - 1) * _tickMilliseconds;
+    }
+
+    auto nextTick = MYODDWEB_TIMERWHEEL_NEVER;
+    for (auto i = 0; i < MYODDWEB_TIMERWHEEL_SLOTS; ++i)
+    {
+      const auto tick = _currentTick + i;
+      if (_lists[tick & SlotMask] != nullptr)
+      {
+        nextTick = tick;
+        break;
+      }
+    }
+
+    // the upper levels are moved down on the first tick of their slot.
+    for (auto level = 1; level < MYODDWEB_TIMERWHEEL_LEVELS; ++level)
+    {
+      const auto shift = SlotBits * level;
+      for (auto i = 0; i < MYODDWEB_TIMERWHEEL_SLOTS; ++i)
+      {
+        const auto block = (_currentTick >> shift) + i;
+        const auto tick = block << shift;
+        if (tick < _currentTick)
+        {
+          // we are already past the start of that slot, it was moved down.
+          continue;
+        }
+        if (_lists[level * MYODDWEB_TIMERWHEEL_SLOTS + (block & SlotMask)] != nullptr)
+        {
+          nextTick = (std::min)(nextTick, tick);
+          break;
+        }
+      }
+    }
+    return _originMilliseconds + nextTick * _tickMilliseconds;
+  }
+
+  /**
+   * \brief the number of timers in the wheel.
+   */
+  size_t TimerWheel::Size() const
+  {
+    return _size;
+  }
+
+  /**
+   * \brief convert a time to the first tick that is not before it.
+   * \param milliseconds the time we are converting.
+   * \return the tick.
+   */
+  long long TimerWheel::ToTick(const long long milliseconds) const
+  {
+    const auto elapsed = milliseconds - _originMilliseconds;
+    if (elapsed <= 0)
+    {
+      return 0;
+    }
+    if (elapsed >= MYODDWEB_TIMERWHEEL_NEVER - _tickMilliseconds)
+    {
+      return MYODDWEB_TIMERWHEEL_NEVER / _tickMilliseconds;
+    }
+    return (elapsed + _tickMilliseconds - 1) / _tickMilliseconds;
+  }
+
+  /**
+   * \brief add a timer to the list of its deadline.
+   * \param timer the timer.
+   */
+  void TimerWheel::Insert(Timer& timer)
+  {
+    const auto delta = timer._deadlineTick - _currentTick;
+    if (delta < 0)
+    {
+      Link(timer, DueList);
+      return;
+    }
+
+    for (auto level = 0; level < MYODDWEB_TIMERWHEEL_LEVELS - 1; ++level)
+    {
+      if (delta < (1LL << (SlotBits * (level + 1))))
+      {
+        Link(timer, level * MYODDWEB_TIMERWHEEL_SLOTS + static_cast<int>((timer._deadlineTick >> (SlotBits * level)) & SlotMask));
+        return;
+      }
+    }
+
+    // the last level, if it is further than a whole turn it will be moved down
+    // at the end of the turn and put back here until it is close enough.
+    constexpr auto level = MYODDWEB_TIMERWHEEL_LEVELS - 1;
+    const auto tick = _currentTick + (std::min)(delta, (1LL << (SlotBits * (level + 1))) - 1);
+    Link(timer, level * MYODDWEB_TIMERWHEEL_SLOTS + static_cast<int>((tick >> (SlotBits * level)) & SlotMask));
+  }
+
+  /**
+   * \brief add a timer to the front of a list.
+   * \param timer the timer.
+   * \param list the list we are adding to.
+   */
+  void TimerWheel::Link(Timer& timer, const int list)
+  {
+    timer._list = list;
+    timer._previous = nullptr;
+    timer._next = _lists[list];
+    if (timer._next != nullptr)
+    {
+      timer._next->_previous = &timer;
+    }
+    _lists[list] = &timer;
+    ++_size;
+  }
+
+  /**
+   * \brief remove a timer from its list.
+   * \param timer the timer.
+   */
+  void TimerWheel::Unlink(Timer& timer)
+  {
+    (timer._previous == nullptr ? _lists[timer._list] : timer._previous->_next) = timer._next;
+    if (timer._next != nullptr)
+    {
+      timer._next->_previous = timer._previous;
+    }
+    timer._previous = nullptr;
+    timer._next = nullptr;
+    timer._list = -1;
+    --_size;
+  }
+
+  /**
+   * \brief move all the timers of a slot to the lower levels.
+   * \param level the level of the slot.
+   * \param slot the slot.
+   */
+  void TimerWheel::Cascade(const int level, const long long slot)
+  {
+    const auto list = level * MYODDWEB_TIMERWHEEL_SLOTS + static_cast<int>(slot);
+    auto timer = _lists[list];
+    while (timer != nullptr)
+    {
+      const auto next = timer->_next;
+      Unlink(*timer);
+      Insert(*timer);
+      timer = next;
+    }
+  }
+
+  /**
+   * \brief take all the timers of a list.
+   * \param list the list.
+   * \param expired where we add the timers.
+   */
+  void TimerWheel::TakeAll(const int list, std::vector<Timer*>& expired)
+  {
+    while (_lists[list] != nullptr)
+    {
+      const auto timer = _lists[list];
+      Unlink(*timer);
+      expired.push_back(timer);
+    }
+  }
+}
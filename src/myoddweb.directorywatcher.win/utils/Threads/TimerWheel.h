@@ -0,0 +1,203 @@
+// Licensed to Florent Guelfucci under one or more agreements.
+// Florent Guelfucci licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+#pragma once
+#include <cstddef>
+#include <vector>
+
+#include "../../monitors/Base.h"
+
+namespace myoddweb:: directorywatcher:: threads
+{
+  /**
+   * \brief a hierarchical timing wheel, the timers are kept in slots of ticks rather than sorted.
+   *        Each level has MYODDWEB_TIMERWHEEL_SLOTS slots, the first level has one slot per tick
+   *        and each slot of the next level covers a whole turn of the level below it.
+   *        When a turn of a level completes, the next slot of the level above is moved down.
+   *        So scheduling and cancelling a timer is O(1) and advancing the time only looks at the slots that are due.
+   *        A timer is never expired before its deadline and never more than one tick after it.
+   *        This class is not thread safe.
+   */
+  class TimerWheel final
+  {
+  public:
+    /**
+     * \brief a timer that can be added to the wheel, it is owned by the caller
+     *        and must be cancelled before it is destroyed.
+     */
+    class Timer final
+    {
+    public:
+      /**
+       * \brief create a timer that is not scheduled.
+       * \param owner what the timer is for, given back when it expires.
+       */
+      explicit Timer(void* owner);
+
+      Timer(const Timer&) = delete;
+      Timer(Timer&&) = delete;
+      const Timer& operator=(const Timer&) = delete;
+      Timer& operator=(Timer&&) = delete;
+
+      /**
+       * \brief what the timer is for.
+       */
+      [[nodiscard]]
+      void* Owner() const;
+
+      /**
+       * \brief if the timer is currently in a wheel.
+       */
+      [[nodiscard]]
+      bool Scheduled() const;
+
+    private:
+      friend class TimerWheel;
+
+      void* const _owner;
+      Timer* _previous;
+      Timer* _next;
+
+      /**
+       * \brief the tick the timer expires on.
+       */
+      long long _deadlineTick;
+
+      /**
+       * \brief the list the timer is in, -1 if it is not scheduled.
+       */
+      int _list;
+    };
+
+    /**
+     * \brief create the wheel
+     * \param tickMilliseconds the number of ms in a tick.
+     * \param nowMilliseconds the current time, all the times given to the wheel must use the same clock.
+     */
+    TimerWheel(long long tickMilliseconds, long long nowMilliseconds);
+    ~TimerWheel() = default;
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel(TimerWheel&&) = delete;
+    const TimerWheel& operator=(const TimerWheel&) = delete;
+    TimerWheel& operator=(TimerWheel&&) = delete;
+
+    /**
+     * \brief add a timer to the wheel, if it was already scheduled it is moved.
+     * \param timer the timer we are adding.
+     * \param deadlineMilliseconds when the timer expires, if it is in the past it expires on the next advance.
+     */
+    void Schedule(Timer& timer, long long deadlineMilliseconds);
+
+    /**
+     * \brief remove a timer from the wheel, if it is scheduled.
+     * \param timer the timer we are removing.
+     */
+    void Cancel(Timer& timer);
+
+    /**
+     * \brief move the time forward and take all the timers that expired.
+     * \param nowMilliseconds the current time.
+     * \param expired where the timers that expired are added, they are no longer scheduled.
+     */
+    void Advance(long long nowMilliseconds, std::vector<Timer*>& expired);
+
+    /**
+     * \brief the next time we need to advance the wheel, either because a timer expires
+     *        or because a slot needs to be moved to a lower level.
+     *        This only looks at the first slot of each level, so it does not depend on the number of timers.
+     * \return the time in ms or MYODDWEB_TIMERWHEEL_NEVER if we have no timers.
+     */
+    [[nodiscard]]
+    long long NextAdvanceMilliseconds() const;
+
+    /**
+     * \brief the number of timers in the wheel.
+     */
+    [[nodiscard]]
+    size_t Size() const;
+
+  private:
+    /**
+     * \brief the number of lists, one per slot and one for the timers that are already due.
+     */
+    static constexpr int NumberOfLists = MYODDWEB_TIMERWHEEL_LEVELS * MYODDWEB_TIMERWHEEL_SLOTS + 1;
+
+    /**
+     * \brief the list of the timers that are already due.
+     */
+    static constexpr int DueList = NumberOfLists - 1;
+
+    /**
+     * \brief the number of bits of a slot number.
+     */
+    static constexpr int SlotBits = MYODDWEB_TIMERWHEEL_SLOT_BITS;
+
+    /**
+     * \brief the mask of a slot number.
+     */
+    static constexpr long long SlotMask = MYODDWEB_TIMERWHEEL_SLOTS - 1;
+
+    /**
+     * \brief convert a time to the first tick that is not before it.
+     * \param milliseconds the time we are converting.
+     * \return the tick.
+     */
+    long long ToTick(long long milliseconds) const;
+
+    /**
+     * \brief add a timer to the list of its deadline.
+     * \param timer the timer.
+     */
+    void Insert(Timer& timer);
+
+    /**
+     * \brief add a timer to the front of a list.
+     * \param timer the timer.
+     * \param list the list we are adding to.
+     */
+    void Link(Timer& timer, int list);
+
+    /**
+     * \brief remove a timer from its list.
+     * \param timer the timer.
+     */
+    void Unlink(Timer& timer);
+
+    /**
+     * \brief move all the timers of a slot to the lower levels.
+     * \param level the level of the slot.
+     * \param slot the slot.
+     */
+    void Cascade(int level, long long slot);
+
+    /**
+     * \brief take all the timers of a list.
+     * \param list the list.
+     * \param expired where we add the timers.
+     */
+    void TakeAll(int list, std::vector<Timer*>& expired);
+
+    const long long _tickMilliseconds;
+
+    /**
+     * \brief the time of tick 0.
+     */
+    const long long _originMilliseconds;
+
+    /**
+     * \brief the next tick we will process, everything before it has expired.
+     */
+    long long _currentTick;
+
+    /**
+     * \brief the first timer of each list.
+     */
+    Timer* _lists[NumberOfLists];
+
+    /**
+     * \brief the number of timers in the wheel.
+     */
+    size_t _size;
+  };
+}
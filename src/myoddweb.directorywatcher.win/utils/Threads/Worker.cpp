@@ -2,17 +2,25 @@
 // Florent Guelfucci licenses this file to you under the MIT license.
 // See the LICENSE file in the project root for more information.
 #include "Worker.h"
+#include <stdexcept>
 #include "../../monitors/Base.h"
 #include "../Instrumentor.h"
 #include "../Lock.h"
 #include "../Logger.h"
 #include "../LogLevel.h"
 #include "../Wait.h"
+#include "Notifier.h"
 
 namespace myoddweb::directorywatcher::threads
 {
   Worker::Worker() :
-    _state( State::unknown )
+    _state( State::unknown ),
+    _poolUpdating( false ),
+    _poolWakeRequested( false ),
+    _poolLastUpdateMilliseconds( 0 ),
+    _poolTimer( this ),
+    _poolRunning( false ),
+    _poolIndex( 0 )
   {
     // set he current time point
     _timePoint1 = std::chrono::system_clock::now();
@@ -44,6 +52,46 @@ namespace myoddweb::directorywatcher::threads
     }
   }
 
+  /**
+   * \brief the notifier shared by all the workers, it outlives them
+   *        so a worker can be deleted as soon as its state says it is complete.
+   */
+  static Notifier& StateNotifier()
+  {
+    static Notifier notifier;
+    return notifier;
+  }
+
+  /**
+   * \brief wait, without using any cpu, until a condition on the state of one or more workers is true.
+   *        The condition is checked again each time the state of any worker changes.
+   * \param condition the condition we are waiting for, it must only depend on the state of the workers.
+   * \param timeout how long we want to wait, -1 to wait forever.
+   * \return if the condition is true.
+   */
+  bool Worker::WaitUntil(const std::function<bool()>& condition, const long long timeout)
+  {
+    return StateNotifier().WaitUntil(condition, timeout);
+  }
+
+  /**
+   * \brief wake whoever is waiting for the state of a worker to change.
+   */
+  void Worker::NotifyStateChanged()
+  {
+    StateNotifier().NotifyAll();
+  }
+
+  /**
+   * \brief change the state and wake whoever is waiting for it, (see WaitUntil( ... ) ).
+   * \param state the new state.
+   */
+  void Worker::SetState(const State state)
+  {
+    _state = state;
+    NotifyStateChanged();
+  }
+
   /**
    * \brief Check if the current state is the one we are after given one
    * \param state the state we want to check for.
@@ -96,7 +144,7 @@ namespace myoddweb::directorywatcher::threads
     if (Is(State::unknown))
     {
       // we are done
-      _state = State::complete;
+      SetState(State::complete);
       return;
     }
 
@@ -108,13 +156,13 @@ namespace myoddweb::directorywatcher::threads
     }
 
     // we are stopping
-    _state = State::stopping;
+    SetState(State::stopping);
 
     // call the derived function
     OnWorkerStop();
 
     // we are done
-    _state = State::stopped;
+    SetState(State::stopped);
   }
 
   /**
@@ -163,14 +211,14 @@ namespace myoddweb::directorywatcher::threads
         break;
 
       default:
-        throw std::exception("Unknown state!");
+        throw std::runtime_error("Unknown state!");
       }
  
       // stop it, (maybe again)
       Stop();
 
-      // wait for it
-      if (false == Wait::SpinUntil([this]
+      // wait for it, we are woken up when the state changes.
+      if (false == WaitUntil([this]
         {
           return Completed();
         },
@@ -198,7 +246,7 @@ namespace myoddweb::directorywatcher::threads
   bool Worker::WorkerStart()
   {
     // we are stopping
-    _state = State::starting;
+    SetState(State::starting);
     try
     {
       // grab the lock not because we are doing anything, but because _we_ might be in the middle of an update
@@ -207,14 +255,14 @@ namespace myoddweb::directorywatcher::threads
       if (!OnWorkerStart())
       {
         // we could not even start, so we are stopped.
-        _state = State::complete;
+        SetState(State::complete);
         return false;
       }
 
       // the thread has started work.
       // we could argue that this flag should be set
       // after `OnWorkerStart()` but this is technically all part of the same thread.
-      _state = State::started;
+      SetState(State::started);
 
       // we are done
       return true;
@@ -240,8 +288,8 @@ namespace myoddweb::directorywatcher::threads
         try
         {
           // make sure that we yield to other thread
-          // from time to time.
-          MYODDWEB_YIELD();
+          // from time to time, or wait until we have something to do.
+          OnWorkerWait();
 
           // grab the lock not because we are doing anything, but because _we_ might be in the middle of an update
           MYODDWEB_LOCK(_lockState);
@@ -291,6 +339,25 @@ namespace myoddweb::directorywatcher::threads
     return OnWorkerUpdate( fElapsedTimeMilliseconds);
   }
 
+  /**
+   * \brief called between two updates when the worker runs in its own thread.
+   *        By default we only yield, but a worker can sleep until it has something to do.
+   */
+  void Worker::OnWorkerWait()
+  {
+    MYODDWEB_YIELD();
+  }
+
+  /**
+   * \brief how long we are happy to wait before our next update if nothing wakes us up.
+   *        This is only used by the worker pool, by default we want to be updated every time.
+   * \return the number of ms before we next need an update.
+   */
+  float Worker::OnWorkerNextUpdateMilliseconds() const
+  {
+    return 0;
+  }
+
   /**
    * \brief calculate the elapsed time since the last time this call was made
    * \return float the elapsed time in milliseconds.
@@ -324,7 +391,7 @@ namespace myoddweb::directorywatcher::threads
       // we cannot do the workend until the state is actually stopped.
       if (!Is(State::stopped))
       {
-        Wait::SpinUntil([=]
+        WaitUntil([=]
         {
           return _state == State::stopped;
         }, 
@@ -342,7 +409,7 @@ namespace myoddweb::directorywatcher::threads
 
     // whatever happens, we have now completed
     // nothing else can happen after this.
-    _state = State::complete;
+    SetState(State::complete);
   }
 
   /**
@@ -4,9 +4,11 @@
 #pragma once
 #include <atomic>
 #include <chrono>
+#include <functional>
 #include <mutex>
 
 #include "../../monitors/Base.h"
+#include "TimerWheel.h"
 #include "WaitResult.h"
 
 namespace myoddweb:: directorywatcher:: threads
@@ -39,6 +41,37 @@ namespace myoddweb:: directorywatcher:: threads
      */
     MYODDWEB_MUTEX _lockState;
 
+    /**
+     * \brief set while the worker pool has an update of this worker queued or running.
+     */
+    std::atomic<bool> _poolUpdating;
+
+    /**
+     * \brief set when something happened and the worker pool must update us
+     *        without waiting for our next update time.
+     */
+    std::atomic<bool> _poolWakeRequested;
+
+    /**
+     * \brief when the worker pool last updated us, so it can tell us how much time went by.
+     */
+    long long _poolLastUpdateMilliseconds;
+
+    /**
+     * \brief the timer the worker pool uses for our next update, only used by the worker pool.
+     */
+    TimerWheel::Timer _poolTimer;
+
+    /**
+     * \brief set while we are one of the running workers of the worker pool, only used by the worker pool.
+     */
+    bool _poolRunning;
+
+    /**
+     * \brief where we are in the running workers of the worker pool, only used by the worker pool.
+     */
+    size_t _poolIndex;
+
   public:
     Worker(const Worker&) = delete;
     Worker(Worker&&) = delete;
@@ -84,7 +117,27 @@ namespace myoddweb:: directorywatcher:: threads
      */
     virtual WaitResult StopAndWait( long long timeout );
 
+    /**
+     * \brief wait, without using any cpu, until a condition on the state of one or more workers is true.
+     *        The condition is checked again each time the state of any worker changes.
+     * \param condition the condition we are waiting for, it must only depend on the state of the workers.
+     * \param timeout how long we want to wait, -1 to wait forever.
+     * \return if the condition is true.
+     */
+    static bool WaitUntil(const std::function<bool()>& condition, long long timeout);
+
   private:
+    /**
+     * \brief change the state and wake whoever is waiting for it, (see WaitUntil( ... ) ).
+     * \param state the new state.
+     */
+    void SetState(State state);
+
+    /**
+     * \brief wake whoever is waiting for the state of a worker to change.
+     */
+    static void NotifyStateChanged();
+
     /**
      * \brief called when the thread is starting
      *        this should not block anything
@@ -147,6 +200,20 @@ namespace myoddweb:: directorywatcher:: threads
      */
     virtual bool OnWorkerUpdate(float fElapsedTimeMilliseconds) = 0;
 
+    /**
+     * \brief called between two updates when the worker runs in its own thread.
+     *        By default we only yield, but a worker can sleep until it has something to do.
+     */
+    virtual void OnWorkerWait();
+
+    /**
+     * \brief how long we are happy to wait before our next update if nothing wakes us up.
+     *        This is only used by the worker pool, by default we want to be updated every time.
+     * \return the number of ms before we next need an update.
+     */
+    [[nodiscard]]
+    virtual float OnWorkerNextUpdateMilliseconds() const;
+
     /**
      * \brief called when the worker has completed
      *        this is to allow our workers a chance to dispose of data
@@ -5,17 +5,31 @@
 #include "../../monitors/Base.h"
 #include "../Lock.h"
 #include "../Wait.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <execution>
+#include <iterator>
+#include <limits>
 #include "../Instrumentor.h"
 #include "../Logger.h"
 #include "../LogLevel.h"
 
 namespace myoddweb :: directorywatcher :: threads
 {
-  WorkerPool::WorkerPool( const long long throttleElapsedTimeMilliseconds) :
+  /**
+   * \brief create the pool
+   * \param throttleElapsedTimeMilliseconds how often we want to update the workers.
+   * \param numberOfThreads the number of threads updating the workers, 0 for one thread per core.
+   */
+  WorkerPool::WorkerPool( const long long throttleElapsedTimeMilliseconds, const unsigned int numberOfThreads) :
     Worker(),
     _thread(nullptr),
-    _throttleElapsedTimeMilliseconds(throttleElapsedTimeMilliseconds)
+    _executor(nullptr),
+    _numberOfThreads(numberOfThreads),
+    _publishers(nullptr),
+    _throttleElapsedTimeMilliseconds(throttleElapsedTimeMilliseconds),
+    _timers(MYODDWEB_TIMERWHEEL_TICK, NowMilliseconds())
   {
   }
 
@@ -34,13 +48,23 @@ namespace myoddweb :: directorywatcher :: threads
 
     delete _thread;
     _thread = nullptr;
+
+    // the executor is normally removed when the pool ends
+    // but the pool might never have been started.
+    delete _executor;
+    _executor = nullptr;
+
+    // all the workers are done, so nothing else can be published.
+    delete _publishers.exchange(nullptr);
   }
 
   #pragma region public functions
   /**
    * \brief stop multiple workers and wait
+   *        They are all told to stop in one pass and then we wait once for all of them
+   *        so the time it takes is the time of the slowest worker, not the sum of them.
    * \param workers the workers we are waiting for.
-   * \param timeout the number of ms we want to wait for them.
+   * \param timeout the number of ms we want to wait for all of them.
    * \return the result of the wait
    */
   WaitResult WorkerPool::StopAndWait(const std::vector<Worker*>& workers, long long timeout)
@@ -48,30 +72,24 @@ namespace myoddweb :: directorywatcher :: threads
     MYODDWEB_PROFILE_FUNCTION();
     try
     {
-      // start whatever needs to start
-      ProcessThreadsAndWorkersWaiting();
-
-      // then go around trying to lock th
-      MYODDWEB_MUTEX lock;
-      auto status = WaitResult::complete;
-      // send an update for all of them at the same time
-      std::for_each(
-        std::execution::par,
-        workers.begin(),
-        workers.end(),
-        [this,timeout,&lock,&status]( Worker* worker )
+      // tell them all to stop, this does not block
+      // and they all get their last update together.
+      StopWorkers(workers);
+
+      // a worker never goes back once it is complete, so each time we are woken up
+      // we carry on from the first one that was not complete rather than checking them all again.
+      size_t next = 0;
+      return Worker::WaitUntil([&workers, &next]
         {
-          const auto result = StopAndWait(*worker, timeout );
-          if( WaitResult::complete !=  result )
+          for (; next < workers.size(); ++next)
           {
-            MYODDWEB_LOCK(lock);
-            status = result;
+            if (!workers[next]->Completed())
+            {
+              return false;
+            }
           }
-        }
-      );
-
-      // all done
-      return status;
+          return true;
+        }, timeout) ? WaitResult::complete : WaitResult::timeout;
     }
     catch (...)
     {
@@ -98,7 +116,9 @@ namespace myoddweb :: directorywatcher :: threads
       auto result = WaitResult::complete;
       if (!worker.Completed())
       {
-        // if not wait for it to complete
+        // tell it to stop and make sure it gets its last update
+        // then wait for it to complete
+        StopWorker(worker);
         result = worker.StopAndWait(timeout);
       }
 
@@ -142,10 +162,16 @@ namespace myoddweb :: directorywatcher :: threads
       // add all the workers at once.
       AddToWorkersWaitingToStart(workers);
 
+      // if we are already running, we want to start them now.
+      _wakeup.Set();
+
       // finally make sure that the thread is now up and running.
       if (nullptr == _thread)
       {
         _thread = new Thread(*this);
+
+        // the thread might be waiting for us to set it before it can start the workers.
+        NotifyStateChanged();
       }
     }
     catch (...)
@@ -173,28 +199,19 @@ namespace myoddweb :: directorywatcher :: threads
       auto runningWorkers = CloneRunningWorkers();
       std::vector<Worker*> remove;
 
-      // send an update for all of them at the same time
-      MYODDWEB_MUTEX lock;
-      std::for_each(
-        std::execution::par,
-        runningWorkers.begin(),
-        runningWorkers.end(),
-        [timeout, &lock, &remove](Worker* worker)
-        {
-          if( !Wait::SpinUntil([&]()
-          {
-            if (!worker->Completed())
-            {
-              return false;
-            }
-            return true;
-          }, timeout))
+      // wait for them one after the other, they all share the same timeout
+      // and we sleep until the state of a worker changes.
+      const auto deadline = NowMilliseconds() + timeout;
+      for (const auto worker : runningWorkers)
+      {
+        if (!Worker::WaitUntil([worker]
           {
-            MYODDWEB_LOCK(lock);
-            remove.emplace_back(worker);
-          }
+            return worker->Completed();
+          }, RemainingMilliseconds(deadline, timeout)))
+        {
+          remove.emplace_back(worker);
         }
-      );
+      }
 
       // if we found anything to be removed we need to process them.
       ProcessWorkersWaitingToEnd(remove);
@@ -225,25 +242,17 @@ namespace myoddweb :: directorywatcher :: threads
       // start whatever needs to start
       ProcessThreadsAndWorkersWaiting();
 
-      // then go around trying to lock th
-      MYODDWEB_MUTEX lock;
+      // wait for them one after the other, they all share the same timeout.
       auto status = WaitResult::complete;
-      // send an update for all of them at the same time
-      std::for_each(
-        std::execution::par,
-        workers.begin(),
-        workers.end(),
-        [this, timeout,&lock,&status]( Worker* worker )
+      const auto deadline = NowMilliseconds() + timeout;
+      for (const auto worker : workers)
+      {
+        const auto result = WaitFor(*worker, RemainingMilliseconds(deadline, timeout));
+        if (WaitResult::complete != result)
         {
-          const auto result = WaitFor(*worker, timeout);
-          if (WaitResult::complete != result)
-          {
-            MYODDWEB_LOCK(lock);
-            status = result;
-          }
-          std::this_thread::yield();
+          status = result;
         }
-      );
+      }
 
       // all done
       return status;
@@ -284,7 +293,7 @@ namespace myoddweb :: directorywatcher :: threads
       }
 
       return
-        Wait::SpinUntil([&]()
+        Worker::WaitUntil([&]()
           {
             // if it is complete, no need to remove it from our list of workers
             // it will be picked up by the next Update( ... ) call
@@ -298,27 +307,246 @@ namespace myoddweb :: directorywatcher :: threads
       return WaitResult::timeout;
     }
   }
+
+  /**
+   * \brief tell the pool that a worker has something to do and must be updated
+   *        without waiting for its next update time.
+   *        This is thread safe and can be called from any thread, (or completion routine).
+   * \param worker the worker that needs an update.
+   */
+  void WorkerPool::Wake(Worker& worker)
+  {
+    RequestWake(worker);
+    _wakeup.Set();
+  }
+
+  /**
+   * \brief run a task on the threads that deliver the events to the host
+   *        so a slow callback does not delay the updates of the workers.
+   * \param task the task we want to run.
+   * \return if the task was queued or not.
+   */
+  bool WorkerPool::Publish(const TCallback& task)
+  {
+    if (_publishers == nullptr)
+    {
+      MYODDWEB_LOCK(_lockPublishers);
+      if (_publishers == nullptr)
+      {
+        _publishers = new Executor(MYODDWEB_PUBLISHER_THREADS);
+      }
+    }
+    return _publishers.load()->Post(task);
+  }
+
+#if defined(__linux__)
+  /**
+   * \brief wake the worker once the file descriptor has something to read.
+   *        The watch only fires once, call it again once the data has been read.
+   * \param fd the file descriptor we are watching.
+   * \param worker the worker that will be updated.
+   * \return if the file descriptor is now watched.
+   */
+  bool WorkerPool::Watch(const int fd, Worker& worker)
+  {
+    return _wakeup.Watch(fd, &worker);
+  }
+
+  /**
+   * \brief stop watching a file descriptor, this must be done before it is closed.
+   * \param fd the file descriptor we no longer want to watch.
+   */
+  void WorkerPool::Unwatch(const int fd)
+  {
+    _wakeup.Unwatch(fd);
+  }
+#endif
   #pragma endregion
 
   #pragma region private functions
   /**
-   * \brief check if the time has now elapsed.
-   * \param givenElapsedTimeMilliseconds the number of ms since the last time we checked.
-   * \param actualElapsedTimeMilliseconds the number of ms that has expired since our last check.
-   * \return if the time has elapsed and we can continue.
+   * \brief calculate how long we can sleep before one of the running workers is due.
+   *        This is never less than the throttle unless a worker has been woken up.
+   * \return the number of ms we can wait.
+   */
+  long long WorkerPool::CalculateWaitMilliseconds()
+  {
+    // if we have workers waiting to start or to end we go right away.
+    if (!IsWorkersWaitingToStartContainerEmpty() || !IsThreadWaitingToEndContainerEmpty())
+    {
+      return 0;
+    }
+
+    {
+      // a worker was woken up, we go now.
+      MYODDWEB_LOCK(_lockWokenWorkers);
+      if (!_wokenWorkers.empty())
+      {
+        return 0;
+      }
+    }
+
+    // the wheel knows when the next worker is due, however many workers we have.
+    long long nextMilliseconds;
+    {
+      MYODDWEB_LOCK(_lockRunningWorkers);
+      nextMilliseconds = _timers.NextAdvanceMilliseconds();
+    }
+    auto waitMilliseconds = static_cast<long long>(MYODDWEB_WORKERPOOL_MAX_WAIT);
+    if (nextMilliseconds != MYODDWEB_TIMERWHEEL_NEVER)
+    {
+      waitMilliseconds = (std::min)(waitMilliseconds, nextMilliseconds - NowMilliseconds());
+    }
+
+    // we do not want to go around more often than the throttle
+    // even if a worker would like us to.
+    return (std::max)(waitMilliseconds, _throttleElapsedTimeMilliseconds);
+  }
+
+  /**
+   * \brief the time used by the pool timers, workers use it for their own deadlines
+   *        so the time they ask for agrees with the time we update them.
+   * \return the number of ms of the steady clock.
+   */
+  long long WorkerPool::NowMilliseconds()
+  {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  /**
+   * \brief how long is left until a deadline.
+   * \param deadlineMilliseconds the deadline, (see NowMilliseconds( ... ) ).
+   * \param timeout the timeout the deadline was made from, -1 to wait forever.
+   * \return the number of ms left, never less than 0, or -1 to wait forever.
+   */
+  long long WorkerPool::RemainingMilliseconds(const long long deadlineMilliseconds, const long long timeout)
+  {
+    if (timeout < 0)
+    {
+      return -1;
+    }
+    return (std::max)(deadlineMilliseconds - NowMilliseconds(), 0LL);
+  }
+
+  /**
+   * \brief flag a worker as woken up and add it to the list of woken workers if it is running.
+   * \param worker the worker that needs an update.
+   */
+  void WorkerPool::RequestWake(Worker& worker)
+  {
+    if (worker._poolWakeRequested.exchange(true))
+    {
+      // it is already in the list, or it will be checked once it is running/done updating.
+      return;
+    }
+    MYODDWEB_LOCK(_lockWokenWorkers);
+    if (worker._poolRunning)
+    {
+      _wokenWorkers.push_back(&worker);
+    }
+  }
+
+  /**
+   * \brief when a running worker wants its next update, unless it is woken up before then.
+   *        It is never later than MYODDWEB_WORKERPOOL_MAX_WAIT so we can check again.
+   * \param worker the worker.
+   * \param nowMilliseconds the current time.
+   * \return the time of the next update.
+   */
+  long long WorkerPool::NextUpdateMilliseconds(const Worker& worker, const long long nowMilliseconds)
+  {
+    const auto next = worker.OnWorkerNextUpdateMilliseconds();
+    if (next <= 0)
+    {
+      return nowMilliseconds;
+    }
+    if (next >= static_cast<float>(MYODDWEB_WORKERPOOL_MAX_WAIT))
+    {
+      return nowMilliseconds + MYODDWEB_WORKERPOOL_MAX_WAIT;
+    }
+    return nowMilliseconds + static_cast<long long>(std::ceil(next));
+  }
+
+  /**
+   * \brief check if a running worker must be updated now, if not its next update is scheduled.
+   *        Must be called while holding the running workers lock.
+   * \param worker the worker we are checking.
+   * \param nowMilliseconds the current time.
+   * \return if we need to update the worker.
+   */
+  bool WorkerPool::IsWorkerDueInLock(Worker& worker, const long long nowMilliseconds)
+  {
+    // something happened, we go now.
+    if (worker._poolWakeRequested.exchange(false))
+    {
+      return true;
+    }
+
+    // it needs its last update so it can complete.
+    if (worker.MustStop())
+    {
+      return true;
+    }
+
+    // otherwise only when it asked us to.
+    const auto next = NextUpdateMilliseconds(worker, nowMilliseconds);
+    if (next <= nowMilliseconds)
+    {
+      return true;
+    }
+    _timers.Schedule(worker._poolTimer, next);
+    return false;
+  }
+
+  /**
+   * \brief check if a worker is one of the running workers.
+   *        Must be called while holding the running workers lock.
+   * \param worker the worker we are looking for.
+   * \return if the worker is running.
+   */
+  bool WorkerPool::IsRunningWorkerInLock(const Worker& worker) const
+  {
+    // the index is only valid while it is running, after that the slot might be used by another worker.
+    return worker._poolIndex < _runningWorkers.size() && _runningWorkers[worker._poolIndex] == &worker;
+  }
+
+  /**
+   * \brief take a running worker out of the running workers and cancel its timer, its wake up is not removed.
+   *        Must be called while holding the running workers lock.
+   * \param worker the running worker we are removing.
+   */
+  void WorkerPool::EraseRunningWorkerInLock(Worker& worker)
+  {
+    // the last worker takes its place so we do not move all the others.
+    const auto last = _runningWorkers.back();
+    _runningWorkers[worker._poolIndex] = last;
+    last->_poolIndex = worker._poolIndex;
+    _runningWorkers.pop_back();
+    _timers.Cancel(worker._poolTimer);
+  }
+
+  /**
+   * \brief remove a worker from the running workers as well as its timer and its wake up.
+   *        Must be called while holding the running workers lock.
+   * \param worker the worker we are removing.
+   * \return if the worker was running.
    */
-  bool WorkerPool::HasElapsed(float givenElapsedTimeMilliseconds, float& actualElapsedTimeMilliseconds)
+  bool WorkerPool::RemoveRunningWorkerInLock(const Worker& worker)
   {
-    _elapsedTimeMilliseconds += givenElapsedTimeMilliseconds;
-    actualElapsedTimeMilliseconds = _elapsedTimeMilliseconds;
-    if (_elapsedTimeMilliseconds < static_cast<float>(_throttleElapsedTimeMilliseconds))
+    if (!IsRunningWorkerInLock(worker))
     {
       return false;
     }
+    const auto running = _runningWorkers[worker._poolIndex];
+    EraseRunningWorkerInLock(*running);
+
+    MYODDWEB_LOCK(_lockWokenWorkers);
+    running->_poolRunning = false;
 
-    //  restart the timer.
-    while (_elapsedTimeMilliseconds > static_cast<float>(_throttleElapsedTimeMilliseconds)) {
-      _elapsedTimeMilliseconds -= static_cast<float>(_throttleElapsedTimeMilliseconds);
+    // it can only be one of the woken workers if its wake up has not been taken yet.
+    if (running->_poolWakeRequested)
+    {
+      _wokenWorkers.erase(std::remove(_wokenWorkers.begin(), _wokenWorkers.end(), running), _wokenWorkers.end());
     }
     return true;
   }
@@ -333,35 +561,143 @@ namespace myoddweb :: directorywatcher :: threads
    */
   bool WorkerPool::WorkerUpdateOnce(Worker& worker, const float fElapsedTimeMilliseconds)
   {
-    //  if we are complete, just remove us and stop processing
-    if (worker.Completed())
+    MYODDWEB_PROFILE_FUNCTION();
+
+    //  if we are complete, there is nothing more to do other than removing it.
+    const auto completed = worker.Completed();
+    auto mustContinue = false;
+    if (!completed)
     {
-      // just remove it from the list, as it is complete there is nothing more to do.
-      RemoveWorkerFromRunningWorkers(worker);
-      return false;
+      try
+      {
+        // grab the lock like the worker would in its own thread, we cannot end while we update.
+        MYODDWEB_LOCK(worker._lockState);
+
+        // then call the worker update
+        // if we return true then we want to continue.
+        mustContinue = worker.WorkerUpdateOnce(fElapsedTimeMilliseconds);
+      }
+      catch (...)
+      {
+        worker.SaveCurrentException();
+      }
     }
 
-    // then call the worker update
-    // if we return true then we want to continue.
-    if (worker.WorkerUpdateOnce(fElapsedTimeMilliseconds))
+    // we are no longer updating that worker, we use the running workers lock
+    // so the worker cannot be posted again between here and us removing it.
+    auto removed = false;
     {
-      // this worker is still running
-      // so we can add it back to the list of running workers
-      AddToRunningWorkers(worker);
-      return true;
+      MYODDWEB_LOCK(_lockRunningWorkers);
+      worker._poolUpdating = false;
+
+      // someone might be waiting for the update to be done before ending it.
+      NotifyStateChanged();
+      if (mustContinue)
+      {
+        // this worker is still running, it will be updated again when it is next due
+        // or right away if it was woken up while we were updating it.
+        if (worker._poolRunning)
+        {
+          const auto now = NowMilliseconds();
+          _timers.Schedule(worker._poolTimer, worker._poolWakeRequested ? now : NextUpdateMilliseconds(worker, now));
+        }
+        // the pool thread needs to know when it is next due.
+        _wakeup.Set();
+        return true;
+      }
+      removed = RemoveRunningWorkerInLock(worker);
     }
 
-    // remove it from our list
-    // this worker was probably removed by the caller function
-    RemoveWorkerFromRunningWorkers(worker);
+    // the pool thread might want to end it.
+    _wakeup.Set();
 
-    // queue this worker now.
-    QueueWorkerEnd(worker);
+    // if it was not in our list then it was already removed and queued by someone else.
+    if (removed && !completed)
+    {
+      // queue this worker now.
+      QueueWorkerEnd(worker);
+    }
 
     // we are done with this worker.
     return false;
   }
 
+  /**
+   * \brief post an update of the running workers that were woken up or whose timer expired.
+   *        workers that are still busy with their previous update are rescheduled once it is done.
+   */
+  void WorkerPool::PostRunningWorkersUpdates()
+  {
+    MYODDWEB_PROFILE_FUNCTION();
+    std::vector<std::pair<Worker*, float>> updates;
+    {
+      MYODDWEB_LOCK(_lockRunningWorkers);
+      const auto now = NowMilliseconds();
+
+      // the workers that were woken up are checked now, whatever their timer says.
+      std::vector<Worker*> candidates;
+      {
+        MYODDWEB_LOCK(_lockWokenWorkers);
+        candidates.swap(_wokenWorkers);
+      }
+      for (auto it = candidates.begin(); it != candidates.end();)
+      {
+        if ((*it)->_poolUpdating)
+        {
+          // one slow worker does not hold the others back, it keeps its wake up
+          // and is rescheduled right away once its update is done.
+          it = candidates.erase(it);
+          continue;
+        }
+        _timers.Cancel((*it)->_poolTimer);
+        ++it;
+      }
+
+      // then the ones that are due, only the expired timers are looked at.
+      std::vector<TimerWheel::Timer*> expired;
+      _timers.Advance(now, expired);
+      for (const auto timer : expired)
+      {
+        candidates.push_back(static_cast<Worker*>(timer->Owner()));
+      }
+
+      updates.reserve(candidates.size());
+      for (const auto worker : candidates)
+      {
+        if (!IsWorkerDueInLock(*worker, now))
+        {
+          // nothing to do yet, it was scheduled again.
+          continue;
+        }
+        worker->_poolUpdating = true;
+        updates.emplace_back(worker, static_cast<float>(now - worker->_poolLastUpdateMilliseconds));
+        worker->_poolLastUpdateMilliseconds = now;
+      }
+    }
+
+    for (const auto& update : updates)
+    {
+      const auto worker = update.first;
+      const auto elapsedTimeMilliseconds = update.second;
+      if (!_executor->Post([this, worker, elapsedTimeMilliseconds]
+        {
+          WorkerUpdateOnce(*worker, elapsedTimeMilliseconds);
+        }))
+      {
+        // the executor is stopping, we are ending.
+        {
+          MYODDWEB_LOCK(_lockRunningWorkers);
+          worker->_poolUpdating = false;
+          if (worker->_poolRunning)
+          {
+            _timers.Schedule(worker->_poolTimer, NowMilliseconds());
+          }
+        }
+        NotifyStateChanged();
+      }
+    }
+  }
+
   /**
    * \brief queue a worker to the end thread
    * \param worker the worker we want to end.
@@ -375,6 +711,9 @@ namespace myoddweb :: directorywatcher :: threads
 
     // and add it to the queue.
     _threadsWaitingToEnd.emplace_back( &worker);
+
+    // the pool thread will end it.
+    _wakeup.Set();
   }
 
   /**
@@ -395,14 +734,19 @@ namespace myoddweb :: directorywatcher :: threads
     // so before we go anywhere, we have to wait for the thread to start.
     if( !_thread->Started() )
     {
-      if( !Wait::SpinUntil( [&]
+      // if the thread has already completed it will never start.
+      if( !Worker::WaitUntil( [&]
       {
-        return _thread->Started();
+        return _thread->Started() || _thread->Completed();
       }, MYODDWEB_WAITFOR_WORKER_COMPLETION ) )
       {
         Logger::Log( 0, LogLevel::Error, L"Workpool unable to start Thread!" );
         return;
       }
+      if( !_thread->Started() )
+      {
+        return;
+      }
     }
 
     // all the workers waiting to start
@@ -549,7 +893,7 @@ namespace myoddweb :: directorywatcher :: threads
   bool WorkerPool::RemoveWorkerFromRunningWorkers(const Worker& worker)
   {
     MYODDWEB_LOCK(_lockRunningWorkers);
-    return RemoveWorker(_runningWorkers, worker);
+    return RemoveRunningWorkerInLock(worker);
   }
 
   /**
@@ -564,12 +908,28 @@ namespace myoddweb :: directorywatcher :: threads
     clone.reserve(workers.size());
     for (const auto worker : workers)
     {
-      if( !RemoveWorker(_runningWorkers, *worker) )
+      if( !IsRunningWorkerInLock(*worker) )
       {
         continue;
       }
+      EraseRunningWorkerInLock(*worker);
       clone.emplace_back(worker);
     }
+    if (clone.empty())
+    {
+      return clone;
+    }
+
+    // and their wake ups are all removed in one pass.
+    MYODDWEB_LOCK(_lockWokenWorkers);
+    for (const auto worker : clone)
+    {
+      worker->_poolRunning = false;
+    }
+    _wokenWorkers.erase(std::remove_if(_wokenWorkers.begin(), _wokenWorkers.end(), [](const Worker* worker)
+    {
+      return !worker->_poolRunning;
+    }), _wokenWorkers.end());
     return clone;
   }
 
@@ -605,6 +965,20 @@ namespace myoddweb :: directorywatcher :: threads
     // make a copy of the list
     const auto clone = _runningWorkers;
 
+    // none of them have a next update anymore.
+    for (const auto worker : clone)
+    {
+      _timers.Cancel(worker->_poolTimer);
+    }
+    {
+      MYODDWEB_LOCK(_lockWokenWorkers);
+      for (const auto worker : clone)
+      {
+        worker->_poolRunning = false;
+      }
+      _wokenWorkers.clear();
+    }
+
     // clear that list
     // we do not want to use `shrink_to_fit` as the reserved value
     // will probably be reused.
@@ -668,8 +1042,7 @@ namespace myoddweb :: directorywatcher :: threads
         return;
       }
 
-      const auto it2 = std::find(std::begin(_runningWorkers), std::end(_runningWorkers), worker);
-      if (it2 != _runningWorkers.end())
+      if (IsRunningWorkerInLock(*worker))
       {
         // it is already running.
         return;
@@ -690,7 +1063,21 @@ namespace myoddweb :: directorywatcher :: threads
    void WorkerPool::AddToRunningWorkers(Worker& worker)
    {
      MYODDWEB_LOCK(_lockRunningWorkers);
+     worker._poolIndex = _runningWorkers.size();
      AddWorker(_runningWorkers, worker);
+
+     // it is checked on the next update, it will then tell us when it wants to be updated.
+     const auto now = NowMilliseconds();
+     worker._poolLastUpdateMilliseconds = now;
+     _timers.Schedule(worker._poolTimer, now);
+
+     // it might have been woken up before it was running.
+     MYODDWEB_LOCK(_lockWokenWorkers);
+     worker._poolRunning = true;
+     if (worker._poolWakeRequested)
+     {
+       _wokenWorkers.push_back(&worker);
+     }
    }
 
   /**
@@ -742,19 +1129,8 @@ namespace myoddweb :: directorywatcher :: threads
       // make sure that we have started what needed to be started
       ProcessThreadsAndWorkersWaiting();
 
-      // clone the current running workers.
-      const auto runningWorkers = CloneRunningWorkers();
-
-      // stop all the workers.
-      std::for_each(
-        std::execution::par,
-        runningWorkers.begin(),
-        runningWorkers.end(),
-        [this, timeout](Worker* worker)
-        {
-          StopAndWait(*worker, timeout );
-        }
-      );
+      // stop all the running workers at once.
+      StopAndWait(CloneRunningWorkers(), timeout);
 
       // set the stop flag here.
       // and we want to wait a little for ourself to complete
@@ -784,6 +1160,9 @@ namespace myoddweb :: directorywatcher :: threads
       // we have to make sure that all the running workers are stopped.
       const auto runningWorkers = CloneRunningWorkers();
       StopWorkers( runningWorkers );
+
+      // and we need to go around at least once more to stop ourselves.
+      _wakeup.Set();
     }
     catch (...)
     {
@@ -809,8 +1188,19 @@ namespace myoddweb :: directorywatcher :: threads
       // the stop function is non blocking.
       for( auto worker : workers )
       {
-        StopWorker( *worker );
+        if (worker->Completed())
+        {
+          continue;
+        }
+
+        // tell the worker to stop then
+        // and make sure that it gets its last update.
+        worker->Stop();
+        RequestWake(*worker);
       }
+
+      // and we only need to wake the pool thread once for all of them.
+      _wakeup.Set();
     }
     catch (...)
     {
@@ -839,8 +1229,10 @@ namespace myoddweb :: directorywatcher :: threads
         return;
       }
 
-      // tell the worker to stop then.
+      // tell the worker to stop then
+      // and make sure that it gets its last update.
       worker.Stop();
+      Wake(worker);
     }
     catch (...)
     {
@@ -857,6 +1249,9 @@ namespace myoddweb :: directorywatcher :: threads
     MYODDWEB_PROFILE_FUNCTION();
     try
     {
+      // the threads that will be running the updates.
+      _executor = new Executor(_numberOfThreads);
+
       //  process anything waiting to start
       ProcessThreadsAndWorkersWaiting();
 
@@ -880,7 +1275,7 @@ namespace myoddweb :: directorywatcher :: threads
    * \param fElapsedTimeMilliseconds the amount of time since the last time we made this call.
    * \return true if we want to continue or false if we want to end the thread
    */
-  bool WorkerPool::OnWorkerUpdate(const float fElapsedTimeMilliseconds)
+  bool WorkerPool::OnWorkerUpdate(const float /*fElapsedTimeMilliseconds*/)
   {
     MYODDWEB_PROFILE_FUNCTION();
     try
@@ -890,54 +1285,11 @@ namespace myoddweb :: directorywatcher :: threads
 
       WorkerEndThreadsWaitingToEnd();
 
-      // the actual elapsed time expired
-      float actualElapsedTimeMilliseconds;
-
-      // check if the elapsed time is more than what we want.
-      if( !HasElapsed(fElapsedTimeMilliseconds, actualElapsedTimeMilliseconds) )
-      {
-        return !CanStopWorkerpoolUpdates();
-      }
-
-      // take all the running workers and remove them from the list
-      // from now on, we will be managing them.
-      auto runningWorkers = RemoveWorkersFromRunningWorkers();
-
-      // assume that all the worker want to continue
-      // unless of course we have no running worker left
-      // then in that case we will need to check
-      auto checkIfContinueWithNextEvent = runningWorkers.empty();
-
-      // send an update for all of them at the same time
-      std::for_each(
-        std::execution::par,
-        runningWorkers.begin(),
-        runningWorkers.end(),
-        [this, actualElapsedTimeMilliseconds, &checkIfContinueWithNextEvent](Worker* worker)
-        {
-          if (!WorkerUpdateOnce(*worker, actualElapsedTimeMilliseconds))
-          {
-            // on of them stopped, so we need to check if we need to stop or not.
-            // boolean assignments are atomic so we do not need a lock
-            // by the time we read the data no threads will be updating it.
-            checkIfContinueWithNextEvent = true;
-          }
-        }
-      );
-
-      // if none of the wokrers wanted to stop then we 
-      // just want to continue unless we must stop all.
-      // there is not point in waiting for ever
-      if (!checkIfContinueWithNextEvent)
-      {
-        // if we are here then we know we have workers
-        // still active so we don't need to check any further
-        return true;
-      }
+      // send an update for all the workers that are due, the executor threads run them
+      // and we do not wait for them to complete, workers that stop remove themselves.
+      PostRunningWorkersUpdates();
 
-      // we either had no working workers
-      // or we removed at least one of them
-      // so we need to check all the others.
+      // if we still have running workers, (or some waiting), we continue.
       return !CanStopWorkerpoolUpdates();
     }
     catch (...)
@@ -948,6 +1300,30 @@ namespace myoddweb :: directorywatcher :: threads
     }
   }
 
+  /**
+   * \brief sleep until one of the workers is woken up or until the next one is due.
+   */
+  void WorkerPool::OnWorkerWait()
+  {
+    // we do not want to wait if we are stopping.
+    if (MustStop())
+    {
+      MYODDWEB_YIELD();
+      return;
+    }
+    _wakeup.WaitFor(CalculateWaitMilliseconds());
+
+#if defined(__linux__)
+    // wake the workers whose file descriptor is ready.
+    std::vector<void*> ready;
+    _wakeup.TakeReady(ready);
+    for (const auto context : ready)
+    {
+      RequestWake(*static_cast<Worker*>(context));
+    }
+#endif
+  }
+
   /**
  * \brief if the running worker container is empty or not.
  */
@@ -1019,6 +1395,15 @@ namespace myoddweb :: directorywatcher :: threads
     {
       MYODDWEB_PROFILE_FUNCTION();
 
+      // let the updates already posted complete
+      // and then get rid of the threads.
+      if (_executor != nullptr)
+      {
+        _executor->Stop();
+        delete _executor;
+        _executor = nullptr;
+      }
+
       // finish all the work of the running workers.
       WorkerEndRunningWorkers();
 
@@ -1042,25 +1427,16 @@ namespace myoddweb :: directorywatcher :: threads
     auto runningWorkers = RemoveWorkersFromRunningWorkers();
     for (; !runningWorkers.empty();)
     {
-      // stop and wait all of them
+      // stop all of them and wait once for all of them
+      // we cannot end the workpool until the are done.
       std::vector<Worker*> timeOutWorkers;
-      MYODDWEB_MUTEX lock;
-      std::for_each(
-        std::execution::par,
-        runningWorkers.begin(),
-        runningWorkers.end(),
-        [this,&lock,&timeOutWorkers](Worker* worker)
+      if (WaitResult::complete != StopAndWait(runningWorkers, MYODDWEB_WAITFOR_WORKER_COMPLETION))
+      {
+        std::copy_if(runningWorkers.begin(), runningWorkers.end(), std::back_inserter(timeOutWorkers), [](const Worker* worker)
         {
-          // stop this worker and wait
-          // we cannot end the workpool until the are done.
-          const auto result = StopAndWait(*worker, MYODDWEB_WAITFOR_WORKER_COMPLETION);
-          if (WaitResult::complete != result)
-          {
-            MYODDWEB_LOCK(lock);
-            timeOutWorkers.emplace_back(worker);
-          }
-        }
-      );
+          return !worker->Completed();
+        });
+      }
 
       // copy over whatever we might have left.
       // so we can wait for them to complete.
@@ -1089,6 +1465,12 @@ namespace myoddweb :: directorywatcher :: threads
         runningWorkers.end(),
         [](Worker* worker)
         {
+          // it might have been queued by someone else while an update is still running.
+          WaitUntil([worker]
+          {
+            return !worker->_poolUpdating;
+          }, -1);
+
           if( !worker->Completed() )
           {
             worker->WorkerEnd();
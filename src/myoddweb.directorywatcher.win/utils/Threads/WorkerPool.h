@@ -3,7 +3,10 @@
 // See the LICENSE file in the project root for more information.
 #pragma once
 #include <mutex>
+#include "Executor.h"
+#include "Signal.h"
 #include "Thread.h"
+#include "TimerWheel.h"
 
 namespace myoddweb:: directorywatcher:: threads
 {
@@ -14,15 +17,31 @@ namespace myoddweb:: directorywatcher:: threads
      */
     Thread* _thread;
 
+    /**
+     * \brief the threads running the worker updates, created when the pool starts.
+     */
+    Executor* _executor;
+
+    /**
+     * \brief the number of threads we want the executor to use.
+     */
+    const unsigned int _numberOfThreads;
+
+    /**
+     * \brief the threads delivering the events to the host, created the first time they are needed.
+     *        They outlive the workers so the last events can still be delivered when a worker ends.
+     */
+    std::atomic<Executor*> _publishers;
+
     /**
      * \brief how often we want to limit this.
      */
     const long long _throttleElapsedTimeMilliseconds;
 
     /**
-     * \brief the elapsed time since the last time we checked this
+     * \brief the signal used to wake the pool thread when a worker has something to do.
      */
-    float _elapsedTimeMilliseconds = 0;
+    Signal _wakeup;
 
     #pragma region Locks
     /**
@@ -39,6 +58,16 @@ namespace myoddweb:: directorywatcher:: threads
      * \brief lock for the workers that are waiting to end
      */
     MYODDWEB_MUTEX _lockThreadsWaitingToEnd;
+
+    /**
+     * \brief lock used to create the publishers
+     */
+    MYODDWEB_MUTEX _lockPublishers;
+
+    /**
+     * \brief lock for the workers that were woken up.
+     */
+    MYODDWEB_MUTEX _lockWokenWorkers;
     #pragma endregion 
 
     #pragma region Worker/Threads containers
@@ -56,8 +85,19 @@ namespace myoddweb:: directorywatcher:: threads
      * \brief all our workers that are currently running.
      */
     std::vector<Worker*> _runningWorkers;
+
+    /**
+     * \brief the running workers that were woken up since we last posted the updates.
+     */
+    std::vector<Worker*> _wokenWorkers;
     #pragma endregion
 
+    /**
+     * \brief the next update of each of the running workers, (unless they are being updated).
+     *        it uses the running workers lock, so we never need to go around all the workers to know who is due.
+     */
+    TimerWheel _timers;
+
   public:
     WorkerPool(const WorkerPool&) = delete;
     WorkerPool(WorkerPool&&) = delete;
@@ -65,7 +105,12 @@ namespace myoddweb:: directorywatcher:: threads
     const WorkerPool& operator=(const WorkerPool&) = delete;
     const WorkerPool& operator=(const WorkerPool&&) = delete;
 
-    explicit WorkerPool(long long throttleElapsedTimeMilliseconds);
+    /**
+     * \brief create the pool
+     * \param throttleElapsedTimeMilliseconds how often we want to update the workers.
+     * \param numberOfThreads the number of threads updating the workers, 0 for one thread per core.
+     */
+    explicit WorkerPool(long long throttleElapsedTimeMilliseconds, unsigned int numberOfThreads = MYODDWEB_WORKERPOOL_THREADS);
     virtual ~WorkerPool();
 
     /**
@@ -131,8 +176,10 @@ namespace myoddweb:: directorywatcher:: threads
 
     /**
      * \brief stop multiple workers and wait
+     *        They are all told to stop in one pass and then we wait once for all of them
+     *        so the time it takes is the time of the slowest worker, not the sum of them.
      * \param workers the workers we are waiting for.
-     * \param timeout the number of ms we want to wait for them.
+     * \param timeout the number of ms we want to wait for all of them.
      * \return the result of the wait
      */
     WaitResult StopAndWait( const std::vector<Worker*>& workers, long long timeout);
@@ -144,6 +191,46 @@ namespace myoddweb:: directorywatcher:: threads
      */
     WaitResult StopAndWait(Worker& worker, long long timeout);
 
+    /**
+     * \brief tell the pool that a worker has something to do and must be updated
+     *        without waiting for its next update time.
+     *        This is thread safe and can be called from any thread, (or completion routine).
+     * \param worker the worker that needs an update.
+     */
+    void Wake(Worker& worker);
+
+    /**
+     * \brief run a task on the threads that deliver the events to the host
+     *        so a slow callback does not delay the updates of the workers.
+     * \param task the task we want to run.
+     * \return if the task was queued or not.
+     */
+    bool Publish(const TCallback& task);
+
+    /**
+     * \brief the time used by the pool timers, workers use it for their own deadlines
+     *        so the time they ask for agrees with the time we update them.
+     * \return the number of ms of the steady clock.
+     */
+    static long long NowMilliseconds();
+
+#if defined(__linux__)
+    /**
+     * \brief wake the worker once the file descriptor has something to read.
+     *        The watch only fires once, call it again once the data has been read.
+     * \param fd the file descriptor we are watching.
+     * \param worker the worker that will be updated.
+     * \return if the file descriptor is now watched.
+     */
+    bool Watch(int fd, Worker& worker);
+
+    /**
+     * \brief stop watching a file descriptor, this must be done before it is closed.
+     * \param fd the file descriptor we no longer want to watch.
+     */
+    void Unwatch(int fd);
+#endif
+
   protected:
     /**
      * \brief called when the worker thread is about to start
@@ -159,6 +246,11 @@ namespace myoddweb:: directorywatcher:: threads
      */
     bool OnWorkerUpdate(float fElapsedTimeMilliseconds) override;
 
+    /**
+     * \brief sleep until one of the workers is woken up or until the next one is due.
+     */
+    void OnWorkerWait() override;
+
     /**
      * \brief Called when the thread pool has been completed, all the workers should have completed here.
      *        We are done with all of them now.
@@ -200,12 +292,66 @@ namespace myoddweb:: directorywatcher:: threads
     bool IsThreadWaitingToEndContainerEmpty();
 
     /**
-     * \brief check if the time has now elapsed.
-     * \param givenElapsedTimeMilliseconds the number of ms since the last time we checked.
-     * \param actualElapsedTimeMilliseconds the number of ms that has expired since our last check.
-     * \return if the time has elapsed and we can continue.
+     * \brief calculate how long we can sleep before one of the running workers is due.
+     *        This is never less than the throttle unless a worker has been woken up.
+     * \return the number of ms we can wait.
+     */
+    long long CalculateWaitMilliseconds();
+
+    /**
+     * \brief how long is left until a deadline.
+     * \param deadlineMilliseconds the deadline, (see NowMilliseconds( ... ) ).
+     * \param timeout the timeout the deadline was made from, -1 to wait forever.
+     * \return the number of ms left, never less than 0, or -1 to wait forever.
+     */
+    static long long RemainingMilliseconds(long long deadlineMilliseconds, long long timeout);
+
+    /**
+     * \brief flag a worker as woken up and add it to the list of woken workers if it is running.
+     * \param worker the worker that needs an update.
+     */
+    void RequestWake(Worker& worker);
+
+    /**
+     * \brief when a running worker wants its next update, unless it is woken up before then.
+     *        It is never later than MYODDWEB_WORKERPOOL_MAX_WAIT so we can check again.
+     * \param worker the worker.
+     * \param nowMilliseconds the current time.
+     * \return the time of the next update.
+     */
+    static long long NextUpdateMilliseconds(const Worker& worker, long long nowMilliseconds);
+
+    /**
+     * \brief check if a running worker must be updated now, if not its next update is scheduled.
+     *        Must be called while holding the running workers lock.
+     * \param worker the worker we are checking.
+     * \param nowMilliseconds the current time.
+     * \return if we need to update the worker.
+     */
+    bool IsWorkerDueInLock(Worker& worker, long long nowMilliseconds);
+
+    /**
+     * \brief check if a worker is one of the running workers.
+     *        Must be called while holding the running workers lock.
+     * \param worker the worker we are looking for.
+     * \return if the worker is running.
+     */
+    bool IsRunningWorkerInLock(const Worker& worker) const;
+
+    /**
+     * \brief take a running worker out of the running workers and cancel its timer, its wake up is not removed.
+     *        Must be called while holding the running workers lock.
+     * \param worker the running worker we are removing.
+     */
+    void EraseRunningWorkerInLock(Worker& worker);
+
+    /**
+     * \brief remove a worker from the running workers as well as its timer and its wake up.
+     *        Must be called while holding the running workers lock.
+     * \param worker the worker we are removing.
+     * \return if the worker was running.
      */
-    bool HasElapsed( float givenElapsedTimeMilliseconds, float& actualElapsedTimeMilliseconds);
+    bool RemoveRunningWorkerInLock(const Worker& worker);
 
     /**
      * \brief queue a worker to the end thread
@@ -217,12 +363,19 @@ namespace myoddweb:: directorywatcher:: threads
      * \brief Give the worker a chance to do something in the loop
      *        Workers can do _all_ the work at once and simply return false
      *        or if they have a tight look they can return true until they need to come out.
+     *        This is called by one of the executor threads.
      * \param worker the worker we are managing.
      * \param fElapsedTimeMilliseconds the amount of time since the last time we made this call.
      * \return true if we want to continue or false if we want to end the thread
      */
     bool WorkerUpdateOnce(Worker& worker, float fElapsedTimeMilliseconds);
 
+    /**
+     * \brief post an update of the running workers that were woken up or whose timer expired.
+     *        workers that are still busy with their previous update are rescheduled once it is done.
+     */
+    void PostRunningWorkersUpdates();
+
     /**
      * \brief make a thread safe copy of the running workers.
      */
@@ -12,7 +12,7 @@
   constexpr auto MYODDWEB_MAX_WAIT_INT = static_cast<unsigned int>(-1);
 #else
   #include <limits> 
-  constexpr auto MYODDWEB_MAX_WAIT_INT = std::numeric_limits<int>::max()
+  constexpr auto MYODDWEB_MAX_WAIT_INT = std::numeric_limits<int>::max();
 #endif
 
 #if defined( _WIN32) || defined(_WIN64 )
@@ -302,6 +302,30 @@ namespace myoddweb:: directorywatcher
       ::SwitchToThread();
       break;
 
+    default:
+      _yieldCounter = 0;
+      break;
+    }
+#else
+    switch (_yieldCounter)
+    {
+    case 1:
+    case 2:
+    case 3:
+      // slee a little bit
+      std::this_thread::sleep_for(oneMillisecond);
+      break;
+
+    case 4:
+      // slee a little bit
+      std::this_thread::sleep_for(zeroMilliseconds);
+      break;
+
+    case 5:
+      // yield.
+      std::this_thread::yield();
+      break;
+
     default:
       _yieldCounter = 0;
       break;
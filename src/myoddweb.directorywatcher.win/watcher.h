@@ -4,29 +4,82 @@
 #pragma once
 #include "utils/Request.h"
 
+#if defined(_WIN32)
+  #define MYODDWEB_EXPORT __declspec(dllexport)
+#else
+  #define MYODDWEB_EXPORT __attribute__((visibility("default")))
+#endif
+
 namespace myoddweb:: directorywatcher
 {
   /**
    */
-  extern "C" { __declspec(dllexport) bool SetConfig(const Request& request); }
+  extern "C" { MYODDWEB_EXPORT bool SetConfig(const Request& request); }
 
   /**
    * \brief Start watching a folder
    * \param request The request containing info about the item we are watching.
    * \return The id of the created request or -ve otherwise
    */
-  extern "C" { __declspec(dllexport) long long Start(const Request& request); }
+  extern "C" { MYODDWEB_EXPORT long long Start(const Request& request); }
 
   /**
    * \brief stop watching
    * \param id the id we would like to remove.
    * \return success or not
    */
-  extern "C" { __declspec(dllexport) bool Stop(long long id); }
+  extern "C" { MYODDWEB_EXPORT bool Stop(long long id); }
+
+  /**
+   * \brief stop watching many requests at once, they are all told to stop and then we wait for all of them.
+   * \param ids the ids we would like to remove.
+   * \param numberOfIds the number of ids.
+   * \param stoppedIds where we copy the ids of the requests we stopped, room for numberOfIds, (or null).
+   *        the ids that were not stopped, (or did not exist), are not copied.
+   * \return the number of requests stopped or -1 if there was an error.
+   */
+  extern "C" { MYODDWEB_EXPORT int StopMany(const long long* ids, int numberOfIds, long long* stoppedIds); }
 
   /**
    * \brief If the monitor manager is ready or not.
    * \return if it is ready or not.
    */
-  extern "C" { __declspec(dllexport) bool Ready(); }
+  extern "C" { MYODDWEB_EXPORT bool Ready(); }
+
+  /**
+   * \brief copy the pending events of a monitor to buffers owned by the caller.
+   *        The request must have been started without any events callbacks, (the events rate is how long events are kept).
+   * \param id the id of the monitor we want the events of.
+   * \param events where the events are copied to.
+   * \param eventsCapacity the number of events that can be copied.
+   * \param names where the names are copied to, the offsets in the events are relative to it.
+   * \param namesCapacity the number of characters that can be copied.
+   * \param cursor 0 to get the next events, or the value returned by the previous call to continue.
+   *        It is set to 0 once all the events have been copied.
+   * \return the number of events copied or -1 if there was an error.
+   */
+  extern "C" { MYODDWEB_EXPORT int GetEvents(long long id, EventRecord* events, int eventsCapacity, wchar_t* names, int namesCapacity, long long* cursor); }
+
+  /**
+   * \brief get how well the host is keeping up with the events of a monitor.
+   * \param id the id of the monitor we want the statistics of.
+   * \param statistics the statistics we are filling, (queue depth, time spent in the callback and so on).
+   *        its size must be set to sizeof(MonitorStatistics), (see MonitorStatistics::Size).
+   * \return if the monitor exists and the statistics were filled.
+   */
+  extern "C" { MYODDWEB_EXPORT bool GetStatistics(long long id, MonitorStatistics* statistics); }
+
+  /**
+   * \brief start recording where the time is spent, the trace can be opened with chrome://tracing/
+   *        if we are already recording the previous trace is completed first.
+   * \param path where the trace is written to.
+   * \param sampleEvery record one scope every that many scopes of each thread, 1 to record them all.
+   * \return if we are now recording or not.
+   */
+  extern "C" { MYODDWEB_EXPORT bool StartProfiling(const wchar_t* path, int sampleEvery); }
+
+  /**
+   * \brief stop recording where the time is spent, the trace is complete once this returns.
+   */
+  extern "C" { MYODDWEB_EXPORT void StopProfiling(); }
 }
\ No newline at end of file
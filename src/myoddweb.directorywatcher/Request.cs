@@ -17,6 +17,12 @@ namespace myoddweb.directorywatcher
     /// <inheritdoc />
     public IRates Rates { get; }
 
+    /// <inheritdoc />
+    public bool CoalesceEvents { get; }
+
+    /// <inheritdoc />
+    public long SettleMilliseconds { get; }
+
     /// <summary>
     /// Create the default requests
     /// </summary>
@@ -33,11 +39,42 @@ namespace myoddweb.directorywatcher
     /// <param name="path">The path we want to watch</param>
     /// <param name="recursive">Recursively watch or not.</param>
     /// <param name="rates">The various refresh rates</param>
-    public Request(string path, bool recursive, IRates rates )
+    public Request(string path, bool recursive, IRates rates ) :
+      this(path, recursive, rates, false)
+    {
+    }
+
+    /// <summary>
+    /// Create the default requests
+    /// </summary>
+    /// <param name="path">The path we want to watch</param>
+    /// <param name="recursive">Recursively watch or not.</param>
+    /// <param name="rates">The various refresh rates</param>
+    /// <param name="coalesceEvents">Only report the net effect of the events of each path.</param>
+    public Request(string path, bool recursive, IRates rates, bool coalesceEvents ) :
+      this(path, recursive, rates, coalesceEvents, 0)
+    {
+    }
+
+    /// <summary>
+    /// Create the default requests
+    /// </summary>
+    /// <param name="path">The path we want to watch</param>
+    /// <param name="recursive">Recursively watch or not.</param>
+    /// <param name="rates">The various refresh rates</param>
+    /// <param name="coalesceEvents">Only report the net effect of the events of each path.</param>
+    /// <param name="settleMilliseconds">How long a touched path must not change before it is reported, 0 to report the changes straight away.</param>
+    public Request(string path, bool recursive, IRates rates, bool coalesceEvents, long settleMilliseconds )
     {
+      if (settleMilliseconds < 0)
+      {
+        throw new ArgumentOutOfRangeException(nameof(settleMilliseconds));
+      }
       Path = path ?? throw new ArgumentNullException(nameof(path));
       Recursive = recursive;
       Rates = rates ?? throw new ArgumentNullException(nameof(rates));
+      CoalesceEvents = coalesceEvents;
+      SettleMilliseconds = settleMilliseconds;
     }
 
   }
@@ -395,12 +395,17 @@ namespace myoddweb.directorywatcher
         return false;
       }
 
-      // we try and remove the requests here.
-      // make sure that we clone the list rather than using the actual list
-      // because Remove() will actually change _processedRequests itself.
-      foreach (var id in _processedRequests.Select(r => r.Key).ToArray())
+      // we remove all the requests at once, they are all told to stop
+      // before we wait for any of them.
+      if (_watcherManager.StopMany(_processedRequests.Select(r => r.Key).ToArray(), out var stoppedIds) < 0)
+      {
+        return false;
+      }
+
+      // only forget the ones that were stopped, the others might still be running.
+      foreach (var id in stoppedIds)
       {
-        Stop(id);
+        _processedRequests.Remove(id);
       }
 
       return true;
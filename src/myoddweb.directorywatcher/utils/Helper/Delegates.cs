@@ -24,6 +24,31 @@ namespace myoddweb.directorywatcher.utils.Helper
       public Int64 StatisticsCallbackIntervalMs;
 
       public LoggerCallback LoggerCallback;
+
+      public EventsBatchCallback EventsBatchCallback;
+
+      [MarshalAs(UnmanagedType.I1)]
+      public bool CoalesceEvents;
+
+      [MarshalAs(UnmanagedType.I8)]
+      public Int64 SettleMilliseconds;
+    }
+
+    /// <summary>
+    /// A single event in a batch of events, the names are in the names block given with the batch.
+    /// The offsets and lengths are in characters and do not include the null terminator.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct EventRecord
+    {
+      public long DateTimeUtc;
+      public int Action;
+      public int Error;
+      public int IsFile;
+      public int NameOffset;
+      public int NameLength;
+      public int OldNameOffset;
+      public int OldNameLength;
     }
 
     // Delegate with function signature for the GetVersion function
@@ -35,6 +60,10 @@ namespace myoddweb.directorywatcher.utils.Helper
     [return: MarshalAs(UnmanagedType.Bool)]
     public delegate bool Stop([In, MarshalAs(UnmanagedType.U8)] Int64 id);
 
+    [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+    [return: MarshalAs(UnmanagedType.I4)]
+    public delegate int StopMany([In, MarshalAs(UnmanagedType.LPArray)] Int64[] ids, [MarshalAs(UnmanagedType.I4)] int numberOfIds, [Out, MarshalAs(UnmanagedType.LPArray)] Int64[] stoppedIds);
+
     [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
     [return: MarshalAs(UnmanagedType.Bool)]
     public delegate bool Ready();
@@ -50,6 +79,15 @@ namespace myoddweb.directorywatcher.utils.Helper
       [MarshalAs(UnmanagedType.I8)] long dateTimeUtc
     );
 
+    [UnmanagedFunctionPointer(CallingConvention.StdCall)]
+    public delegate void EventsBatchCallback(
+      [MarshalAs(UnmanagedType.I8)] long id,
+      IntPtr events,
+      [MarshalAs(UnmanagedType.I4)] int numberOfEvents,
+      IntPtr names,
+      [MarshalAs(UnmanagedType.I4)] int namesLength
+    );
+
     [UnmanagedFunctionPointer(CallingConvention.StdCall)]
     public delegate void StatisticsCallback(
       [MarshalAs(UnmanagedType.I8)] long id,
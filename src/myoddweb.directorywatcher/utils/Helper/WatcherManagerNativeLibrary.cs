@@ -21,11 +21,21 @@ namespace myoddweb.directorywatcher.utils.Helper
     /// </summary>
     private Delegates.Stop _stop;
 
+    /// <summary>
+    /// Delegate to stop many requests at once
+    /// </summary>
+    private Delegates.StopMany _stopMany;
+
     /// <summary>
     /// The callback function called from time to time when Events happen.
     /// </summary>
     private readonly Delegates.EventsCallback _eventsCallback;
 
+    /// <summary>
+    /// The callback function called with all the events at once, used instead of the events callback.
+    /// </summary>
+    private readonly Delegates.EventsBatchCallback _eventsBatchCallback;
+
     /// <summary>
     /// The callback function called from time to time when stats are updated
     /// </summary>
@@ -41,7 +51,7 @@ namespace myoddweb.directorywatcher.utils.Helper
     /// </summary>
     private readonly IntPtr _handle;
 
-    public WatcherManagerNativeLibrary(string library, Delegates.EventsCallback eventsCallback, Delegates.StatisticsCallback statisticsCallback, Delegates.LoggerCallback loggerCallback)
+    public WatcherManagerNativeLibrary(string library, Delegates.EventsCallback eventsCallback, Delegates.EventsBatchCallback eventsBatchCallback, Delegates.StatisticsCallback statisticsCallback, Delegates.LoggerCallback loggerCallback)
     {
       // some sanity checks.
       if( library == null )
@@ -51,6 +61,7 @@ namespace myoddweb.directorywatcher.utils.Helper
 
       _handle = CreatePtrFromFileSystem( library );
       _eventsCallback = eventsCallback ?? throw new ArgumentNullException(nameof(eventsCallback));
+      _eventsBatchCallback = eventsBatchCallback ?? throw new ArgumentNullException(nameof(eventsBatchCallback));
       _statisticsCallback = statisticsCallback ?? throw new ArgumentNullException(nameof(statisticsCallback));
       _loggerCallback = loggerCallback ?? throw new ArgumentNullException(nameof(loggerCallback));
     }
@@ -111,7 +122,10 @@ namespace myoddweb.directorywatcher.utils.Helper
         StatisticsCallback = _statisticsCallback,
         EventsCallbackIntervalMs = request.Rates.EventsMilliseconds,
         StatisticsCallbackIntervalMs = request.Rates.StatisticsMilliseconds,
-        LoggerCallback = _loggerCallback
+        LoggerCallback = _loggerCallback,
+        EventsBatchCallback = _eventsBatchCallback,
+        CoalesceEvents = request.CoalesceEvents,
+        SettleMilliseconds = request.SettleMilliseconds
       };
 
       // start
@@ -127,6 +141,21 @@ namespace myoddweb.directorywatcher.utils.Helper
       return _stop(id);
     }
 
+    public int StopMany(long[] ids, out long[] stoppedIds)
+    {
+      if (_stopMany == null)
+      {
+        _stopMany = Get<Delegates.StopMany>("StopMany");
+      }
+
+      // we are only given the ids that were actually stopped.
+      var stopped = new long[ids.Length];
+      var numberOfStopped = _stopMany(ids, ids.Length, stopped);
+      Array.Resize(ref stopped, Math.Max(0, numberOfStopped));
+      stoppedIds = stopped;
+      return numberOfStopped;
+    }
+
     /// <summary>
     /// Return if the monitor manager is ready to accept requests.
     /// </summary>
@@ -7,6 +7,7 @@ using System.Collections.Generic;
 using System.IO;
 using System.Linq;
 using System.Reflection;
+using System.Runtime.InteropServices;
 using System.Security.Cryptography;
 using System.Text;
 using myoddweb.directorywatcher.utils.Helper;
@@ -182,6 +183,53 @@ namespace myoddweb.directorywatcher.utils
         }
       }
     }
+
+    /// <summary>
+    /// Function called at regular intervals with all the file events detected since the last call.
+    /// The records and the names are only valid for the duration of the call.
+    /// </summary>
+    /// <param name="id"></param>
+    /// <param name="events">the array of <see cref="Delegates.EventRecord"/></param>
+    /// <param name="numberOfEvents"></param>
+    /// <param name="names">all the names, each one is null terminated.</param>
+    /// <param name="namesLength">the number of characters in the names.</param>
+    protected void EventsBatchCallback(
+      long id,
+      IntPtr events,
+      int numberOfEvents,
+      IntPtr names,
+      int namesLength)
+    {
+      // copy all the names in one go.
+      var allNames = namesLength > 0 ? Marshal.PtrToStringUni(names, namesLength) : string.Empty;
+      var recordSize = Marshal.SizeOf(typeof(Delegates.EventRecord));
+
+      var batch = new List<IEvent>(numberOfEvents);
+      for (var i = 0; i < numberOfEvents; ++i)
+      {
+        var record = (Delegates.EventRecord)Marshal.PtrToStructure(events + i * recordSize, typeof(Delegates.EventRecord));
+        batch.Add(new Event(
+          record.IsFile != 0,
+          allNames.Substring(record.NameOffset, record.NameLength),
+          record.OldNameOffset == -1 ? null : allNames.Substring(record.OldNameOffset, record.OldNameLength),
+          (EventAction)record.Action,
+          (interfaces.EventError)record.Error,
+          UnixMillisecondsToDateTimeUtc(record.DateTimeUtc)
+        ));
+      }
+
+      lock (_idAndEvents)
+      {
+        if (!_idAndEvents.ContainsKey(id))
+        {
+          _idAndEvents[id] = batch;
+        }
+        else
+        {
+          ((List<IEvent>)_idAndEvents[id]).AddRange(batch);
+        }
+      }
+    }
     #endregion
 
     #region Static helpers
@@ -395,6 +443,14 @@ namespace myoddweb.directorywatcher.utils
     public abstract long Start(IRequest request);
 
     public abstract bool Stop(long id);
+
+    /// <summary>
+    /// Stop many requests at once, they are all told to stop before we wait for any of them.
+    /// </summary>
+    /// <param name="ids">The ids of the requests we want to stop.</param>
+    /// <param name="stoppedIds">The ids of the requests that were stopped, the others might still be running.</param>
+    /// <returns>The number of requests stopped or -1 if there was an error.</returns>
+    public abstract int StopMany(long[] ids, out long[] stoppedIds);
     
     public abstract bool Ready();
     #endregion
@@ -17,7 +17,7 @@ namespace myoddweb.directorywatcher.utils
     public WatcherManagerEmbeddedLoadLibrary()
     {
       // Create helper we will throw if the file does not exist.
-      _helper = new WatcherManagerNativeLibrary(GetFromEmbedded(), EventsCallback, StatisticsCallback, LoggerCallback );
+      _helper = new WatcherManagerNativeLibrary(GetFromEmbedded(), EventsCallback, EventsBatchCallback, StatisticsCallback, LoggerCallback );
     }
 
     #region Private Methods
@@ -50,6 +50,11 @@ namespace myoddweb.directorywatcher.utils
       return _helper.Stop(id);
     }
 
+    public override int StopMany(long[] ids, out long[] stoppedIds)
+    {
+      return _helper.StopMany(ids, out stoppedIds);
+    }
+
     public override bool Ready()
     {
       return _helper.Ready();
@@ -18,7 +18,7 @@ namespace myoddweb.directorywatcher.utils
     public WatcherManagerLoadLibrary()
     {
       // Create helper we will throw if the file does not exist.
-      _helper = new WatcherManagerNativeLibrary(GetFromFileSystem(), EventsCallback, StatisticsCallback, LoggerCallback);
+      _helper = new WatcherManagerNativeLibrary(GetFromFileSystem(), EventsCallback, EventsBatchCallback, StatisticsCallback, LoggerCallback);
     }
 
     #region Private Methods
@@ -87,6 +87,11 @@ namespace myoddweb.directorywatcher.utils
       return _helper.Stop( id );
     }
 
+    public override int StopMany(long[] ids, out long[] stoppedIds)
+    {
+      return _helper.StopMany( ids, out stoppedIds );
+    }
+
     public override bool Ready()
     {
       return _helper.Ready();